@@ -17,6 +17,8 @@
 #endif
 
 #include "wifi_network_config.h"
+#include "settings_lib.h"
+extern settingsStore settings;
 #if defined (INCLUDE_OLED_DISPLAY)
 #include "oled_lib.h"
 extern oledDisplay  oled_Display;
@@ -48,13 +50,6 @@ const char* PARAM_INPUT_2 = "pass";
 String ssid;
 String pass;
 
-
-// File paths to save input values permanently
-const char* ssidPath = "/ssid.txt";
-const char* passPath = "/pass.txt";
-
-
-
 // Timer variables
 unsigned long previousMillis = 0;
 const long interval = 10000;  // interval to wait for Wi-Fi connection (milliseconds)
@@ -77,49 +72,13 @@ void initFS() {
     oled_Display.writeLine(1, "detected",  ALIGN_CENTER);
     oled_Display.writeLine(2, "Install by",  		ALIGN_CENTER);
     oled_Display.writeLine(3, "PlatformIO",  		ALIGN_CENTER);
+    oled_Display.flush();
 #endif
     while(true){};
   }
   DEBUG_PRINT("%s mounted successfully\n", FS_NAME);
 }
 
-// Read File from filesystem
-String readFile(fs::FS &fs, const char * path){
-  DEBUG_PRINT("Reading file: %s\r\n", path);
-
-  File file = fs.open(path);
-  if(!file || file.isDirectory()){
-    DEBUG_PRINT("- failed to open file for reading\n");
-    return String();
-  }
-  
-  String fileContent;
-  while(file.available()){
-    fileContent = file.readStringUntil('\n');
-    break;     
-  }
-  file.close();
-  DEBUG_PRINT("- read from file: %s\n", fileContent.c_str());
-  return fileContent;
-}
-
-// Write file to filesystem
-void writeFile(fs::FS &fs, const char * path, const char * message){
-  DEBUG_PRINT("Writing file: %s\r\n", path);
-
-  File file = fs.open(path, FILE_WRITE);
-  if(!file){
-    DEBUG_PRINT("- failed to open file for writing\n");
-    return;
-  }
-  if(file.print(message)){
-    DEBUG_PRINT("- file written\n");
-  } else {
-    DEBUG_PRINT("- write failed\n");
-  }
-  file.close();
-}
-
 // Initialize WiFi
 bool testWifi() {
   if(ssid=="" || pass==""){
@@ -134,6 +93,7 @@ bool testWifi() {
   oled_Display.clear();
   oled_Display.writeLine(0, "Connecting", ALIGN_CENTER);
   oled_Display.writeLine(1, "to WiFi...",  ALIGN_CENTER);
+  oled_Display.flush();
 #endif
 
   unsigned long currentMillis = millis();
@@ -148,10 +108,13 @@ bool testWifi() {
     oled_Display.writeLine(0, "Failed to", ALIGN_CENTER);
     oled_Display.writeLine(1, "connect to",  ALIGN_CENTER);
     oled_Display.writeLine(2, "WiFi",  		ALIGN_CENTER);
+    oled_Display.flush();
 
 #endif
       return false;
     }
+    // runs in the WiFi boot task, give the idle task a chance
+    delay(10);
   }
 
   DEBUG_PRINT("Connected to WiFi\n");
@@ -171,18 +134,18 @@ void handleConfigPost(AsyncWebServerRequest *request) {
       if (p->name() == PARAM_INPUT_1) {
         ssid = p->value().c_str();
         DEBUG_PRINT("SSID set to: %s\n", ssid.c_str());
-        // Write file to save value
-        writeFile(FS_SYSTEM, ssidPath, ssid.c_str());
+        settings.setSsid(ssid.c_str());
       }
       // HTTP POST pass value
       if (p->name() == PARAM_INPUT_2) {
         pass = p->value().c_str();
         DEBUG_PRINT("Password set to: %s\n", pass.c_str());
-        // Write file to save value
-        writeFile(FS_SYSTEM, passPath, pass.c_str());
+        settings.setPassword(pass.c_str());
       }
     }
   }
+  // Save both values permanently in one write
+  settings.commit();
   request->send(200, "text/plain", "Done. Controller will restart");
 #if defined (INCLUDE_OLED_DISPLAY)
   oled_Display.clear();
@@ -190,6 +153,7 @@ void handleConfigPost(AsyncWebServerRequest *request) {
   oled_Display.writeLine(1, "configuration",  ALIGN_CENTER);
   oled_Display.writeLine(2, "stored",  		ALIGN_CENTER);
   oled_Display.writeLine(3, "Restarting...",  ALIGN_CENTER);
+  oled_Display.flush();
 #endif
   delay(3000);
   ESP.restart();
@@ -211,14 +175,15 @@ bool configureNetwork(bool forceConfigure, NETWORK_CONFIG *networkConfig) {
     oled_Display.writeLine(1, "found",  ALIGN_CENTER);
     oled_Display.writeLine(2, "Install by",  		ALIGN_CENTER);
     oled_Display.writeLine(3, "PlatformIO",  		ALIGN_CENTER);
+    oled_Display.flush();
 #endif
     while(true){};
   }
   file.close();
  
-  // Load values saved in filesystem
-  ssid = readFile(FS_SYSTEM, ssidPath);
-  pass = readFile(FS_SYSTEM, passPath);
+  // Values loaded from the settings record at boot
+  ssid = settings.getSsid();
+  pass = settings.getPassword();
 
 
   DEBUG_PRINT("ssid : %s\n", ssid.c_str());
@@ -250,6 +215,7 @@ bool configureNetwork(bool forceConfigure, NETWORK_CONFIG *networkConfig) {
     oled_Display.writeLine(1, text_buffer,  ALIGN_CENTER);
     snprintf(text_buffer, sizeof(text_buffer), "IP: %s", IP.toString().c_str());
     oled_Display.writeLine(2, text_buffer,  ALIGN_CENTER);
+    oled_Display.flush();
 #endif
 
     // Web Server Root URL - serve static files first
@@ -31,6 +31,31 @@ void adc3208::init(spi *spi_bus)
 
     spi_bus->selectDevice(SPI_DEVICE_ADC);   // select
     spi_bus->deselectDevice();   			// and deselect again
+
+	for (uint8_t channel = 0; channel < N_ADC_CHANNELS; channel++)
+	{
+		setCalibration(channel, nullptr);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adc3208::setCalibration(uint8_t channel, const conv_calibration_t *calibration)
+//
+// rebuilds the fixed point conversion of a channel, nullptr = ideal.
+// The range depends on the channel:
+// channel 0..3: -10 volt .. +10 volt
+// channel 4..7: 0 volt .. +2.5 volt
+
+void adc3208::setCalibration(uint8_t channel, const conv_calibration_t *calibration)
+{
+    if (channel <= 3)
+    {
+        convInitRawToUv(&conversion[channel], ADC03_MIN_VOLTAGE, ADC03_RESOLUTION, calibration);
+    }
+    else if (channel < N_ADC_CHANNELS)
+    {
+        convInitRawToUv(&conversion[channel], ADC47_MIN_VOLTAGE, ADC47_RESOLUTION, calibration);
+    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -52,16 +77,18 @@ void adc3208::init(spi *spi_bus)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// uint16_t adc3208::readRaw(uint8_t channel, uint8_t averageCount)
+// uint16_t adc3208::readRaw(uint8_t channel, uint16_t averageCount)
+//
+// averageCount conversions back to back, the sum fits 32 bit for any count
 
-uint16_t adc3208::readRaw(uint8_t channel, uint8_t averageCount)
+uint16_t adc3208::readRaw(uint8_t channel, uint16_t averageCount)
 {
     uint16_t adcCommand = 0;
     uint16_t adcValue = 0;
 	uint16_t ix = 0;
 	uint32_t raw = 0;
 
-    if (channel < N_ADC_CHANNELS)
+    if ((channel < N_ADC_CHANNELS) && (averageCount > 0))
     {
         adcCommand = ADC_STR | ADC_SINGLE | (channel << 6);
         
@@ -131,10 +158,10 @@ void adc3208::readRawMultiple(uint8_t channelList[], uint8_t numChannels, uint16
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void adc3208::readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, 
-//                              double voltages[])
+// void adc3208::readMicrovoltMultiple(uint8_t channelList[], uint8_t numChannels, 
+//                                int32_t microVolts[])
 
-void adc3208::readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, double voltages[])
+void adc3208::readMicrovoltMultiple(uint8_t channelList[], uint8_t numChannels, int32_t microVolts[])
 {
     uint16_t rawValues[N_ADC_CHANNELS];
     uint8_t ix = 0;
@@ -143,47 +170,81 @@ void adc3208::readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, do
 
     readRawMultiple(channelList, numChannels, rawValues);
 
-    // raw to voltage conversion is dependent on the channel range:
-    // channel 0..3: -10 volt .. +10 volt
-    // channel 4..7: 0 volt .. +2.5 volt
-    
     for (ix = 0; ix < numChannels; ix++)
     {
-        voltages[ix] = rawToVoltage(rawValues[ix], channelList[ix]);
+        microVolts[ix] = rawToMicrovolt(rawValues[ix], channelList[ix]);
     }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// double adc3208::readVoltage(uint8_t channel, uint8_t averageCount)
+// void adc3208::readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, 
+//                              float voltages[])
 
-double adc3208::readVoltage(uint8_t channel, uint8_t averageCount)
+void adc3208::readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, float voltages[])
+{
+    int32_t microVolts[N_ADC_CHANNELS];
+    uint8_t ix = 0;
+
+    numChannels = constrain(numChannels, 0, N_ADC_CHANNELS);
+
+    readMicrovoltMultiple(channelList, numChannels, microVolts);
+
+    for (ix = 0; ix < numChannels; ix++)
+    {
+        voltages[ix] = microVolts[ix] * 1e-6f;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int32_t adc3208::readMicrovolt(uint8_t channel, uint16_t averageCount)
+
+int32_t adc3208::readMicrovolt(uint8_t channel, uint16_t averageCount)
 {
     uint16_t adcRaw = 0;
-    double  voltage = 0.0;
 
 	adcRaw = adc3208::readRaw(channel, averageCount);
-   	voltage = adc3208::rawToVoltage(adcRaw, channel);
-     
-    return voltage;
+
+    return adc3208::rawToMicrovolt(adcRaw, channel);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// float adc3208::readVoltage(uint8_t channel, uint16_t averageCount)
+
+float adc3208::readVoltage(uint8_t channel, uint16_t averageCount)
+{
+    return adc3208::readMicrovolt(channel, averageCount) * 1e-6f;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// double adc3208::rawToVoltage(uint16_t adcRaw, uint8_t channel)
+// int32_t adc3208::rawToMicrovolt(uint16_t adcRaw, uint8_t channel)
 
-double adc3208::rawToVoltage(uint16_t adcRaw, uint8_t channel)
+int32_t adc3208::rawToMicrovolt(uint16_t adcRaw, uint8_t channel)
 {
-    double voltage = 0.0;
+    int32_t microVolt = 0;
     
-    if ((channel >= 0) && (channel <= 3))   // channels 0..3: -10 .. +10 volt
+    if (channel < N_ADC_CHANNELS)
     {
-        voltage = fmap(adcRaw, ADC_MIN_VALUE, ADC_MAX_VALUE, ADC03_MIN_VOLTAGE, ADC03_MAX_VOLTAGE);
+        microVolt = convRawToUv(&conversion[channel], adcRaw);
     }
-    else if ((channel >= 4) && (channel <= 7)) // channels 4..7: 0.. +2.5 volt
+  
+    return microVolt;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int32_t adc3208::rawQ8ToMicrovolt(int32_t adcRawQ8, uint8_t channel)
+//
+// adcRawQ8: averaged or filtered raw value with 8 fraction bits
+
+int32_t adc3208::rawQ8ToMicrovolt(int32_t adcRawQ8, uint8_t channel)
+{
+    int32_t microVolt = 0;
+    
+    if (channel < N_ADC_CHANNELS)
     {
-        voltage = fmap(adcRaw, ADC_MIN_VALUE, ADC_MAX_VALUE, ADC47_MIN_VOLTAGE, ADC47_MAX_VOLTAGE);
+        microVolt = convRawQ8ToUv(&conversion[channel], adcRawQ8);
     }
   
-    return voltage;
+    return microVolt;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
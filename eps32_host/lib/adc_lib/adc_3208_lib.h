@@ -13,7 +13,7 @@
 #include <SPI.h>
 #include "spi_lib.h"
 #include "../config.h"
-#include "fmap.h"
+#include "conv_lib.h"
 #include "../bits.h"
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -35,20 +35,22 @@ public:
 
     void init(spi *spi_bus);
 
-    uint16_t readRaw(uint8_t channel, uint8_t averageCount = 1);
+    uint16_t readRaw(uint8_t channel, uint16_t averageCount = 1);
     void readRawMultiple(uint8_t channelList[], uint8_t numChannels, uint16_t rawValues[]);
-    void readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, double voltages[]);
+    void readVoltageMultiple(uint8_t channelList[], uint8_t numChannels, float voltages[]);
+    void readMicrovoltMultiple(uint8_t channelList[], uint8_t numChannels, int32_t microVolts[]);
 
-    double readVoltage(uint8_t channel, uint8_t averageCount = 1);
-    bool   isButtonPressed(uint8_t analogButton);
+    float   readVoltage(uint8_t channel, uint16_t averageCount = 1);
+    int32_t readMicrovolt(uint8_t channel, uint16_t averageCount = 1);
+    int32_t rawToMicrovolt(uint16_t adcRaw, uint8_t channel);
+    int32_t rawQ8ToMicrovolt(int32_t adcRawQ8, uint8_t channel);
+    bool    isButtonPressed(uint8_t analogButton);
+
+    void setCalibration(uint8_t channel, const conv_calibration_t *calibration);
 private:
     spi *spi_bus;
     SPISettings ADCSPISettings = SPISettings(SPI_ADC_SPEED, MSBFIRST, SPI_MODE0);
-    double rawToVoltage(uint16_t adcRaw, uint8_t channel);
+    conv_raw_to_uv_t conversion[N_ADC_CHANNELS];
 };
 
 #endif  // ADC3208_H
-
-    uint16_t readRaw(uint8_t channel, uint8_t averageCount = 1);
-    double readVoltage(uint8_t channel, uint8_t averageCount = 1);
-    bool   isButtonPressed(uint8_t analogButton);
\ No newline at end of file
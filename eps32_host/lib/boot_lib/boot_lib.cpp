@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// BootLib.cpp
+//
+// Times are taken from esp_timer, which starts with the application, so the
+// first stage also shows the time spent before setup() is called.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "boot_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// uint8_t bootProfile::begin(const char *name)
+//
+// returns the stage to pass to end(), BOOT_STAGE_NONE when the table is full
+
+uint8_t bootProfile::begin(const char *name)
+{
+	uint8_t stage = BOOT_STAGE_NONE;
+	uint32_t now = (uint32_t)esp_timer_get_time();
+
+	portENTER_CRITICAL(&mux);
+	if (numStages < BOOT_MAX_STAGES)
+	{
+		stage = numStages++;
+		stages[stage].name       = name;
+		stages[stage].startUs    = now;
+		stages[stage].durationUs = 0;
+		stages[stage].done       = false;
+	}
+	portEXIT_CRITICAL(&mux);
+
+	return stage;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void bootProfile::end(uint8_t stage)
+
+void bootProfile::end(uint8_t stage)
+{
+	uint32_t now = (uint32_t)esp_timer_get_time();
+
+	portENTER_CRITICAL(&mux);
+	if ((stage < numStages) && !stages[stage].done)
+	{
+		stages[stage].durationUs = now - stages[stage].startUs;
+		stages[stage].done       = true;
+	}
+	portEXIT_CRITICAL(&mux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void bootProfile::ready(void)
+//
+// the RPC server accepts commands from here on
+
+void bootProfile::ready(void)
+{
+	readyUs = (uint32_t)esp_timer_get_time();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void bootProfile::firstCommand(void)
+
+void bootProfile::firstCommand(void)
+{
+	if (firstCommandUs == BOOT_NOT_REACHED)
+	{
+		firstCommandUs = (uint32_t)esp_timer_get_time();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint8_t bootProfile::count(void)
+
+uint8_t bootProfile::count(void)
+{
+	return numStages;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool bootProfile::get(uint8_t stage, boot_stage_t *info)
+//
+// a stage still running reports the time elapsed so far
+
+bool bootProfile::get(uint8_t stage, boot_stage_t *info)
+{
+	uint32_t now = (uint32_t)esp_timer_get_time();
+
+	if (stage >= numStages)
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	*info = stages[stage];
+	portEXIT_CRITICAL(&mux);
+
+	if (!info->done)
+	{
+		info->durationUs = now - info->startUs;
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t bootProfile::getReadyUs(void)
+
+uint32_t bootProfile::getReadyUs(void)
+{
+	return readyUs;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t bootProfile::getFirstCommandUs(void)
+
+uint32_t bootProfile::getFirstCommandUs(void)
+{
+	return firstCommandUs;
+}
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// BootLib.h
+//
+// boot time profile: start and duration of every setup() stage, including
+// stages that run in parallel in their own task (WiFi association)
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BOOTLIB_H
+#define BOOTLIB_H
+
+#include <Arduino.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define BOOT_MAX_STAGES		12
+#define BOOT_STAGE_NONE		0xFF
+#define BOOT_NOT_REACHED	0			// milestone time when not reached yet
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	const char *name;				// string literal
+	uint32_t    startUs;			// since application start
+	uint32_t    durationUs;
+	bool        done;
+} boot_stage_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class bootProfile {
+public:
+	uint8_t begin(const char *name);
+	void end(uint8_t stage);
+	void ready(void);
+	void firstCommand(void);
+
+	uint8_t count(void);
+	bool get(uint8_t stage, boot_stage_t *info);
+	uint32_t getReadyUs(void);
+	uint32_t getFirstCommandUs(void);
+
+private:
+	boot_stage_t stages[BOOT_MAX_STAGES];
+	uint8_t      numStages = 0;
+	uint32_t     readyUs = BOOT_NOT_REACHED;
+	uint32_t     firstCommandUs = BOOT_NOT_REACHED;
+
+	// stages are opened from setup() and the WiFi task
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif	// BOOTLIB_H
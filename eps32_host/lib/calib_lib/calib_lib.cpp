@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CalibLib.cpp
+//
+// The record is read once at boot and pushed into the fixed point conversion
+// tables of the ADC & DAC, so corrected values come straight from the device.
+// A missing, outdated or corrupt record falls back to the ideal conversion.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "calib_lib.h"
+
+RECORD_CHECK_LAYOUT(calib_record_t);
+
+///////////////////////////////////////////////////////////////////////////////
+// void calibrationStore::attach(adc3208 *adc)
+
+void calibrationStore::attach(adc3208 *adc)
+{
+	this->adc = adc;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void calibrationStore::attach(dac4922 *dac)
+
+void calibrationStore::attach(dac4922 *dac)
+{
+	this->dac = dac;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::init(void)
+//
+// returns false when no valid record was found and defaults are used
+
+bool calibrationStore::init(void)
+{
+	bool loaded = load();
+
+	if (!loaded)
+	{
+		reset();
+	}
+	else
+	{
+		apply();
+	}
+
+	return loaded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::load(void)
+
+bool calibrationStore::load(void)
+{
+	return recordLoad(CALIB_FILE_PATH, &record, sizeof(record), CALIB_MAGIC, CALIB_VERSION);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::commit(void)
+
+bool calibrationStore::commit(void)
+{
+	return recordCommit(CALIB_FILE_PATH, CALIB_TEMP_PATH, &record, sizeof(record), CALIB_MAGIC, CALIB_VERSION);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void calibrationStore::apply(void)
+
+void calibrationStore::apply(void)
+{
+	uint8_t channel = 0;
+
+	if (adc != nullptr)
+	{
+		for (channel = 0; channel < N_ADC_CHANNELS; channel++)
+		{
+			adc->setCalibration(channel, &record.adc[channel]);
+		}
+	}
+
+	if (dac != nullptr)
+	{
+		for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+		{
+			dac->setCalibration(channel, &record.dac[channel]);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void calibrationStore::reset(void)
+//
+// ideal conversion for all channels, the stored record is kept until commit()
+
+void calibrationStore::reset(void)
+{
+	uint8_t channel = 0;
+
+	for (channel = 0; channel < N_ADC_CHANNELS; channel++)
+	{
+		convDefaultCalibration(&record.adc[channel]);
+	}
+
+	for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+	{
+		convDefaultCalibration(&record.dac[channel]);
+	}
+
+	apply();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// conv_calibration_t *calibrationStore::channelEntry(calib_device_t device, uint8_t channel)
+
+conv_calibration_t *calibrationStore::channelEntry(calib_device_t device, uint8_t channel)
+{
+	conv_calibration_t *entry = nullptr;
+
+	if ((device == CALIB_DEVICE_ADC) && (channel < N_ADC_CHANNELS))
+	{
+		entry = &record.adc[channel];
+	}
+	else if ((device == CALIB_DEVICE_DAC) && (channel < N_DAC_CHANNELS))
+	{
+		entry = &record.dac[channel];
+	}
+
+	return entry;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::isValid(calib_device_t device, uint8_t channel,
+//								  const conv_calibration_t *calibration)
+//
+// gain & offset within the conv_lib limits, the PWL points ascending within
+// the voltage range of the channel and each correction at most its span
+
+bool calibrationStore::isValid(calib_device_t device, uint8_t channel, const conv_calibration_t *calibration)
+{
+	int32_t minUv = 0;
+	int32_t maxUv = 0;
+	uint8_t ix = 0;
+
+	if ((calibration->gain < CONV_MIN_GAIN) || (calibration->gain > CONV_MAX_GAIN) ||
+		(calibration->offset < -CONV_MAX_OFFSET) || (calibration->offset > CONV_MAX_OFFSET) ||
+		(calibration->pwl.numPoints > CONV_PWL_POINTS))
+	{
+		return false;
+	}
+
+	if (device == CALIB_DEVICE_DAC)
+	{
+		minUv = convVoltToUv(DAC_MIN_VOLTAGE);
+		maxUv = convVoltToUv(DAC_MAX_VOLTAGE);
+	}
+	else if (channel <= 3)
+	{
+		minUv = convVoltToUv(ADC03_MIN_VOLTAGE);
+		maxUv = convVoltToUv(ADC03_MAX_VOLTAGE);
+	}
+	else
+	{
+		minUv = convVoltToUv(ADC47_MIN_VOLTAGE);
+		maxUv = convVoltToUv(ADC47_MAX_VOLTAGE);
+	}
+
+	for (ix = 0; ix < calibration->pwl.numPoints; ix++)
+	{
+		if ((calibration->pwl.pointUv[ix] < minUv) || (calibration->pwl.pointUv[ix] > maxUv) ||
+			(calibration->pwl.correctionUv[ix] < minUv - maxUv) || (calibration->pwl.correctionUv[ix] > maxUv - minUv) ||
+			((ix > 0) && (calibration->pwl.pointUv[ix] <= calibration->pwl.pointUv[ix - 1])))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::get(calib_device_t device, uint8_t channel,
+//							  conv_calibration_t *calibration)
+
+bool calibrationStore::get(calib_device_t device, uint8_t channel, conv_calibration_t *calibration)
+{
+	conv_calibration_t *entry = channelEntry(device, channel);
+
+	if (entry == nullptr)
+	{
+		return false;
+	}
+
+	*calibration = *entry;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool calibrationStore::set(calib_device_t device, uint8_t channel,
+//							  const conv_calibration_t *calibration)
+//
+// takes effect immediately, persisted by commit()
+
+bool calibrationStore::set(calib_device_t device, uint8_t channel, const conv_calibration_t *calibration)
+{
+	conv_calibration_t *entry = channelEntry(device, channel);
+
+	if ((entry == nullptr) || !isValid(device, channel, calibration))
+	{
+		return false;
+	}
+
+	*entry = *calibration;
+
+	if ((device == CALIB_DEVICE_ADC) && (adc != nullptr))
+	{
+		adc->setCalibration(channel, entry);
+	}
+	else if ((device == CALIB_DEVICE_DAC) && (dac != nullptr))
+	{
+		dac->setCalibration(channel, entry);
+	}
+
+	return true;
+}
@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CalibLib.h
+//
+// per channel calibration of the ADC & DAC, kept in RAM and persisted as a
+// single CRC checked record in LittleFS
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CALIBLIB_H
+#define CALIBLIB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "conv_lib.h"
+#include "adc_3208_lib.h"
+#include "dac_4922_lib.h"
+#include "record_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define CALIB_FILE_PATH		"/calibration.bin"
+#define CALIB_TEMP_PATH		"/calibration.tmp"
+
+#define CALIB_MAGIC			0x42494C43		// "CLIB"
+#define CALIB_VERSION		1
+
+///////////////////////////////////////////////////////////////////////////////
+// enum's
+
+typedef enum
+{
+	CALIB_DEVICE_ADC,
+	CALIB_DEVICE_DAC,
+} calib_device_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	record_header_t header;
+	conv_calibration_t adc[N_ADC_CHANNELS];
+	conv_calibration_t dac[N_DAC_CHANNELS];
+	uint32_t crc;						// CRC32 of all fields above, see record_lib
+} calib_record_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class calibrationStore {
+public:
+	void attach(adc3208 *adc);
+	void attach(dac4922 *dac);
+	bool init(void);
+
+	bool get(calib_device_t device, uint8_t channel, conv_calibration_t *calibration);
+	bool set(calib_device_t device, uint8_t channel, const conv_calibration_t *calibration);
+	void reset(void);
+	bool commit(void);
+
+private:
+	bool load(void);
+	void apply(void);
+	conv_calibration_t *channelEntry(calib_device_t device, uint8_t channel);
+	bool isValid(calib_device_t device, uint8_t channel, const conv_calibration_t *calibration);
+
+	calib_record_t record;
+	adc3208 *adc = nullptr;
+	dac4922 *dac = nullptr;
+};
+
+#endif	// CALIBLIB_H
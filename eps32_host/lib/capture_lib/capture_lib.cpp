@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CaptureLib.cpp
+//
+// The capture task scans without a timer: one SPI transaction per scan,
+// back to back, so the sample rate is what the bus sustains. The ring holds
+// exactly preScans + 1 + postScans scans. The trigger is only accepted once
+// the pre-trigger part is filled, so a finished capture always has a full
+// ring with the oldest scan at writeScan and the trigger scan at preScans.
+//
+// The timestamp is taken just before the first conversion of a scan, the
+// channels of a scan follow each other at the conversion time.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "capture_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcCapture::init(adc3208 *adc, dio *digitalIo)
+//
+// digitalIo nullptr: no DIO edge triggers
+
+void adcCapture::init(adc3208 *adc, dio *digitalIo)
+{
+	this->adc = adc;
+	this->digitalIo = digitalIo;
+
+	memset(&config, 0, sizeof(config));
+
+	xTaskCreatePinnedToCore(captureTask, "adcCapture", RTOS_DEFAULT_STACKSIZE, this,
+							CAPTURE_TASK_PRIORITY, &taskHandle, CORE_0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcCapture::captureTask(void *parameter)
+
+void adcCapture::captureTask(void *parameter)
+{
+	adcCapture *capture = (adcCapture *)parameter;
+
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		capture->run();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcCapture::checkTrigger(const uint16_t rawValues[])
+//
+// an edge needs the source on the other side of the level first (by the
+// hysteresis for an ADC channel), so noise around the level does not retrigger
+
+bool adcCapture::checkTrigger(const uint16_t rawValues[])
+{
+	uint16_t value = rawValues[triggerIndex];
+	bool bitSet = false;
+	bool hit = false;
+
+	switch (config.trigger)
+	{
+		case CAPTURE_TRIGGER_NOW:
+		hit = true;
+		break;
+
+		case CAPTURE_TRIGGER_RISING:
+		if (value + config.hysteresis < config.level)
+		{
+			primed = true;
+		}
+		else if (primed && (value >= config.level))
+		{
+			hit = true;
+		}
+		break;
+
+		case CAPTURE_TRIGGER_FALLING:
+		if (value > config.level + config.hysteresis)
+		{
+			primed = true;
+		}
+		else if (primed && (value <= config.level))
+		{
+			hit = true;
+		}
+		break;
+
+		case CAPTURE_TRIGGER_DIO_RISING:
+		case CAPTURE_TRIGGER_DIO_FALLING:
+		bitSet = digitalIo->isBitSet(config.source);
+		if (bitSet == (config.trigger == CAPTURE_TRIGGER_DIO_FALLING))
+		{
+			primed = true;
+		}
+		else if (primed)
+		{
+			hit = true;
+		}
+		break;
+	}
+
+	if (hit)
+	{
+		primed = false;
+	}
+
+	return hit || forceRequested;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcCapture::run(void)
+
+void adcCapture::run(void)
+{
+	uint16_t remaining = 0;
+	uint16_t scan = 0;
+	uint32_t lastYield = millis();
+	bool     triggered = false;
+
+	while (true)
+	{
+		if (stopRequested)
+		{
+			state = CAPTURE_IDLE;
+			return;
+		}
+
+		scan = writeScan;
+		timestamps[scan] = xthal_get_ccount();
+		adc->readRawMultiple(channelList, numChannels, &samples[scan * numChannels]);
+
+		writeScan = (scan + 1 == ringScans) ? 0 : scan + 1;
+		if (scansRecorded < ringScans)
+		{
+			scansRecorded++;
+		}
+
+		if (state == CAPTURE_ARMED)
+		{
+			// the trigger state follows the signal while the ring fills
+			triggered = checkTrigger(&samples[scan * numChannels]);
+
+			if (triggered && (scansRecorded > config.preScans))
+			{
+				triggerScan = scan;
+				remaining   = config.postScans;
+				state       = CAPTURE_TRIGGERED;
+			}
+			else if (millis() - lastYield >= CAPTURE_YIELD_MS)
+			{
+				vTaskDelay(1);
+				lastYield = millis();
+			}
+		}
+		else
+		{
+			remaining--;
+		}
+
+		if ((state == CAPTURE_TRIGGERED) && (remaining == 0))
+		{
+			state = CAPTURE_DONE;
+			return;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t adcCapture::maxScans(uint8_t channelMask)
+//
+// preScans + 1 + postScans may not exceed this
+
+uint16_t adcCapture::maxScans(uint8_t channelMask)
+{
+	uint8_t count = __builtin_popcount(channelMask);
+
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	return min(CAPTURE_MAX_SCANS, CAPTURE_MAX_SAMPLES / count);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcCapture::arm(const capture_config_t *config)
+//
+// returns false on an invalid configuration or while a capture is running,
+// a finished capture is discarded
+
+bool adcCapture::arm(const capture_config_t *config)
+{
+	uint8_t channel = 0;
+
+	if ((state == CAPTURE_ARMED) || (state == CAPTURE_TRIGGERED) ||
+		(config->channelMask == 0) || (config->trigger > CAPTURE_TRIGGER_DIO_FALLING) ||
+		((uint32_t)config->preScans + 1 + config->postScans > maxScans(config->channelMask)))
+	{
+		return false;
+	}
+
+	if (((config->trigger == CAPTURE_TRIGGER_RISING) || (config->trigger == CAPTURE_TRIGGER_FALLING)) &&
+		((config->source >= N_ADC_CHANNELS) || !(config->channelMask & (1 << config->source))))
+	{
+		return false;
+	}
+
+	if (((config->trigger == CAPTURE_TRIGGER_DIO_RISING) || (config->trigger == CAPTURE_TRIGGER_DIO_FALLING)) &&
+		((digitalIo == nullptr) || (config->source >= N_INPUT_BITS)))
+	{
+		return false;
+	}
+
+	this->config = *config;
+	numChannels  = 0;
+	triggerIndex = 0;
+	for (channel = 0; channel < N_ADC_CHANNELS; channel++)
+	{
+		if (config->channelMask & (1 << channel))
+		{
+			if (channel == config->source)
+			{
+				triggerIndex = numChannels;
+			}
+			channelList[numChannels++] = channel;
+		}
+	}
+
+	ringScans      = config->preScans + 1 + config->postScans;
+	writeScan      = 0;
+	scansRecorded  = 0;
+	triggerScan    = 0;
+	primed         = false;
+	stopRequested  = false;
+	forceRequested = false;
+	state          = CAPTURE_ARMED;
+
+	xTaskNotifyGive(taskHandle);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcCapture::stop(void)
+//
+// aborts a running capture and waits for the task to leave the scan loop
+
+void adcCapture::stop(void)
+{
+	stopRequested = true;
+
+	while ((state == CAPTURE_ARMED) || (state == CAPTURE_TRIGGERED))
+	{
+		vTaskDelay(1);
+	}
+
+	state = CAPTURE_IDLE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcCapture::forceTrigger(void)
+//
+// triggers on the next scan, once the pre-trigger part is filled
+
+void adcCapture::forceTrigger(void)
+{
+	forceRequested = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getters
+
+capture_state_t adcCapture::getState(void)
+{
+	return state;
+}
+
+uint8_t adcCapture::getNumChannels(void)
+{
+	return numChannels;
+}
+
+uint16_t adcCapture::getScans(void)
+{
+	return ringScans;
+}
+
+uint16_t adcCapture::getScansRecorded(void)
+{
+	return scansRecorded;
+}
+
+const capture_config_t *adcCapture::getConfig(void)
+{
+	return &config;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcCapture::readScan(uint16_t scan, int32_t *cycles, uint16_t rawValues[])
+//
+// scan 0 is the oldest, scan preScans the trigger scan. cycles is relative to
+// the trigger scan, negative before it. Only valid once the capture is done.
+
+bool adcCapture::readScan(uint16_t scan, int32_t *cycles, uint16_t rawValues[])
+{
+	uint16_t position = 0;
+
+	if ((state != CAPTURE_DONE) || (scan >= ringScans))
+	{
+		return false;
+	}
+
+	position = (writeScan + scan) % ringScans;
+
+	*cycles = (int32_t)(timestamps[position] - timestamps[triggerScan]);
+	memcpy(rawValues, &samples[position * numChannels], numChannels * sizeof(uint16_t));
+
+	return true;
+}
@@ -0,0 +1,114 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CaptureLib.h
+//
+// oscilloscope style triggered burst capture on the MCP3208 ADC: a channel
+// set is scanned back to back at the full SPI rate into a pre-trigger ring,
+// a level crossing, a DIO edge or a forced trigger completes the capture
+// with a post-trigger block. Every scan carries a CPU cycle count timestamp.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CAPTURELIB_H
+#define CAPTURELIB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "adc_3208_lib.h"
+#include "dio_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define CAPTURE_MAX_SAMPLES		4096		// conversions over all channels (8 kB)
+#define CAPTURE_MAX_SCANS		1024		// scan timestamps (4 kB)
+
+// the capture task runs on the protocol core, next to the WiFi stack. While
+// waiting for the trigger it gives up one tick every CAPTURE_YIELD_MS so the
+// idle task keeps the watchdog fed, the timestamps show the gap.
+
+#define CAPTURE_TASK_PRIORITY	1
+#define CAPTURE_YIELD_MS		100
+
+///////////////////////////////////////////////////////////////////////////////
+// enum's
+
+typedef enum
+{
+	CAPTURE_TRIGGER_NOW,			// first scan after the pre-trigger block
+	CAPTURE_TRIGGER_RISING,			// ADC channel crosses level upwards
+	CAPTURE_TRIGGER_FALLING,		// ADC channel crosses level downwards
+	CAPTURE_TRIGGER_DIO_RISING,		// DIO input bit goes high
+	CAPTURE_TRIGGER_DIO_FALLING,	// DIO input bit goes low
+} capture_trigger_t;
+
+typedef enum
+{
+	CAPTURE_IDLE,
+	CAPTURE_ARMED,					// filling the pre-trigger ring, waiting for the trigger
+	CAPTURE_TRIGGERED,				// recording the post-trigger block
+	CAPTURE_DONE,					// block ready to read
+} capture_state_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint8_t           channelMask;		// bit n set = capture ADC channel n
+	capture_trigger_t trigger;
+	uint8_t           source;			// ADC channel (level) or DIO input bit (edge)
+	uint16_t          level;			// raw trigger level
+	uint16_t          hysteresis;		// raw, the signal must first be this far on the other side
+	uint16_t          preScans;			// scans kept before the trigger scan
+	uint16_t          postScans;		// scans recorded after the trigger scan
+} capture_config_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class adcCapture {
+public:
+	void init(adc3208 *adc, dio *digitalIo = nullptr);
+
+	bool arm(const capture_config_t *config);
+	void stop(void);
+	void forceTrigger(void);
+
+	capture_state_t getState(void);
+	uint16_t maxScans(uint8_t channelMask);
+	uint8_t  getNumChannels(void);
+	uint16_t getScans(void);
+	uint16_t getScansRecorded(void);
+	const capture_config_t *getConfig(void);
+	bool readScan(uint16_t scan, int32_t *cycles, uint16_t rawValues[]);
+
+private:
+	static void captureTask(void *parameter);
+	void run(void);
+	bool checkTrigger(const uint16_t rawValues[]);
+
+	adc3208 *adc;
+	dio *digitalIo;
+	TaskHandle_t taskHandle = nullptr;
+
+	capture_config_t config;
+	uint8_t  channelList[N_ADC_CHANNELS];
+	uint8_t  numChannels = 0;
+	uint8_t  triggerIndex = 0;			// position of the trigger channel in a scan
+	uint16_t ringScans = 0;				// preScans + 1 + postScans
+
+	volatile capture_state_t state = CAPTURE_IDLE;
+	volatile bool stopRequested = false;
+	volatile bool forceRequested = false;
+	bool     primed = false;			// trigger source was on the far side of the level
+
+	uint16_t writeScan = 0;				// next ring position
+	uint16_t scansRecorded = 0;
+	uint16_t triggerScan = 0;			// ring position of the trigger scan
+
+	uint16_t samples[CAPTURE_MAX_SAMPLES];
+	uint32_t timestamps[CAPTURE_MAX_SCANS];		// CCOUNT at the start of a scan
+};
+
+#endif	// CAPTURELIB_H
@@ -0,0 +1,317 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CompareLib.cpp
+//
+// The DFLAG/LFLAG outputs of the LS7366R are not wired to the ESP32, so the
+// latched CMP bit in STR is polled: a hardware timer wakes the poll task,
+// which reads one status byte per armed counter (a few microseconds on the
+// bus). CMP stays set until STR is cleared, so a match between two polls is
+// never lost, it is only seen up to one poll period late. The actions run in
+// the poll task right after the detection, no host round trip is involved.
+//
+// FLAG_ON_CMP is set in MDR1 as well, a board with DFLAG routed to an input
+// can use the flag pin directly.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "compare_lib.h"
+
+qcCompare *qcCompare::instance = nullptr;
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::init(qc7366 *qc, PulseLib *pulseChannels, uint8_t numPulseChannels,
+//						dio *digitalIo, adc3208 *adc, adcCapture *capture)
+//
+// a nullptr device makes its action unavailable
+
+void qcCompare::init(qc7366 *qc, PulseLib *pulseChannels, uint8_t numPulseChannels,
+					 dio *digitalIo, adc3208 *adc, adcCapture *capture)
+{
+	this->qc               = qc;
+	this->pulseChannels    = pulseChannels;
+	this->numPulseChannels = numPulseChannels;
+	this->digitalIo        = digitalIo;
+	this->adc              = adc;
+	this->capture          = capture;
+	instance = this;
+
+	memset(actions, 0, sizeof(actions));
+	memset(results, 0, sizeof(results));
+	memset(pollRates, 0, sizeof(pollRates));
+
+	xTaskCreatePinnedToCore(pollTask, "qcCompare", RTOS_DEFAULT_STACKSIZE, this,
+							COMPARE_TASK_PRIORITY, &taskHandle, CORE_1);
+
+	timer = timerBegin(COMPARE_TIMER_NUMBER, COMPARE_TIMER_DIVIDER, true);
+	timerAttachInterrupt(timer, &onTimer, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void IRAM_ATTR qcCompare::onTimer(void)
+
+void IRAM_ATTR qcCompare::onTimer(void)
+{
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(instance->taskHandle, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::pollTask(void *parameter)
+
+void qcCompare::pollTask(void *parameter)
+{
+	qcCompare *compare = (qcCompare *)parameter;
+	uint32_t ticks = 0;
+
+	while (true)
+	{
+		ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		compare->poll(ticks);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::poll(uint32_t ticks)
+//
+// ticks > 1: the task was held up for more than one poll period
+
+void qcCompare::poll(uint32_t ticks)
+{
+	uint8_t channel = 0;
+	bool    armed = false;
+
+	for (channel = 0; channel <= QC_MAX_CHANNEL; channel++)
+	{
+		portENTER_CRITICAL(&mux);
+		armed = results[channel].armed;
+		portEXIT_CRITICAL(&mux);
+
+		if (armed && ((qc->readStatusRegister(channel) & CMP_BIT) != 0))
+		{
+			fire(channel);
+		}
+	}
+
+	portENTER_CRITICAL(&mux);
+	polls++;
+	missedPolls += (ticks > 1) ? (ticks - 1) : 0;
+	portEXIT_CRITICAL(&mux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::fire(uint8_t channel)
+//
+// actions in order of urgency: stop the motion first, the measurements after
+
+void qcCompare::fire(uint8_t channel)
+{
+	compare_action_t action;
+	uint16_t rawValues[N_ADC_CHANNELS];
+	uint8_t  list[N_ADC_CHANNELS];
+	uint8_t  count = 0;
+	uint8_t  ix = 0;
+	uint32_t detectedUs = (uint32_t)esp_timer_get_time();
+	int32_t  counter = 0;
+
+	portENTER_CRITICAL(&mux);
+	action = actions[channel];
+	portEXIT_CRITICAL(&mux);
+
+	for (ix = 0; ix < numPulseChannels; ix++)
+	{
+		if ((action.pulseMask & (1 << ix)) != 0)
+		{
+			pulseChannels[ix].haltFromISR(PULSE_HALT_COMPARE + channel);
+		}
+	}
+
+	if (action.dioBit != COMPARE_NO_DIO_BIT)
+	{
+		if (action.dioLevel)
+		{
+			digitalIo->setBit(action.dioBit);
+		}
+		else
+		{
+			digitalIo->clearBit(action.dioBit);
+		}
+	}
+
+	if (action.triggerCapture)
+	{
+		capture->forceTrigger();
+	}
+
+	if (action.adcMask != 0)
+	{
+		for (ix = 0; ix < N_ADC_CHANNELS; ix++)
+		{
+			if ((action.adcMask & (1 << ix)) != 0)
+			{
+				list[count++] = ix;
+			}
+		}
+		adc->readRawMultiple(list, count, rawValues);
+	}
+
+	qc->latchOutputRegisters(1 << channel);
+	counter = qc->readOutputRegister(channel);
+
+	portENTER_CRITICAL(&mux);
+	compare_result_t *result = &results[channel];
+
+	result->armed       = false;
+	result->fired       = true;
+	result->count       = counter;
+	result->timestampUs = detectedUs;
+	result->latencyUs   = (uint32_t)esp_timer_get_time() - detectedUs;
+	memcpy(result->adcRaw, rawValues, count * sizeof(uint16_t));
+	updateTimer();
+	portEXIT_CRITICAL(&mux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::updateTimer(void)
+//
+// called with the mux held. The poll rate is the highest of the armed
+// counters, the timer stops when none is armed.
+
+void qcCompare::updateTimer(void)
+{
+	uint32_t rate = 0;
+	uint8_t  channel = 0;
+
+	for (channel = 0; channel <= QC_MAX_CHANNEL; channel++)
+	{
+		if (results[channel].armed && (pollRates[channel] > rate))
+		{
+			rate = pollRates[channel];
+		}
+	}
+
+	if (rate == 0)
+	{
+		timerAlarmDisable(timer);
+	}
+	else if (rate != pollRate)
+	{
+		timerAlarmWrite(timer, 1000000UL / rate, true);
+		timerAlarmEnable(timer);
+	}
+	else
+	{
+		timerAlarmEnable(timer);
+	}
+
+	pollRate = rate;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool qcCompare::arm(uint8_t channel, const compare_action_t *action, uint32_t pollRate)
+//
+// target is a counter value at the configured counter width, not a 64 bit
+// position. Rearming replaces the actions and discards the last result.
+// Returns false on an invalid action or an action without its device.
+
+bool qcCompare::arm(uint8_t channel, const compare_action_t *action, uint32_t pollRate)
+{
+	uint8_t mdrValue = 0;
+
+	if ((channel > QC_MAX_CHANNEL) || (pollRate == 0) || (pollRate > COMPARE_MAX_POLL_RATE_HZ) ||
+		((action->pulseMask >> numPulseChannels) != 0))
+	{
+		return false;
+	}
+
+	if ((action->dioBit != COMPARE_NO_DIO_BIT) &&
+		((digitalIo == nullptr) || (action->dioBit < 0) || (action->dioBit >= N_OUTPUT_BITS)))
+	{
+		return false;
+	}
+
+	if (((action->adcMask != 0) && (adc == nullptr)) || (action->triggerCapture && (capture == nullptr)))
+	{
+		return false;
+	}
+
+	disarm(channel);
+
+	qc->writeDataRegister(channel, action->target);
+	mdrValue = qc->readModeRegister(channel, QC_MODE_REGISTER_1);
+	qc->writeModeRegister(channel, QC_MODE_REGISTER_1, mdrValue | FLAG_ON_CMP);
+	qc->clearStatusRegister(channel);
+
+	portENTER_CRITICAL(&mux);
+	actions[channel]   = *action;
+	pollRates[channel] = pollRate;
+	memset(&results[channel], 0, sizeof(compare_result_t));
+	results[channel].armed = true;
+	updateTimer();
+	portEXIT_CRITICAL(&mux);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qcCompare::disarm(uint8_t channel)
+//
+// the result of a compare that fired stays readable
+
+void qcCompare::disarm(uint8_t channel)
+{
+	if (channel > QC_MAX_CHANNEL)
+	{
+		return;
+	}
+
+	portENTER_CRITICAL(&mux);
+	results[channel].armed = false;
+	updateTimer();
+	portEXIT_CRITICAL(&mux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool qcCompare::read(uint8_t channel, compare_action_t *action, compare_result_t *result)
+
+bool qcCompare::read(uint8_t channel, compare_action_t *action, compare_result_t *result)
+{
+	if (channel > QC_MAX_CHANNEL)
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	*action = actions[channel];
+	*result = results[channel];
+	portEXIT_CRITICAL(&mux);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getters
+
+uint32_t qcCompare::getPollRate(void)
+{
+	return pollRate;
+}
+
+uint32_t qcCompare::getPolls(void)
+{
+	return polls;
+}
+
+uint32_t qcCompare::getMissedPolls(void)
+{
+	return missedPolls;
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// CompareLib.h
+//
+// position compare on the LS7366R counters: a target count is written to DTR,
+// the counter latches CMP in STR when CNTR equals DTR and the poll task runs
+// the bound actions on the device: halt pulse channels, drive a DIO output,
+// convert ADC channels and trigger an armed ADC capture. A compare fires once
+// and has to be armed again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef COMPARELIB_H
+#define COMPARELIB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "qc_7366_lib.h"
+#include "pulse_lib.h"
+#include "dio_lib.h"
+#include "adc_3208_lib.h"
+#include "capture_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define COMPARE_MAX_POLL_RATE_HZ	10000		// max. STR polls per second per armed counter
+#define COMPARE_DEFAULT_POLL_RATE_HZ	2000
+#define COMPARE_TIMER_NUMBER		2			// hardware timer used for the poll clock
+#define COMPARE_TIMER_DIVIDER		80			// 80 MHz APB clock / 80 = 1 us timer ticks
+
+// above the ADC sampler, a compare hit must not wait for a scan
+
+#define COMPARE_TASK_PRIORITY		(configMAX_PRIORITIES - 2)
+
+#define COMPARE_NO_DIO_BIT			-1
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	int32_t  target;					// count at which the compare fires
+	uint8_t  pulseMask;					// bit n set = halt pulse channel n
+	int8_t   dioBit;					// DIO output bit, COMPARE_NO_DIO_BIT = none
+	bool     dioLevel;					// level the DIO bit is driven to
+	uint8_t  adcMask;					// bit n set = convert ADC channel n
+	bool     triggerCapture;			// force the trigger of an armed ADC capture
+} compare_action_t;
+
+typedef struct
+{
+	bool     armed;
+	bool     fired;
+	int32_t  count;						// counter at detection, past target by the poll latency
+	uint32_t timestampUs;				// esp_timer at detection
+	uint32_t latencyUs;					// detection to the last action done
+	uint16_t adcRaw[N_ADC_CHANNELS];	// in channel order, adcMask channels only
+} compare_result_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class qcCompare {
+public:
+	void init(qc7366 *qc, PulseLib *pulseChannels, uint8_t numPulseChannels,
+			  dio *digitalIo = nullptr, adc3208 *adc = nullptr, adcCapture *capture = nullptr);
+
+	bool arm(uint8_t channel, const compare_action_t *action, uint32_t pollRate = COMPARE_DEFAULT_POLL_RATE_HZ);
+	void disarm(uint8_t channel);
+	bool read(uint8_t channel, compare_action_t *action, compare_result_t *result);
+
+	uint32_t getPollRate(void);
+	uint32_t getPolls(void);
+	uint32_t getMissedPolls(void);
+
+private:
+	static void IRAM_ATTR onTimer(void);
+	static void pollTask(void *parameter);
+	void poll(uint32_t ticks);
+	void fire(uint8_t channel);
+	void updateTimer(void);
+
+	qc7366 *qc;
+	PulseLib *pulseChannels;
+	uint8_t numPulseChannels = 0;
+	dio *digitalIo;
+	adc3208 *adc;
+	adcCapture *capture;
+
+	hw_timer_t *timer = nullptr;
+	TaskHandle_t taskHandle = nullptr;
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+	compare_action_t actions[QC_N_CHANNELS];
+	compare_result_t results[QC_N_CHANNELS];
+	uint32_t pollRates[QC_N_CHANNELS];
+	uint32_t pollRate = 0;
+	uint32_t polls = 0;
+	uint32_t missedPolls = 0;
+
+	static qcCompare *instance;
+};
+
+#endif	// COMPARELIB_H
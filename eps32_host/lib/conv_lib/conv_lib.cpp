@@ -0,0 +1,169 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// ConvLib.cpp
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <math.h>
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "conv_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// the init functions run once per (re)calibration, so they may use double
+
+#define UV_PER_VOLT		1e6
+
+///////////////////////////////////////////////////////////////////////////////
+// void convDefaultCalibration(conv_calibration_t *calibration)
+
+void convDefaultCalibration(conv_calibration_t *calibration)
+{
+	memset(calibration, 0, sizeof(conv_calibration_t));
+	calibration->gain   = 1.0f;
+	calibration->offset = 0.0f;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// static void convGainOffset(const conv_calibration_t *calibration, float *gain, float *offset)
+//
+// a calibration outside the gain & offset limits is ignored
+
+static void convGainOffset(const conv_calibration_t *calibration, float *gain, float *offset)
+{
+	*gain   = 1.0f;
+	*offset = 0.0f;
+
+	if ((calibration != nullptr) &&
+		(calibration->gain >= CONV_MIN_GAIN) && (calibration->gain <= CONV_MAX_GAIN) &&
+		(calibration->offset >= -CONV_MAX_OFFSET) && (calibration->offset <= CONV_MAX_OFFSET))
+	{
+		*gain   = calibration->gain;
+		*offset = calibration->offset;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// static void convInitPwl(conv_pwl_t *pwl, const conv_calibration_t *calibration)
+//
+// an invalid correction (too many points, not ascending, beyond
+// CONV_PWL_MAX_UV) is dropped
+
+static void convInitPwl(conv_pwl_t *pwl, const conv_calibration_t *calibration)
+{
+	uint8_t ix = 0;
+
+	memset(pwl, 0, sizeof(conv_pwl_t));
+
+	if ((calibration == nullptr) || (calibration->pwl.numPoints > CONV_PWL_POINTS))
+	{
+		return;
+	}
+
+	for (ix = 0; ix < calibration->pwl.numPoints; ix++)
+	{
+		if ((calibration->pwl.pointUv[ix] < -CONV_PWL_MAX_UV) || (calibration->pwl.pointUv[ix] > CONV_PWL_MAX_UV) ||
+			(calibration->pwl.correctionUv[ix] < -CONV_PWL_MAX_UV) || (calibration->pwl.correctionUv[ix] > CONV_PWL_MAX_UV) ||
+			((ix > 0) && (calibration->pwl.pointUv[ix] <= calibration->pwl.pointUv[ix - 1])))
+		{
+			return;
+		}
+	}
+
+	*pwl = calibration->pwl;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void convInitRawToUv(conv_raw_to_uv_t *conv, float minVoltage, float resolution,
+//						const conv_calibration_t *calibration)
+
+void convInitRawToUv(conv_raw_to_uv_t *conv, float minVoltage, float resolution,
+					 const conv_calibration_t *calibration)
+{
+	float gain   = 1.0f;
+	float offset = 0.0f;
+
+	convGainOffset(calibration, &gain, &offset);
+
+	conv->offsetUv = (int32_t)lround(((double)gain * minVoltage + offset) * UV_PER_VOLT);
+	conv->scaleQ16 = (int32_t)lround((double)gain * resolution * UV_PER_VOLT * (1UL << CONV_SCALE_SHIFT));
+	convInitPwl(&conv->pwl, calibration);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void convInitUvToRaw(conv_uv_to_raw_t *conv, float minVoltage, float resolution,
+//						uint16_t maxValue, const conv_calibration_t *calibration)
+
+void convInitUvToRaw(conv_uv_to_raw_t *conv, float minVoltage, float resolution, uint16_t maxValue,
+					 const conv_calibration_t *calibration)
+{
+	float gain   = 1.0f;
+	float offset = 0.0f;
+
+	convGainOffset(calibration, &gain, &offset);
+
+	conv->offsetUv        = (int32_t)lround(((double)gain * minVoltage + offset) * UV_PER_VOLT);
+	conv->inverseScaleQ36 = (uint32_t)lround(ldexp(1.0, CONV_INVERSE_SHIFT) / ((double)gain * resolution * UV_PER_VOLT));
+	conv->maxValue        = maxValue;
+	convInitPwl(&conv->pwl, calibration);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int32_t convPwlCorrection(const conv_pwl_t *pwl, int32_t microVolt)
+
+int32_t convPwlCorrection(const conv_pwl_t *pwl, int32_t microVolt)
+{
+	uint8_t ix = 0;
+	int64_t deltaCorrection = 0;
+	int64_t deltaPoint = 0;
+
+	if (pwl->numPoints == 0)
+	{
+		return 0;
+	}
+
+	if (microVolt <= pwl->pointUv[0])
+	{
+		return pwl->correctionUv[0];
+	}
+
+	for (ix = 1; ix < pwl->numPoints; ix++)
+	{
+		if (microVolt < pwl->pointUv[ix])
+		{
+			// the differences of two int32 values need 33 bits
+			deltaCorrection = ((int64_t)pwl->correctionUv[ix] - pwl->correctionUv[ix - 1]) *
+							  ((int64_t)microVolt - pwl->pointUv[ix - 1]);
+			deltaPoint      = (int64_t)pwl->pointUv[ix] - pwl->pointUv[ix - 1];
+			return pwl->correctionUv[ix - 1] + (int32_t)(deltaCorrection / deltaPoint);
+		}
+	}
+
+	return pwl->correctionUv[pwl->numPoints - 1];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int32_t convVoltToUv(float voltage)
+//
+// single precision is exact to ~1 uV over the +/- 10 volt range, the clamp
+// keeps out of range requests within 32 bits
+
+int32_t convVoltToUv(float voltage)
+{
+	if (voltage > 2000.0f)
+	{
+		voltage = 2000.0f;
+	}
+	else if (voltage < -2000.0f)
+	{
+		voltage = -2000.0f;
+	}
+
+	return (int32_t)lroundf(voltage * 1e6f);
+}
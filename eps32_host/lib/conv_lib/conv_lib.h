@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// ConvLib.h
+//
+// fixed point conversion between ADC/DAC codes and voltages in microvolt
+//
+// The ESP32 has a single precision FPU only, double math is done in software.
+// Every channel gets a precomputed offset & scale so a conversion is one
+// 32x32->64 bit multiply, a shift and an add.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CONVLIB_H
+#define CONVLIB_H
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define CONV_SCALE_SHIFT	16		// raw -> uV scale is Q16
+#define CONV_SCALE_ROUND	(1L << (CONV_SCALE_SHIFT - 1))
+#define CONV_INVERSE_SHIFT	36		// uV -> raw scale is Q36, Q32 rounds 1 LSB
+									// low just above a half code
+#define CONV_INVERSE_ROUND	(1LL << (CONV_INVERSE_SHIFT - 1))
+
+#define CONV_MIN_GAIN		0.5f	// calibration gain limits, keeps the
+#define CONV_MAX_GAIN		2.0f	// Q16 scale within 32 bits
+#define CONV_MAX_OFFSET		20.0f	// calibration offset limit in volt, the
+									// span of the widest channel
+
+#define CONV_PWL_MAX_UV		20000000	// limit of the PWL points & corrections,
+										// keeps the interpolation within 64 bits
+
+#define CONV_PWL_POINTS		8		// max. points of the piecewise linear correction
+
+#define CONV_FRACTION_SHIFT	8		// fraction bits of a filtered/averaged raw value
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+// piecewise linear correction on top of gain & offset: correctionUv[i] is
+// added at pointUv[i] (ascending), linear in between, constant outside
+
+typedef struct
+{
+	uint8_t numPoints;
+	int32_t pointUv[CONV_PWL_POINTS];
+	int32_t correctionUv[CONV_PWL_POINTS];
+} conv_pwl_t;
+
+// calibration of one channel: Vcorrected = gain * Videal + offset + pwl(V)
+
+typedef struct
+{
+	float      gain;
+	float      offset;				// volt
+	conv_pwl_t pwl;
+} conv_calibration_t;
+
+// raw -> voltage: uV = offsetUv + round((raw * scaleQ16) >> 16) + pwl
+
+typedef struct
+{
+	int32_t    offsetUv;
+	int32_t    scaleQ16;
+	conv_pwl_t pwl;
+} conv_raw_to_uv_t;
+
+// voltage -> raw: raw = round(((uV - pwl - offsetUv) * inverseScaleQ36) >> 36)
+// rounds to the nearest code, the fmap() path it replaced truncated
+
+typedef struct
+{
+	int32_t    offsetUv;
+	uint32_t   inverseScaleQ36;
+	uint16_t   maxValue;
+	conv_pwl_t pwl;
+} conv_uv_to_raw_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+//
+// minVoltage & resolution are the ideal values from config.h, calibration
+// may be nullptr for the ideal conversion
+
+void convInitRawToUv(conv_raw_to_uv_t *conv, float minVoltage, float resolution,
+					 const conv_calibration_t *calibration = nullptr);
+void convInitUvToRaw(conv_uv_to_raw_t *conv, float minVoltage, float resolution, uint16_t maxValue,
+					 const conv_calibration_t *calibration = nullptr);
+void convDefaultCalibration(conv_calibration_t *calibration);
+
+int32_t convPwlCorrection(const conv_pwl_t *pwl, int32_t microVolt);
+int32_t convVoltToUv(float voltage);
+
+///////////////////////////////////////////////////////////////////////////////
+// inline single sample kernels
+
+static inline int32_t convRawToUv(const conv_raw_to_uv_t *conv, uint16_t raw)
+{
+	int32_t microVolt = conv->offsetUv + (int32_t)(((int64_t)raw * conv->scaleQ16 + CONV_SCALE_ROUND) >> CONV_SCALE_SHIFT);
+
+	if (conv->pwl.numPoints != 0)
+	{
+		microVolt += convPwlCorrection(&conv->pwl, microVolt);
+	}
+
+	return microVolt;
+}
+
+// raw value with CONV_FRACTION_SHIFT fraction bits, the extra resolution of
+// an averaged value is kept in the result
+
+static inline int32_t convRawQ8ToUv(const conv_raw_to_uv_t *conv, int32_t rawQ8)
+{
+	int32_t microVolt = conv->offsetUv +
+		(int32_t)(((int64_t)rawQ8 * conv->scaleQ16 + (CONV_SCALE_ROUND << CONV_FRACTION_SHIFT)) >> (CONV_SCALE_SHIFT + CONV_FRACTION_SHIFT));
+
+	if (conv->pwl.numPoints != 0)
+	{
+		microVolt += convPwlCorrection(&conv->pwl, microVolt);
+	}
+
+	return microVolt;
+}
+
+static inline uint16_t convUvToRaw(const conv_uv_to_raw_t *conv, int32_t microVolt)
+{
+	if (conv->pwl.numPoints != 0)
+	{
+		microVolt -= convPwlCorrection(&conv->pwl, microVolt);
+	}
+
+	int64_t raw = (((int64_t)microVolt - conv->offsetUv) * conv->inverseScaleQ36 + CONV_INVERSE_ROUND) >> CONV_INVERSE_SHIFT;
+
+	if (raw < 0)
+	{
+		raw = 0;
+	}
+	else if (raw > conv->maxValue)
+	{
+		raw = conv->maxValue;
+	}
+
+	return (uint16_t)raw;
+}
+
+#endif	// CONVLIB_H
@@ -30,15 +30,39 @@
 void dac4922::init(spi *spi_bus)
 {
 	this->spi_bus = spi_bus;
+
+	invalidateShadow();
+	memset(&shadowStats, 0, sizeof(shadowStats));
+
+#if defined DAC_LDAC_PIN
+	pinMode(DAC_LDAC_PIN, OUTPUT);
+	digitalWrite(DAC_LDAC_PIN, HIGH);
+#endif
+
 	// init the DAC chips the first time by writing any value - use zero volts
 	float outputVoltage = 0.0;
 	
 	for (uint8_t channel = 0; channel < N_DAC_CHANNELS; channel++)
 	{
+		setCalibration(channel, nullptr);
 		setOutputVoltage(channel, outputVoltage);
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::setCalibration(uint8_t dacChannel, const conv_calibration_t *calibration)
+//
+// rebuilds the fixed point conversion of a channel, the calibration describes
+// the measured output: Vout = gain * Videal + offset + pwl, nullptr = ideal
+
+void dac4922::setCalibration(uint8_t dacChannel, const conv_calibration_t *calibration)
+{
+	if (dacChannel < N_DAC_CHANNELS)
+	{
+		convInitUvToRaw(&conversion[dacChannel], DAC_MIN_VOLTAGE, DAC_RESOLUTION, DAC_MAX_VALUE, calibration);
+	}
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // void dac4922::SelectSPIDevice(uint8_t dacChannel)
@@ -60,60 +84,244 @@ void dac4922::selectSPIDevice(uint8_t dacChannel)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dac4922::write(uint8_t dacChannel, uint16_t dacValue)
+// void dac4922::latchOutputs(void)
+//
+// pulse LDAC* to move the input registers of both chips to the outputs
 
-void dac4922::write(uint8_t dacChannel, uint16_t dacValue)
+void dac4922::latchOutputs(void)
+{
+#if defined DAC_LDAC_PIN
+	digitalWrite(DAC_LDAC_PIN, LOW);
+	digitalWrite(DAC_LDAC_PIN, HIGH);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t dac4922::buildCommand(uint8_t dacChannel, uint16_t dacValue)
+
+uint16_t dac4922::buildCommand(uint8_t dacChannel, uint16_t dacValue)
 {
 	uint16_t dacCommand = 0;
 
-	if (dacChannel < N_DAC_CHANNELS)
+	dacCommand  = dacValue & 0xfff; // only 12 bits allowed for DAC value
+	dacCommand |= DAC_VREF_BUFFERED | DAC_GAINSELECT_1 | DAC_POWER_ON;
+
+	if ((dacChannel == 1) || (dacChannel == 3) ) // channnel 1 or 3 => B channel of MCP4922
 	{
-		dacCommand  = dacValue & 0xfff; // only 12 bits allowed for DAC value
-		dacCommand |= DAC_VREF_BUFFERED | DAC_GAINSELECT_1 | DAC_POWER_ON;
+		dacCommand = dacCommand | DAC_SELECT_B;
+	}
 
-		if ((dacChannel == 1) || (dacChannel == 3) ) // channnel 1 or 3 => B channel of MCP4922
-		{
-			dacCommand = dacCommand | DAC_SELECT_B;
-		}
+	return dacCommand;
+}
 
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::write(uint8_t dacChannel, uint16_t dacValue)
+
+void dac4922::write(uint8_t dacChannel, uint16_t dacValue)
+{
+	if (dacChannel < N_DAC_CHANNELS)
+	{
 		spi_bus->beginTransaction(DACSPISettings);
 		dac4922::selectSPIDevice(dacChannel);
 
-		spi_bus->writeWord(dacCommand);
+		spi_bus->writeWord(buildCommand(dacChannel, dacValue));
 
 		spi_bus->deselectDevice(); // DEselect DAC channel: cause CSDAC* to go high!!
+
+		shadowValue[dacChannel] = dacValue;
+		shadowValidMask |= (1 << dacChannel);
+
 		spi_bus->endTransaction();
+
+		latchOutputs();
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dac4922::SetOutputVoltage(uint8_t dacChannel, float outputVoltage)
+// void dac4922::writeChannels(const uint16_t dacValues[N_DAC_CHANNELS], uint8_t channelMask)
+//
+// writes the channels in channelMask in a single SPI transaction, every word
+// still needs its own CS* frame. With LDAC* wired the outputs change together.
+// The shadow is updated inside the transaction, the bus lock orders it with
+// the writes of the waveform task.
+
+void dac4922::writeChannels(const uint16_t dacValues[N_DAC_CHANNELS], uint8_t channelMask)
+{
+	uint8_t channel = 0;
+
+	spi_bus->beginTransaction(DACSPISettings);
+
+	for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+	{
+		if ((channelMask & (1 << channel)) != 0)
+		{
+			dac4922::selectSPIDevice(channel);
+			spi_bus->writeWord(buildCommand(channel, dacValues[channel]));
+			spi_bus->deselectDevice();
+
+			shadowValue[channel] = dacValues[channel];
+		}
+	}
+
+	shadowValidMask |= channelMask;
+
+	spi_bus->endTransaction();
+
+	latchOutputs();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::writeAll(const uint16_t dacValues[N_DAC_CHANNELS])
+
+void dac4922::writeAll(const uint16_t dacValues[N_DAC_CHANNELS])
+{
+	writeChannels(dacValues, (1 << N_DAC_CHANNELS) - 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::update(uint8_t dacChannel, uint16_t dacValue, bool force)
+//
+// write() unless the channel already outputs dacValue
+
+void dac4922::update(uint8_t dacChannel, uint16_t dacValue, bool force)
+{
+	if (dacChannel >= N_DAC_CHANNELS)
+	{
+		return;
+	}
+
+	if (!force && ((shadowValidMask & (1 << dacChannel)) != 0) && (shadowValue[dacChannel] == dacValue))
+	{
+		shadowStats.hits++;
+		return;
+	}
+
+	shadowStats.misses++;
+	write(dacChannel, dacValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::updateAll(const uint16_t dacValues[N_DAC_CHANNELS], bool force)
+//
+// only the channels that change are written, still in one transaction
+
+void dac4922::updateAll(const uint16_t dacValues[N_DAC_CHANNELS], bool force)
+{
+	uint8_t channel = 0;
+	uint8_t channelMask = 0;
+
+	for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+	{
+		if (force || ((shadowValidMask & (1 << channel)) == 0) || (shadowValue[channel] != dacValues[channel]))
+		{
+			channelMask |= (1 << channel);
+			shadowStats.misses++;
+		}
+		else
+		{
+			shadowStats.hits++;
+		}
+	}
+
+	if (channelMask != 0)
+	{
+		writeChannels(dacValues, channelMask);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::invalidateShadow(void)
+//
+// the next update of every channel goes to the chip
+
+void dac4922::invalidateShadow(void)
+{
+	shadowValidMask = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::getShadowStats(shadow_stats_t *stats, bool reset)
+
+void dac4922::getShadowStats(shadow_stats_t *stats, bool reset)
+{
+	*stats = shadowStats;
+
+	if (reset)
+	{
+		memset(&shadowStats, 0, sizeof(shadowStats));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t dac4922::microvoltToValue(uint8_t dacChannel, int32_t microVolt)
+
+uint16_t dac4922::microvoltToValue(uint8_t dacChannel, int32_t microVolt)
+{
+	uint16_t dacValue = 0;
+
+	if (dacChannel < N_DAC_CHANNELS)
+	{
+		dacValue = convUvToRaw(&conversion[dacChannel], microVolt);
+	}
+
+	return dacValue;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t dac4922::voltageToValue(uint8_t dacChannel, float outputVoltage)
+
+uint16_t dac4922::voltageToValue(uint8_t dacChannel, float outputVoltage)
+{
+	return microvoltToValue(dacChannel, convVoltToUv(outputVoltage));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::SetOutputVoltage(uint8_t dacChannel, float outputVoltage, bool force)
 //
 // Vout = -10 + 8*Vdac
 
-void dac4922::setOutputVoltage(uint8_t dacChannel, float outputVoltage)
+void dac4922::setOutputVoltage(uint8_t dacChannel, float outputVoltage, bool force)
 {
-	float dacValue = 0.0;
-	
-	outputVoltage = constrain(outputVoltage, DAC_MIN_VOLTAGE, DAC_MAX_VOLTAGE);
-	
-	dacValue = fmap(outputVoltage,	DAC_MIN_VOLTAGE, DAC_MAX_VOLTAGE, 
-	 								DAC_MIN_VALUE, DAC_MAX_VALUE);	
+	uint16_t dacValue = 0;
+
+	dacValue = voltageToValue(dacChannel, outputVoltage);
 
-	// SerialPrintf("DAC value channel %d = %d\n", dacChannel, (uint16_t)(dacValue));
+	// SerialPrintf("DAC value channel %d = %d\n", dacChannel, dacValue);
 
-	write(dacChannel, (uint16_t)dacValue);
+	update(dacChannel, dacValue, force);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dac4922::SetOutputVoltageAll(float outputVoltage)
+// void dac4922::SetOutputVoltageAll(float outputVoltage, bool force)
 
-void dac4922::setOutputVoltageAll(float outputVoltage)
+void dac4922::setOutputVoltageAll(float outputVoltage, bool force)
 {
+	uint16_t dacValues[N_DAC_CHANNELS];
+	int32_t microVolt = 0;
 	uint8_t channel = 0;
 
+	microVolt = convVoltToUv(outputVoltage);
+
 	for (channel = 0; channel <= DAC_MAX_CHANNEL; channel++)
 	{
-		setOutputVoltage(channel, outputVoltage);
+		dacValues[channel] = microvoltToValue(channel, microVolt);
+	}
+
+	updateAll(dacValues, force);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dac4922::setOutputVoltages(const float outputVoltages[N_DAC_CHANNELS], bool force)
+
+void dac4922::setOutputVoltages(const float outputVoltages[N_DAC_CHANNELS], bool force)
+{
+	uint16_t dacValues[N_DAC_CHANNELS];
+	uint8_t channel = 0;
+
+	for (channel = 0; channel <= DAC_MAX_CHANNEL; channel++)
+	{
+		dacValues[channel] = voltageToValue(channel, outputVoltages[channel]);
 	}
+
+	updateAll(dacValues, force);
 }
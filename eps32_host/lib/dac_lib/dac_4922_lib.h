@@ -13,7 +13,8 @@
 #include <SPI.h>
 #include "spi_lib.h"
 #include "../config.h"
-#include "fmap.h"
+#include "conv_lib.h"
+#include "shadow_lib.h"
 #include "../bits.h"
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,6 +38,15 @@
 
 #define SPI_DAC_SPEED	10000000
 
+///////////////////////////////////////////////////////////////////////////////
+// LDAC* pin of the MCP4922's
+//
+// Define DAC_LDAC_PIN (build_flags) when LDAC* is wired to a GPIO. Writes then
+// only load the input registers and all outputs change together on the LDAC*
+// pulse. Without it LDAC* is tied low and each output follows its own CS*.
+
+//#define DAC_LDAC_PIN		GPIO_NUM_4
+
 ///////////////////////////////////////////////////////////////////////////////
 // function prototypes
 
@@ -44,12 +54,34 @@ class dac4922{
 public:
     void init(spi *spi_bus);
     void write(uint8_t dacChannel, uint16_t dacValue);
-    void setOutputVoltage(uint8_t dacChannel, float outputVoltage);
-    void setOutputVoltageAll(float outputVoltage);
+    void setOutputVoltage(uint8_t dacChannel, float outputVoltage, bool force = false);
+    void setOutputVoltageAll(float outputVoltage, bool force = false);
+    void writeAll(const uint16_t dacValues[N_DAC_CHANNELS]);
+    void writeChannels(const uint16_t dacValues[N_DAC_CHANNELS], uint8_t channelMask);
+    void setOutputVoltages(const float outputVoltages[N_DAC_CHANNELS], bool force = false);
+
+    void update(uint8_t dacChannel, uint16_t dacValue, bool force = false);
+    void updateAll(const uint16_t dacValues[N_DAC_CHANNELS], bool force = false);
+    void invalidateShadow(void);
+    void getShadowStats(shadow_stats_t *stats, bool reset);
+
+    uint16_t voltageToValue(uint8_t dacChannel, float outputVoltage);
+    uint16_t microvoltToValue(uint8_t dacChannel, int32_t microVolt);
+    void setCalibration(uint8_t dacChannel, const conv_calibration_t *calibration);
+
+    static uint16_t buildCommand(uint8_t dacChannel, uint16_t dacValue);
 private:
     void selectSPIDevice(uint8_t dacChannel);
+    void latchOutputs(void);
     spi *spi_bus;
     SPISettings DACSPISettings = SPISettings(SPI_DAC_SPEED, MSBFIRST, SPI_MODE0);
+    conv_uv_to_raw_t conversion[N_DAC_CHANNELS];
+
+    // last code written per channel, write() & writeAll() always refresh it
+    // while they hold the SPI bus
+    uint16_t shadowValue[N_DAC_CHANNELS];
+    uint8_t  shadowValidMask;
+    shadow_stats_t shadowStats;
 };
 
 #endif  // DAC4922_H
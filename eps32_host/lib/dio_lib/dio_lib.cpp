@@ -10,7 +10,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 // system #includes
 
-
+#include <string.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // application #includes
@@ -21,33 +21,131 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 // void dio::Init(void)
+//
+// builds the port & mask of every bit so getInput() and setOutput() access
+// each GPIO port register only once
 
 void dio::init(void)
 {
 	uint8_t pin = 0;
 
+	memset(inputPortMask, 0, sizeof(inputPortMask));
+
 	for (pin = 0; pin < N_INPUT_BITS; pin++)
 	{
 		pinMode(InputPins[pin], INPUT_PULLDOWN); 
+
+		inputPort[pin] = GPIO_PORT(InputPins[pin]);
+		inputMask[pin] = GPIO_MASK(InputPins[pin]);
+		inputPortMask[inputPort[pin]] |= inputMask[pin];
 	}
 
 	for (pin = 0; pin < N_OUTPUT_BITS; pin++)
 	{
 		pinMode(OutputPins[pin], OUTPUT); 
+
+		outputPort[pin] = GPIO_PORT(OutputPins[pin]);
+		outputMask[pin] = GPIO_MASK(OutputPins[pin]);
+	}
+
+	invalidateShadow();
+	memset(&shadowStats, 0, sizeof(shadowStats));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dio::invalidateShadow(void)
+//
+// reloads the shadow from the GPIO output latches
+
+void dio::invalidateShadow(void)
+{
+	uint8_t  bitNr = 0;
+	uint8_t  value = 0;
+	uint32_t port[N_GPIO_PORTS];
+
+	portENTER_CRITICAL(&shadowMux);
+
+	port[0] = GPIO.out;
+	port[1] = GPIO.out1.val;
+
+	for (bitNr = 0; bitNr < N_OUTPUT_BITS; bitNr++)
+	{
+		if ((port[outputPort[bitNr]] & outputMask[bitNr]) != 0)
+		{
+			value |= (0x01 << bitNr);
+		}
+	}
+	outputShadow = value;
+
+	portEXIT_CRITICAL(&shadowMux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dio::getShadowStats(shadow_stats_t *stats, bool reset)
+
+void dio::getShadowStats(shadow_stats_t *stats, bool reset)
+{
+	*stats = shadowStats;
+
+	if (reset)
+	{
+		memset(&shadowStats, 0, sizeof(shadowStats));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dio::readInputPorts(uint32_t port[N_GPIO_PORTS])
+//
+// snapshot of the input registers, only ports with input bits are read
+
+void dio::readInputPorts(uint32_t port[N_GPIO_PORTS])
+{
+	port[0] = (inputPortMask[0] != 0) ? GPIO.in : 0;
+	port[1] = (inputPortMask[1] != 0) ? GPIO.in1.val : 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dio::writeOutputPorts(const uint32_t setMask[N_GPIO_PORTS],
+//							  const uint32_t clearMask[N_GPIO_PORTS])
+//
+// one write-1-to-set & one write-1-to-clear per port, no read-modify-write
+
+void dio::writeOutputPorts(const uint32_t setMask[N_GPIO_PORTS], const uint32_t clearMask[N_GPIO_PORTS])
+{
+	if (setMask[0] != 0)
+	{
+		GPIO.out_w1ts = setMask[0];
+	}
+	if (clearMask[0] != 0)
+	{
+		GPIO.out_w1tc = clearMask[0];
+	}
+	if (setMask[1] != 0)
+	{
+		GPIO.out1_w1ts.val = setMask[1];
+	}
+	if (clearMask[1] != 0)
+	{
+		GPIO.out1_w1tc.val = clearMask[1];
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // uint8_t dio::GetInput(void)
+//
+// all bits come from the same register snapshot
 
 uint8_t dio::getInput(void)
 {
-	uint8_t value = 0;
-	uint8_t bitNr = 0;
+	uint8_t  value = 0;
+	uint8_t  bitNr = 0;
+	uint32_t port[N_GPIO_PORTS];
+
+	readInputPorts(port);
 
 	for (bitNr = 0; bitNr < N_INPUT_BITS; bitNr++)
 	{
-		if (digitalRead(InputPins[bitNr]) == HIGH)
+		if ((port[inputPort[bitNr]] & inputMask[bitNr]) != 0)
 		{
 			value = value | (0x01 << bitNr);
 		}
@@ -74,69 +172,150 @@ bool dio::isValidBitNumber(uint8_t bitNumber)
 bool dio::isBitSet(uint8_t bitNumber)
 {
 	bool isBitSet = false;
+	uint32_t port[N_GPIO_PORTS];
 
 	if (isValidBitNumber(bitNumber))
 	{
-		isBitSet = (digitalRead(bitNumber) == HIGH);
+		readInputPorts(port);
+		isBitSet = ((port[inputPort[bitNumber]] & inputMask[bitNumber]) != 0);
 	}
 	
 	return isBitSet;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dio::SetOutput(uint8_t value)
+// void dio::SetOutput(uint8_t value, bool force)
+//
+// all changed outputs change within one port write (set) and the next
+// (clear), bits that already have their level are not written
 
-void dio::setOutput(uint8_t value)
+void dio::setOutput(uint8_t value, bool force)
 {
-	uint8_t bitNr = 0;
-	uint8_t bitOn = LOW;
+	uint8_t  bitNr = 0;
+	uint8_t  changed = (1 << N_OUTPUT_BITS) - 1;
+	uint32_t setMask[N_GPIO_PORTS]   = {0, 0};
+	uint32_t clearMask[N_GPIO_PORTS] = {0, 0};
+
+	value &= (1 << N_OUTPUT_BITS) - 1;
+
+	portENTER_CRITICAL(&shadowMux);
+
+	if (!force)
+	{
+		changed = value ^ outputShadow;
+
+		if (changed == 0)
+		{
+			shadowStats.hits++;
+			portEXIT_CRITICAL(&shadowMux);
+			return;
+		}
+	}
 
 	for(bitNr = 0; bitNr < N_OUTPUT_BITS; bitNr++)
 	{
+		if ((changed & (0x01 << bitNr)) == 0)
+		{
+			continue;
+		}
+
 		if ((value & (0x01 << bitNr)) != 0)
 		{
-			bitOn = HIGH;
+			setMask[outputPort[bitNr]] |= outputMask[bitNr];
 		}
 		else
 		{
-			bitOn = LOW;
+			clearMask[outputPort[bitNr]] |= outputMask[bitNr];
 		}
-		digitalWrite(OutputPins[bitNr], bitOn);
 	}
+
+	writeOutputPorts(setMask, clearMask);
+
+	outputShadow = value;
+	shadowStats.misses++;
+
+	portEXIT_CRITICAL(&shadowMux);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dio::setBit(uint8_t bitNumber)
+// void dio::setBit(uint8_t bitNumber, bool force)
 
-void dio::setBit(uint8_t bitNumber)
+void dio::setBit(uint8_t bitNumber, bool force)
 {
-
+	uint32_t setMask[N_GPIO_PORTS]   = {0, 0};
+	uint32_t clearMask[N_GPIO_PORTS] = {0, 0};
 
 	if (isValidBitNumber(bitNumber))
 	{
-		digitalWrite(OutputPins[bitNumber], HIGH);
+		portENTER_CRITICAL(&shadowMux);
+
+		if (!force && ((outputShadow & (0x01 << bitNumber)) != 0))
+		{
+			shadowStats.hits++;
+		}
+		else
+		{
+			setMask[outputPort[bitNumber]] = outputMask[bitNumber];
+			writeOutputPorts(setMask, clearMask);
+
+			outputShadow |= (0x01 << bitNumber);
+			shadowStats.misses++;
+		}
+
+		portEXIT_CRITICAL(&shadowMux);
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// void dio::clearBit(uint8_t bitNumber)
+// void dio::clearBit(uint8_t bitNumber, bool force)
 
-void dio::clearBit(uint8_t bitNumber)
+void dio::clearBit(uint8_t bitNumber, bool force)
 {
+	uint32_t setMask[N_GPIO_PORTS]   = {0, 0};
+	uint32_t clearMask[N_GPIO_PORTS] = {0, 0};
+
 	if (isValidBitNumber(bitNumber))
 	{
-		digitalWrite(OutputPins[bitNumber], LOW);
+		portENTER_CRITICAL(&shadowMux);
+
+		if (!force && ((outputShadow & (0x01 << bitNumber)) == 0))
+		{
+			shadowStats.hits++;
+		}
+		else
+		{
+			clearMask[outputPort[bitNumber]] = outputMask[bitNumber];
+			writeOutputPorts(setMask, clearMask);
+
+			outputShadow &= ~(0x01 << bitNumber);
+			shadowStats.misses++;
+		}
+
+		portEXIT_CRITICAL(&shadowMux);
 	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 // void dio::toggleBit(uint8_t bitNumber)
+//
+// the level comes from the output latch, the write always goes out
 
 void dio::toggleBit(uint8_t bitNumber)
 {
+	uint32_t outputLevel = 0;
+
 	if (isValidBitNumber(bitNumber))
 	{
-		digitalWrite(OutputPins[bitNumber], !digitalRead(OutputPins[bitNumber]));
+		outputLevel = (outputPort[bitNumber] == 0) ? GPIO.out : GPIO.out1.val;
+
+		if ((outputLevel & outputMask[bitNumber]) != 0)
+		{
+			clearBit(bitNumber, true);
+		}
+		else
+		{
+			setBit(bitNumber, true);
+		}
 	}
 }
 
@@ -17,12 +17,21 @@
 
 #include <inttypes.h>
 
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "shadow_lib.h"
+
 ///////////////////////////////////////////////////////////////////////////////
 // #define's
 
 #define N_INPUT_BITS	6
 #define N_OUTPUT_BITS	6
 
+#define N_GPIO_PORTS	2		// GPIO0..31 & GPIO32..39
+#define GPIO_PORT(gpio)	((gpio) >> 5)
+#define GPIO_MASK(gpio)	(1UL << ((gpio) & 0x1F))
+
 ///////////////////////////////////////////////////////////////////////////////
 // function prototypes
 
@@ -31,14 +40,33 @@ public:
     void init(void);
     uint8_t getInput(void);
     bool isBitSet(uint8_t bitNumber);
-    void setOutput(uint8_t value);
-    void setBit(uint8_t bitNumber);
-    void clearBit(uint8_t bitNumber);
+    void setOutput(uint8_t value, bool force = false);
+    void setBit(uint8_t bitNumber, bool force = false);
+    void clearBit(uint8_t bitNumber, bool force = false);
     void toggleBit(uint8_t bitNumber);
 
     int16_t getGPIONumberInput(uint8_t inputBitNumber);
+
+    void invalidateShadow(void);
+    void getShadowStats(shadow_stats_t *stats, bool reset);
 private:
     bool isValidBitNumber(uint8_t bitNumber);
+    void readInputPorts(uint32_t port[N_GPIO_PORTS]);
+    void writeOutputPorts(const uint32_t setMask[N_GPIO_PORTS], const uint32_t clearMask[N_GPIO_PORTS]);
+
+    // bit-gather tables, built by init()
+    uint8_t  inputPort[N_INPUT_BITS];
+    uint32_t inputMask[N_INPUT_BITS];
+    uint32_t inputPortMask[N_GPIO_PORTS];
+    uint8_t  outputPort[N_OUTPUT_BITS];
+    uint32_t outputMask[N_OUTPUT_BITS];
+
+    // output bits as last written, every write path keeps it up to date.
+    // The encoder compare writes bits from its own task, hence the lock.
+    uint8_t  outputShadow;
+    portMUX_TYPE shadowMux = portMUX_INITIALIZER_UNLOCKED;
+    shadow_stats_t shadowStats;
+
     const uint8_t InputPins[N_INPUT_BITS] =
     {
         GPIO_NUM_36,	// LSB, bit 0
@@ -0,0 +1,200 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// EventLib.cpp
+//
+// Every watched GPIO gets a CHANGE interrupt. The ISR samples the input
+// register and pushes {pin, level, timestamp} into a lock free ring buffer,
+// the RPC server drains it in bulk. A full buffer drops new events and counts
+// them, the oldest events are never overwritten.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "event_lib.h"
+#include "dio_lib.h"
+#include "gpio_irq_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// void inputEvents::init(void)
+
+void inputEvents::init(void)
+{
+	uint8_t ix = 0;
+
+	memset(pins, 0, sizeof(pins));
+
+	for (ix = 0; ix < INPUT_EVENTS_MAX_PINS; ix++)
+	{
+		pins[ix].owner = this;
+	}
+
+	head = 0;
+	tail = 0;
+	overflowCount = 0;
+	overflowBase = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void IRAM_ATTR inputEvents::onEdge(void *arg)
+
+void IRAM_ATTR inputEvents::onEdge(void *arg)
+{
+	input_event_pin_t *watched = (input_event_pin_t *)arg;
+	inputEvents *events = watched->owner;
+	uint32_t timestamp = micros();
+	uint32_t port = (GPIO_PORT(watched->pin) == 0) ? GPIO.in : GPIO.in1.val;
+	uint32_t head = events->head;
+
+	if ((head - events->tail) >= INPUT_EVENTS_BUFFER_SIZE)
+	{
+		events->overflowCount = events->overflowCount + 1;
+		return;
+	}
+
+	input_event_t *event = &events->buffer[head & INPUT_EVENTS_BUFFER_MASK];
+	event->timestampUs = timestamp;
+	event->pin         = watched->pin;
+	event->level       = ((port & GPIO_MASK(watched->pin)) != 0) ? HIGH : LOW;
+
+	// publish the event only after it is complete
+	__asm__ __volatile__("" ::: "memory");
+	events->head = head + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool inputEvents::enable(uint8_t pin)
+//
+// the pin mode is left as is, it is set by the owner of the pin. A pin whose
+// interrupt is owned by the pulse guard is refused.
+
+bool inputEvents::enable(uint8_t pin)
+{
+	uint8_t ix = 0;
+	input_event_pin_t *freeSlot = nullptr;
+
+	if (pin > INPUT_EVENTS_MAX_GPIO)
+	{
+		return false;
+	}
+
+	for (ix = 0; ix < INPUT_EVENTS_MAX_PINS; ix++)
+	{
+		if (pins[ix].active && (pins[ix].pin == pin))
+		{
+			return true;
+		}
+		if (!pins[ix].active && (freeSlot == nullptr))
+		{
+			freeSlot = &pins[ix];
+		}
+	}
+
+	if ((freeSlot == nullptr) || !gpioIrqClaim(pin, GPIO_IRQ_INPUT_EVENTS))
+	{
+		return false;
+	}
+
+	freeSlot->pin    = pin;
+	freeSlot->active = true;
+	attachInterruptArg(pin, onEdge, freeSlot, CHANGE);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool inputEvents::disable(uint8_t pin)
+
+bool inputEvents::disable(uint8_t pin)
+{
+	uint8_t ix = 0;
+
+	for (ix = 0; ix < INPUT_EVENTS_MAX_PINS; ix++)
+	{
+		if (pins[ix].active && (pins[ix].pin == pin))
+		{
+			detachInterrupt(pin);
+			gpioIrqRelease(pin, GPIO_IRQ_INPUT_EVENTS);
+			pins[ix].active = false;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void inputEvents::disableAll(void)
+
+void inputEvents::disableAll(void)
+{
+	uint8_t ix = 0;
+
+	for (ix = 0; ix < INPUT_EVENTS_MAX_PINS; ix++)
+	{
+		if (pins[ix].active)
+		{
+			detachInterrupt(pins[ix].pin);
+			gpioIrqRelease(pins[ix].pin, GPIO_IRQ_INPUT_EVENTS);
+			pins[ix].active = false;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t inputEvents::read(input_event_t events[], uint16_t maxEvents)
+//
+// returns the number of events copied, oldest first
+
+uint16_t inputEvents::read(input_event_t events[], uint16_t maxEvents)
+{
+	uint16_t count = 0;
+	uint32_t readIndex = tail;
+	uint32_t writeIndex = head;
+
+	while ((readIndex != writeIndex) && (count < maxEvents))
+	{
+		events[count++] = buffer[readIndex & INPUT_EVENTS_BUFFER_MASK];
+		readIndex++;
+	}
+
+	// release the slots only after they are copied
+	__asm__ __volatile__("" ::: "memory");
+	tail = readIndex;
+
+	return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t inputEvents::available(void)
+
+uint16_t inputEvents::available(void)
+{
+	return (uint16_t)(head - tail);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t inputEvents::getOverflowCount(void)
+//
+// events dropped since the last clear()
+
+uint32_t inputEvents::getOverflowCount(void)
+{
+	return overflowCount - overflowBase;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void inputEvents::clear(void)
+
+void inputEvents::clear(void)
+{
+	tail = head;
+	overflowBase = overflowCount;
+}
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// EventLib.h
+//
+// interrupt driven capture of digital input changes into a timestamped
+// event log, for the DIO inputs and any other GPIO (e.g. endstops)
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef EVENTLIB_H
+#define EVENTLIB_H
+
+#include <Arduino.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define INPUT_EVENTS_BUFFER_SIZE	256		// power of 2
+#define INPUT_EVENTS_BUFFER_MASK	(INPUT_EVENTS_BUFFER_SIZE - 1)
+#define INPUT_EVENTS_MAX_PINS		16		// GPIOs watched at the same time
+#define INPUT_EVENTS_MAX_GPIO		39
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint32_t timestampUs;			// micros(), wraps after ~71 minutes
+	uint8_t  pin;					// GPIO number
+	uint8_t  level;					// level after the edge
+} input_event_t;
+
+class inputEvents;
+
+typedef struct
+{
+	inputEvents *owner;
+	uint8_t      pin;
+	bool         active;
+} input_event_pin_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class inputEvents {
+public:
+	void init(void);
+	bool enable(uint8_t pin);
+	bool disable(uint8_t pin);
+	void disableAll(void);
+
+	uint16_t read(input_event_t events[], uint16_t maxEvents);
+	uint16_t available(void);
+	uint32_t getOverflowCount(void);
+	void clear(void);
+
+private:
+	static void IRAM_ATTR onEdge(void *arg);
+
+	// single producer (edge ISR) / single consumer ring buffer, the ISR only
+	// writes head & overflowCount, the consumer only tail & overflowBase
+	input_event_t     buffer[INPUT_EVENTS_BUFFER_SIZE];
+	volatile uint32_t head = 0;
+	volatile uint32_t tail = 0;
+	volatile uint32_t overflowCount = 0;
+	uint32_t          overflowBase = 0;
+
+	input_event_pin_t pins[INPUT_EVENTS_MAX_PINS];
+};
+
+#endif	// EVENTLIB_H
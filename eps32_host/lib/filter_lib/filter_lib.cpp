@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// FilterLib.cpp
+//
+// Every stage runs per sample in integer math, a sample costs a sort of at
+// most FILTER_MAX_MEDIAN values, an add and once per decimated output a
+// divide and a 64 bit multiply.
+//
+// The IIR state keeps FILTER_ALPHA_SHIFT fraction bits below the 24.8
+// output. With a 24.8 state the rounded step alpha * (x - y) became 0 while
+// x - y was still 0.5 / alpha output LSBs, e.g. a 0 -> 1000 step settled at
+// 872 with alpha = 1 / 65536. Now the step only vanishes below half an
+// output LSB, the output settles on the input.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "filter_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// void filterDefaultConfig(filter_config_t *config)
+//
+// all stages off, the output follows the input
+
+void filterDefaultConfig(filter_config_t *config)
+{
+	config->medianLength = 1;
+	config->decimation   = 1;
+	config->alphaQ16     = FILTER_ALPHA_ONE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool filterInit(filter_state_t *filter, const filter_config_t *config)
+//
+// returns false on an invalid configuration and leaves the filter as is
+
+bool filterInit(filter_state_t *filter, const filter_config_t *config)
+{
+	if ((config->medianLength == 0) || (config->medianLength > FILTER_MAX_MEDIAN) ||
+		((config->medianLength & 1) == 0) ||
+		(config->decimation == 0) || (config->decimation > FILTER_MAX_DECIMATION) ||
+		(config->alphaQ16 == 0) || (config->alphaQ16 > FILTER_ALPHA_ONE))
+	{
+		return false;
+	}
+
+	filter->config = *config;
+	filterReset(filter);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void filterReset(filter_state_t *filter)
+//
+// clears the history, keeps the configuration
+
+void filterReset(filter_state_t *filter)
+{
+	memset(filter->window, 0, sizeof(filter->window));
+	filter->windowIndex = 0;
+	filter->windowFill  = 0;
+	filter->sum         = 0;
+	filter->sumCount    = 0;
+	filter->state       = 0;
+	filter->primed      = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// static uint16_t filterMedian(filter_state_t *filter, uint16_t raw)
+//
+// while the window fills up the median of the samples so far is used
+
+static uint16_t filterMedian(filter_state_t *filter, uint16_t raw)
+{
+	uint16_t sorted[FILTER_MAX_MEDIAN];
+	uint16_t value = 0;
+	uint8_t  ix = 0;
+	uint8_t  jx = 0;
+
+	if (filter->config.medianLength == 1)
+	{
+		return raw;
+	}
+
+	filter->window[filter->windowIndex] = raw;
+	filter->windowIndex = (filter->windowIndex + 1) % filter->config.medianLength;
+	if (filter->windowFill < filter->config.medianLength)
+	{
+		filter->windowFill++;
+	}
+
+	// insertion sort, the window is a handful of samples
+	for (ix = 0; ix < filter->windowFill; ix++)
+	{
+		value = filter->window[ix];
+		for (jx = ix; (jx > 0) && (sorted[jx - 1] > value); jx--)
+		{
+			sorted[jx] = sorted[jx - 1];
+		}
+		sorted[jx] = value;
+	}
+
+	return sorted[filter->windowFill / 2];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool filterProcess(filter_state_t *filter, uint16_t raw, int32_t *output)
+//
+// feeds one sample, returns true and the new 24.8 output once every
+// decimation samples
+
+bool filterProcess(filter_state_t *filter, uint16_t raw, int32_t *output)
+{
+	int32_t average = 0;
+
+	filter->sum += filterMedian(filter, raw);
+	filter->sumCount++;
+
+	if (filter->sumCount < filter->config.decimation)
+	{
+		return false;
+	}
+
+	average = (int32_t)((((uint64_t)filter->sum << FILTER_OUTPUT_SHIFT) + filter->sumCount / 2) / filter->sumCount);
+	filter->sum      = 0;
+	filter->sumCount = 0;
+
+	if (!filter->primed)
+	{
+		filter->state  = (int64_t)average << FILTER_ALPHA_SHIFT;
+		filter->primed = true;
+	}
+	else
+	{
+		// |x - y| < 2^36, times alpha <= 2^16 fits 64 bit
+		filter->state += ((((int64_t)average << FILTER_ALPHA_SHIFT) - filter->state) * (int64_t)filter->config.alphaQ16 +
+						  (1LL << (FILTER_ALPHA_SHIFT - 1))) >> FILTER_ALPHA_SHIFT;
+	}
+
+	*output = (int32_t)((filter->state + (1LL << (FILTER_ALPHA_SHIFT - 1))) >> FILTER_ALPHA_SHIFT);
+
+	return true;
+}
@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// FilterLib.h
+//
+// fixed point filter pipeline for periodically sampled ADC channels:
+//
+//   raw -> median of N -> decimating moving average -> first order IIR
+//
+// The median removes single sample spikes, the moving average of D samples
+// outputs once per D inputs and has its nulls at multiples of fs / D (choose
+// D = fs / 50 to reject 50 Hz mains and its harmonics), the IIR smooths the
+// decimated output: y += alpha * (x - y).
+//
+// No floating point, no Arduino dependencies.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef FILTERLIB_H
+#define FILTERLIB_H
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define FILTER_MAX_MEDIAN		9			// max. median window, odd
+#define FILTER_MAX_DECIMATION	1000		// max. samples per output
+
+#define FILTER_OUTPUT_SHIFT		8			// outputs are 24.8 fixed point raw values
+#define FILTER_ALPHA_SHIFT		16			// IIR coefficient is Q16
+#define FILTER_ALPHA_ONE		(1UL << FILTER_ALPHA_SHIFT)		// alpha = 1.0, IIR off
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint8_t  medianLength;					// 1 = off
+	uint16_t decimation;					// 1 = an output for every sample
+	uint32_t alphaQ16;						// 1 .. FILTER_ALPHA_ONE
+} filter_config_t;
+
+typedef struct
+{
+	filter_config_t config;
+
+	uint16_t window[FILTER_MAX_MEDIAN];		// last samples, oldest overwritten
+	uint8_t  windowIndex;
+	uint8_t  windowFill;
+
+	uint32_t sum;							// moving average accumulator
+	uint16_t sumCount;
+
+	int64_t  state;							// IIR state, 24.8 with FILTER_ALPHA_SHIFT
+											// more fraction bits so a small alpha
+											// settles on the input
+	bool     primed;						// output holds a value
+} filter_state_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+void filterDefaultConfig(filter_config_t *config);
+bool filterInit(filter_state_t *filter, const filter_config_t *config);
+void filterReset(filter_state_t *filter);
+bool filterProcess(filter_state_t *filter, uint16_t raw, int32_t *output);
+
+#endif	// FILTERLIB_H
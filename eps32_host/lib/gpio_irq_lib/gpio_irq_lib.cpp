@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// GpioIrqLib.cpp
+//
+// Claims are made from the loop task only (RPC handlers), no lock needed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "gpio_irq_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static gpio_irq_owner_t gpioIrqOwners[GPIO_IRQ_MAX_GPIO + 1];
+
+///////////////////////////////////////////////////////////////////////////////
+// bool gpioIrqClaim(uint8_t pin, gpio_irq_owner_t owner)
+//
+// true when the pin was free or is already owned by owner
+
+bool gpioIrqClaim(uint8_t pin, gpio_irq_owner_t owner)
+{
+	if ((pin > GPIO_IRQ_MAX_GPIO) || (owner == GPIO_IRQ_FREE))
+	{
+		return false;
+	}
+
+	if ((gpioIrqOwners[pin] != GPIO_IRQ_FREE) && (gpioIrqOwners[pin] != owner))
+	{
+		return false;
+	}
+
+	gpioIrqOwners[pin] = owner;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void gpioIrqRelease(uint8_t pin, gpio_irq_owner_t owner)
+//
+// only the owner releases a pin
+
+void gpioIrqRelease(uint8_t pin, gpio_irq_owner_t owner)
+{
+	if ((pin <= GPIO_IRQ_MAX_GPIO) && (gpioIrqOwners[pin] == owner))
+	{
+		gpioIrqOwners[pin] = GPIO_IRQ_FREE;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// gpio_irq_owner_t gpioIrqOwner(uint8_t pin)
+
+gpio_irq_owner_t gpioIrqOwner(uint8_t pin)
+{
+	return (pin <= GPIO_IRQ_MAX_GPIO) ? gpioIrqOwners[pin] : GPIO_IRQ_FREE;
+}
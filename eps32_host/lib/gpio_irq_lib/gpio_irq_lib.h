@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// GpioIrqLib.h
+//
+// owner table of the GPIO interrupts. A GPIO has one interrupt handler,
+// attachInterruptArg() silently replaces the previous one, so every library
+// that attaches a handler claims the pin here first and a pin owned by
+// another library is refused.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GPIOIRQLIB_H
+#define GPIOIRQLIB_H
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define GPIO_IRQ_MAX_GPIO		39
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef enum
+{
+	GPIO_IRQ_FREE = 0,
+	GPIO_IRQ_PULSE_GUARD,				// pulse_guard, endstop halts
+	GPIO_IRQ_INPUT_EVENTS,				// event_lib, input event log
+} gpio_irq_owner_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+bool gpioIrqClaim(uint8_t pin, gpio_irq_owner_t owner);
+void gpioIrqRelease(uint8_t pin, gpio_irq_owner_t owner);
+gpio_irq_owner_t gpioIrqOwner(uint8_t pin);
+
+#endif	// GPIOIRQLIB_H
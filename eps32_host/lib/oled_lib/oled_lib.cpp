@@ -14,17 +14,46 @@
 // system #includes
 
 #include "Arduino.h"
+#include <Wire.h>
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // application #includes
 
+#include "../config.h"
 #include "oled_lib.h"
 
 #define I2C_ADDRESS_OLED		0x3C	    // I2C address of OLED display
 #define I2C_SDA_PIN			21		    // GPIO pin for I2C SDA
 #define I2C_SCL_PIN			22		    // GPIO pin for I2C S
 
+#define SSD1306_COLUMNADDR		0x21
+#define SSD1306_PAGEADDR		0x22
+#define SSD1306_CONTROL_COMMAND	0x80
+#define SSD1306_CONTROL_DATA	0x40
+
+// precomputed dashboard layout: the value of a cell is right aligned at
+// valueEnd, a change erases valueX .. valueEnd over the full row height
+
+typedef struct
+{
+	const char *label;
+	uint8_t     row;
+	uint8_t     labelX;
+	uint8_t     valueX;
+	uint8_t     valueEnd;
+} dashboard_cell_t;
+
+static const dashboard_cell_t dashboardCells[OLED_DASHBOARD_CELLS] =
+{
+	{ "RPC/s",      0,  0,  32,  62 },
+	{ "Loop",       0, 66,  92, 128 },		// loops per second
+	{ "Latency us", 1,  0,  64, 128 },
+	{ "Free heap",  2,  0,  64, 128 },
+	{ "Pulses",     3,  0,  36,  62 },
+	{ "Clients",    3, 66, 102, 128 },
+};
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // the OLED display object (class static member)
@@ -37,6 +66,7 @@ bool oledDisplay::init(void)
 {
 	bool result = false;
 	
+	lock = xSemaphoreCreateMutex();
 	display = new SSD1306Wire(I2C_ADDRESS_OLED, I2C_SDA_PIN, I2C_SCL_PIN);
 
 	result = display->init();
@@ -47,6 +77,12 @@ bool oledDisplay::init(void)
 	display->setTextAlignment(TEXT_ALIGN_LEFT);
 	display->flipScreenVertically();
 
+	// init() leaves the panel cleared
+	memset(panelFrame, 0, sizeof(panelFrame));
+	dirty = false;
+	lastFlushMs = millis();
+	bytesSent = 0;
+
 	return result;
 }
 
@@ -55,8 +91,11 @@ bool oledDisplay::init(void)
 
 void oledDisplay::clear(void)
 {
+	xSemaphoreTake(lock, portMAX_DELAY);
 	display->clear();
-	display->display();
+	dirty = true;
+	dashboardLayoutDrawn = false;
+	xSemaphoreGive(lock);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -66,6 +105,8 @@ void oledDisplay::writeLine(uint8_t line, const char *message, uint8_t align)
 {
 	uint8_t startCol = 0;
 	
+	xSemaphoreTake(lock, portMAX_DELAY);
+
 	switch (align)
 	{
 		case ALIGN_LEFT:
@@ -87,5 +128,317 @@ void oledDisplay::writeLine(uint8_t line, const char *message, uint8_t align)
 	line = constrain(line, 0, OLED_NLINES - 1);
 
 	display->drawString(startCol, line * OLED_LINEHEIGTH, message);
-	display->display();
+	dirty = true;
+	dashboardLayoutDrawn = false;
+
+	xSemaphoreGive(lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::update(void)
+//
+// called from the main loop, coalesces all changes since the last flush
+
+void oledDisplay::update(void)
+{
+	if (dirty && ((millis() - lastFlushMs) >= OLED_FLUSH_INTERVAL_MS))
+	{
+		flush();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::flush(void)
+
+void oledDisplay::flush(void)
+{
+	xSemaphoreTake(lock, portMAX_DELAY);
+	flushFrame();
+	xSemaphoreGive(lock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::flushFrame(void)
+//
+// sends only the changed column range of every changed page instead of the
+// full 1 KB frame, the caller holds the lock
+
+void oledDisplay::flushFrame(void)
+{
+	uint8_t page = 0;
+	int16_t column = 0;
+	int16_t firstColumn = 0;
+	int16_t lastColumn = 0;
+	const uint8_t *frame = display->buffer;
+
+	if (frame == nullptr)
+	{
+		return;
+	}
+
+	for (page = 0; page < OLED_NPAGES; page++)
+	{
+		const uint8_t *framePage = &frame[page * OLED_XSIZE];
+		const uint8_t *panelPage = &panelFrame[page * OLED_XSIZE];
+
+		firstColumn = -1;
+		for (column = 0; column < OLED_XSIZE; column++)
+		{
+			if (framePage[column] != panelPage[column])
+			{
+				firstColumn = column;
+				break;
+			}
+		}
+
+		if (firstColumn < 0)
+		{
+			continue;
+		}
+
+		for (lastColumn = OLED_XSIZE - 1; lastColumn > firstColumn; lastColumn--)
+		{
+			if (framePage[lastColumn] != panelPage[lastColumn])
+			{
+				break;
+			}
+		}
+
+		sendPage(page, firstColumn, lastColumn);
+	}
+
+	dirty = false;
+	lastFlushMs = millis();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t oledDisplay::getBytesSent(void)
+//
+// I2C payload bytes sent by flush(), commands included
+
+uint32_t oledDisplay::getBytesSent(void)
+{
+	return bytesSent;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::sendCommand(uint8_t command)
+
+void oledDisplay::sendCommand(uint8_t command)
+{
+	Wire.beginTransmission(I2C_ADDRESS_OLED);
+	Wire.write(SSD1306_CONTROL_COMMAND);
+	Wire.write(command);
+	Wire.endTransmission();
+
+	bytesSent += 2;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::sendPage(uint8_t page, uint8_t firstColumn, uint8_t lastColumn)
+
+void oledDisplay::sendPage(uint8_t page, uint8_t firstColumn, uint8_t lastColumn)
+{
+	uint16_t offset = page * OLED_XSIZE;
+	uint16_t column = firstColumn;
+	uint16_t ix = 0;
+	const uint8_t *frame = display->buffer;
+
+	sendCommand(SSD1306_COLUMNADDR);
+	sendCommand(firstColumn);
+	sendCommand(lastColumn);
+	sendCommand(SSD1306_PAGEADDR);
+	sendCommand(page);
+	sendCommand(page);
+
+	while (column <= lastColumn)
+	{
+		Wire.beginTransmission(I2C_ADDRESS_OLED);
+		Wire.write(SSD1306_CONTROL_DATA);
+		for (ix = 0; (ix < OLED_I2C_CHUNK) && (column <= lastColumn); ix++, column++)
+		{
+			Wire.write(frame[offset + column]);
+		}
+		Wire.endTransmission();
+
+		bytesSent += ix + 1;
+	}
+
+	memcpy(&panelFrame[offset + firstColumn], &frame[offset + firstColumn], lastColumn - firstColumn + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::setDashboardSource(oled_dashboard_source_t source)
+
+void oledDisplay::setDashboardSource(oled_dashboard_source_t source)
+{
+	dashboardSource = source;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool oledDisplay::startDashboard(uint16_t periodMs)
+//
+// the dashboard owns the display until stopDashboard(), a writeLine() or
+// clear() in between is overdrawn at the next refresh
+
+bool oledDisplay::startDashboard(uint16_t periodMs)
+{
+	if ((dashboardSource == nullptr) || (periodMs < OLED_FLUSH_INTERVAL_MS))
+	{
+		return false;
+	}
+
+	xSemaphoreTake(lock, portMAX_DELAY);
+	dashboardPeriodMs    = periodMs;
+	dashboardLayoutDrawn = false;
+	dashboardPrimed      = false;
+	dashboardActive      = true;
+	xSemaphoreGive(lock);
+
+	if (dashboardHandle == nullptr)
+	{
+		xTaskCreatePinnedToCore(dashboardTask, "oledDashboard", RTOS_DEFAULT_STACKSIZE, this,
+								1, &dashboardHandle, CORE_0);
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::stopDashboard(void)
+//
+// the last dashboard frame stays on the display
+
+void oledDisplay::stopDashboard(void)
+{
+	dashboardActive = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool oledDisplay::isDashboardActive(void)
+
+bool oledDisplay::isDashboardActive(void)
+{
+	return dashboardActive;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::dashboardTask(void *parameter)
+//
+// lowest priority on the protocol core, away from the pulse timing in loop()
+
+void oledDisplay::dashboardTask(void *parameter)
+{
+	oledDisplay *oled = (oledDisplay *)parameter;
+	oled_dashboard_t values;
+	TickType_t lastWake = xTaskGetTickCount();
+
+	while (true)
+	{
+		vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(oled->dashboardPeriodMs));
+
+		if (!oled->dashboardActive)
+		{
+			continue;
+		}
+
+		oled->dashboardSource(&values);
+
+		xSemaphoreTake(oled->lock, portMAX_DELAY);
+		oled->renderDashboard(&values);
+		oled->flushFrame();
+		xSemaphoreGive(oled->lock);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void oledDisplay::renderDashboard(const oled_dashboard_t *values)
+//
+// labels are drawn once, a value is only erased & redrawn when its text
+// changed, so flushFrame() sends just those columns
+
+void oledDisplay::renderDashboard(const oled_dashboard_t *values)
+{
+	uint8_t  cell = 0;
+	uint32_t nowMs = millis();
+	uint32_t elapsedMs = nowMs - dashboardPreviousMs;
+	uint32_t calls = 0;
+	uint32_t callsPerSecond = 0;
+	uint32_t averageUs = 0;
+	uint32_t loopHz = 0;
+	char text[OLED_DASHBOARD_TEXT];
+
+	if (dashboardPrimed && (elapsedMs > 0))
+	{
+		calls          = values->rpcCalls - dashboardPrevious.rpcCalls;
+		callsPerSecond = (calls * 1000UL) / elapsedMs;
+		averageUs      = (calls > 0) ? (values->rpcHandlerUs - dashboardPrevious.rpcHandlerUs) / calls : 0;
+		loopHz         = ((values->loopCount - dashboardPrevious.loopCount) * 1000UL) / elapsedMs;
+	}
+	dashboardPrevious   = *values;
+	dashboardPreviousMs = nowMs;
+	dashboardPrimed     = true;
+
+	display->setFont(ArialMT_Plain_10);
+
+	if (!dashboardLayoutDrawn)
+	{
+		display->clear();
+		display->setTextAlignment(TEXT_ALIGN_LEFT);
+		for (cell = 0; cell < OLED_DASHBOARD_CELLS; cell++)
+		{
+			display->drawString(dashboardCells[cell].labelX, dashboardCells[cell].row * OLED_DASHBOARD_ROW_HEIGHT,
+								dashboardCells[cell].label);
+		}
+		memset(dashboardText, 0, sizeof(dashboardText));
+		dashboardLayoutDrawn = true;
+	}
+
+	display->setTextAlignment(TEXT_ALIGN_RIGHT);
+
+	for (cell = 0; cell < OLED_DASHBOARD_CELLS; cell++)
+	{
+		const dashboard_cell_t *layout = &dashboardCells[cell];
+
+		switch (cell)
+		{
+			case 0:
+			snprintf(text, sizeof(text), "%lu", (unsigned long)callsPerSecond);
+			break;
+
+			case 1:
+			snprintf(text, sizeof(text), "%lu", (unsigned long)loopHz);
+			break;
+
+			case 2:
+			snprintf(text, sizeof(text), "%lu/%lu", (unsigned long)averageUs, (unsigned long)values->rpcHandlerMaxUs);
+			break;
+
+			case 3:
+			snprintf(text, sizeof(text), "%lu", (unsigned long)values->freeHeap);
+			break;
+
+			case 4:
+			snprintf(text, sizeof(text), "%u", values->activePulses);
+			break;
+
+			case 5:
+			snprintf(text, sizeof(text), "%u", values->clients);
+			break;
+		}
+
+		if (strcmp(text, dashboardText[cell]) != 0)
+		{
+			display->setColor(BLACK);
+			display->fillRect(layout->valueX, layout->row * OLED_DASHBOARD_ROW_HEIGHT,
+							  layout->valueEnd - layout->valueX, OLED_DASHBOARD_ROW_HEIGHT);
+			display->setColor(WHITE);
+			display->drawString(layout->valueEnd, layout->row * OLED_DASHBOARD_ROW_HEIGHT, text);
+			strcpy(dashboardText[cell], text);
+		}
+	}
+
+	// writeLine() expects the line font
+	display->setFont(ArialMT_Plain_16);
+	dirty = true;
 }
@@ -25,6 +25,36 @@
 
 #define OLED_LINEHEIGTH 		(OLED_YSIZE / OLED_NLINES)
 
+#define OLED_NPAGES				(OLED_YSIZE / 8)	// SSD1306 page = 8 pixel rows
+#define OLED_FRAME_SIZE			(OLED_XSIZE * OLED_NPAGES)
+
+#define OLED_FLUSH_INTERVAL_MS	50		// min. time between two deferred flushes
+#define OLED_I2C_CHUNK			16		// data bytes per I2C transfer
+
+#define OLED_DASHBOARD_PERIOD_MS	500		// default dashboard refresh
+#define OLED_DASHBOARD_ROWS		4		// ArialMT_Plain_10 is 13 px high,
+#define OLED_DASHBOARD_ROW_HEIGHT	(OLED_YSIZE / OLED_DASHBOARD_ROWS)	// 16 px rows
+#define OLED_DASHBOARD_CELLS	6		// label & value pairs, two share a row
+#define OLED_DASHBOARD_TEXT		20
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+// dashboard input, counters are cumulative, rates are computed per refresh
+
+typedef struct
+{
+  uint32_t rpcCalls;
+  uint32_t rpcHandlerUs;		// total handler time
+  uint32_t rpcHandlerMaxUs;		// max. handler time since the previous sample
+  uint32_t loopCount;
+  uint32_t freeHeap;
+  uint8_t  activePulses;
+  uint8_t  clients;
+} oled_dashboard_t;
+
+typedef void (*oled_dashboard_source_t)(oled_dashboard_t *values);
+
 ///////////////////////////////////////////////////////////////////////////////
 // function prototypes
 
@@ -33,8 +63,43 @@ public:
   bool init(void);
   void clear(void);
   void writeLine(uint8_t line, const char *message, uint8_t align);
+
+  void update(void);
+  void flush(void);
+  uint32_t getBytesSent(void);
+
+  void setDashboardSource(oled_dashboard_source_t source);
+  bool startDashboard(uint16_t periodMs = OLED_DASHBOARD_PERIOD_MS);
+  void stopDashboard(void);
+  bool isDashboardActive(void);
 protected:
+  void flushFrame(void);
+  void sendCommand(uint8_t command);
+  void sendPage(uint8_t page, uint8_t firstColumn, uint8_t lastColumn);
+
+  static void dashboardTask(void *parameter);
+  void renderDashboard(const oled_dashboard_t *values);
+
   SSD1306Wire *display;
+
+  // the dashboard task draws from another core
+  SemaphoreHandle_t lock;
+
+  // what the panel shows, flush() only sends the columns that differ
+  uint8_t panelFrame[OLED_FRAME_SIZE];
+  bool dirty;
+  uint32_t lastFlushMs;
+  uint32_t bytesSent;
+
+  TaskHandle_t dashboardHandle = nullptr;
+  oled_dashboard_source_t dashboardSource = nullptr;
+  volatile bool dashboardActive = false;
+  uint16_t dashboardPeriodMs;
+  bool dashboardLayoutDrawn;
+  bool dashboardPrimed;
+  oled_dashboard_t dashboardPrevious;
+  uint32_t dashboardPreviousMs;
+  char dashboardText[OLED_DASHBOARD_CELLS][OLED_DASHBOARD_TEXT];
 };
 
 
@@ -0,0 +1,105 @@
+#include "pulse_guard.h"
+
+PulseGuard::PulseGuard()
+		: _channels(nullptr), _numChannels(0) {
+	memset(_pins, 0, sizeof(_pins));
+}
+
+void PulseGuard::begin(PulseLib *channels, int numChannels) {
+	_channels = channels;
+	_numChannels = numChannels;
+	for (int i = 0; i < PULSE_GUARD_MAX_PINS; ++i) {
+		_pins[i].owner = this;
+		_pins[i].active = false;
+	}
+}
+
+// A pin may guard several channels, binding it again adds the channel. A pin
+// already at its active level halts a running train of the channel at once,
+// the interrupt only fires on the next edge.
+bool PulseGuard::bind(uint8_t pin, int channel, uint8_t activeLevel) {
+	pulse_guard_pin_t *freeSlot = nullptr;
+
+	if (channel < 0 || channel >= _numChannels || activeLevel > HIGH) {
+		return false;
+	}
+
+	if (!gpioIrqClaim(pin, GPIO_IRQ_PULSE_GUARD)) {
+		return false;
+	}
+
+	for (int i = 0; i < PULSE_GUARD_MAX_PINS; ++i) {
+		if (_pins[i].active && _pins[i].pin == pin) {
+			if (_pins[i].activeLevel != activeLevel) {
+				return false;
+			}
+			_pins[i].channelMask |= (1 << channel);
+			_channels[channel].addGuardPin(pin, activeLevel);
+			onTrip(&_pins[i]);
+			return true;
+		}
+		if (!_pins[i].active && freeSlot == nullptr) {
+			freeSlot = &_pins[i];
+		}
+	}
+
+	if (freeSlot == nullptr) {
+		gpioIrqRelease(pin, GPIO_IRQ_PULSE_GUARD);
+		return false;
+	}
+
+	freeSlot->pin = pin;
+	freeSlot->activeLevel = activeLevel;
+	freeSlot->channelMask = (1 << channel);
+	freeSlot->active = true;
+	_channels[channel].addGuardPin(pin, activeLevel);
+	attachInterruptArg(pin, onTrip, freeSlot, (activeLevel == HIGH) ? RISING : FALLING);
+	onTrip(freeSlot);
+	return true;
+}
+
+bool PulseGuard::unbind(uint8_t pin) {
+	for (int i = 0; i < PULSE_GUARD_MAX_PINS; ++i) {
+		if (_pins[i].active && _pins[i].pin == pin) {
+			detachInterrupt(pin);
+			gpioIrqRelease(pin, GPIO_IRQ_PULSE_GUARD);
+			for (int channel = 0; channel < _numChannels; ++channel) {
+				if ((_pins[i].channelMask & (1 << channel)) != 0) {
+					_channels[channel].removeGuardPin(pin);
+				}
+			}
+			_pins[i].active = false;
+			return true;
+		}
+	}
+	return false;
+}
+
+// True while a bound pin is at its active level.
+bool PulseGuard::isTripped(uint8_t pin) {
+	for (int i = 0; i < PULSE_GUARD_MAX_PINS; ++i) {
+		if (_pins[i].active && _pins[i].pin == pin) {
+			return digitalRead(pin) == _pins[i].activeLevel;
+		}
+	}
+	return false;
+}
+
+// The level is checked again so a glitch on the inactive edge does not halt
+// the axis. The halt reason latched in the channel is the guard pin.
+void IRAM_ATTR PulseGuard::onTrip(void *arg) {
+	pulse_guard_pin_t *guard = (pulse_guard_pin_t *)arg;
+	PulseGuard *owner = guard->owner;
+	uint32_t port = (guard->pin < 32) ? GPIO.in : GPIO.in1.val;
+	uint8_t level = ((port & (1UL << (guard->pin & 0x1F))) != 0) ? HIGH : LOW;
+
+	if (level != guard->activeLevel) {
+		return;
+	}
+
+	for (int channel = 0; channel < owner->_numChannels; ++channel) {
+		if ((guard->channelMask & (1 << channel)) != 0) {
+			owner->_channels[channel].haltFromISR(guard->pin);
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef PULSE_GUARD_H
+#define PULSE_GUARD_H
+
+#include <Arduino.h>
+#include "pulse_lib.h"
+#include "gpio_irq_lib.h"
+
+// Endstop/limit guard: input pins bound to pulse channels. When a pin goes to
+// its active level the ISR halts the bound channels directly, no RPC or
+// tick() is involved. A guarded pin can not be used by the input event log,
+// a GPIO has only one interrupt handler: bind() claims the pin in the GPIO
+// interrupt owner table and fails for a pin the event log owns.
+#define PULSE_GUARD_MAX_PINS 8
+
+class PulseGuard;
+
+typedef struct {
+  PulseGuard *owner;
+  uint8_t pin;
+  uint8_t activeLevel;
+  uint8_t channelMask;
+  bool active;
+} pulse_guard_pin_t;
+
+
+class PulseGuard {
+  public:
+    PulseGuard();
+    void begin(PulseLib *channels, int numChannels);
+    bool bind(uint8_t pin, int channel, uint8_t activeLevel);
+    bool unbind(uint8_t pin);
+    bool isTripped(uint8_t pin);
+
+  private:
+    static void IRAM_ATTR onTrip(void *arg);
+
+    PulseLib *_channels;
+    int _numChannels;
+    pulse_guard_pin_t _pins[PULSE_GUARD_MAX_PINS];
+};
+
+
+#endif
@@ -3,7 +3,12 @@
 PulseLib::PulseLib()
 		: _pin(-1), _pulsing(false), _asyncActive(false), _outputHigh(false),
 			_pulseWidthMs(0), _pauseWidthMs(0), _pulseCount(0), _currentPulse(0),
-			_lastToggle(0) {}
+			_lastToggleUs(0), _mux(portMUX_INITIALIZER_UNLOCKED),
+			_haltReason(PULSE_HALT_NONE), _cutPulses(0) {
+	memset(_guardMask, 0, sizeof(_guardMask));
+	memset(_guardActiveHigh, 0, sizeof(_guardActiveHigh));
+	resetStats();
+}
 
 void PulseLib::begin(int pin) {
 	_pin = pin;
@@ -17,16 +22,18 @@ void PulseLib::pulse(int duration_ms) {
 	if (_pin < 0) {
 		return;
 	}
-	_pulsing = true;
-	digitalWrite(_pin, HIGH);
-	delay(duration_ms);
-	digitalWrite(_pin, LOW);
-	_pulsing = false;
+	runPulses(duration_ms, 0, 1);
 }
 
-void PulseLib::pulseAsync(int duration_ms) {
+bool PulseLib::pulseAsync(int duration_ms) {
 	if (_pin < 0 || duration_ms < 0) {
-		return;
+		return false;
+	}
+
+	portENTER_CRITICAL(&_mux);
+	if (refuseIfGuarded(1)) {
+		portEXIT_CRITICAL(&_mux);
+		return false;
 	}
 	_pulseWidthMs = duration_ms;
 	_pauseWidthMs = 0;
@@ -35,13 +42,15 @@ void PulseLib::pulseAsync(int duration_ms) {
 	_outputHigh = false;
 	_asyncActive = true;
 	_pulsing = true;
-	_lastToggle = millis();
 
 	// Start the pulse
 	digitalWrite(_pin, HIGH);
+	TRACE_EVENT(TRACE_PULSE_EDGE, _pin | (HIGH << 8));
 	_outputHigh = true;
-	_lastToggle = millis();
+	_lastToggleUs = esp_timer_get_time();
 	++_currentPulse;
+	portEXIT_CRITICAL(&_mux);
+	return true;
 }
 
 bool PulseLib::isPulsing() {
@@ -62,20 +71,72 @@ void PulseLib::generetePulses(int pulseWidthMs, int pauseWidthMs, int pulseCount
 	}
 
 
-	for (int i = 0; i < pulseCount; ++i) {
-		pulse(pulseWidthMs);
+	if (_pin < 0) {
+		return;
+	}
+	runPulses(pulseWidthMs, pauseWidthMs, pulseCount);
+}
+
+// Blocking pulse train, a guard halt ends it at the next edge.
+void PulseLib::runPulses(int pulseWidthMs, int pauseWidthMs, int pulseCount) {
+	bool halted = false;
+
+	portENTER_CRITICAL(&_mux);
+	if (refuseIfGuarded(pulseCount)) {
+		portEXIT_CRITICAL(&_mux);
+		return;
+	}
+	_pulseCount = pulseCount;
+	_currentPulse = 0;
+	_outputHigh = false;
+	_pulsing = true;
+	portEXIT_CRITICAL(&_mux);
+
+	for (int i = 0; i < pulseCount && !halted; ++i) {
+		portENTER_CRITICAL(&_mux);
+		halted = !_pulsing;
+		if (!halted) {
+			digitalWrite(_pin, HIGH);
+			TRACE_EVENT(TRACE_PULSE_EDGE, _pin | (HIGH << 8));
+			_outputHigh = true;
+			++_currentPulse;
+		}
+		portEXIT_CRITICAL(&_mux);
+		if (halted) {
+			break;
+		}
+
+		delay(pulseWidthMs);
+
+		portENTER_CRITICAL(&_mux);
+		digitalWrite(_pin, LOW);
+		TRACE_EVENT(TRACE_PULSE_EDGE, _pin | (LOW << 8));
+		_outputHigh = false;
+		halted = !_pulsing;
+		portEXIT_CRITICAL(&_mux);
+
 		if (i < pulseCount - 1) {
 			delay(pauseWidthMs);
 		}
 	}
+
+	_pulsing = false;
 }
 
-void PulseLib::generetePulsesAsync(int pulseWidthMs, int pauseWidthMs, int pulseCount) {
+bool PulseLib::generetePulsesAsync(int pulseWidthMs, int pauseWidthMs, int pulseCount) {
 	if (pulseCount <= 0 || pulseWidthMs < 0 || pauseWidthMs < 0) {
-		return;
+		return false;
 	}
 
+	if (_pin < 0) {
+		return false;
+	}
 
+	portENTER_CRITICAL(&_mux);
+	if (refuseIfGuarded(pulseCount)) {
+		portEXIT_CRITICAL(&_mux);
+		return false;
+	}
 	_pulseWidthMs = pulseWidthMs;
 	_pauseWidthMs = pauseWidthMs;
 	_pulseCount = pulseCount;
@@ -83,10 +144,12 @@ void PulseLib::generetePulsesAsync(int pulseWidthMs, int pauseWidthMs, int pulse
 	_outputHigh = false;
 	_asyncActive = true;
 	_pulsing = true;
-	_lastToggle = millis();
+	_lastToggleUs = esp_timer_get_time();
 
 	// ensure starting from LOW
 	digitalWrite(_pin, LOW);
+	portEXIT_CRITICAL(&_mux);
+	return true;
 }
 
 void PulseLib::tick() {
@@ -94,14 +157,25 @@ void PulseLib::tick() {
 		return;
 	}
 
-	unsigned long now = millis();
-	unsigned long elapsed = now - _lastToggle;
+	portENTER_CRITICAL(&_mux);
+	if (_asyncActive) {
+		advance();
+	}
+	portEXIT_CRITICAL(&_mux);
+}
+
+// Edges are scheduled on the same 64-bit microsecond clock the lateness is
+// measured with, an edge is never early and the clock does not wrap.
+void PulseLib::advance() {
+	int64_t now = esp_timer_get_time();
+	int64_t elapsed = now - _lastToggleUs;
 
 	if (_outputHigh) {
-		if (elapsed >= static_cast<unsigned long>(_pulseWidthMs)) {
+		if (elapsed >= (int64_t)_pulseWidthMs * 1000) {
 			digitalWrite(_pin, LOW);
+			TRACE_EVENT(TRACE_PULSE_EDGE, _pin | (LOW << 8));
+			recordEdge(now, _pulseWidthMs);
 			_outputHigh = false;
-			_lastToggle = now;
 		}
 	} else {
 		if (_currentPulse >= _pulseCount) {
@@ -110,10 +184,11 @@ void PulseLib::tick() {
 			return;
 		}
 
-		if (elapsed >= static_cast<unsigned long>(_pauseWidthMs)) {
+		if (elapsed >= (int64_t)_pauseWidthMs * 1000) {
 			digitalWrite(_pin, HIGH);
+			TRACE_EVENT(TRACE_PULSE_EDGE, _pin | (HIGH << 8));
+			recordEdge(now, _pauseWidthMs);
 			_outputHigh = true;
-			_lastToggle = now;
 			++_currentPulse;
 		}
 	}
@@ -130,3 +205,121 @@ int PulseLib::getRemainingPulses() {
 	}
 	return remaining;
 }
+
+void PulseLib::getStats(pulse_stats_t *stats) {
+	*stats = _stats;
+}
+
+void PulseLib::resetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+	_stats.minLatenessUs = INT32_MAX;
+	_stats.maxLatenessUs = INT32_MIN;
+}
+
+// Lateness of an edge is the measured time since the previous edge minus the
+// requested width, so it shows how late tick() got to the scheduled edge.
+void PulseLib::recordEdge(int64_t nowUs, int requestedWidthMs) {
+	int64_t late = nowUs - _lastToggleUs - (int64_t)requestedWidthMs * 1000;
+	int32_t latenessUs = (late > INT32_MAX) ? INT32_MAX : (int32_t)late;
+	_lastToggleUs = nowUs;
+
+	uint8_t bucket = 0;
+	uint32_t magnitude = (uint32_t)latenessUs;
+	while (magnitude != 0 && bucket < PULSE_STATS_N_BUCKETS - 1) {
+		magnitude >>= 1;
+		++bucket;
+	}
+
+	++_stats.edgeCount;
+	++_stats.histogram[bucket];
+	_stats.sumLatenessUs += latenessUs;
+	if (latenessUs < _stats.minLatenessUs) {
+		_stats.minLatenessUs = latenessUs;
+	}
+	if (latenessUs > _stats.maxLatenessUs) {
+		_stats.maxLatenessUs = latenessUs;
+	}
+}
+
+// Called from a guard ISR: drives the output low through the GPIO
+// write-1-to-clear register and cancels the running pulse train. The pulse
+// in progress counts as cut, it is shorter than requested.
+void IRAM_ATTR PulseLib::haltFromISR(int reason) {
+	portENTER_CRITICAL_ISR(&_mux);
+	if (_pin >= 0) {
+		if (_pin < 32) {
+			GPIO.out_w1tc = (1UL << _pin);
+		} else {
+			GPIO.out1_w1tc.val = (1UL << (_pin - 32));
+		}
+	}
+	TRACE_EVENT(TRACE_PULSE_HALT, _pin);
+	if (_pulsing) {
+		int cut = _pulseCount - _currentPulse + (_outputHigh ? 1 : 0);
+		_cutPulses = (cut > 0) ? cut : 0;
+		_haltReason = reason;
+	}
+	_outputHigh = false;
+	_asyncActive = false;
+	_pulsing = false;
+	portEXIT_CRITICAL_ISR(&_mux);
+}
+
+int PulseLib::getHaltReason() {
+	return _haltReason;
+}
+
+int PulseLib::getCutPulses() {
+	return _cutPulses;
+}
+
+void PulseLib::clearHalt() {
+	_haltReason = PULSE_HALT_NONE;
+	_cutPulses = 0;
+}
+
+void PulseLib::addGuardPin(uint8_t pin, uint8_t activeLevel) {
+	uint32_t mask = (1UL << (pin & 0x1F));
+
+	portENTER_CRITICAL(&_mux);
+	_guardMask[pin >> 5] |= mask;
+	if (activeLevel == HIGH) {
+		_guardActiveHigh[pin >> 5] |= mask;
+	} else {
+		_guardActiveHigh[pin >> 5] &= ~mask;
+	}
+	portEXIT_CRITICAL(&_mux);
+}
+
+void PulseLib::removeGuardPin(uint8_t pin) {
+	uint32_t mask = (1UL << (pin & 0x1F));
+
+	portENTER_CRITICAL(&_mux);
+	_guardMask[pin >> 5] &= ~mask;
+	_guardActiveHigh[pin >> 5] &= ~mask;
+	portEXIT_CRITICAL(&_mux);
+}
+
+// Called with _mux held by the start paths. The guard ISR only fires on an
+// edge, a pin already at its active level would never stop the train, so it
+// does not start and the halt is latched as if the guard had tripped at once.
+// A pin that trips after this check halts the train through the ISR.
+bool PulseLib::refuseIfGuarded(int pulseCount) {
+	uint32_t tripped[2] = {0, 0};
+
+	if (_guardMask[0] != 0) {
+		tripped[0] = ~((uint32_t)GPIO.in ^ _guardActiveHigh[0]) & _guardMask[0];
+	}
+	if (_guardMask[1] != 0) {
+		tripped[1] = ~((uint32_t)GPIO.in1.val ^ _guardActiveHigh[1]) & _guardMask[1];
+	}
+
+	if (tripped[0] == 0 && tripped[1] == 0) {
+		return false;
+	}
+
+	_haltReason = (tripped[0] != 0) ? __builtin_ctz(tripped[0]) : 32 + __builtin_ctz(tripped[1]);
+	_cutPulses = pulseCount;
+	TRACE_EVENT(TRACE_PULSE_HALT, _pin);
+	return true;
+}
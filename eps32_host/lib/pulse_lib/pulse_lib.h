@@ -2,6 +2,24 @@
 #define PULSE_LIB_H
 
 #include <Arduino.h>
+#include "trace_lib.h"
+
+// Edge timing telemetry: lateness histogram uses log2 buckets in microseconds,
+// bucket 0 holds edges on time, bucket n holds lateness in [2^(n-1), 2^n) us
+#define PULSE_STATS_N_BUCKETS 16
+
+typedef struct {
+  uint32_t edgeCount;
+  int32_t minLatenessUs;
+  int32_t maxLatenessUs;
+  int64_t sumLatenessUs;
+  uint32_t histogram[PULSE_STATS_N_BUCKETS];
+} pulse_stats_t;
+
+// Halt reason when a channel was not stopped by a guard
+#define PULSE_HALT_NONE -1
+// Halt reason PULSE_HALT_COMPARE + counter channel: stopped by an encoder compare
+#define PULSE_HALT_COMPARE 100
 
 
 class PulseLib {    
@@ -9,27 +27,53 @@ class PulseLib {
     PulseLib();
     void begin(int pin);
     void pulse(int duration_ms);
-    void pulseAsync(int duration_ms);
+    bool pulseAsync(int duration_ms);
     bool isPulsing();
     void stopPulse();
 
     void generetePulses(int pulseWidthMs, int pauseWidthMs, int pulseCount);
-    void generetePulsesAsync(int pulseWidthMs, int pauseWidthMs, int pulseCount);
+    bool generetePulsesAsync(int pulseWidthMs, int pauseWidthMs, int pulseCount);
     void tick();
     int getRemainingPulses();
+
+    void getStats(pulse_stats_t *stats);
+    void resetStats();
+
+    void IRAM_ATTR haltFromISR(int reason);
+    int getHaltReason();
+    int getCutPulses();
+    void clearHalt();
+
+    // Guard pins of the channel, kept by PulseGuard. A train does not start
+    // while one of them is at its active level, the halt is latched instead.
+    void addGuardPin(uint8_t pin, uint8_t activeLevel);
+    void removeGuardPin(uint8_t pin);
     
   private:
+    void advance();
+    void runPulses(int pulseWidthMs, int pauseWidthMs, int pulseCount);
+    void recordEdge(int64_t nowUs, int requestedWidthMs);
+    bool refuseIfGuarded(int pulseCount);
+
     int _pin;
-    bool _pulsing;
-    bool _asyncActive;
+    volatile bool _pulsing;
+    volatile bool _asyncActive;
     bool _outputHigh;
     int _pulseWidthMs;
     int _pauseWidthMs;
     int _pulseCount;
     int _currentPulse;
-    unsigned long _lastToggle;
+    int64_t _lastToggleUs;
+    pulse_stats_t _stats;
+
+    // tick() and haltFromISR() both drive the pin, the guard ISR must not
+    // run between the state check and the edge in tick()
+    portMUX_TYPE _mux;
+    volatile int _haltReason;
+    volatile int _cutPulses;
+    uint32_t _guardMask[2];        // GPIO0..31 & GPIO32..39
+    uint32_t _guardActiveHigh[2];
 };  
 
 
 #endif
-
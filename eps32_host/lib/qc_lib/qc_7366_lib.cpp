@@ -47,7 +47,8 @@ void qc7366::init(spi *spi)
 	for (channel = 0; channel <= QC_MAX_CHANNEL; channel++)
 	{
 		writeModeRegister(channel, modeRegister, defaultMode);
-		disableCounter(channel);
+		writeModeRegister(channel, QC_MODE_REGISTER_1, CNTMODE_4 | CNT_DISABLE);
+		counterBytes[channel] = QC_MAX_COUNTER_BYTES;
 		clearCountRegister(channel);
 	}
 
@@ -193,25 +194,36 @@ void qc7366::clearModeRegister(uint8_t channel, mode_register_t modeRegister)
 void qc7366::clearCountRegister(uint8_t channel)
 {
 	sendCommand(channel, CLR_CNTR);
+
+	if (channel <= QC_MAX_CHANNEL)
+	{
+		portENTER_CRITICAL(&positionMux);
+		lastCount[channel] = 0;
+		position[channel]  = 0;
+		portEXIT_CRITICAL(&positionMux);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-// int32_t qc7366::ReadCountRegister(uint8_t channel)
+// int32_t qc7366::readCounter(uint8_t channel, uint8_t readCommand)
+//
+// reads CNTR or OTR, only the bytes of the configured counter width are
+// clocked out. The value is sign extended to 32 bit.
 
-int32_t  qc7366::readCountRegister(uint8_t channel)
+int32_t qc7366::readCounter(uint8_t channel, uint8_t readCommand)
 {
-	int32_t count = 0;
-	uint8_t ix	  = 0;
-	uint8_t val	  = 0;
-	
+	uint32_t count = 0;
+	uint8_t  ix	   = 0;
+	uint8_t  val   = 0;
+	uint8_t  shift = 0;
+
 	if (channel <= QC_MAX_CHANNEL)
 	{
-
 		spi_bus->beginTransaction(QCSPISettings);
 		selectSPIDevice(channel);
 
-		spi_bus->writeByte(READ_CNTR);
-		for (ix = 0; ix < 4; ix++)
+		spi_bus->writeByte(readCommand);
+		for (ix = 0; ix < counterBytes[channel]; ix++)
 		{
 			spi_bus->readByte(&val);
 			count = (count << 8) | val;
@@ -219,17 +231,163 @@ int32_t  qc7366::readCountRegister(uint8_t channel)
 
 		spi_bus->deselectDevice();
 		spi_bus->endTransaction();
+
+		shift = 8 * (QC_MAX_COUNTER_BYTES - counterBytes[channel]);
 	}
-	
+
+	return (int32_t)(count << shift) >> shift;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qc7366::trackPosition(uint8_t channel, int32_t count)
+//
+// the step since the previous read, taken modulo the counter width, is added
+// to the 64 bit position. Reads must follow each other within half the
+// counter range (128 counts for a 1 byte counter). CNTR and OTR reads both
+// count, an OTR latched before the last CNTR read steps back and forth but
+// does not lose counts. The difference is taken in uint32_t, it wraps with
+// a 4 byte counter.
+
+void qc7366::trackPosition(uint8_t channel, int32_t count)
+{
+	uint8_t shift = 8 * (QC_MAX_COUNTER_BYTES - counterBytes[channel]);
+	int32_t step  = 0;
+
+	portENTER_CRITICAL(&positionMux);
+	step = (int32_t)(((uint32_t)count - (uint32_t)lastCount[channel]) << shift) >> shift;
+	position[channel]  += step;
+	lastCount[channel]  = count;
+	portEXIT_CRITICAL(&positionMux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int32_t qc7366::ReadCountRegister(uint8_t channel)
+//
+// every read also updates the 64 bit position
+
+int32_t  qc7366::readCountRegister(uint8_t channel)
+{
+	int32_t count = 0;
+
+	if (channel <= QC_MAX_CHANNEL)
+	{
+		count = readCounter(channel, READ_CNTR);
+		trackPosition(channel, count);
+	}
+
 	return count;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// int64_t qc7366::readPosition(uint8_t channel)
+//
+// counter extended to 64 bit in software, no range is lost with a narrow
+// counter as long as it is read often enough
+
+int64_t qc7366::readPosition(uint8_t channel)
+{
+	if (channel > QC_MAX_CHANNEL)
+	{
+		return 0;
+	}
+
+	readCountRegister(channel);
+
+	return getPosition(channel);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int64_t qc7366::getPosition(uint8_t channel)
+//
+// position as of the last counter read, no SPI access
+
+int64_t qc7366::getPosition(uint8_t channel)
+{
+	int64_t value = 0;
+
+	if (channel <= QC_MAX_CHANNEL)
+	{
+		portENTER_CRITICAL(&positionMux);
+		value = position[channel];
+		portEXIT_CRITICAL(&positionMux);
+	}
+
+	return value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qc7366::pollPositions(void)
+//
+// reads every counter so the positions follow while no client does, call
+// at least every QC_POSITION_POLL_MS
+
+void qc7366::pollPositions(void)
+{
+	uint8_t channel = 0;
+
+	for (channel = 0; channel <= QC_MAX_CHANNEL; channel++)
+	{
+		readCountRegister(channel);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool qc7366::setCounterBytes(uint8_t channel, uint8_t numBytes)
+//
+// programs the MDR1 byte mode (CNTMODE_1..4), CNTR, DTR and OTR all take the
+// new width. The position carries on from the truncated counter.
+
+bool qc7366::setCounterBytes(uint8_t channel, uint8_t numBytes)
+{
+	uint8_t mdrValue = 0;
+	int32_t count = 0;
+
+	if ((channel > QC_MAX_CHANNEL) || (numBytes == 0) || (numBytes > QC_MAX_COUNTER_BYTES))
+	{
+		return false;
+	}
+
+	mdrValue  = readModeRegister(channel, QC_MODE_REGISTER_1);
+	mdrValue  = (mdrValue & ~0x03) | (QC_MAX_COUNTER_BYTES - numBytes);	// CNTMODE_4 .. CNTMODE_1
+	writeModeRegister(channel, QC_MODE_REGISTER_1, mdrValue);
+
+	counterBytes[channel] = numBytes;
+	count = readCounter(channel, READ_CNTR);
+
+	portENTER_CRITICAL(&positionMux);
+	lastCount[channel] = count;
+	portEXIT_CRITICAL(&positionMux);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint8_t qc7366::getCounterBytes(uint8_t channel)
+
+uint8_t qc7366::getCounterBytes(uint8_t channel)
+{
+	return (channel <= QC_MAX_CHANNEL) ? counterBytes[channel] : 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // void qc7366::TransferDataRegisterToCountRegister(uint8_t channel)
 
 void qc7366::transferDataRegisterToCountRegister(uint8_t channel)
 {
+	int32_t count = 0;
+
 	sendCommand(channel, LOAD_CNTR);
+
+	// the position restarts at the loaded value
+	if (channel <= QC_MAX_CHANNEL)
+	{
+		count = readCounter(channel, READ_CNTR);
+
+		portENTER_CRITICAL(&positionMux);
+		lastCount[channel] = count;
+		position[channel]  = count;
+		portEXIT_CRITICAL(&positionMux);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -246,9 +404,9 @@ void qc7366::writeDataRegister(uint8_t channel, int32_t dtrValue)
 		selectSPIDevice(channel);
 
 		spi_bus->writeByte(WRITE_DTR);
-		for (ix = 0; ix < 4; ix++) // Most Significant byte first!
+		for (ix = 0; ix < counterBytes[channel]; ix++) // Most Significant byte first!
 		{
-			spiData = (uint8_t)(dtrValue >> 8*(3 - ix));	// shift right 24, 16, 8, 0
+			spiData = (uint8_t)(dtrValue >> 8*(counterBytes[channel] - 1 - ix));	// shift right .., 8, 0
 			spi_bus->writeByte(spiData);
 		}		
 
@@ -259,30 +417,47 @@ void qc7366::writeDataRegister(uint8_t channel, int32_t dtrValue)
 
 ///////////////////////////////////////////////////////////////////////////////
 // int32_t qc7366::ReadOutputRegister(uint8_t channel)
+//
+// the latched count updates the 64 bit position like a counter read
 
 int32_t qc7366::readOutputRegister(uint8_t channel)
 {
 	int32_t count = 0;
-	uint8_t ix = 0;
-	uint8_t val = 0;
-	
+
 	if (channel <= QC_MAX_CHANNEL)
 	{
-		spi_bus->beginTransaction(QCSPISettings);
-		selectSPIDevice(channel);
+		count = readCounter(channel, READ_OTR);
+		trackPosition(channel, count);
+	}
 
-		spi_bus->writeByte(READ_OTR);
-		for (ix = 0; ix < 4; ix++)
+	return count;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void qc7366::latchOutputRegisters(uint8_t channelMask)
+//
+// LOAD_OTR to every channel in channelMask (bit 0 = channel 0) within one SPI
+// transaction, the counts are then read at leisure with readOutputRegister().
+// The chips share the select decoder, so the latches follow each other by
+// one command byte instead of happening at the same instant.
+
+void qc7366::latchOutputRegisters(uint8_t channelMask)
+{
+	uint8_t channel = 0;
+
+	spi_bus->beginTransaction(QCSPISettings);
+
+	for (channel = 0; channel <= QC_MAX_CHANNEL; channel++)
+	{
+		if ((channelMask & (1 << channel)) != 0)
 		{
-			spi_bus->readByte(&val);
-			count = (count << 8) | val;
+			selectSPIDevice(channel);
+			spi_bus->writeByte(LOAD_OTR);
+			spi_bus->deselectDevice();
 		}
-
-		spi_bus->deselectDevice();
-		spi_bus->endTransaction();
 	}
-	
-	return count;
+
+	spi_bus->endTransaction();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
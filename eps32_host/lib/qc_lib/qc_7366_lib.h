@@ -33,6 +33,13 @@
 #define QC_N_CHANNELS	2
 #define QC_MAX_CHANNEL	(QC_N_CHANNELS - 1)
 
+#define QC_MAX_COUNTER_BYTES	4		// counter width after init()
+
+// pollPositions() period of the main loop. The counters must be read within
+// half their range: 128 counts for a 1 byte counter, 12.8 kHz at 10 ms.
+
+#define QC_POSITION_POLL_MS		10
+
 ///////////////////////////////////////////////////////////////////////////////
 // registers & bit definitions
 
@@ -161,6 +168,12 @@ public:
 	void	clearCountRegister(uint8_t channel);
 	int32_t readCountRegister(uint8_t channel);
 
+	bool	setCounterBytes(uint8_t channel, uint8_t numBytes);
+	uint8_t getCounterBytes(uint8_t channel);
+	int64_t readPosition(uint8_t channel);
+	int64_t getPosition(uint8_t channel);
+	void	pollPositions(void);
+
 	void	clearStatusRegister(uint8_t channel);
 	uint8_t readStatusRegister(uint8_t channel);
 
@@ -168,6 +181,7 @@ public:
 	void	transferDataRegisterToCountRegister(uint8_t channel);
 
 	int32_t readOutputRegister(uint8_t channel);
+	void	latchOutputRegisters(uint8_t channelMask);
 
 	void	enableCounter(uint8_t channel);
 	void	disableCounter(uint8_t channel);
@@ -176,10 +190,19 @@ public:
 private:
     void selectSPIDevice(uint8_t dacChannel);
 	void sendCommand(uint8_t channel, uint8_t commandByte);
+	int32_t readCounter(uint8_t channel, uint8_t readCommand);
+	void trackPosition(uint8_t channel, int32_t count);
 
 	spi *spi_bus;
     SPISettings QCSPISettings = SPISettings(SPI_QC_SPEED, SPI_MSBFIRST, SPI_MODE0);
 
+	// counter width (MDR1 byte mode) and the software extension to 64 bit.
+	// The compare task reads counters as well, hence the lock.
+	uint8_t counterBytes[QC_N_CHANNELS];
+	int32_t lastCount[QC_N_CHANNELS];
+	int64_t position[QC_N_CHANNELS];
+	portMUX_TYPE positionMux = portMUX_INITIALIZER_UNLOCKED;
+
 };
 
 #endif // QC7366LIB_H
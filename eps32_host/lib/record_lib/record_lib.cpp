@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// RecordLib.cpp
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include <rom/crc.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "record_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// static uint32_t *recordCRC(void *record, uint16_t size)
+//
+// the CRC is the last word of the record and covers all bytes before it
+
+static uint32_t *recordCRC(void *record, uint16_t size)
+{
+	return (uint32_t *)((uint8_t *)record + size - sizeof(uint32_t));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// static uint32_t calculateCRC(const void *record, uint16_t size)
+
+static uint32_t calculateCRC(const void *record, uint16_t size)
+{
+	return crc32_le(0, (const uint8_t *)record, size - sizeof(uint32_t));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool recordLoad(const char *path, void *record, uint16_t size,
+//				   uint32_t magic, uint16_t version)
+//
+// LittleFS is mounted at boot and stays mounted, begin() only mounts it when
+// that has not happened yet
+
+bool recordLoad(const char *path, void *record, uint16_t size, uint32_t magic, uint16_t version)
+{
+	record_header_t *header = (record_header_t *)record;
+	bool valid = false;
+
+	if (!LittleFS.begin(true))
+	{
+		return false;
+	}
+
+	File file = LittleFS.open(path, FILE_READ);
+	if (file && !file.isDirectory())
+	{
+		if (file.read((uint8_t *)record, size) == size)
+		{
+			valid = (header->magic == magic) &&
+					(header->version == version) &&
+					(header->size == size) &&
+					(*recordCRC(record, size) == calculateCRC(record, size));
+		}
+		file.close();
+	}
+
+	return valid;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool recordCommit(const char *path, const char *tempPath, void *record,
+//					 uint16_t size, uint32_t magic, uint16_t version)
+//
+// written to a temporary file first and renamed, a power failure during the
+// write leaves the previous record intact. LittleFS rename() replaces an
+// existing file atomically, removing it first would open a window without
+// any record.
+
+bool recordCommit(const char *path, const char *tempPath, void *record, uint16_t size,
+				  uint32_t magic, uint16_t version)
+{
+	record_header_t *header = (record_header_t *)record;
+	bool result = false;
+
+	header->magic   = magic;
+	header->version = version;
+	header->size    = size;
+	*recordCRC(record, size) = calculateCRC(record, size);
+
+	if (!LittleFS.begin(true))
+	{
+		return false;
+	}
+
+	File file = LittleFS.open(tempPath, FILE_WRITE);
+	if (file)
+	{
+		result = (file.write((const uint8_t *)record, size) == size);
+		file.close();
+
+		if (result)
+		{
+			result = LittleFS.rename(tempPath, path);
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// RecordLib.h
+//
+// a fixed size binary record in LittleFS, checked by magic, version, size and
+// CRC32. Used by the calibration and settings stores.
+//
+// A record struct starts with a record_header_t and ends with the uint32_t
+// CRC of everything in front of it:
+//
+//   typedef struct
+//   {
+//       record_header_t header;
+//       ...
+//       uint32_t crc;
+//   } my_record_t;
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef RECORDLIB_H
+#define RECORDLIB_H
+
+#include <Arduino.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+// compile time check of a record struct, the CRC has to be its last word
+#define RECORD_CHECK_LAYOUT(type) \
+	static_assert(offsetof(type, crc) == sizeof(type) - sizeof(uint32_t), #type ": crc is not the last word")
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;						// sizeof the whole record
+} record_header_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+//
+// recordLoad() returns false when the file is missing, too short, or its
+// header or CRC does not match, the record is then left undefined.
+// recordCommit() fills in the header & CRC before it writes.
+
+bool recordLoad(const char *path, void *record, uint16_t size, uint32_t magic, uint16_t version);
+bool recordCommit(const char *path, const char *tempPath, void *record, uint16_t size,
+				  uint32_t magic, uint16_t version);
+
+#endif	// RECORDLIB_H
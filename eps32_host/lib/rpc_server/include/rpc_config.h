@@ -10,7 +10,9 @@
 //#define CONFIG_COMM_MODE COMM_WIFI
 
 // WiFi configuration (used when COMM_WIFI mode is selected)
-// Use these default values if WIFI_CONFIGURE_SERVER is not defined
+// Use these default values if WIFI_CONFIGURE_SERVER is not defined.
+// The SSID, password, port and baud rate below are defaults of the settings
+// record (settings_lib), configGet/configSet change them at runtime.
 #define CONFIG_WIFI_SSID "ESP32_RPC"
 #define CONFIG_WIFI_PASSWORD "password123"
 
@@ -19,10 +21,23 @@
 // USB/Serial configuration
 #define CONFIG_BAUD_RATE 115200
 
+// setBaudRate: range accepted, and the time the host has to confirm the new
+// rate with a request before the server falls back to the previous rate
+#define RPC_BAUD_RATE_MIN 9600
+#define RPC_BAUD_RATE_MAX 5000000
+#define RPC_BAUD_CONFIRM_MS 2000
+
 // When 0, suppress non-JSON Serial logs so the RPC stream is clean.
 // Set to 1 to enable human-readable logs on Serial.
 #define RPC_SERIAL_LOGS 0
 
+// Per method call counts & latency histograms (stats/statsReset RPCs).
+// Set to 0 to compile the instrumentation out completely.
+#ifndef RPC_STATS_ENABLED
+#define RPC_STATS_ENABLED 1
+#endif
+#define RPC_STATS_PAGE_SIZE 8
+
 // RPC Protocol version
 #define RPC_VERSION 1
 
@@ -37,4 +52,17 @@
 // Pulse library configuration
 #define NUMBER_OF_PULSE_LIB_INSTANCES 4
 
+// Prepared method handles (prepare/release RPCs, invoke frames)
+#define RPC_MAX_PREPARED 16
+
+// Job table (jobDelay/jobPulses and the blocking delay, pulse and
+// generatePulses RPCs that run as jobs)
+#define RPC_MAX_JOBS 8
+
+// Input events returned per eventsRead, bounded by the response buffer
+#define RPC_EVENTS_MAX_READ 16
+
+// Trace records per traceDump chunk, 8 bytes each and base64 encoded
+#define RPC_TRACE_DUMP_RECORDS 96
+
 #endif
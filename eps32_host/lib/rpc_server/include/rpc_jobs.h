@@ -0,0 +1,76 @@
+#ifndef RPC_JOBS_H
+#define RPC_JOBS_H
+
+#include <Arduino.h>
+#include "rpc_config.h"
+#include "pulse_lib.h"
+
+// Long running operations as on-device jobs: a fixed table of delays and
+// pulse trains, advanced by poll() from the main loop instead of delay()
+// inside a request handler. A finished job stays in its slot, with its final
+// state, until the slot is needed for a new job.
+
+// Handler result of a blocking RPC that answers once its job has finished,
+// never sent to the host
+#define RPC_RESPONSE_DEFERRED -1
+
+// Job flags, given at start
+#define RPC_JOB_NOTIFY 0x01        // send an event line when the job finishes
+#define RPC_JOB_DEFERRED 0x02      // a blocking RPC answers when the job finishes
+#define RPC_JOB_SERIAL 0x04        // started over Serial, else over TCP
+
+typedef enum {
+  RPC_JOB_DELAY,
+  RPC_JOB_PULSES
+} rpc_job_type_t;
+
+typedef enum {
+  RPC_JOB_RUNNING,
+  RPC_JOB_DONE,
+  RPC_JOB_HALTED,                  // pulse train stopped by a guard or compare
+  RPC_JOB_CANCELLED                // jobCancel or a stopPulse on the channel
+} rpc_job_state_t;
+
+typedef struct {
+  uint16_t id;                     // 0 = free slot
+  rpc_job_type_t type;
+  rpc_job_state_t state;
+  uint8_t flags;
+  bool reported;                   // finish handed out by nextFinished()
+  int8_t channel;                  // pulse channel, -1 for a delay
+  uint32_t startMs;
+  uint32_t endMs;                  // valid once finished
+  uint32_t done;                   // ms waited or pulses started
+  uint32_t total;
+} rpc_job_t;
+
+class RpcJobs {
+  public:
+    RpcJobs();
+    void begin(PulseLib* channels, uint8_t num_channels);
+
+    // return the job id, 0 when no slot is free or the channel is busy or
+    // not begun
+    uint16_t startDelay(uint32_t ms, uint8_t flags);
+    uint16_t startPulses(uint8_t channel, uint32_t width_ms, uint32_t pause_ms, uint32_t count, uint8_t flags);
+    bool cancel(uint16_t id);
+
+    void poll();
+    const rpc_job_t* nextFinished();
+    const rpc_job_t* find(uint16_t id);
+    const rpc_job_t* get(uint8_t index);   // nullptr for a free slot
+    bool isChannelBusy(uint8_t channel);
+    bool hasRunning();
+
+  private:
+    rpc_job_t* allocate(rpc_job_type_t type, uint8_t flags);
+    void update(rpc_job_t* job);
+    void finish(rpc_job_t* job, rpc_job_state_t state);
+
+    rpc_job_t _jobs[RPC_MAX_JOBS];
+    PulseLib* _channels;
+    uint8_t _numChannels;
+    uint16_t _nextId;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef RPC_PARAMS_H
+#define RPC_PARAMS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <float.h>
+#include <stddef.h>
+
+// Typed parameter binding for RPC handlers. A handler declares a struct with
+// one member per parameter, named like the JSON key, and a constexpr table of
+// field descriptors built with the macros below:
+//
+//   typedef struct {
+//     uint8_t channel;
+//     bool reset;
+//   } pulse_stats_params_t;
+//
+//   static constexpr rpc_param_t PULSE_STATS_PARAMS[] = {
+//     RPC_REQUIRED_RANGE(pulse_stats_params_t, channel, 0, NUMBER_OF_PULSE_LIB_INSTANCES - 1),
+//     RPC_OPTIONAL(pulse_stats_params_t, reset, true),
+//   };
+//
+//   pulse_stats_params_t p;
+//   if (!rpcBindParams(params, PULSE_STATS_PARAMS, &p)) {
+//     return RPC_ERROR_INVALID_PARAMS;
+//   }
+//
+// rpcBindParams() walks the request object once: every key is matched
+// against the table, type and range checked and stored. A missing required
+// field, a wrong type or a value out of range fails the bind, missing
+// optional fields get their default and unknown keys are ignored.
+//
+// Without an explicit range a field accepts the range of its C type, so a
+// negative number can not wrap into an unsigned field.
+//
+// A setting a request may leave unchanged is an rpc_flag_t instead of a
+// bool: it takes true/false like a bool and defaults to RPC_FLAG_KEEP.
+
+#define RPC_PARAMS_MAX_FIELDS 32   // fields per table, one bit each while binding
+#define RPC_ARGS_MAX_SIZE 32       // bytes of a parameter struct bound by the dispatcher
+
+typedef enum {
+  RPC_PARAM_BOOL,
+  RPC_PARAM_FLAG,                  // rpc_flag_t
+  RPC_PARAM_UINT8,
+  RPC_PARAM_UINT16,
+  RPC_PARAM_UINT32,
+  RPC_PARAM_INT8,
+  RPC_PARAM_INT16,
+  RPC_PARAM_INT32,
+  RPC_PARAM_FLOAT,
+  RPC_PARAM_STRING,                // const char*, points into the request document
+  RPC_PARAM_ARRAY                  // JsonArray, the elements are not checked
+} rpc_param_kind_t;
+
+typedef enum : uint8_t {
+  RPC_FLAG_FALSE,
+  RPC_FLAG_TRUE,
+  RPC_FLAG_KEEP                    // not in the request
+} rpc_flag_t;
+
+typedef struct {
+  const char* name;
+  rpc_param_kind_t kind;
+  uint16_t offset;
+  bool required;
+  int64_t minInt;                  // integer & bool fields
+  int64_t maxInt;
+  int64_t defaultInt;
+  float minFloat;                  // float fields
+  float maxFloat;
+  float defaultFloat;
+} rpc_param_t;
+
+// Field kind and natural range of every supported member type, any other
+// member type fails to compile
+template <typename T> struct RpcParamKind;
+
+#define RPC_PARAM_KIND(type, id, lo, hi) \
+  template <> struct RpcParamKind<type> { \
+    static constexpr rpc_param_kind_t kind = id; \
+    static constexpr double minValue = lo; \
+    static constexpr double maxValue = hi; \
+  }
+
+RPC_PARAM_KIND(bool, RPC_PARAM_BOOL, 0, 1);
+RPC_PARAM_KIND(rpc_flag_t, RPC_PARAM_FLAG, 0, 1);
+RPC_PARAM_KIND(uint8_t, RPC_PARAM_UINT8, 0, UINT8_MAX);
+RPC_PARAM_KIND(uint16_t, RPC_PARAM_UINT16, 0, UINT16_MAX);
+RPC_PARAM_KIND(uint32_t, RPC_PARAM_UINT32, 0, UINT32_MAX);
+RPC_PARAM_KIND(int8_t, RPC_PARAM_INT8, INT8_MIN, INT8_MAX);
+RPC_PARAM_KIND(int16_t, RPC_PARAM_INT16, INT16_MIN, INT16_MAX);
+RPC_PARAM_KIND(int32_t, RPC_PARAM_INT32, INT32_MIN, INT32_MAX);
+RPC_PARAM_KIND(float, RPC_PARAM_FLOAT, -FLT_MAX, FLT_MAX);
+RPC_PARAM_KIND(const char*, RPC_PARAM_STRING, 0, 0);
+RPC_PARAM_KIND(JsonArray, RPC_PARAM_ARRAY, 0, 0);
+
+template <typename T>
+constexpr rpc_param_t rpcParam(const char* name, uint16_t offset, bool required,
+                               double lo, double hi, double def) {
+  return (RpcParamKind<T>::kind == RPC_PARAM_FLOAT)
+    ? rpc_param_t{name, RPC_PARAM_FLOAT, offset, required, 0, 0, 0, (float)lo, (float)hi, (float)def}
+    : rpc_param_t{name, RpcParamKind<T>::kind, offset, required, (int64_t)lo, (int64_t)hi, (int64_t)def, 0, 0, 0};
+}
+
+#define RPC_PARAM_TYPE(type, member) decltype(type::member)
+
+#define RPC_REQUIRED_RANGE(type, member, lo, hi) \
+  rpcParam<RPC_PARAM_TYPE(type, member)>(#member, offsetof(type, member), true, lo, hi, 0)
+#define RPC_REQUIRED(type, member) \
+  RPC_REQUIRED_RANGE(type, member, RpcParamKind<RPC_PARAM_TYPE(type, member)>::minValue, \
+                     RpcParamKind<RPC_PARAM_TYPE(type, member)>::maxValue)
+
+// An optional string or array defaults to null, pass 0 as default
+#define RPC_OPTIONAL_RANGE(type, member, lo, hi, def) \
+  rpcParam<RPC_PARAM_TYPE(type, member)>(#member, offsetof(type, member), false, lo, hi, def)
+#define RPC_OPTIONAL(type, member, def) \
+  RPC_OPTIONAL_RANGE(type, member, RpcParamKind<RPC_PARAM_TYPE(type, member)>::minValue, \
+                     RpcParamKind<RPC_PARAM_TYPE(type, member)>::maxValue, def)
+
+// Size of a parameter struct the dispatcher binds into its own buffer
+template <typename T>
+constexpr uint8_t rpcArgsSize() {
+  static_assert(sizeof(T) <= RPC_ARGS_MAX_SIZE, "RPC parameter struct too large");
+  return sizeof(T);
+}
+
+bool rpcBindFields(JsonObject params, const rpc_param_t* fields, uint8_t num_fields, void* out);
+
+// Positional binding for prepared calls: values[i] is stored into
+// fields[layout[i]], the layout lists every required field (rpcCheckLayout)
+bool rpcBindValues(JsonArray values, const rpc_param_t* fields, uint8_t num_fields,
+                   const uint8_t* layout, uint8_t num_values, void* out);
+
+// Field index of a parameter name, -1 when the table has no such field
+int8_t rpcFindField(const rpc_param_t* fields, uint8_t num_fields, const char* name);
+
+// A layout of distinct field indexes that covers every required field
+bool rpcCheckLayout(const rpc_param_t* fields, uint8_t num_fields, const uint8_t* layout, uint8_t num_values);
+
+template <typename T, size_t N>
+inline bool rpcBindParams(JsonObject params, const rpc_param_t (&fields)[N], T* out) {
+  static_assert(N <= RPC_PARAMS_MAX_FIELDS, "too many fields in an RPC parameter table");
+  return rpcBindFields(params, fields, N, out);
+}
+
+#endif
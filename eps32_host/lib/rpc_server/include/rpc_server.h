@@ -4,9 +4,25 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "rpc_config.h"
+#include "rpc_stats.h"
+#include "rpc_params.h"
+#include "rpc_jobs.h"
+#include "trace_lib.h"
 #include "pulse_lib.h"
+#include "pulse_guard.h"
+#include "shadow_lib.h"
+#if defined INCLUDE_QC_COMPARE
+#include "compare_lib.h"
+#endif
 #include <WiFi.h>
 
+// Handler load, read by the OLED dashboard
+typedef struct {
+  uint32_t calls;
+  uint32_t handlerUs;
+  uint32_t handlerMaxUs;
+} rpc_metrics_t;
+
 class RpcServer {
 
 public:
@@ -15,37 +31,131 @@ public:
   void handle_serial();
   void handle_wifi();
   void handlePulseTicks();  // Process pulse ticks for all active channels
+  void handleJobs();        // Finished jobs: deferred responses & notifications
+  // Safe to call from another task (OLED dashboard): they only read words
+  // the loop task publishes, reset_max ends the handlerMaxUs window without
+  // writing the metrics
+  void getMetrics(rpc_metrics_t* metrics, bool reset_max);
+  uint8_t getActivePulseChannels();
+  bool hasRunningJobs();
+  uint8_t getClientCount();
   
 private:
   DynamicJsonDocument request_doc{2048};
-  DynamicJsonDocument response_doc{2048};
-  DynamicJsonDocument response_data{1024};  // Storage for response data
+  DynamicJsonDocument response_doc{3072};
+  DynamicJsonDocument response_data{2048};  // Storage for response data
 
   PulseLib pulseLibChannels[NUMBER_OF_PULSE_LIB_INSTANCES];
+  PulseGuard pulseGuard;
+  outputShadow output_shadow;    // GPIO modes & LEDC duty written over RPC
+#if defined INCLUDE_QC_COMPARE
+  qcCompare encoderCompare;      // acts on pulseLibChannels
+#endif
+  RpcJobs jobs;                  // delays & pulse trains on pulseLibChannels
+  uint16_t deferred_job;         // blocking RPC waiting for this job, 0 = none
   
   // WiFi TCP Server
   WiFiServer* tcp_server;
   WiFiClient tcp_client;
   bool tcp_server_started;
+
+  // Serial baud rate negotiation (setBaudRate)
+  bool serial_request;           // request being handled came in over Serial
+  uint32_t pending_baud;         // switch after the response is sent
+  uint32_t previous_baud;
+  uint32_t serial_baud;          // rate the serial link runs at
+  uint32_t baud_switch_ms;
+  bool baud_unconfirmed;
+  void switchBaudRate(uint32_t baud);
+  void checkBaudRateConfirmed();
+  bool isBaudRateConfirmed(uint32_t baud);
+
+  // Input snapshot (snapshotConfig/snapshot), bit n = channel n
+  uint8_t snapshot_adc_mask;
+  uint8_t snapshot_qc_mask;
+  bool snapshot_dio;
+  bool snapshot_voltage;         // ADC values in volt instead of raw
+
+  // Methods with a typed parameter table. They are called by name or, once
+  // prepared, by an invoke frame {"h": handle, "v": [values]} that carries
+  // the parameters in the prepared order and skips name dispatch and keys.
+  typedef struct {
+    const char* name;
+    const rpc_param_t* fields;
+    uint8_t numFields;
+    uint8_t argsSize;
+    int (RpcServer::*run)(const void* args);
+  } bound_method_t;
+
+  typedef struct {
+    const bound_method_t* method;  // nullptr = free handle
+    uint8_t numValues;
+    uint8_t layout[RPC_PARAMS_MAX_FIELDS];  // field index of every value
+  } prepared_t;
+
+  static const bound_method_t bound_methods[];
+  static const uint8_t num_bound_methods;
+  prepared_t prepared[RPC_MAX_PREPARED];
+  const bound_method_t* findBoundMethod(const char* method);
+  const char* requestMethod(const prepared_t** prepared_call);
+  int invoke(const prepared_t* prepared_call, JsonArray values);
+
+  // written by the loop task only. A reader that wants a new max window
+  // counts max_reads up, the next dispatch() starts the window when it sees
+  // the count change. max_reads & max_read_calls belong to the reader.
+  volatile rpc_metrics_t metrics;
+  volatile uint32_t max_reads;
+  uint32_t max_reads_seen;
+  uint32_t max_read_calls;         // calls at the last reset_max read
+  volatile uint8_t client_count;   // TCP client connected, set by handle_wifi()
+#if RPC_STATS_ENABLED
+  RpcStats stats;
+#endif
   
-  // RPC Handler methods
+  // RPC Handler methods, the (const void* args) handlers are bound methods
+  int dispatch(const char* method, JsonObject params,
+               const prepared_t* prepared_call = nullptr, JsonArray values = JsonArray());
   int execute_command(const char* method, JsonObject params);
   void send_response(int result_code, const char* message = "", JsonObject data = JsonObject());
   void send_response_tcp(int result_code, const char* message = "", JsonObject data = JsonObject());
+  void send_job_event(const rpc_job_t* job);
+  int deferResponse(uint16_t job_id);
+  uint8_t jobOrigin();
   
   // GPIO functions
   int rpc_pinMode(JsonObject params);
-  int rpc_digitalWrite(JsonObject params);
-  int rpc_digitalRead(JsonObject params);
+  int rpc_digitalWrite(const void* args);
+  int rpc_digitalRead(const void* args);
   int rpc_analogWrite(JsonObject params);
-  int rpc_analogRead(JsonObject params);
+  int rpc_analogRead(const void* args);
   
   // System functions
   int rpc_delay(JsonObject params);
   int rpc_getMillis(JsonObject params);
   int rpc_getFreeMem(JsonObject params);
   int rpc_getChipID(JsonObject params);
+  int rpc_setBaudRate(JsonObject params);
+  int rpc_bootProfile(JsonObject params);
+  int rpc_prepare(JsonObject params);
+  int rpc_release(JsonObject params);
+  int rpc_configGet(JsonObject params);
+  int rpc_configSet(JsonObject params);
+  int rpc_configCommit(JsonObject params);
+  int rpc_configReset(JsonObject params);
+#if RPC_STATS_ENABLED
+  int rpc_stats(JsonObject params);
+  int rpc_statsReset(JsonObject params);
+#endif
+#if defined INCLUDE_TRACE
+  int rpc_traceStart(JsonObject params);
+  int rpc_traceStop(JsonObject params);
+  int rpc_traceDump(JsonObject params);
+#endif
   
+  // Input snapshot functions
+  int rpc_snapshotConfig(JsonObject params);
+  int rpc_snapshot(JsonObject params);
+
   // I2C functions
   int rpc_i2c_begin(JsonObject params);
   int rpc_i2c_write(JsonObject params);
@@ -53,47 +163,112 @@ private:
   
   // PWM/Analog functions
   int rpc_ledcSetup(JsonObject params);
-  int rpc_ledcWrite(JsonObject params);
+  int rpc_ledcWrite(const void* args);
+  int rpc_shadowStats(JsonObject params);
+  int rpc_shadowInvalidate(JsonObject params);
   
   // Pulse library functions
   int rpc_pulseBegin(JsonObject params);
-  int rpc_pulse(JsonObject params);
-  int rpc_pulseAsync(JsonObject params);
-  int rpc_isPulsing(JsonObject params);
-  int rpc_getRemainingPulses(JsonObject params);
-  int rpc_stopPulse(JsonObject params);
+  int rpc_pulse(const void* args);
+  int rpc_pulseAsync(const void* args);
+  int rpc_isPulsing(const void* args);
+  int rpc_getRemainingPulses(const void* args);
+  int rpc_stopPulse(const void* args);
   int rpc_generatePulses(JsonObject params);
-  int rpc_generatePulsesAsync(JsonObject params);
+  int rpc_generatePulsesAsync(const void* args);
+  int rpc_pulseStats(JsonObject params);
+  int rpc_jobDelay(JsonObject params);
+  int rpc_jobPulses(JsonObject params);
+  int rpc_jobStatus(JsonObject params);
+  int rpc_jobList(JsonObject params);
+  int rpc_jobCancel(JsonObject params);
+  int rpc_guardBind(JsonObject params);
+  int rpc_guardUnbind(JsonObject params);
+  int rpc_guardStatus(JsonObject params);
 
   // DAC library functions
-  int rpc_dacSetVoltage(JsonObject params);
+  int rpc_dacSetVoltage(const void* args);
   int rpc_dacSetVoltageAll(JsonObject params);
+  int rpc_dacSetVoltages(JsonObject params);
+
+#if defined INCLUDE_DAC_WAVE_LIB
+  // DAC waveform functions
+  int rpc_waveUpload(JsonObject params);
+  int rpc_waveSetup(JsonObject params);
+  int rpc_waveStart(JsonObject params);
+  int rpc_waveStop(JsonObject params);
+#endif
+
+#if defined INCLUDE_CALIBRATION_STORE
+  // Calibration functions
+  int rpc_calGet(JsonObject params);
+  int rpc_calSet(JsonObject params);
+  int rpc_calCommit(JsonObject params);
+  int rpc_calReset(JsonObject params);
+#endif
 
   // ADC library functions
-  int rpc_adcReadRaw(JsonObject params);
+  int rpc_adcReadRaw(const void* args);
   int rpc_adcReadVoltage(JsonObject params);
   int rpc_isButtonPressed(JsonObject params);
 
+#if defined INCLUDE_ADC_SAMPLER
+  // Background ADC sampler functions
+  int rpc_adcSamplerStart(JsonObject params);
+  int rpc_adcSamplerStop(JsonObject params);
+  int rpc_adcSamplerStatus(JsonObject params);
+  int rpc_adcSamplerRead(JsonObject params);
+  int rpc_adcFilterSet(JsonObject params);
+  int rpc_adcFilterRead(JsonObject params);
+#endif
+
+#if defined INCLUDE_ADC_CAPTURE
+  // Triggered burst capture functions
+  int rpc_captureArm(JsonObject params);
+  int rpc_captureStop(JsonObject params);
+  int rpc_captureTrigger(JsonObject params);
+  int rpc_captureStatus(JsonObject params);
+  int rpc_captureRead(JsonObject params);
+#endif
+
   // DIO library functions
   int rpc_dioGetInput(JsonObject params);
-  int rpc_dioIsBitSet(JsonObject params);
-  int rpc_dioSetOutput(JsonObject params);
-  int rpc_dioSetBit(JsonObject params);
-  int rpc_dioClearBit(JsonObject params);
+  int rpc_dioIsBitSet(const void* args);
+  int rpc_dioSetOutput(const void* args);
+  int rpc_dioSetBit(const void* args);
+  int rpc_dioClearBit(const void* args);
   int rpc_dioToggleBit(JsonObject params);
 
+#if defined INCLUDE_INPUT_EVENTS
+  // Input event functions
+  int rpc_eventsEnable(JsonObject params);
+  int rpc_eventsDisable(JsonObject params);
+  int rpc_eventsRead(JsonObject params);
+  int rpc_eventsClear(JsonObject params);
+#endif
+
 #if defined INCLUDE_QC_7366_LIB
   // QC7366 library functions
   int rpc_qcEnableCounter(JsonObject params);
   int rpc_qcDisableCounter(JsonObject params);
   int rpc_qcClearCountRegister(JsonObject params);
-  int rpc_qcReadCountRegister(JsonObject params);
+  int rpc_qcReadCountRegister(const void* args);
+  int rpc_qcSetCounterWidth(JsonObject params);
+#endif
+
+#if defined INCLUDE_QC_COMPARE
+  // Encoder position compare
+  int rpc_qcCompareArm(JsonObject params);
+  int rpc_qcCompareDisarm(JsonObject params);
+  int rpc_qcCompareStatus(JsonObject params);
 #endif
   
 #if defined INCLUDE_OLED_DISPLAY
   // OLED library functions
   int rpc_oledClear(JsonObject params);
   int rpc_oledWriteLine(JsonObject params);
+  int rpc_oledFlush(JsonObject params);
+  int rpc_oledDashboard(JsonObject params);
 #endif
   // Utility
   String getMethodName(const char* method);
@@ -0,0 +1,65 @@
+#ifndef RPC_STATS_H
+#define RPC_STATS_H
+
+#include <Arduino.h>
+#include "rpc_config.h"
+
+// Per method instrumentation: call & error counts and the parse, execute and
+// serialize time of every request in log2 histograms. Compiled out completely
+// when RPC_STATS_ENABLED is 0.
+
+#if RPC_STATS_ENABLED
+
+#define RPC_STATS_MAX_METHODS 80   // last slot collects methods that do not fit
+#define RPC_STATS_NAME_LENGTH 24
+#define RPC_STATS_N_BUCKETS 16     // bucket n holds [2^(n-1), 2^n) us
+
+typedef enum {
+  RPC_PHASE_PARSE,
+  RPC_PHASE_EXECUTE,
+  RPC_PHASE_SERIALIZE,
+  RPC_N_PHASES
+} rpc_phase_t;
+
+typedef struct {
+  char name[RPC_STATS_NAME_LENGTH];
+  uint32_t calls;
+  uint32_t errors;
+  uint32_t totalUs[RPC_N_PHASES];
+  uint32_t maxUs[RPC_N_PHASES];
+  uint16_t histogram[RPC_N_PHASES][RPC_STATS_N_BUCKETS];  // saturating
+} rpc_method_stats_t;
+
+class RpcStats {
+  public:
+    RpcStats();
+    void record(const char* method, int result, uint32_t parse_us, uint32_t execute_us, uint32_t serialize_us);
+    void reset();
+    uint8_t count();
+    const rpc_method_stats_t* get(uint8_t index);
+    const rpc_method_stats_t* find(const char* method);
+
+  private:
+    rpc_method_stats_t* lookup(const char* method);
+    void addSample(rpc_method_stats_t* entry, rpc_phase_t phase, uint32_t us);
+
+    rpc_method_stats_t _methods[RPC_STATS_MAX_METHODS];
+    uint8_t _count;
+};
+
+#define RPC_STATS_TIMESTAMP(var) uint32_t var = micros()
+#define RPC_STATS_RECORD(stats, method, result, parse_start, execute_start, serialize_start) \
+  do { \
+    uint32_t serialize_end = micros(); \
+    (stats).record((method), (result), (execute_start) - (parse_start), \
+                   (serialize_start) - (execute_start), serialize_end - (serialize_start)); \
+  } while (0)
+
+#else
+
+#define RPC_STATS_TIMESTAMP(var)
+#define RPC_STATS_RECORD(stats, method, result, parse_start, execute_start, serialize_start)
+
+#endif
+
+#endif
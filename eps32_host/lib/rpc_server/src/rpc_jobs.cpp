@@ -0,0 +1,177 @@
+#include "rpc_jobs.h"
+
+RpcJobs::RpcJobs() {
+  memset(_jobs, 0, sizeof(_jobs));
+  _channels = nullptr;
+  _numChannels = 0;
+  _nextId = 1;
+}
+
+void RpcJobs::begin(PulseLib* channels, uint8_t num_channels) {
+  _channels = channels;
+  _numChannels = num_channels;
+}
+
+// A free slot, else the finished and reported job that ended longest ago.
+// Running jobs and finishes not handed out yet are never overwritten.
+rpc_job_t* RpcJobs::allocate(rpc_job_type_t type, uint8_t flags) {
+  rpc_job_t* slot = nullptr;
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    rpc_job_t* job = &_jobs[i];
+    if (job->id == 0) {
+      slot = job;
+      break;
+    }
+    if (job->state != RPC_JOB_RUNNING && job->reported &&
+        (slot == nullptr || now - job->endMs > now - slot->endMs)) {
+      slot = job;
+    }
+  }
+  if (slot == nullptr) {
+    return nullptr;
+  }
+
+  memset(slot, 0, sizeof(rpc_job_t));
+  slot->id = _nextId;
+  slot->type = type;
+  slot->state = RPC_JOB_RUNNING;
+  slot->flags = flags;
+  slot->channel = -1;
+  slot->startMs = now;
+
+  _nextId = (_nextId == UINT16_MAX) ? 1 : _nextId + 1;
+  return slot;
+}
+
+uint16_t RpcJobs::startDelay(uint32_t ms, uint8_t flags) {
+  rpc_job_t* job = allocate(RPC_JOB_DELAY, flags);
+  if (job == nullptr) {
+    return 0;
+  }
+  job->total = ms;
+  return job->id;
+}
+
+// The train runs on the async pulse generator of the channel, ticked from
+// the main loop. A halt latched by an earlier train is cleared so the job
+// can tell its own halt apart. A train refused because a guard pin is already
+// active keeps its job, the next poll() finishes it as halted.
+uint16_t RpcJobs::startPulses(uint8_t channel, uint32_t width_ms, uint32_t pause_ms, uint32_t count, uint8_t flags) {
+  if (channel >= _numChannels || _channels[channel].isPulsing() || isChannelBusy(channel)) {
+    return 0;
+  }
+
+  rpc_job_t* job = allocate(RPC_JOB_PULSES, flags);
+  if (job == nullptr) {
+    return 0;
+  }
+  job->channel = channel;
+  job->total = count;
+
+  _channels[channel].clearHalt();
+  if (count > 0) {
+    if (!_channels[channel].generetePulsesAsync(width_ms, pause_ms, count) &&
+        _channels[channel].getHaltReason() == PULSE_HALT_NONE) {
+      job->id = 0;  // channel not begun
+      return 0;
+    }
+  }
+  return job->id;
+}
+
+bool RpcJobs::cancel(uint16_t id) {
+  rpc_job_t* job = (rpc_job_t*)find(id);
+  if (job == nullptr || job->state != RPC_JOB_RUNNING) {
+    return false;
+  }
+  if (job->type == RPC_JOB_PULSES) {
+    update(job);
+    if (job->state != RPC_JOB_RUNNING) {
+      return true;  // finished before the cancel
+    }
+    _channels[job->channel].stopPulse();
+  }
+  finish(job, RPC_JOB_CANCELLED);
+  return true;
+}
+
+void RpcJobs::finish(rpc_job_t* job, rpc_job_state_t state) {
+  job->state = state;
+  job->endMs = millis();
+  job->reported = false;
+}
+
+void RpcJobs::update(rpc_job_t* job) {
+  if (job->type == RPC_JOB_DELAY) {
+    uint32_t elapsed = millis() - job->startMs;
+    job->done = (elapsed < job->total) ? elapsed : job->total;
+    if (elapsed >= job->total) {
+      finish(job, RPC_JOB_DONE);
+    }
+    return;
+  }
+
+  PulseLib* channel = &_channels[job->channel];
+  if (channel->isPulsing()) {
+    // pulses started so far, the remaining count drops at every rising edge
+    job->done = job->total - channel->getRemainingPulses();
+  } else if (channel->getHaltReason() != PULSE_HALT_NONE) {
+    job->done = job->total - channel->getCutPulses();
+    finish(job, RPC_JOB_HALTED);
+  } else {
+    finish(job, (job->done >= job->total) ? RPC_JOB_DONE : RPC_JOB_CANCELLED);
+  }
+}
+
+void RpcJobs::poll() {
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    if (_jobs[i].id != 0 && _jobs[i].state == RPC_JOB_RUNNING) {
+      update(&_jobs[i]);
+    }
+  }
+}
+
+// Hands out every finish once, for deferred responses and notifications
+const rpc_job_t* RpcJobs::nextFinished() {
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    rpc_job_t* job = &_jobs[i];
+    if (job->id != 0 && job->state != RPC_JOB_RUNNING && !job->reported) {
+      job->reported = true;
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+const rpc_job_t* RpcJobs::find(uint16_t id) {
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    if (id != 0 && _jobs[i].id == id) {
+      return &_jobs[i];
+    }
+  }
+  return nullptr;
+}
+
+const rpc_job_t* RpcJobs::get(uint8_t index) {
+  return (index < RPC_MAX_JOBS && _jobs[index].id != 0) ? &_jobs[index] : nullptr;
+}
+
+bool RpcJobs::isChannelBusy(uint8_t channel) {
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    if (_jobs[i].id != 0 && _jobs[i].state == RPC_JOB_RUNNING && _jobs[i].channel == channel) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RpcJobs::hasRunning() {
+  for (uint8_t i = 0; i < RPC_MAX_JOBS; i++) {
+    if (_jobs[i].id != 0 && _jobs[i].state == RPC_JOB_RUNNING) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,166 @@
+#include "rpc_params.h"
+
+// Stores one JSON value into its struct member. Integers must be JSON
+// integers, floats accept any number, a bool or flag also accepts 0 and 1.
+static bool storeValue(const rpc_param_t* field, JsonVariant value, uint8_t* out) {
+  uint8_t* member = out + field->offset;
+  int64_t number = 0;
+  float real = 0.0;
+
+  switch (field->kind) {
+    case RPC_PARAM_FLOAT:
+      if (!value.is<float>()) {
+        return false;
+      }
+      real = value.as<float>();
+      // written so a NaN fails as well
+      if (!(real >= field->minFloat && real <= field->maxFloat)) {
+        return false;
+      }
+      *(float*)member = real;
+      return true;
+
+    case RPC_PARAM_STRING:
+      if (!value.is<const char*>()) {
+        return false;
+      }
+      *(const char**)member = value.as<const char*>();
+      return true;
+
+    case RPC_PARAM_ARRAY:
+      if (!value.is<JsonArray>()) {
+        return false;
+      }
+      *(JsonArray*)member = value.as<JsonArray>();
+      return true;
+
+    default:
+      break;
+  }
+
+  if (value.is<bool>() && (field->kind == RPC_PARAM_BOOL || field->kind == RPC_PARAM_FLAG)) {
+    number = value.as<bool>() ? 1 : 0;
+  } else if (value.is<int64_t>()) {
+    number = value.as<int64_t>();
+  } else {
+    return false;
+  }
+
+  if (number < field->minInt || number > field->maxInt) {
+    return false;
+  }
+
+  switch (field->kind) {
+    case RPC_PARAM_BOOL:   *(bool*)member = (number != 0); break;
+    case RPC_PARAM_FLAG:   *(rpc_flag_t*)member = (number != 0) ? RPC_FLAG_TRUE : RPC_FLAG_FALSE; break;
+    case RPC_PARAM_UINT8:  *(uint8_t*)member = (uint8_t)number; break;
+    case RPC_PARAM_UINT16: *(uint16_t*)member = (uint16_t)number; break;
+    case RPC_PARAM_UINT32: *(uint32_t*)member = (uint32_t)number; break;
+    case RPC_PARAM_INT8:   *(int8_t*)member = (int8_t)number; break;
+    case RPC_PARAM_INT16:  *(int16_t*)member = (int16_t)number; break;
+    case RPC_PARAM_INT32:  *(int32_t*)member = (int32_t)number; break;
+    default: return false;
+  }
+  return true;
+}
+
+static void storeDefault(const rpc_param_t* field, uint8_t* out) {
+  uint8_t* member = out + field->offset;
+
+  switch (field->kind) {
+    case RPC_PARAM_BOOL:   *(bool*)member = (field->defaultInt != 0); break;
+    case RPC_PARAM_FLAG:   *(rpc_flag_t*)member = (rpc_flag_t)field->defaultInt; break;
+    case RPC_PARAM_UINT8:  *(uint8_t*)member = (uint8_t)field->defaultInt; break;
+    case RPC_PARAM_UINT16: *(uint16_t*)member = (uint16_t)field->defaultInt; break;
+    case RPC_PARAM_UINT32: *(uint32_t*)member = (uint32_t)field->defaultInt; break;
+    case RPC_PARAM_INT8:   *(int8_t*)member = (int8_t)field->defaultInt; break;
+    case RPC_PARAM_INT16:  *(int16_t*)member = (int16_t)field->defaultInt; break;
+    case RPC_PARAM_INT32:  *(int32_t*)member = (int32_t)field->defaultInt; break;
+    case RPC_PARAM_FLOAT:  *(float*)member = field->defaultFloat; break;
+    case RPC_PARAM_STRING: *(const char**)member = nullptr; break;
+    case RPC_PARAM_ARRAY:  *(JsonArray*)member = JsonArray(); break;
+  }
+}
+
+// Fields not in bound get their default, a missing required field fails
+static bool bindDefaults(const rpc_param_t* fields, uint8_t num_fields, uint32_t bound, uint8_t* out) {
+  for (uint8_t ix = 0; ix < num_fields; ix++) {
+    if ((bound & (1UL << ix)) == 0) {
+      if (fields[ix].required) {
+        return false;
+      }
+      storeDefault(&fields[ix], out);
+    }
+  }
+  return true;
+}
+
+// One pass over the request: each key is compared against the fields not
+// bound yet, so a handler with k fields costs at most k string compares per
+// key instead of a containsKey and a lookup scan per field.
+bool rpcBindFields(JsonObject params, const rpc_param_t* fields, uint8_t num_fields, void* out) {
+  uint32_t bound = 0;
+  uint8_t* base = (uint8_t*)out;
+
+  for (JsonPair pair : params) {
+    const char* key = pair.key().c_str();
+    for (uint8_t ix = 0; ix < num_fields; ix++) {
+      if ((bound & (1UL << ix)) == 0 && strcmp(key, fields[ix].name) == 0) {
+        if (!storeValue(&fields[ix], pair.value(), base)) {
+          return false;
+        }
+        bound |= (1UL << ix);
+        break;
+      }
+    }
+  }
+
+  return bindDefaults(fields, num_fields, bound, base);
+}
+
+bool rpcBindValues(JsonArray values, const rpc_param_t* fields, uint8_t num_fields,
+                   const uint8_t* layout, uint8_t num_values, void* out) {
+  uint32_t bound = 0;
+  uint8_t* base = (uint8_t*)out;
+  uint8_t ix = 0;
+
+  for (JsonVariant value : values) {
+    if (ix >= num_values || !storeValue(&fields[layout[ix]], value, base)) {
+      return false;
+    }
+    bound |= (1UL << layout[ix]);
+    ix++;
+  }
+
+  if (ix != num_values) {
+    return false;
+  }
+  return bindDefaults(fields, num_fields, bound, base);
+}
+
+int8_t rpcFindField(const rpc_param_t* fields, uint8_t num_fields, const char* name) {
+  for (uint8_t ix = 0; ix < num_fields; ix++) {
+    if (strcmp(name, fields[ix].name) == 0) {
+      return ix;
+    }
+  }
+  return -1;
+}
+
+bool rpcCheckLayout(const rpc_param_t* fields, uint8_t num_fields, const uint8_t* layout, uint8_t num_values) {
+  uint32_t listed = 0;
+
+  for (uint8_t ix = 0; ix < num_values; ix++) {
+    if (layout[ix] >= num_fields || (listed & (1UL << layout[ix])) != 0) {
+      return false;
+    }
+    listed |= (1UL << layout[ix]);
+  }
+
+  for (uint8_t ix = 0; ix < num_fields; ix++) {
+    if (fields[ix].required && (listed & (1UL << ix)) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
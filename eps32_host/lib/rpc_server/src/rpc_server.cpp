@@ -5,32 +5,98 @@ extern oledDisplay oled_Display;
 #endif
 #include "dac_4922_lib.h"
 extern dac4922 dac;
+#if defined INCLUDE_DAC_WAVE_LIB
+#include "wave_lib.h"
+extern dacWaveform dac_waveform;
+#endif
 #if defined INCLUDE_ADC_3208_LIB
 #include "adc_3208_lib.h"
 extern adc3208 adc;
 #endif
+#if defined INCLUDE_ADC_SAMPLER
+#include "sampler_lib.h"
+extern adcSampler adc_sampler;
+#endif
 #if defined INCLUDE_DIO_LIB
 #include "dio_lib.h"
 extern dio digital_io;
 #endif
+#if defined INCLUDE_ADC_CAPTURE
+#include "capture_lib.h"
+extern adcCapture adc_capture;
+#endif
 #if defined INCLUDE_QC_7366_LIB
 #include "qc_7366_lib.h"
 extern qc7366 qc;
 #endif
+#if defined INCLUDE_INPUT_EVENTS
+#include "event_lib.h"
+extern inputEvents input_events;
+#endif
+#if defined INCLUDE_CALIBRATION_STORE
+#include "calib_lib.h"
+extern calibrationStore calibration;
+#endif
+#include "boot_lib.h"
+extern bootProfile boot_profile;
+#include "settings_lib.h"
+extern settingsStore settings;
 #include "rpc_server.h"
+#include "rpc_params.h"
 
 RpcServer::RpcServer() {
   tcp_server = nullptr;
   tcp_server_started = false;
+  serial_request = false;
+  pending_baud = 0;
+  previous_baud = 0;
+  serial_baud = 0;
+  baud_switch_ms = 0;
+  baud_unconfirmed = false;
+  snapshot_adc_mask = 0xFF;
+  snapshot_qc_mask = 0xFF;
+  snapshot_dio = true;
+  snapshot_voltage = false;
+  metrics.calls = 0;
+  metrics.handlerUs = 0;
+  metrics.handlerMaxUs = 0;
+  max_reads = 0;
+  max_reads_seen = 0;
+  max_read_calls = 0;
+  client_count = 0;
+  memset(prepared, 0, sizeof(prepared));
+  deferred_job = 0;
 }
 
 void RpcServer::begin() {
-  Serial.begin(CONFIG_BAUD_RATE);
+  serial_baud = settings.getBaudRate();
+  Serial.begin(serial_baud);
   
   // Initialize WiFi TCP server if needed
   // This will be started after WiFi is connected in main.cpp
-  tcp_server = new WiFiServer(CONFIG_WIFI_PORT);
+  tcp_server = new WiFiServer(settings.getTcpPort());
   tcp_server_started = false;
+
+  pulseGuard.begin(pulseLibChannels, NUMBER_OF_PULSE_LIB_INSTANCES);
+  jobs.begin(pulseLibChannels, NUMBER_OF_PULSE_LIB_INSTANCES);
+  output_shadow.init();
+
+#if defined INCLUDE_QC_COMPARE
+  dio* compare_dio = nullptr;
+  adc3208* compare_adc = nullptr;
+  adcCapture* compare_capture = nullptr;
+#if defined INCLUDE_DIO_LIB
+  compare_dio = &digital_io;
+#endif
+#if defined INCLUDE_ADC_3208_LIB
+  compare_adc = &adc;
+#endif
+#if defined INCLUDE_ADC_CAPTURE
+  compare_capture = &adc_capture;
+#endif
+  encoderCompare.init(&qc, pulseLibChannels, NUMBER_OF_PULSE_LIB_INSTANCES,
+                      compare_dio, compare_adc, compare_capture);
+#endif
 }
 
 void RpcServer::handlePulseTicks() {
@@ -40,27 +106,98 @@ void RpcServer::handlePulseTicks() {
   }
 }
 
+static const char* jobStateName(rpc_job_state_t state) {
+  switch (state) {
+    case RPC_JOB_RUNNING: return "running";
+    case RPC_JOB_DONE: return "done";
+    case RPC_JOB_HALTED: return "halted";
+    default: return "cancelled";
+  }
+}
+
+// done/total: ms waited of the delay, or pulses started of the train
+static void addJobStatus(JsonObject status, const rpc_job_t* job) {
+  status["job"] = job->id;
+  status["type"] = (job->type == RPC_JOB_DELAY) ? "delay" : "pulses";
+  status["state"] = jobStateName(job->state);
+  if (job->channel >= 0) {
+    status["channel"] = job->channel;
+  }
+  status["done"] = job->done;
+  status["total"] = job->total;
+  status["elapsed_ms"] = ((job->state == RPC_JOB_RUNNING) ? millis() : job->endMs) - job->startMs;
+}
+
+// Sends the response of a blocking RPC whose job has finished and the
+// notification of jobs started with notify, between two requests
+void RpcServer::handleJobs() {
+  jobs.poll();
+
+  const rpc_job_t* job = jobs.nextFinished();
+  while (job != nullptr) {
+    if (job->id == deferred_job) {
+      // a halted or cancelled job fails the RPC, the data tells how far it got
+      int result = (job->state == RPC_JOB_DONE) ? RPC_OK : RPC_ERROR_EXECUTION;
+      deferred_job = 0;
+      response_data.clear();
+      addJobStatus(response_data.to<JsonObject>(), job);
+      if (job->flags & RPC_JOB_SERIAL) {
+        send_response(result, "", response_data.as<JsonObject>());
+      } else {
+        send_response_tcp(result, "", response_data.as<JsonObject>());
+      }
+    }
+    if (job->flags & RPC_JOB_NOTIFY) {
+      send_job_event(job);
+    }
+    job = jobs.nextFinished();
+  }
+}
+
 void RpcServer::handle_serial() {
-  if (Serial.available()) {
+  checkBaudRateConfirmed();
+
+  // the next request waits in the receive buffer while a blocking RPC runs
+  if (deferred_job == 0 && Serial.available()) {
     String request_str = Serial.readStringUntil('\n');
     request_str.trim();
     
     if (request_str.length() > 0) {
+      RPC_STATS_TIMESTAMP(parse_start);
       if (parseRequest(request_str)) {
-        const char* method = request_doc["method"];
+        const prepared_t* prepared_call = nullptr;
+        const char* method = requestMethod(&prepared_call);
         JsonObject params = request_doc["params"];
+        JsonArray values = request_doc["v"];
         
         // Clear response data before executing command
         response_data.clear();
         
-        int result = execute_command(method, params);
+        // A valid request at a new baud rate confirms it
+        baud_unconfirmed = false;
+
+        RPC_STATS_TIMESTAMP(execute_start);
+        serial_request = true;
+        int result = dispatch(method, params, prepared_call, values);
+        serial_request = false;
+        RPC_STATS_TIMESTAMP(serialize_start);
         
-        // Send response with data if any was set
-        if (response_data.size() > 0) {
+        // Send response with data if any was set, a blocking RPC answers
+        // from handleJobs() once its job has finished
+        if (result == RPC_RESPONSE_DEFERRED) {
+          result = RPC_OK;
+        } else if (response_data.size() > 0) {
           send_response(result, "", response_data.as<JsonObject>());
         } else {
           send_response(result);
         }
+        RPC_STATS_RECORD(stats, method, result, parse_start, execute_start, serialize_start);
+
+        // setBaudRate is answered at the old rate and switches afterwards
+        if (pending_baud != 0) {
+          switchBaudRate(pending_baud);
+          pending_baud = 0;
+        }
       } else {
         send_response(RPC_ERROR_INVALID_COMMAND, "Invalid JSON format");
       }
@@ -68,6 +205,32 @@ void RpcServer::handle_serial() {
   }
 }
 
+void RpcServer::switchBaudRate(uint32_t baud) {
+  Serial.flush();  // the response still goes out at the old rate
+  previous_baud = serial_baud;
+  serial_baud = baud;
+  Serial.updateBaudRate(baud);
+  baud_switch_ms = millis();
+  baud_unconfirmed = true;
+}
+
+// Falls back to the previous rate when the host did not get through at the
+// new rate, so a failed switch never locks out the serial link
+void RpcServer::checkBaudRateConfirmed() {
+  if (baud_unconfirmed && millis() - baud_switch_ms >= RPC_BAUD_CONFIRM_MS) {
+    Serial.updateBaudRate(previous_baud);
+    serial_baud = previous_baud;
+    baud_unconfirmed = false;
+  }
+}
+
+// A rate the host has talked at: the build default or the rate the serial
+// link runs at once a request got through at it. Only such a rate is
+// stored, a stored rate is used at boot without a fallback.
+bool RpcServer::isBaudRateConfirmed(uint32_t baud) {
+  return baud == CONFIG_BAUD_RATE || (baud == serial_baud && !baud_unconfirmed);
+}
+
 void RpcServer::handle_wifi() {
   if (tcp_server == nullptr) {
     return;
@@ -87,6 +250,7 @@ void RpcServer::handle_wifi() {
       Serial.println("[DEBUG] No client available.");
 #endif
     } else {
+      TRACE_EVENT(TRACE_WIFI_CONNECT, 0);
 #if RPC_SERIAL_LOGS
       Serial.println("[DEBUG] New client connected.");
 #endif
@@ -95,30 +259,40 @@ void RpcServer::handle_wifi() {
 
   // Handle connected client
   if (tcp_client && tcp_client.connected()) {
-    // Check if data is available from the TCP client
-    if (tcp_client.available()) {
+    // Check if data is available from the TCP client, the next request
+    // waits in the receive buffer while a blocking RPC runs
+    if (deferred_job == 0 && tcp_client.available()) {
       String request_str = tcp_client.readStringUntil('\n');
       request_str.trim();
+      TRACE_EVENT(TRACE_WIFI_RX, request_str.length());
 
       if (request_str.length() > 0) {
 #if RPC_SERIAL_LOGS
         Serial.printf("[DEBUG] Received request: %s\n", request_str.c_str());
 #endif
+        RPC_STATS_TIMESTAMP(parse_start);
         if (parseRequest(request_str)) {
-          const char* method = request_doc["method"];
+          const prepared_t* prepared_call = nullptr;
+          const char* method = requestMethod(&prepared_call);
           JsonObject params = request_doc["params"];
+          JsonArray values = request_doc["v"];
 
           // Clear response data before executing command
           response_data.clear();
 
-          int result = execute_command(method, params);
+          RPC_STATS_TIMESTAMP(execute_start);
+          int result = dispatch(method, params, prepared_call, values);
+          RPC_STATS_TIMESTAMP(serialize_start);
 
           // Send response via TCP
-          if (response_data.size() > 0) {
+          if (result == RPC_RESPONSE_DEFERRED) {
+            result = RPC_OK;
+          } else if (response_data.size() > 0) {
             send_response_tcp(result, "", response_data.as<JsonObject>());
           } else {
             send_response_tcp(result);
           }
+          RPC_STATS_RECORD(stats, method, result, parse_start, execute_start, serialize_start);
         } else {
           send_response_tcp(RPC_ERROR_INVALID_COMMAND, "Invalid JSON format");
         }
@@ -138,6 +312,8 @@ void RpcServer::handle_wifi() {
       }
     }
   }
+
+  client_count = (tcp_client && tcp_client.connected()) ? 1 : 0;
 }
 
 bool RpcServer::parseRequest(const String& request_str) {
@@ -145,19 +321,115 @@ bool RpcServer::parseRequest(const String& request_str) {
   return error == DeserializationError::Ok;
 }
 
+// Method of the parsed request. An invoke frame names no method, it resolves
+// to the method prepared under its handle; an unknown handle to "invoke",
+// which the dispatcher rejects as an invalid command.
+const char* RpcServer::requestMethod(const prepared_t** prepared_call) {
+  JsonVariant handle = request_doc["h"];
+  if (handle.isNull()) {
+    return request_doc["method"];
+  }
+
+  uint8_t index = handle.is<uint8_t>() ? handle.as<uint8_t>() : RPC_MAX_PREPARED;
+  if (index >= RPC_MAX_PREPARED || prepared[index].method == nullptr) {
+    return "invoke";
+  }
+  *prepared_call = &prepared[index];
+  return prepared[index].method->name;
+}
+
+// Runs a handler and accounts its execution time. For an invoke frame
+// prepared_call is set and values holds the positional parameters.
+int RpcServer::dispatch(const char* method, JsonObject params,
+                        const prepared_t* prepared_call, JsonArray values) {
+  uint32_t start_us = micros();
+  if (metrics.calls == 0) {
+    boot_profile.firstCommand();
+  }
+  TRACE_EVENT(TRACE_RPC_BEGIN, traceHash(method));
+  int result = (prepared_call != nullptr) ? invoke(prepared_call, values) : execute_command(method, params);
+  TRACE_EVENT(TRACE_RPC_END, result);
+  uint32_t elapsed_us = micros() - start_us;
+
+  metrics.calls = metrics.calls + 1;
+  metrics.handlerUs = metrics.handlerUs + elapsed_us;
+  uint32_t reads = max_reads;
+  if (reads != max_reads_seen) {
+    max_reads_seen = reads;
+    metrics.handlerMaxUs = elapsed_us;
+  } else if (elapsed_us > metrics.handlerMaxUs) {
+    metrics.handlerMaxUs = elapsed_us;
+  }
+  return result;
+}
+
+// A window without calls has no max, handlerMaxUs still holds the one of
+// the window before until the next dispatch() starts a new window.
+void RpcServer::getMetrics(rpc_metrics_t* metrics_out, bool reset_max) {
+  metrics_out->calls = metrics.calls;
+  metrics_out->handlerUs = metrics.handlerUs;
+  metrics_out->handlerMaxUs = (metrics_out->calls != max_read_calls) ? metrics.handlerMaxUs : 0;
+  if (reset_max) {
+    max_read_calls = metrics_out->calls;
+    max_reads = max_reads + 1;
+  }
+}
+
+uint8_t RpcServer::getActivePulseChannels() {
+  uint8_t active = 0;
+  for (int i = 0; i < NUMBER_OF_PULSE_LIB_INSTANCES; i++) {
+    if (pulseLibChannels[i].isPulsing()) {
+      active++;
+    }
+  }
+  return active;
+}
+
+bool RpcServer::hasRunningJobs() {
+  return jobs.hasRunning();
+}
+
+uint8_t RpcServer::getClientCount() {
+  return client_count;
+}
+
+const RpcServer::bound_method_t* RpcServer::findBoundMethod(const char* method) {
+  for (uint8_t ix = 0; ix < num_bound_methods; ix++) {
+    if (strcmp(method, bound_methods[ix].name) == 0) {
+      return &bound_methods[ix];
+    }
+  }
+  return nullptr;
+}
+
+// The bound parameter struct lives on the stack, uint32_t keeps it aligned
+int RpcServer::invoke(const prepared_t* prepared_call, JsonArray values) {
+  uint32_t args[RPC_ARGS_MAX_SIZE / sizeof(uint32_t)];
+  const bound_method_t* method = prepared_call->method;
+
+  if (!rpcBindValues(values, method->fields, method->numFields,
+                     prepared_call->layout, prepared_call->numValues, args)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return (this->*method->run)(args);
+}
+
 int RpcServer::execute_command(const char* method, JsonObject params) {
+  const bound_method_t* bound = findBoundMethod(method);
+  if (bound != nullptr) {
+    uint32_t args[RPC_ARGS_MAX_SIZE / sizeof(uint32_t)];
+    if (!rpcBindFields(params, bound->fields, bound->numFields, args)) {
+      return RPC_ERROR_INVALID_PARAMS;
+    }
+    return (this->*bound->run)(args);
+  }
+
   // OLED commands
 
   if (strcmp(method, "pinMode") == 0) {
     return rpc_pinMode(params);
-  } else if (strcmp(method, "digitalWrite") == 0) {
-    return rpc_digitalWrite(params);
-  } else if (strcmp(method, "digitalRead") == 0) {
-    return rpc_digitalRead(params);
   } else if (strcmp(method, "analogWrite") == 0) {
     return rpc_analogWrite(params);
-  } else if (strcmp(method, "analogRead") == 0) {
-    return rpc_analogRead(params);
   } else if (strcmp(method, "delay") == 0) {
     return rpc_delay(params);
   } else if (strcmp(method, "millis") == 0) {
@@ -166,54 +438,142 @@ int RpcServer::execute_command(const char* method, JsonObject params) {
     return rpc_getFreeMem(params);
   } else if (strcmp(method, "chipID") == 0) {
     return rpc_getChipID(params);
+  } else if (strcmp(method, "setBaudRate") == 0) {
+    return rpc_setBaudRate(params);
+  } else if (strcmp(method, "bootProfile") == 0) {
+    return rpc_bootProfile(params);
+  } else if (strcmp(method, "prepare") == 0) {
+    return rpc_prepare(params);
+  } else if (strcmp(method, "release") == 0) {
+    return rpc_release(params);
+  } else if (strcmp(method, "configGet") == 0) {
+    return rpc_configGet(params);
+  } else if (strcmp(method, "configSet") == 0) {
+    return rpc_configSet(params);
+  } else if (strcmp(method, "configCommit") == 0) {
+    return rpc_configCommit(params);
+  } else if (strcmp(method, "configReset") == 0) {
+    return rpc_configReset(params);
+#if RPC_STATS_ENABLED
+  } else if (strcmp(method, "stats") == 0) {
+    return rpc_stats(params);
+  } else if (strcmp(method, "statsReset") == 0) {
+    return rpc_statsReset(params);
+#endif
+#if defined INCLUDE_TRACE
+  } else if (strcmp(method, "traceStart") == 0) {
+    return rpc_traceStart(params);
+  } else if (strcmp(method, "traceStop") == 0) {
+    return rpc_traceStop(params);
+  } else if (strcmp(method, "traceDump") == 0) {
+    return rpc_traceDump(params);
+#endif
+  } else if (strcmp(method, "snapshotConfig") == 0) {
+    return rpc_snapshotConfig(params);
+  } else if (strcmp(method, "snapshot") == 0) {
+    return rpc_snapshot(params);
   } else if (strcmp(method, "ledcSetup") == 0) {
     return rpc_ledcSetup(params);
-  } else if (strcmp(method, "ledcWrite") == 0) {
-    return rpc_ledcWrite(params);
+  } else if (strcmp(method, "shadowStats") == 0) {
+    return rpc_shadowStats(params);
+  } else if (strcmp(method, "shadowInvalidate") == 0) {
+    return rpc_shadowInvalidate(params);
   } else if (strcmp(method, "pulseBegin") == 0) {
     return rpc_pulseBegin(params);
-  } else if (strcmp(method, "pulse") == 0) {
-    return rpc_pulse(params);
-  } else if (strcmp(method, "pulseAsync") == 0) {
-    return rpc_pulseAsync(params);
-  } else if (strcmp(method, "isPulsing") == 0) {
-    return rpc_isPulsing(params);
-  } else if (strcmp(method, "getRemainingPulses") == 0) {
-    return rpc_getRemainingPulses(params);
-  } else if (strcmp(method, "stopPulse") == 0) {
-    return rpc_stopPulse(params);
   } else if (strcmp(method, "generatePulses") == 0) {
     return rpc_generatePulses(params);
-  } else if (strcmp(method, "generatePulsesAsync") == 0) {
-    return rpc_generatePulsesAsync(params);
+  } else if (strcmp(method, "pulseStats") == 0) {
+    return rpc_pulseStats(params);
+  } else if (strcmp(method, "jobDelay") == 0) {
+    return rpc_jobDelay(params);
+  } else if (strcmp(method, "jobPulses") == 0) {
+    return rpc_jobPulses(params);
+  } else if (strcmp(method, "jobStatus") == 0) {
+    return rpc_jobStatus(params);
+  } else if (strcmp(method, "jobList") == 0) {
+    return rpc_jobList(params);
+  } else if (strcmp(method, "jobCancel") == 0) {
+    return rpc_jobCancel(params);
+  } else if (strcmp(method, "guardBind") == 0) {
+    return rpc_guardBind(params);
+  } else if (strcmp(method, "guardUnbind") == 0) {
+    return rpc_guardUnbind(params);
+  } else if (strcmp(method, "guardStatus") == 0) {
+    return rpc_guardStatus(params);
 #if defined INCLUDE_ADC_3208_LIB
-  } else if (strcmp(method, "adcReadRaw") == 0) {
-    return rpc_adcReadRaw(params);
   } else if (strcmp(method, "adcReadVoltage") == 0) {
     return rpc_adcReadVoltage(params);
   } else if (strcmp(method, "isButtonPressed") == 0) {
     return rpc_isButtonPressed(params);
 #endif
+#if defined INCLUDE_ADC_SAMPLER
+  } else if (strcmp(method, "adcSamplerStart") == 0) {
+    return rpc_adcSamplerStart(params);
+  } else if (strcmp(method, "adcSamplerStop") == 0) {
+    return rpc_adcSamplerStop(params);
+  } else if (strcmp(method, "adcSamplerStatus") == 0) {
+    return rpc_adcSamplerStatus(params);
+  } else if (strcmp(method, "adcSamplerRead") == 0) {
+    return rpc_adcSamplerRead(params);
+  } else if (strcmp(method, "adcFilterSet") == 0) {
+    return rpc_adcFilterSet(params);
+  } else if (strcmp(method, "adcFilterRead") == 0) {
+    return rpc_adcFilterRead(params);
+#endif
+#if defined INCLUDE_ADC_CAPTURE
+  } else if (strcmp(method, "captureArm") == 0) {
+    return rpc_captureArm(params);
+  } else if (strcmp(method, "captureStop") == 0) {
+    return rpc_captureStop(params);
+  } else if (strcmp(method, "captureTrigger") == 0) {
+    return rpc_captureTrigger(params);
+  } else if (strcmp(method, "captureStatus") == 0) {
+    return rpc_captureStatus(params);
+  } else if (strcmp(method, "captureRead") == 0) {
+    return rpc_captureRead(params);
+#endif
 #if defined INCLUDE_DAC_4922_LIB
-  } else if (strcmp(method, "dacSetVoltage") == 0) {
-    return rpc_dacSetVoltage(params);
   } else if (strcmp(method, "dacSetVoltageAll") == 0) {
     return rpc_dacSetVoltageAll(params);
+  } else if (strcmp(method, "dacSetVoltages") == 0) {
+    return rpc_dacSetVoltages(params);
+#endif
+#if defined INCLUDE_DAC_WAVE_LIB
+  } else if (strcmp(method, "waveUpload") == 0) {
+    return rpc_waveUpload(params);
+  } else if (strcmp(method, "waveSetup") == 0) {
+    return rpc_waveSetup(params);
+  } else if (strcmp(method, "waveStart") == 0) {
+    return rpc_waveStart(params);
+  } else if (strcmp(method, "waveStop") == 0) {
+    return rpc_waveStop(params);
+#endif
+#if defined INCLUDE_CALIBRATION_STORE
+  } else if (strcmp(method, "calGet") == 0) {
+    return rpc_calGet(params);
+  } else if (strcmp(method, "calSet") == 0) {
+    return rpc_calSet(params);
+  } else if (strcmp(method, "calCommit") == 0) {
+    return rpc_calCommit(params);
+  } else if (strcmp(method, "calReset") == 0) {
+    return rpc_calReset(params);
 #endif
 #if defined INCLUDE_DIO_LIB
   } else if (strcmp(method, "dioGetInput") == 0) {
     return rpc_dioGetInput(params);
-  } else if (strcmp(method, "dioIsBitSet") == 0) {
-    return rpc_dioIsBitSet(params);
-  } else if (strcmp(method, "dioSetOutput") == 0) {
-    return rpc_dioSetOutput(params);
-  } else if (strcmp(method, "dioSetBit") == 0) {
-    return rpc_dioSetBit(params);
-  } else if (strcmp(method, "dioClearBit") == 0) {
-    return rpc_dioClearBit(params);
   } else if (strcmp(method, "dioToggleBit") == 0) {
     return rpc_dioToggleBit(params);
 #endif
+#if defined INCLUDE_INPUT_EVENTS
+  } else if (strcmp(method, "eventsEnable") == 0) {
+    return rpc_eventsEnable(params);
+  } else if (strcmp(method, "eventsDisable") == 0) {
+    return rpc_eventsDisable(params);
+  } else if (strcmp(method, "eventsRead") == 0) {
+    return rpc_eventsRead(params);
+  } else if (strcmp(method, "eventsClear") == 0) {
+    return rpc_eventsClear(params);
+#endif
 #if defined INCLUDE_QC_7366_LIB
   } else if (strcmp(method, "qcEnableCounter") == 0) {
     return rpc_qcEnableCounter(params);
@@ -221,14 +581,26 @@ int RpcServer::execute_command(const char* method, JsonObject params) {
     return rpc_qcDisableCounter(params);
   } else if (strcmp(method, "qcClearCountRegister") == 0) {
     return rpc_qcClearCountRegister(params);
-  } else if (strcmp(method, "qcReadCountRegister") == 0) {
-    return rpc_qcReadCountRegister(params);
+  } else if (strcmp(method, "qcSetCounterWidth") == 0) {
+    return rpc_qcSetCounterWidth(params);
+#endif
+#if defined INCLUDE_QC_COMPARE
+  } else if (strcmp(method, "qcCompareArm") == 0) {
+    return rpc_qcCompareArm(params);
+  } else if (strcmp(method, "qcCompareDisarm") == 0) {
+    return rpc_qcCompareDisarm(params);
+  } else if (strcmp(method, "qcCompareStatus") == 0) {
+    return rpc_qcCompareStatus(params);
 #endif
 #if defined INCLUDE_OLED_DISPLAY
   } else if (strcmp(method, "oledClear") == 0) {
     return rpc_oledClear(params);
   } else if (strcmp(method, "oledWriteLine") == 0) {
     return rpc_oledWriteLine(params);
+  } else if (strcmp(method, "oledFlush") == 0) {
+    return rpc_oledFlush(params);
+  } else if (strcmp(method, "oledDashboard") == 0) {
+    return rpc_oledDashboard(params);
 #endif
   } else {
     return RPC_ERROR_INVALID_COMMAND;
@@ -263,77 +635,143 @@ void RpcServer::send_response_tcp(int result_code, const char* message, JsonObje
   
   if (tcp_client.connected()) {
     tcp_client.println(response);
+    TRACE_EVENT(TRACE_WIFI_TX, response.length());
+  }
+}
+
+// An unsolicited line {"event": "job", "data": {...}} on the transport the
+// job was started on. It is only sent between responses, never inside one.
+void RpcServer::send_job_event(const rpc_job_t* job) {
+  response_doc.clear();
+  response_doc["event"] = "job";
+  addJobStatus(response_doc.createNestedObject("data"), job);
+
+  String event;
+  serializeJson(response_doc, event);
+  if (job->flags & RPC_JOB_SERIAL) {
+    Serial.println(event);
+  } else if (tcp_client.connected()) {
+    tcp_client.println(event);
+  }
+}
+
+uint8_t RpcServer::jobOrigin() {
+  return serial_request ? RPC_JOB_SERIAL : 0;
+}
+
+// Blocking RPCs run as a job: the handler returns at once and the loop keeps
+// running, the response is sent when the job finishes
+int RpcServer::deferResponse(uint16_t job_id) {
+  if (job_id == 0) {
+    return RPC_ERROR_EXECUTION;
   }
+  deferred_job = job_id;
+  return RPC_RESPONSE_DEFERRED;
 }
 
 // GPIO Functions
+typedef struct {
+  uint8_t pin;
+  uint8_t mode;
+  bool force;
+} pin_mode_params_t;
+
+static constexpr rpc_param_t PIN_MODE_PARAMS[] = {
+  RPC_REQUIRED_RANGE(pin_mode_params_t, pin, 0, SHADOW_N_GPIO - 1),
+  RPC_REQUIRED(pin_mode_params_t, mode),
+  RPC_OPTIONAL(pin_mode_params_t, force, false),
+};
+
 int RpcServer::rpc_pinMode(JsonObject params) {
-  if (!params.containsKey("pin") || !params.containsKey("mode")) {
+  pin_mode_params_t p;
+  if (!rpcBindParams(params, PIN_MODE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint8_t pin = params["pin"];
-  uint8_t mode = params["mode"];
-  
-  pinMode(pin, mode);
+  output_shadow.setMode(p.pin, p.mode, p.force);
   return RPC_OK;
 }
 
-int RpcServer::rpc_digitalWrite(JsonObject params) {
-  if (!params.containsKey("pin") || !params.containsKey("value")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t pin = params["pin"];
-  uint8_t value = params["value"];
-  
-  // Ensure pin is set to OUTPUT mode before writing
-  pinMode(pin, OUTPUT);
-  digitalWrite(pin, value);
+typedef struct {
+  uint8_t pin;
+  uint8_t value;
+  bool force;
+} pin_write_params_t;
+
+static constexpr rpc_param_t DIGITAL_WRITE_PARAMS[] = {
+  RPC_REQUIRED_RANGE(pin_write_params_t, pin, 0, SHADOW_N_GPIO - 1),
+  RPC_REQUIRED(pin_write_params_t, value),
+  RPC_OPTIONAL(pin_write_params_t, force, false),
+};
+
+int RpcServer::rpc_digitalWrite(const void* args) {
+  const pin_write_params_t* p = (const pin_write_params_t*)args;
+
+  // Ensure pin is set to OUTPUT mode before writing, the shadow skips the
+  // pinMode when the pin already is an output
+  output_shadow.setMode(p->pin, OUTPUT, p->force);
+  output_shadow.writeLevel(p->pin, p->value, p->force);
   return RPC_OK;
 }
 
-int RpcServer::rpc_digitalRead(JsonObject params) {
-  if (!params.containsKey("pin")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t pin = params["pin"];
-  
+// mode is optional, PIN_MODE_KEEP leaves the pin as configured
+#define PIN_MODE_KEEP 0xFF
+
+typedef struct {
+  uint8_t pin;
+  uint8_t mode;
+} pin_read_params_t;
+
+static constexpr rpc_param_t DIGITAL_READ_PARAMS[] = {
+  RPC_REQUIRED_RANGE(pin_read_params_t, pin, 0, SHADOW_N_GPIO - 1),
+  RPC_OPTIONAL_RANGE(pin_read_params_t, mode, 0, PIN_MODE_KEEP - 1, PIN_MODE_KEEP),
+};
+
+int RpcServer::rpc_digitalRead(const void* args) {
+  const pin_read_params_t* p = (const pin_read_params_t*)args;
+
   // Only set pin mode if explicitly provided; otherwise read current pin state
-  if (params.containsKey("mode")) {
-    uint8_t mode = params["mode"];
-    pinMode(pin, mode);
+  if (p->mode != PIN_MODE_KEEP) {
+    output_shadow.setMode(p->pin, p->mode);
   }
   // Do NOT change pin mode during read - preserve the current pin configuration
   // (e.g., OUTPUT pins should stay OUTPUT to read the value being driven)
   
-  int value = digitalRead(pin);
+  int value = digitalRead(p->pin);
   
   response_data["value"] = value;
   
   return RPC_OK;
 }
 
+static constexpr rpc_param_t ANALOG_WRITE_PARAMS[] = {
+  RPC_REQUIRED_RANGE(pin_write_params_t, pin, 0, SHADOW_N_GPIO - 1),
+  RPC_REQUIRED(pin_write_params_t, value),
+};
+
 int RpcServer::rpc_analogWrite(JsonObject params) {
-  if (!params.containsKey("pin") || !params.containsKey("value")) {
+  pin_write_params_t p;
+  if (!rpcBindParams(params, ANALOG_WRITE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint8_t pin = params["pin"];
-  uint8_t value = params["value"];
-  
-  analogWrite(pin, value);
+  // analogWrite attaches the pin to an LEDC channel of its own choice
+  output_shadow.invalidatePin(p.pin);
+  for (uint8_t channel = 0; channel < SHADOW_N_LEDC; channel++) {
+    output_shadow.invalidateLedc(channel);
+  }
+  analogWrite(p.pin, p.value);
   return RPC_OK;
 }
 
-int RpcServer::rpc_analogRead(JsonObject params) {
-  if (!params.containsKey("pin")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t pin = params["pin"];
-  int value = analogRead(pin);
+static constexpr rpc_param_t ANALOG_READ_PARAMS[] = {
+  RPC_REQUIRED_RANGE(pin_read_params_t, pin, 0, SHADOW_N_GPIO - 1),
+};
+
+int RpcServer::rpc_analogRead(const void* args) {
+  const pin_read_params_t* p = (const pin_read_params_t*)args;
+
+  int value = analogRead(p->pin);
   
   response_data["value"] = value;
   
@@ -341,15 +779,21 @@ int RpcServer::rpc_analogRead(JsonObject params) {
 }
 
 // System Functions
+typedef struct {
+  uint32_t ms;
+} delay_params_t;
+
+static constexpr rpc_param_t DELAY_PARAMS[] = {
+  RPC_REQUIRED(delay_params_t, ms),
+};
+
 int RpcServer::rpc_delay(JsonObject params) {
-  if (!params.containsKey("ms")) {
+  delay_params_t p;
+  if (!rpcBindParams(params, DELAY_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint32_t ms = params["ms"];
-  delay(ms);
-  
-  return RPC_OK;
+  return deferResponse(jobs.startDelay(p.ms, RPC_JOB_DEFERRED | jobOrigin()));
 }
 
 int RpcServer::rpc_getMillis(JsonObject params) {
@@ -376,303 +820,1478 @@ int RpcServer::rpc_getChipID(JsonObject params) {
   return RPC_OK;
 }
 
-// PWM/Analog Functions
-int RpcServer::rpc_ledcSetup(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("freq") || !params.containsKey("bits")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t channel = params["channel"];
-  uint32_t freq = params["freq"];
-  uint8_t bits = params["bits"];
-  
-  ledcSetup(channel, freq, bits);
-  return RPC_OK;
-}
+typedef struct {
+  uint32_t baud;
+} baud_rate_params_t;
+
+static constexpr rpc_param_t BAUD_RATE_PARAMS[] = {
+  RPC_REQUIRED_RANGE(baud_rate_params_t, baud, RPC_BAUD_RATE_MIN, RPC_BAUD_RATE_MAX),
+};
 
-int RpcServer::rpc_ledcWrite(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("duty")) {
+// Switches the serial link after the response, the host must send a request
+// at the new rate within RPC_BAUD_CONFIRM_MS or the old rate is restored
+int RpcServer::rpc_setBaudRate(JsonObject params) {
+  baud_rate_params_t p;
+  if (!rpcBindParams(params, BAUD_RATE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t channel = params["channel"];
-  uint32_t duty = params["duty"];
-  
-  ledcWrite(channel, duty);
-  return RPC_OK;
-}
-
-// I2C Functions
-int RpcServer::rpc_i2c_begin(JsonObject params) {
-  // Placeholder for I2C begin
+  if (!serial_request) {
+    return RPC_ERROR_NOT_SUPPORTED;
+  }
+  response_data["previous_baud"] = serial_baud;
+  response_data["confirm_ms"] = RPC_BAUD_CONFIRM_MS;
+  pending_baud = p.baud;
   return RPC_OK;
 }
 
-int RpcServer::rpc_i2c_write(JsonObject params) {
-  // Placeholder for I2C write
+// Stage times of the last boot in ms, the WiFi stage may still be running
+int RpcServer::rpc_bootProfile(JsonObject params) {
+  JsonArray stages = response_data.createNestedArray("stages");
+  boot_stage_t stage;
+  for (uint8_t i = 0; i < boot_profile.count(); i++) {
+    if (boot_profile.get(i, &stage)) {
+      JsonObject entry = stages.createNestedObject();
+      entry["name"] = stage.name;
+      entry["start_ms"] = stage.startUs / 1000.0f;
+      entry["ms"] = stage.durationUs / 1000.0f;
+      entry["done"] = stage.done;
+    }
+  }
+  response_data["ready_ms"] = boot_profile.getReadyUs() / 1000.0f;
+  if (boot_profile.getFirstCommandUs() != BOOT_NOT_REACHED) {
+    response_data["first_command_ms"] = boot_profile.getFirstCommandUs() / 1000.0f;
+  }
   return RPC_OK;
 }
 
-int RpcServer::rpc_i2c_read(JsonObject params) {
-  // Placeholder for I2C read
+// Settings RPC functions, changes take effect after configCommit and a restart
+int RpcServer::rpc_configGet(JsonObject params) {
+  response_data["comm_mode"] = settings.getCommMode();
+  response_data["baud_rate"] = settings.getBaudRate();
+  response_data["tcp_port"] = settings.getTcpPort();
+  response_data["ssid"] = settings.getSsid();
+  response_data["password_set"] = (settings.getPassword()[0] != '\0');
+  response_data["hostname"] = settings.getHostname();
   return RPC_OK;
 }
 
-String RpcServer::getMethodName(const char* method) {
-  return String(method);
-}
-
-// Pulse Library Functions
-int RpcServer::rpc_pulseBegin(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("pin")) {
+// A field left out keeps its setting: the numbers default to a value
+// outside their range, the strings to null
+#define CONFIG_KEEP_COMM_MODE 0xFF
+#define CONFIG_KEEP_NUMBER 0
+
+typedef struct {
+  uint8_t comm_mode;
+  uint32_t baud_rate;
+  uint16_t tcp_port;
+  const char* ssid;
+  const char* password;
+  const char* hostname;
+} config_set_params_t;
+
+static constexpr rpc_param_t CONFIG_SET_PARAMS[] = {
+  RPC_OPTIONAL_RANGE(config_set_params_t, comm_mode, 0, CONFIG_KEEP_COMM_MODE - 1, CONFIG_KEEP_COMM_MODE),
+  RPC_OPTIONAL_RANGE(config_set_params_t, baud_rate, 1, UINT32_MAX, CONFIG_KEEP_NUMBER),
+  RPC_OPTIONAL_RANGE(config_set_params_t, tcp_port, 1, UINT16_MAX, CONFIG_KEEP_NUMBER),
+  RPC_OPTIONAL(config_set_params_t, ssid, 0),
+  RPC_OPTIONAL(config_set_params_t, password, 0),
+  RPC_OPTIONAL(config_set_params_t, hostname, 0),
+};
+
+// Any subset of the fields. They are set on a copy of the settings, which
+// replaces the settings only when every field was valid, so an invalid value
+// changes nothing. baud_rate must be confirmed: switch with setBaudRate
+// first, then store the rate the link runs at.
+int RpcServer::rpc_configSet(JsonObject params) {
+  config_set_params_t p;
+  if (!rpcBindParams(params, CONFIG_SET_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t channel = params["channel"];
-  uint8_t pin = params["pin"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  pulseLibChannels[channel].begin(pin);
-  return RPC_OK;
-}
 
-int RpcServer::rpc_pulse(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("duration_ms")) {
-    return RPC_ERROR_INVALID_PARAMS;
+  settingsStore staged = settings;
+  bool valid = true;
+  if (p.comm_mode != CONFIG_KEEP_COMM_MODE) {
+    valid = valid && staged.setCommMode(p.comm_mode);
   }
-  
-  uint8_t channel = params["channel"];
-  uint32_t duration_ms = params["duration_ms"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
+  if (p.baud_rate != CONFIG_KEEP_NUMBER) {
+    valid = valid && isBaudRateConfirmed(p.baud_rate) && staged.setBaudRate(p.baud_rate);
+  }
+  if (p.tcp_port != CONFIG_KEEP_NUMBER) {
+    valid = valid && staged.setTcpPort(p.tcp_port);
+  }
+  if (p.ssid != nullptr) {
+    valid = valid && staged.setSsid(p.ssid);
+  }
+  if (p.password != nullptr) {
+    valid = valid && staged.setPassword(p.password);
+  }
+  if (p.hostname != nullptr) {
+    valid = valid && staged.setHostname(p.hostname);
+  }
+  if (!valid) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  pulseLibChannels[channel].pulse(duration_ms);
+  settings = staged;
   return RPC_OK;
 }
 
-int RpcServer::rpc_pulseAsync(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("duration_ms")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t channel = params["channel"];
-  uint32_t duration_ms = params["duration_ms"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  pulseLibChannels[channel].pulseAsync(duration_ms);
+int RpcServer::rpc_configCommit(JsonObject params) {
+  return settings.commit() ? RPC_OK : RPC_ERROR_EXECUTION;
+}
+
+int RpcServer::rpc_configReset(JsonObject params) {
+  settings.reset();
   return RPC_OK;
 }
 
-int RpcServer::rpc_isPulsing(JsonObject params) {
-  if (!params.containsKey("channel")) {
+// Prepared handles: prepare registers a bound method with the order of its
+// parameters and returns a handle, invoke frames {"h": handle, "v": [...]}
+// then carry only the values. Preparing the same layout again returns the
+// existing handle, so a host can re-prepare after a reconnect.
+typedef struct {
+  const char* method;
+  JsonArray params;
+} prepare_params_t;
+
+static constexpr rpc_param_t PREPARE_PARAMS[] = {
+  RPC_REQUIRED(prepare_params_t, method),
+  RPC_OPTIONAL(prepare_params_t, params, 0),
+};
+
+int RpcServer::rpc_prepare(JsonObject params) {
+  prepare_params_t p;
+  if (!rpcBindParams(params, PREPARE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t channel = params["channel"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
-    return RPC_ERROR_INVALID_PARAMS;
+
+  const bound_method_t* method = findBoundMethod(p.method);
+  if (method == nullptr) {
+    return RPC_ERROR_NOT_SUPPORTED;
   }
-  
-  bool pulsing = pulseLibChannels[channel].isPulsing();
-  response_data["pulsing"] = pulsing;
-  
-  return RPC_OK;
-}
 
-int RpcServer::rpc_stopPulse(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
+  uint8_t layout[RPC_PARAMS_MAX_FIELDS];
+  uint8_t num_values = 0;
+  if (!p.params.isNull()) {
+    for (JsonVariant name : p.params) {
+      int8_t field = name.is<const char*>() ? rpcFindField(method->fields, method->numFields, name.as<const char*>()) : -1;
+      if (field < 0 || num_values >= method->numFields) {
+        return RPC_ERROR_INVALID_PARAMS;
+      }
+      layout[num_values++] = field;
+    }
   }
-  
-  uint8_t channel = params["channel"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
+  if (!rpcCheckLayout(method->fields, method->numFields, layout, num_values)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  pulseLibChannels[channel].stopPulse();
-  return RPC_OK;
-}
 
-int RpcServer::rpc_generatePulses(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("pulse_width_ms") || 
-      !params.containsKey("pause_width_ms") || !params.containsKey("pulse_count")) {
-    return RPC_ERROR_INVALID_PARAMS;
+  int8_t handle = -1;
+  for (uint8_t ix = 0; ix < RPC_MAX_PREPARED; ix++) {
+    if (prepared[ix].method == method && prepared[ix].numValues == num_values &&
+        memcmp(prepared[ix].layout, layout, num_values) == 0) {
+      handle = ix;
+      break;
+    }
+    if (prepared[ix].method == nullptr && handle < 0) {
+      handle = ix;
+    }
   }
-  
-  uint8_t channel = params["channel"];
-  uint32_t pulse_width_ms = params["pulse_width_ms"];
-  uint32_t pause_width_ms = params["pause_width_ms"];
-  uint32_t pulse_count = params["pulse_count"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
-    return RPC_ERROR_INVALID_PARAMS;
+  if (handle < 0) {
+    return RPC_ERROR_EXECUTION;
   }
-  
-  pulseLibChannels[channel].generetePulses(pulse_width_ms, pause_width_ms, pulse_count);
+
+  prepared[handle].method = method;
+  prepared[handle].numValues = num_values;
+  memcpy(prepared[handle].layout, layout, num_values);
+
+  response_data["handle"] = handle;
   return RPC_OK;
 }
 
-int RpcServer::rpc_generatePulsesAsync(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("pulse_width_ms") || 
-      !params.containsKey("pause_width_ms") || !params.containsKey("pulse_count")) {
+// Without a handle every prepared handle is released
+#define RELEASE_ALL_HANDLES 0xFF
+
+typedef struct {
+  uint8_t handle;
+} release_params_t;
+
+static constexpr rpc_param_t RELEASE_PARAMS[] = {
+  RPC_OPTIONAL_RANGE(release_params_t, handle, 0, RPC_MAX_PREPARED - 1, RELEASE_ALL_HANDLES),
+};
+
+int RpcServer::rpc_release(JsonObject params) {
+  release_params_t p;
+  if (!rpcBindParams(params, RELEASE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t channel = params["channel"];
-  uint32_t pulse_width_ms = params["pulse_width_ms"];
-  uint32_t pause_width_ms = params["pause_width_ms"];
-  uint32_t pulse_count = params["pulse_count"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
+
+  if (p.handle == RELEASE_ALL_HANDLES) {
+    memset(prepared, 0, sizeof(prepared));
+    return RPC_OK;
+  }
+  if (prepared[p.handle].method == nullptr) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  pulseLibChannels[channel].generetePulsesAsync(pulse_width_ms, pause_width_ms, pulse_count);
+  prepared[p.handle].method = nullptr;
   return RPC_OK;
 }
 
-int RpcServer::rpc_getRemainingPulses(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
+#if RPC_STATS_ENABLED
+// Instrumentation RPC functions
+static void addPhaseStats(JsonObject phase, const rpc_method_stats_t* entry, rpc_phase_t index) {
+  phase["total_us"] = entry->totalUs[index];
+  phase["max_us"] = entry->maxUs[index];
+  // trailing empty buckets are left out
+  int last = RPC_STATS_N_BUCKETS - 1;
+  while (last > 0 && entry->histogram[index][last] == 0) {
+    last--;
   }
-  
-  uint8_t channel = params["channel"];
-  
-  if (channel >= NUMBER_OF_PULSE_LIB_INSTANCES) {
-    return RPC_ERROR_INVALID_PARAMS;
+  JsonArray histogram = phase.createNestedArray("histogram");
+  for (int i = 0; i <= last; i++) {
+    histogram.add(entry->histogram[index][i]);
   }
-  
-  int remaining = pulseLibChannels[channel].getRemainingPulses();
-  response_data["remaining"] = remaining;
-  
-  return RPC_OK;
 }
 
-#if defined INCLUDE_QC_7366_LIB
-int RpcServer::rpc_qcEnableCounter(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
+typedef struct {
+  const char* method;
+  uint8_t start;
+} stats_params_t;
 
-  uint8_t channel = params["channel"];
+static constexpr rpc_param_t STATS_PARAMS[] = {
+  RPC_OPTIONAL(stats_params_t, method, 0),
+  RPC_OPTIONAL(stats_params_t, start, 0),
+};
 
-  if (channel > QC_MAX_CHANNEL) {
+int RpcServer::rpc_stats(JsonObject params) {
+  stats_params_t p;
+  if (!rpcBindParams(params, STATS_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
 
-  qc.enableCounter(channel);
-  return RPC_OK;
-}
-
-int RpcServer::rpc_qcDisableCounter(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
+  if (p.method != nullptr) {
+    const rpc_method_stats_t* entry = stats.find(p.method);
+    if (entry == nullptr) {
+      return RPC_ERROR_INVALID_PARAMS;
+    }
+    response_data["name"] = (const char*)entry->name;
+    response_data["calls"] = entry->calls;
+    response_data["errors"] = entry->errors;
+    addPhaseStats(response_data.createNestedObject("parse"), entry, RPC_PHASE_PARSE);
+    addPhaseStats(response_data.createNestedObject("execute"), entry, RPC_PHASE_EXECUTE);
+    addPhaseStats(response_data.createNestedObject("serialize"), entry, RPC_PHASE_SERIALIZE);
+    return RPC_OK;
   }
 
-  uint8_t channel = params["channel"];
-
-  if (channel > QC_MAX_CHANNEL) {
-    return RPC_ERROR_INVALID_PARAMS;
+  uint8_t start = p.start;
+  JsonArray methods = response_data.createNestedArray("methods");
+  uint8_t index = start;
+  for (; index < stats.count() && index < start + RPC_STATS_PAGE_SIZE; index++) {
+    const rpc_method_stats_t* entry = stats.get(index);
+    JsonObject method = methods.createNestedObject();
+    method["name"] = (const char*)entry->name;
+    method["calls"] = entry->calls;
+    method["errors"] = entry->errors;
+    if (entry->calls > 0) {
+      method["parse_us"] = entry->totalUs[RPC_PHASE_PARSE] / entry->calls;
+      method["execute_us"] = entry->totalUs[RPC_PHASE_EXECUTE] / entry->calls;
+      method["serialize_us"] = entry->totalUs[RPC_PHASE_SERIALIZE] / entry->calls;
+    }
+    method["execute_max_us"] = entry->maxUs[RPC_PHASE_EXECUTE];
   }
+  response_data["total"] = stats.count();
+  response_data["next"] = (index < stats.count()) ? (int)index : -1;
+  return RPC_OK;
+}
 
-  qc.disableCounter(channel);
+int RpcServer::rpc_statsReset(JsonObject params) {
+  stats.reset();
   return RPC_OK;
 }
+#endif
 
-int RpcServer::rpc_qcClearCountRegister(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
+#if defined INCLUDE_TRACE || defined INCLUDE_ADC_CAPTURE
+// Binary blobs (trace, capture) are sent as base64 strings
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void encodeBase64(const uint8_t* data, size_t length, char* text) {
+  size_t i = 0;
+  for (; i + 2 < length; i += 3) {
+    uint32_t triple = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    *text++ = base64_chars[(triple >> 18) & 0x3F];
+    *text++ = base64_chars[(triple >> 12) & 0x3F];
+    *text++ = base64_chars[(triple >> 6) & 0x3F];
+    *text++ = base64_chars[triple & 0x3F];
   }
-
-  uint8_t channel = params["channel"];
-
-  if (channel > QC_MAX_CHANNEL) {
-    return RPC_ERROR_INVALID_PARAMS;
+  if (i < length) {
+    uint32_t triple = (data[i] << 16) | ((i + 1 < length) ? (data[i + 1] << 8) : 0);
+    *text++ = base64_chars[(triple >> 18) & 0x3F];
+    *text++ = base64_chars[(triple >> 12) & 0x3F];
+    *text++ = (i + 1 < length) ? base64_chars[(triple >> 6) & 0x3F] : '=';
+    *text++ = '=';
   }
-
-  qc.clearCountRegister(channel);
-  return RPC_OK;
+  *text = '\0';
 }
+#endif
 
-int RpcServer::rpc_qcReadCountRegister(JsonObject params) {
-  if (!params.containsKey("channel")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
+#if defined INCLUDE_TRACE
+// Trace RPC functions
+typedef struct {
+  bool clear;
+} trace_start_params_t;
 
-  uint8_t channel = params["channel"];
+static constexpr rpc_param_t TRACE_START_PARAMS[] = {
+  RPC_OPTIONAL(trace_start_params_t, clear, true),
+};
 
-  if (channel > QC_MAX_CHANNEL) {
+int RpcServer::rpc_traceStart(JsonObject params) {
+  trace_start_params_t p;
+  if (!rpcBindParams(params, TRACE_START_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
 
-  int32_t count = qc.readCountRegister(channel);
-  response_data["count"] = count;
+  traceStart(p.clear);
   return RPC_OK;
 }
-#endif
 
-// OLED RPC functions (must be outside of any function body)
-#if defined INCLUDE_OLED_DISPLAY
-int RpcServer::rpc_oledClear(JsonObject params) {
-  oled_Display.clear();
+int RpcServer::rpc_traceStop(JsonObject params) {
+  traceStop();
   return RPC_OK;
 }
 
-int RpcServer::rpc_oledWriteLine(JsonObject params) {
-  if (!params.containsKey("line") || !params.containsKey("text") || !params.containsKey("align")) {
+typedef struct {
+  uint32_t start;
+} trace_dump_params_t;
+
+static constexpr rpc_param_t TRACE_DUMP_PARAMS[] = {
+  RPC_OPTIONAL(trace_dump_params_t, start, 0),
+};
+
+// The first chunk stops the trace, so all chunks come from the same snapshot
+int RpcServer::rpc_traceDump(JsonObject params) {
+  static trace_record_t records[RPC_TRACE_DUMP_RECORDS];
+  static char text[((sizeof(records) + 2) / 3) * 4 + 1];
+
+  trace_dump_params_t p;
+  if (!rpcBindParams(params, TRACE_DUMP_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  uint8_t line = params["line"];
-  const char* text = params["text"];
-  uint8_t align = params["align"];
-  oled_Display.writeLine(line, text, align);
+
+  uint32_t start = p.start;
+  if (start == 0) {
+    traceStop();
+  }
+  uint32_t count = traceRead(start, records, RPC_TRACE_DUMP_RECORDS);
+  encodeBase64((const uint8_t*)records, count * sizeof(trace_record_t), text);
+
+  response_data["cpu_mhz"] = ESP.getCpuFreqMHz();
+  response_data["total"] = traceTotal();
+  response_data["available"] = traceAvailable();
+  response_data["data"] = (const char*)text;
+  response_data["next"] = (start + count < traceAvailable()) ? (int32_t)(start + count) : -1;
   return RPC_OK;
 }
 #endif
 
-#if defined INCLUDE_DAC_4922_LIB
-// DAC RPC functions
-int RpcServer::rpc_dacSetVoltage(JsonObject params) {
-  if (!params.containsKey("channel") || !params.containsKey("voltage")) {
-    return RPC_ERROR_INVALID_PARAMS;
+// Input snapshot: a set of ADC channels, encoder counts and the DIO port
+// captured back to back under one timestamp
+// A channel outside 0..num_channels-1 clears *valid and is left out of the
+// mask, the shift would be undefined for it.
+static uint8_t maskFromList(JsonArray list, uint8_t num_channels, bool* valid) {
+  uint8_t mask = 0;
+  for (JsonVariant channel : list) {
+    int32_t ch = channel.is<int32_t>() ? channel.as<int32_t>() : -1;
+    if (ch < 0 || ch >= num_channels) {
+      *valid = false;
+      continue;
+    }
+    mask |= (1 << ch);
   }
-  uint8_t channel = params["channel"];
-  float voltage = params["voltage"];
-  dac.setOutputVoltage(channel, voltage);
-  return RPC_OK;
+  return mask;
 }
 
-int RpcServer::rpc_dacSetVoltageAll(JsonObject params) {
-  if (!params.containsKey("voltage")) {
+// Fields left out keep their setting
+typedef struct {
+  JsonArray adc;
+  JsonArray qc;
+  rpc_flag_t dio;
+  rpc_flag_t voltage;
+} snapshot_config_params_t;
+
+static constexpr rpc_param_t SNAPSHOT_CONFIG_PARAMS[] = {
+  RPC_OPTIONAL(snapshot_config_params_t, adc, 0),
+  RPC_OPTIONAL(snapshot_config_params_t, qc, 0),
+  RPC_OPTIONAL(snapshot_config_params_t, dio, RPC_FLAG_KEEP),
+  RPC_OPTIONAL(snapshot_config_params_t, voltage, RPC_FLAG_KEEP),
+};
+
+int RpcServer::rpc_snapshotConfig(JsonObject params) {
+  snapshot_config_params_t p;
+  if (!rpcBindParams(params, SNAPSHOT_CONFIG_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  float voltage = params["voltage"];
-  dac.setOutputVoltageAll(voltage);
+
+  bool valid = true;
+  uint8_t adc_mask = snapshot_adc_mask;
+  uint8_t qc_mask = snapshot_qc_mask;
+  if (!p.adc.isNull()) {
+#if defined INCLUDE_ADC_3208_LIB
+    adc_mask = maskFromList(p.adc, N_ADC_CHANNELS, &valid);
+#else
+    adc_mask = maskFromList(p.adc, 0, &valid);
+#endif
+  }
+  if (!p.qc.isNull()) {
+#if defined INCLUDE_QC_7366_LIB
+    qc_mask = maskFromList(p.qc, QC_N_CHANNELS, &valid);
+#else
+    qc_mask = maskFromList(p.qc, 0, &valid);
+#endif
+  }
+  if (!valid) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  snapshot_adc_mask = adc_mask;
+  snapshot_qc_mask = qc_mask;
+  if (p.dio != RPC_FLAG_KEEP) {
+    snapshot_dio = (p.dio == RPC_FLAG_TRUE);
+  }
+  if (p.voltage != RPC_FLAG_KEEP) {
+    snapshot_voltage = (p.voltage == RPC_FLAG_TRUE);
+  }
+  return RPC_OK;
+}
+
+// The encoder counts are latched first, t_us is the latch time and span_us
+// the time until the last input was read. Values come in ascending channel
+// order of the configured sets.
+int RpcServer::rpc_snapshot(JsonObject params) {
+  uint32_t t_us = micros();
+  uint8_t ch = 0;
+
+#if defined INCLUDE_QC_7366_LIB
+  uint8_t qc_mask = snapshot_qc_mask & ((1 << QC_N_CHANNELS) - 1);
+  qc.latchOutputRegisters(qc_mask);
+#endif
+
+#if defined INCLUDE_ADC_3208_LIB
+  uint8_t adc_list[N_ADC_CHANNELS];
+  uint16_t adc_raw[N_ADC_CHANNELS];
+  uint8_t adc_count = 0;
+  for (ch = 0; ch < N_ADC_CHANNELS; ch++) {
+    if (snapshot_adc_mask & (1 << ch)) {
+      adc_list[adc_count++] = ch;
+    }
+  }
+  if (adc_count > 0) {
+    adc.readRawMultiple(adc_list, adc_count, adc_raw);
+  }
+#endif
+
+#if defined INCLUDE_DIO_LIB
+  uint8_t dio_value = snapshot_dio ? digital_io.getInput() : 0;
+#endif
+  uint32_t span_us = micros() - t_us;
+
+  response_data["t_us"] = t_us;
+  response_data["span_us"] = span_us;
+#if defined INCLUDE_ADC_3208_LIB
+  JsonArray adc_values = response_data.createNestedArray("adc");
+  for (ch = 0; ch < adc_count; ch++) {
+    if (snapshot_voltage) {
+      adc_values.add(adc.rawToMicrovolt(adc_raw[ch], adc_list[ch]) * 1e-6f);
+    } else {
+      adc_values.add(adc_raw[ch]);
+    }
+  }
+#endif
+#if defined INCLUDE_QC_7366_LIB
+  JsonArray qc_values = response_data.createNestedArray("qc");
+  for (ch = 0; ch < QC_N_CHANNELS; ch++) {
+    if (qc_mask & (1 << ch)) {
+      qc_values.add(qc.readOutputRegister(ch));
+    }
+  }
+#endif
+#if defined INCLUDE_DIO_LIB
+  if (snapshot_dio) {
+    response_data["dio"] = dio_value;
+  }
+#endif
+  return RPC_OK;
+}
+
+// PWM/Analog Functions
+typedef struct {
+  uint8_t channel;
+  uint32_t freq;
+  uint8_t bits;
+} ledc_setup_params_t;
+
+static constexpr rpc_param_t LEDC_SETUP_PARAMS[] = {
+  RPC_REQUIRED(ledc_setup_params_t, channel),
+  RPC_REQUIRED(ledc_setup_params_t, freq),
+  RPC_REQUIRED(ledc_setup_params_t, bits),
+};
+
+int RpcServer::rpc_ledcSetup(JsonObject params) {
+  ledc_setup_params_t p;
+  if (!rpcBindParams(params, LEDC_SETUP_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  ledcSetup(p.channel, p.freq, p.bits);
+  output_shadow.invalidateLedc(p.channel);
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  uint32_t duty;
+  bool force;
+} ledc_write_params_t;
+
+static constexpr rpc_param_t LEDC_WRITE_PARAMS[] = {
+  RPC_REQUIRED(ledc_write_params_t, channel),
+  RPC_REQUIRED(ledc_write_params_t, duty),
+  RPC_OPTIONAL(ledc_write_params_t, force, false),
+};
+
+int RpcServer::rpc_ledcWrite(const void* args) {
+  const ledc_write_params_t* p = (const ledc_write_params_t*)args;
+
+  output_shadow.writeDuty(p->channel, p->duty, p->force);
+  return RPC_OK;
+}
+
+// Output write cache: writes that would not change an output are skipped
+static void addShadowStats(JsonObject stats, const shadow_stats_t* counters) {
+  stats["hits"] = counters->hits;
+  stats["misses"] = counters->misses;
+}
+
+typedef struct {
+  bool reset;
+} shadow_stats_params_t;
+
+static constexpr rpc_param_t SHADOW_STATS_PARAMS[] = {
+  RPC_OPTIONAL(shadow_stats_params_t, reset, false),
+};
+
+int RpcServer::rpc_shadowStats(JsonObject params) {
+  shadow_stats_params_t p;
+  if (!rpcBindParams(params, SHADOW_STATS_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  bool reset = p.reset;
+  shadow_stats_t gpio_stats;
+  shadow_stats_t ledc_stats;
+
+  output_shadow.getStats(&gpio_stats, &ledc_stats, reset);
+  addShadowStats(response_data.createNestedObject("gpio"), &gpio_stats);
+  addShadowStats(response_data.createNestedObject("ledc"), &ledc_stats);
+#if defined INCLUDE_DAC_4922_LIB
+  shadow_stats_t dac_stats;
+  dac.getShadowStats(&dac_stats, reset);
+  addShadowStats(response_data.createNestedObject("dac"), &dac_stats);
+#endif
+#if defined INCLUDE_DIO_LIB
+  shadow_stats_t dio_stats;
+  digital_io.getShadowStats(&dio_stats, reset);
+  addShadowStats(response_data.createNestedObject("dio"), &dio_stats);
+#endif
+  return RPC_OK;
+}
+
+// Recovery after the hardware changed behind the cache, the next write of
+// every output goes out again (DIO reloads its shadow from the latches)
+int RpcServer::rpc_shadowInvalidate(JsonObject params) {
+  output_shadow.invalidate();
+#if defined INCLUDE_DAC_4922_LIB
+  dac.invalidateShadow();
+#endif
+#if defined INCLUDE_DIO_LIB
+  digital_io.invalidateShadow();
+#endif
+  return RPC_OK;
+}
+
+// I2C Functions
+int RpcServer::rpc_i2c_begin(JsonObject params) {
+  // Placeholder for I2C begin
+  return RPC_OK;
+}
+
+int RpcServer::rpc_i2c_write(JsonObject params) {
+  // Placeholder for I2C write
+  return RPC_OK;
+}
+
+int RpcServer::rpc_i2c_read(JsonObject params) {
+  // Placeholder for I2C read
+  return RPC_OK;
+}
+
+String RpcServer::getMethodName(const char* method) {
+  return String(method);
+}
+
+// Pulse Library Functions
+// Every pulse RPC takes a channel, its range is checked while binding. The
+// PulseLib durations and counts are int, larger values are rejected.
+#define PULSE_CHANNEL_PARAM(type) \
+  RPC_REQUIRED_RANGE(type, channel, 0, NUMBER_OF_PULSE_LIB_INSTANCES - 1)
+
+typedef struct {
+  uint8_t channel;
+} pulse_channel_params_t;
+
+static constexpr rpc_param_t PULSE_CHANNEL_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(pulse_channel_params_t),
+};
+
+typedef struct {
+  uint8_t channel;
+  uint8_t pin;
+} pulse_begin_params_t;
+
+static constexpr rpc_param_t PULSE_BEGIN_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(pulse_begin_params_t),
+  RPC_REQUIRED(pulse_begin_params_t, pin),
+};
+
+typedef struct {
+  uint8_t channel;
+  uint32_t duration_ms;
+} pulse_params_t;
+
+static constexpr rpc_param_t PULSE_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(pulse_params_t),
+  RPC_REQUIRED_RANGE(pulse_params_t, duration_ms, 0, INT32_MAX),
+};
+
+typedef struct {
+  uint8_t channel;
+  uint32_t pulse_width_ms;
+  uint32_t pause_width_ms;
+  uint32_t pulse_count;
+} pulse_train_params_t;
+
+static constexpr rpc_param_t PULSE_TRAIN_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(pulse_train_params_t),
+  RPC_REQUIRED_RANGE(pulse_train_params_t, pulse_width_ms, 0, INT32_MAX),
+  RPC_REQUIRED_RANGE(pulse_train_params_t, pause_width_ms, 0, INT32_MAX),
+  RPC_REQUIRED_RANGE(pulse_train_params_t, pulse_count, 0, INT32_MAX),
+};
+
+int RpcServer::rpc_pulseBegin(JsonObject params) {
+  pulse_begin_params_t p;
+  if (!rpcBindParams(params, PULSE_BEGIN_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  pulseLibChannels[p.channel].begin(p.pin);
+  output_shadow.invalidatePin(p.pin);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_pulse(const void* args) {
+  const pulse_params_t* p = (const pulse_params_t*)args;
+
+  return deferResponse(jobs.startPulses(p->channel, p->duration_ms, 0, 1, RPC_JOB_DEFERRED | jobOrigin()));
+}
+
+int RpcServer::rpc_pulseAsync(const void* args) {
+  const pulse_params_t* p = (const pulse_params_t*)args;
+
+  // refused while a guard pin of the channel is active
+  if (!pulseLibChannels[p->channel].pulseAsync(p->duration_ms)) {
+    return RPC_ERROR_EXECUTION;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_isPulsing(const void* args) {
+  const pulse_channel_params_t* p = (const pulse_channel_params_t*)args;
+
+  bool pulsing = pulseLibChannels[p->channel].isPulsing();
+  response_data["pulsing"] = pulsing;
+  
+  return RPC_OK;
+}
+
+int RpcServer::rpc_stopPulse(const void* args) {
+  const pulse_channel_params_t* p = (const pulse_channel_params_t*)args;
+
+  pulseLibChannels[p->channel].stopPulse();
+  return RPC_OK;
+}
+
+int RpcServer::rpc_generatePulses(JsonObject params) {
+  pulse_train_params_t p;
+  if (!rpcBindParams(params, PULSE_TRAIN_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  return deferResponse(jobs.startPulses(p.channel, p.pulse_width_ms, p.pause_width_ms, p.pulse_count,
+                                       RPC_JOB_DEFERRED | jobOrigin()));
+}
+
+int RpcServer::rpc_generatePulsesAsync(const void* args) {
+  const pulse_train_params_t* p = (const pulse_train_params_t*)args;
+
+  // an empty train is a no-op, refused while a guard pin is active
+  if (p->pulse_count > 0 &&
+      !pulseLibChannels[p->channel].generetePulsesAsync(p->pulse_width_ms, p->pause_width_ms, p->pulse_count)) {
+    return RPC_ERROR_EXECUTION;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_getRemainingPulses(const void* args) {
+  const pulse_channel_params_t* p = (const pulse_channel_params_t*)args;
+
+  int remaining = pulseLibChannels[p->channel].getRemainingPulses();
+  response_data["remaining"] = remaining;
+  
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  bool reset;
+} pulse_stats_params_t;
+
+static constexpr rpc_param_t PULSE_STATS_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(pulse_stats_params_t),
+  RPC_OPTIONAL(pulse_stats_params_t, reset, true),
+};
+
+int RpcServer::rpc_pulseStats(JsonObject params) {
+  pulse_stats_params_t p;
+  if (!rpcBindParams(params, PULSE_STATS_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  pulse_stats_t stats;
+  pulseLibChannels[p.channel].getStats(&stats);
+  if (p.reset) {
+    pulseLibChannels[p.channel].resetStats();
+  }
+  
+  response_data["edges"] = stats.edgeCount;
+  if (stats.edgeCount > 0) {
+    response_data["min_us"] = stats.minLatenessUs;
+    response_data["max_us"] = stats.maxLatenessUs;
+    response_data["mean_us"] = (int32_t)(stats.sumLatenessUs / stats.edgeCount);
+  }
+  JsonArray histogram = response_data.createNestedArray("histogram");
+  for (int i = 0; i < PULSE_STATS_N_BUCKETS; i++) {
+    histogram.add(stats.histogram[i]);
+  }
+  
+  return RPC_OK;
+}
+
+// Jobs: delays and pulse trains that run on the device while the server
+// keeps serving requests. notify sends an event line when the job finishes.
+typedef struct {
+  uint32_t ms;
+  bool notify;
+} job_delay_params_t;
+
+static constexpr rpc_param_t JOB_DELAY_PARAMS[] = {
+  RPC_REQUIRED(job_delay_params_t, ms),
+  RPC_OPTIONAL(job_delay_params_t, notify, false),
+};
+
+typedef struct {
+  uint8_t channel;
+  uint32_t pulse_width_ms;
+  uint32_t pause_width_ms;
+  uint32_t pulse_count;
+  bool notify;
+} job_pulses_params_t;
+
+static constexpr rpc_param_t JOB_PULSES_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(job_pulses_params_t),
+  RPC_REQUIRED_RANGE(job_pulses_params_t, pulse_width_ms, 0, INT32_MAX),
+  RPC_OPTIONAL_RANGE(job_pulses_params_t, pause_width_ms, 0, INT32_MAX, 0),
+  RPC_OPTIONAL_RANGE(job_pulses_params_t, pulse_count, 1, INT32_MAX, 1),
+  RPC_OPTIONAL(job_pulses_params_t, notify, false),
+};
+
+typedef struct {
+  uint16_t job;
+} job_id_params_t;
+
+static constexpr rpc_param_t JOB_ID_PARAMS[] = {
+  RPC_REQUIRED_RANGE(job_id_params_t, job, 1, UINT16_MAX),
+};
+
+int RpcServer::rpc_jobDelay(JsonObject params) {
+  job_delay_params_t p;
+  if (!rpcBindParams(params, JOB_DELAY_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  uint16_t job_id = jobs.startDelay(p.ms, (p.notify ? RPC_JOB_NOTIFY : 0) | jobOrigin());
+  if (job_id == 0) {
+    return RPC_ERROR_EXECUTION;
+  }
+  response_data["job"] = job_id;
+  return RPC_OK;
+}
+
+// Fails while the channel is pulsing or not begun
+int RpcServer::rpc_jobPulses(JsonObject params) {
+  job_pulses_params_t p;
+  if (!rpcBindParams(params, JOB_PULSES_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  uint16_t job_id = jobs.startPulses(p.channel, p.pulse_width_ms, p.pause_width_ms, p.pulse_count,
+                                     (p.notify ? RPC_JOB_NOTIFY : 0) | jobOrigin());
+  if (job_id == 0) {
+    return RPC_ERROR_EXECUTION;
+  }
+  response_data["job"] = job_id;
+  return RPC_OK;
+}
+
+int RpcServer::rpc_jobStatus(JsonObject params) {
+  job_id_params_t p;
+  if (!rpcBindParams(params, JOB_ID_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  const rpc_job_t* job = jobs.find(p.job);
+  if (job == nullptr) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  addJobStatus(response_data.to<JsonObject>(), job);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_jobList(JsonObject params) {
+  JsonArray list = response_data.createNestedArray("jobs");
+  for (uint8_t ix = 0; ix < RPC_MAX_JOBS; ix++) {
+    const rpc_job_t* job = jobs.get(ix);
+    if (job != nullptr) {
+      addJobStatus(list.createNestedObject(), job);
+    }
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_jobCancel(JsonObject params) {
+  job_id_params_t p;
+  if (!rpcBindParams(params, JOB_ID_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!jobs.cancel(p.job)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t pin;
+  uint8_t channel;
+  uint8_t active_level;
+} guard_bind_params_t;
+
+static constexpr rpc_param_t GUARD_BIND_PARAMS[] = {
+  RPC_REQUIRED(guard_bind_params_t, pin),
+  RPC_REQUIRED(guard_bind_params_t, channel),
+  RPC_OPTIONAL(guard_bind_params_t, active_level, HIGH),
+};
+
+int RpcServer::rpc_guardBind(JsonObject params) {
+  guard_bind_params_t p;
+  if (!rpcBindParams(params, GUARD_BIND_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  if (!pulseGuard.bind(p.pin, p.channel, p.active_level)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+static constexpr rpc_param_t GUARD_UNBIND_PARAMS[] = {
+  RPC_REQUIRED(pin_read_params_t, pin),
+};
+
+int RpcServer::rpc_guardUnbind(JsonObject params) {
+  pin_read_params_t p;
+  if (!rpcBindParams(params, GUARD_UNBIND_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  if (!pulseGuard.unbind(p.pin)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  bool clear;
+} guard_status_params_t;
+
+static constexpr rpc_param_t GUARD_STATUS_PARAMS[] = {
+  PULSE_CHANNEL_PARAM(guard_status_params_t),
+  RPC_OPTIONAL(guard_status_params_t, clear, false),
+};
+
+int RpcServer::rpc_guardStatus(JsonObject params) {
+  guard_status_params_t p;
+  if (!rpcBindParams(params, GUARD_STATUS_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  
+  int reason = pulseLibChannels[p.channel].getHaltReason();
+  response_data["halted"] = (reason != PULSE_HALT_NONE);
+  if (reason >= PULSE_HALT_COMPARE) {
+    response_data["pin"] = PULSE_HALT_NONE;
+    response_data["compare"] = reason - PULSE_HALT_COMPARE;
+  } else {
+    response_data["pin"] = reason;
+  }
+  response_data["cut_pulses"] = pulseLibChannels[p.channel].getCutPulses();
+  if (p.clear) {
+    pulseLibChannels[p.channel].clearHalt();
+  }
+  
+  return RPC_OK;
+}
+
+#if defined INCLUDE_QC_7366_LIB
+typedef struct {
+  uint8_t channel;
+} qc_channel_params_t;
+
+static constexpr rpc_param_t QC_CHANNEL_PARAMS[] = {
+  RPC_REQUIRED_RANGE(qc_channel_params_t, channel, 0, QC_MAX_CHANNEL),
+};
+
+int RpcServer::rpc_qcEnableCounter(JsonObject params) {
+  qc_channel_params_t p;
+  if (!rpcBindParams(params, QC_CHANNEL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  qc.enableCounter(p.channel);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_qcDisableCounter(JsonObject params) {
+  qc_channel_params_t p;
+  if (!rpcBindParams(params, QC_CHANNEL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  qc.disableCounter(p.channel);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_qcClearCountRegister(JsonObject params) {
+  qc_channel_params_t p;
+  if (!rpcBindParams(params, QC_CHANNEL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  qc.clearCountRegister(p.channel);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_qcReadCountRegister(const void* args) {
+  const qc_channel_params_t* p = (const qc_channel_params_t*)args;
+
+  int32_t count = qc.readCountRegister(p->channel);
+  response_data["count"] = count;
+  response_data["position"] = qc.getPosition(p->channel);
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  uint8_t bytes;
+} qc_width_params_t;
+
+static constexpr rpc_param_t QC_WIDTH_PARAMS[] = {
+  RPC_REQUIRED_RANGE(qc_width_params_t, channel, 0, QC_MAX_CHANNEL),
+  RPC_REQUIRED_RANGE(qc_width_params_t, bytes, 1, QC_MAX_COUNTER_BYTES),
+};
+
+int RpcServer::rpc_qcSetCounterWidth(JsonObject params) {
+  qc_width_params_t p;
+  if (!rpcBindParams(params, QC_WIDTH_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!qc.setCounterBytes(p.channel, p.bytes)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  response_data["bytes"] = qc.getCounterBytes(p.channel);
+  return RPC_OK;
+}
+#endif
+
+#if defined INCLUDE_QC_COMPARE
+typedef struct {
+  uint8_t channel;
+  int32_t target;
+  JsonArray pulse;
+  int8_t dio_bit;
+  bool dio_level;
+  JsonArray adc;
+  bool capture;
+  uint32_t poll_hz;
+} compare_arm_params_t;
+
+static constexpr rpc_param_t COMPARE_ARM_PARAMS[] = {
+  RPC_REQUIRED(compare_arm_params_t, channel),
+  RPC_REQUIRED(compare_arm_params_t, target),
+  RPC_OPTIONAL(compare_arm_params_t, pulse, 0),
+  RPC_OPTIONAL(compare_arm_params_t, dio_bit, COMPARE_NO_DIO_BIT),
+  RPC_OPTIONAL(compare_arm_params_t, dio_level, true),
+  RPC_OPTIONAL(compare_arm_params_t, adc, 0),
+  RPC_OPTIONAL(compare_arm_params_t, capture, false),
+  RPC_OPTIONAL(compare_arm_params_t, poll_hz, COMPARE_DEFAULT_POLL_RATE_HZ),
+};
+
+// Position compare: target is a counter value at the configured width. The
+// actions run on the device when the counter reaches it, once per arm.
+int RpcServer::rpc_qcCompareArm(JsonObject params) {
+  compare_arm_params_t p;
+  if (!rpcBindParams(params, COMPARE_ARM_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  bool valid = true;
+  compare_action_t action;
+
+  action.target = p.target;
+  action.pulseMask = p.pulse.isNull() ? 0 : maskFromList(p.pulse, NUMBER_OF_PULSE_LIB_INSTANCES, &valid);
+  action.dioBit = p.dio_bit;
+  action.dioLevel = p.dio_level;
+  action.adcMask = p.adc.isNull() ? 0 : maskFromList(p.adc, N_ADC_CHANNELS, &valid);
+  action.triggerCapture = p.capture;
+
+  if (!valid) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!encoderCompare.arm(p.channel, &action, p.poll_hz)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_qcCompareDisarm(JsonObject params) {
+  qc_channel_params_t p;
+  if (!rpcBindParams(params, QC_CHANNEL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  encoderCompare.disarm(p.channel);
+  return RPC_OK;
+}
+
+// t_us is the detection time, latency_us the time the actions took after it
+int RpcServer::rpc_qcCompareStatus(JsonObject params) {
+  qc_channel_params_t p;
+  if (!rpcBindParams(params, QC_CHANNEL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  compare_action_t action;
+  compare_result_t result;
+
+  if (!encoderCompare.read(p.channel, &action, &result)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  response_data["armed"] = result.armed;
+  response_data["fired"] = result.fired;
+  response_data["target"] = action.target;
+  if (result.fired) {
+    response_data["count"] = result.count;
+    response_data["t_us"] = result.timestampUs;
+    response_data["latency_us"] = result.latencyUs;
+    JsonArray adc_values = response_data.createNestedArray("adc");
+    uint8_t ix = 0;
+    for (uint8_t ch = 0; ch < N_ADC_CHANNELS; ch++) {
+      if (action.adcMask & (1 << ch)) {
+        adc_values.add(result.adcRaw[ix++]);
+      }
+    }
+  }
+  response_data["poll_hz"] = encoderCompare.getPollRate();
+  response_data["polls"] = encoderCompare.getPolls();
+  response_data["missed_polls"] = encoderCompare.getMissedPolls();
   return RPC_OK;
 }
 #endif
 
-// ADC RPC functions
-int RpcServer::rpc_adcReadRaw(JsonObject params) {
-  if (!params.containsKey("channel")) {
+// OLED RPC functions (must be outside of any function body)
+#if defined INCLUDE_OLED_DISPLAY
+int RpcServer::rpc_oledClear(JsonObject params) {
+  oled_Display.clear();
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t line;
+  const char* text;
+  uint8_t align;
+} oled_line_params_t;
+
+static constexpr rpc_param_t OLED_LINE_PARAMS[] = {
+  RPC_REQUIRED(oled_line_params_t, line),
+  RPC_REQUIRED(oled_line_params_t, text),
+  RPC_REQUIRED(oled_line_params_t, align),
+};
+
+int RpcServer::rpc_oledWriteLine(JsonObject params) {
+  oled_line_params_t p;
+  if (!rpcBindParams(params, OLED_LINE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t channel = params["channel"];
-  uint8_t averageCount = params.containsKey("averageCount") ? params["averageCount"] : 1;
+
+  oled_Display.writeLine(p.line, p.text, p.align);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_oledFlush(JsonObject params) {
+  oled_Display.flush();
+  response_data["bytes_sent"] = oled_Display.getBytesSent();
+  return RPC_OK;
+}
+
+typedef struct {
+  bool enable;
+  uint16_t period_ms;
+} oled_dashboard_params_t;
+
+static constexpr rpc_param_t OLED_DASHBOARD_PARAMS[] = {
+  RPC_REQUIRED(oled_dashboard_params_t, enable),
+  RPC_OPTIONAL(oled_dashboard_params_t, period_ms, OLED_DASHBOARD_PERIOD_MS),
+};
+
+int RpcServer::rpc_oledDashboard(JsonObject params) {
+  oled_dashboard_params_t p;
+  if (!rpcBindParams(params, OLED_DASHBOARD_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!p.enable) {
+    oled_Display.stopDashboard();
+  } else if (!oled_Display.startDashboard(p.period_ms)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+#endif
+
+#if defined INCLUDE_DAC_4922_LIB
+// DAC RPC functions
+typedef struct {
+  uint8_t channel;
+  float voltage;
+  bool force;
+} dac_voltage_params_t;
+
+static constexpr rpc_param_t DAC_VOLTAGE_PARAMS[] = {
+  RPC_REQUIRED_RANGE(dac_voltage_params_t, channel, 0, DAC_MAX_CHANNEL),
+  RPC_REQUIRED(dac_voltage_params_t, voltage),
+  RPC_OPTIONAL(dac_voltage_params_t, force, false),
+};
+
+// A channel playing a waveform is written by the sample task only
+static bool isWavePlaying(uint8_t channel_mask) {
+#if defined INCLUDE_DAC_WAVE_LIB
+  for (uint8_t channel = 0; channel < N_DAC_CHANNELS; channel++) {
+    if ((channel_mask & (1 << channel)) && dac_waveform.isRunning(channel)) {
+      return true;
+    }
+  }
+#endif
+  return false;
+}
+
+int RpcServer::rpc_dacSetVoltage(const void* args) {
+  const dac_voltage_params_t* p = (const dac_voltage_params_t*)args;
+  if (isWavePlaying(1 << p->channel)) {
+    return RPC_ERROR_EXECUTION;  // stop the waveform first
+  }
+  dac.setOutputVoltage(p->channel, p->voltage, p->force);
+  return RPC_OK;
+}
+
+static constexpr rpc_param_t DAC_VOLTAGE_ALL_PARAMS[] = {
+  RPC_REQUIRED(dac_voltage_params_t, voltage),
+  RPC_OPTIONAL(dac_voltage_params_t, force, false),
+};
+
+int RpcServer::rpc_dacSetVoltageAll(JsonObject params) {
+  dac_voltage_params_t p;
+  if (!rpcBindParams(params, DAC_VOLTAGE_ALL_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  if (isWavePlaying((1 << N_DAC_CHANNELS) - 1)) {
+    return RPC_ERROR_EXECUTION;
+  }
+
+  dac.setOutputVoltageAll(p.voltage, p.force);
+  return RPC_OK;
+}
+
+typedef struct {
+  JsonArray voltages;
+  bool force;
+} dac_voltages_params_t;
+
+static constexpr rpc_param_t DAC_VOLTAGES_PARAMS[] = {
+  RPC_REQUIRED(dac_voltages_params_t, voltages),
+  RPC_OPTIONAL(dac_voltages_params_t, force, false),
+};
+
+int RpcServer::rpc_dacSetVoltages(JsonObject params) {
+  dac_voltages_params_t p;
+  if (!rpcBindParams(params, DAC_VOLTAGES_PARAMS, &p) || p.voltages.size() != N_DAC_CHANNELS) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  if (isWavePlaying((1 << N_DAC_CHANNELS) - 1)) {
+    return RPC_ERROR_EXECUTION;
+  }
+
+  float voltages[N_DAC_CHANNELS];
+  for (uint8_t channel = 0; channel < N_DAC_CHANNELS; channel++) {
+    voltages[channel] = p.voltages[channel];
+  }
+  dac.setOutputVoltages(voltages, p.force);
+  return RPC_OK;
+}
+#endif
+
+#if defined INCLUDE_DAC_WAVE_LIB
+// DAC waveform RPC functions
+typedef struct {
+  uint8_t channel;
+  uint16_t start;
+  JsonArray points;
+} wave_upload_params_t;
+
+static constexpr rpc_param_t WAVE_UPLOAD_PARAMS[] = {
+  RPC_REQUIRED_RANGE(wave_upload_params_t, channel, 0, DAC_MAX_CHANNEL),
+  RPC_OPTIONAL_RANGE(wave_upload_params_t, start, 0, WAVE_TABLE_SIZE - 1, 0),
+  RPC_REQUIRED(wave_upload_params_t, points),
+};
+
+int RpcServer::rpc_waveUpload(JsonObject params) {
+  wave_upload_params_t p;
+  if (!rpcBindParams(params, WAVE_UPLOAD_PARAMS, &p) || p.points.size() > WAVE_TABLE_SIZE) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  float points[WAVE_TABLE_SIZE];
+  uint16_t num_points = p.points.size();
+  for (uint16_t i = 0; i < num_points; i++) {
+    points[i] = p.points[i];
+  }
+  if (!dac_waveform.uploadTable(p.channel, p.start, points, num_points)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+  uint8_t shape;
+  float amplitude;
+  float offset;
+  uint32_t sample_rate;
+  uint16_t length;
+} wave_setup_params_t;
+
+static constexpr rpc_param_t WAVE_SETUP_PARAMS[] = {
+  RPC_REQUIRED_RANGE(wave_setup_params_t, channel, 0, DAC_MAX_CHANNEL),
+  RPC_REQUIRED(wave_setup_params_t, shape),
+  RPC_REQUIRED(wave_setup_params_t, amplitude),
+  RPC_OPTIONAL(wave_setup_params_t, offset, 0.0),
+  RPC_REQUIRED(wave_setup_params_t, sample_rate),
+  RPC_OPTIONAL_RANGE(wave_setup_params_t, length, 1, WAVE_TABLE_SIZE, WAVE_TABLE_SIZE),
+};
+
+int RpcServer::rpc_waveSetup(JsonObject params) {
+  wave_setup_params_t p;
+  if (!rpcBindParams(params, WAVE_SETUP_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!dac_waveform.configure(p.channel, (wave_shape_t)p.shape, p.amplitude, p.offset, p.sample_rate, p.length)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+} wave_channel_params_t;
+
+static constexpr rpc_param_t WAVE_CHANNEL_PARAMS[] = {
+  RPC_REQUIRED_RANGE(wave_channel_params_t, channel, 0, DAC_MAX_CHANNEL),
+};
+
+int RpcServer::rpc_waveStart(JsonObject params) {
+  wave_channel_params_t p;
+  if (!rpcBindParams(params, WAVE_CHANNEL_PARAMS, &p) || !dac_waveform.start(p.channel)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_waveStop(JsonObject params) {
+  wave_channel_params_t p;
+  if (!rpcBindParams(params, WAVE_CHANNEL_PARAMS, &p) || !dac_waveform.stop(p.channel)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+#endif
+
+#if defined INCLUDE_CALIBRATION_STORE
+// Calibration RPC functions
+static bool parseCalibrationDevice(const char* type, calib_device_t *device) {
+  if (strcmp(type, "adc") == 0) {
+    *device = CALIB_DEVICE_ADC;
+  } else if (strcmp(type, "dac") == 0) {
+    *device = CALIB_DEVICE_DAC;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// The channel range depends on the device, calibration checks it
+typedef struct {
+  const char* type;
+  uint8_t channel;
+  float gain;
+  float offset;
+  JsonArray points;
+} cal_params_t;
+
+static constexpr rpc_param_t CAL_GET_PARAMS[] = {
+  RPC_REQUIRED(cal_params_t, type),
+  RPC_REQUIRED(cal_params_t, channel),
+};
+
+static constexpr rpc_param_t CAL_SET_PARAMS[] = {
+  RPC_REQUIRED(cal_params_t, type),
+  RPC_REQUIRED(cal_params_t, channel),
+  RPC_REQUIRED_RANGE(cal_params_t, gain, CONV_MIN_GAIN, CONV_MAX_GAIN),
+  RPC_REQUIRED_RANGE(cal_params_t, offset, -CONV_MAX_OFFSET, CONV_MAX_OFFSET),
+  RPC_OPTIONAL(cal_params_t, points, 0),
+};
+
+int RpcServer::rpc_calGet(JsonObject params) {
+  cal_params_t p;
+  calib_device_t device;
+  conv_calibration_t cal;
+  if (!rpcBindParams(params, CAL_GET_PARAMS, &p) || !parseCalibrationDevice(p.type, &device) ||
+      !calibration.get(device, p.channel, &cal)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  response_data["gain"] = cal.gain;
+  response_data["offset"] = cal.offset;
+  JsonArray points = response_data.createNestedArray("points");
+  for (uint8_t i = 0; i < cal.pwl.numPoints; i++) {
+    JsonArray point = points.createNestedArray();
+    point.add(cal.pwl.pointUv[i] / 1e6);
+    point.add(cal.pwl.correctionUv[i] / 1e6);
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_calSet(JsonObject params) {
+  cal_params_t p;
+  calib_device_t device;
+  conv_calibration_t cal;
+  if (!rpcBindParams(params, CAL_SET_PARAMS, &p) || !parseCalibrationDevice(p.type, &device)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  convDefaultCalibration(&cal);
+  cal.gain = p.gain;
+  cal.offset = p.offset;
+  if (!p.points.isNull()) {
+    JsonArray point_list = p.points;
+    if (point_list.size() > CONV_PWL_POINTS) {
+      return RPC_ERROR_INVALID_PARAMS;
+    }
+    cal.pwl.numPoints = point_list.size();
+    for (uint8_t i = 0; i < cal.pwl.numPoints; i++) {
+      // each point is [voltage, correction]
+      JsonArray point = point_list[i].as<JsonArray>();
+      if (point.isNull() || point.size() != 2 || !point[0].is<float>() || !point[1].is<float>()) {
+        return RPC_ERROR_INVALID_PARAMS;
+      }
+      cal.pwl.pointUv[i] = convVoltToUv(point[0].as<float>());
+      cal.pwl.correctionUv[i] = convVoltToUv(point[1].as<float>());
+    }
+  }
+  // the points must lie within the voltage range of the channel
+  if (!calibration.set(device, p.channel, &cal)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_calCommit(JsonObject params) {
+  if (!calibration.commit()) {
+    return RPC_ERROR_EXECUTION;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_calReset(JsonObject params) {
+  calibration.reset();
+  return RPC_OK;
+}
+#endif
+
+// ADC RPC functions
+typedef struct {
+  uint8_t channel;
+  uint16_t averageCount;
+  bool fresh;
+} adc_raw_params_t;
+
+static constexpr rpc_param_t ADC_RAW_PARAMS[] = {
+  RPC_REQUIRED_RANGE(adc_raw_params_t, channel, 0, ADC_MAX_CHANNEL),
+  RPC_OPTIONAL_RANGE(adc_raw_params_t, averageCount, 1, UINT16_MAX, 1),
+  RPC_OPTIONAL(adc_raw_params_t, fresh, false),
+};
+
+int RpcServer::rpc_adcReadRaw(const void* args) {
+  const adc_raw_params_t* p = (const adc_raw_params_t*)args;
+  uint8_t channel = p->channel;
   
 #if defined INCLUDE_ADC_3208_LIB
-  uint16_t raw_value = adc.readRaw(channel, averageCount);
+#if defined INCLUDE_ADC_SAMPLER
+  // a scanned channel is answered from the cache, without touching the bus
+  adc_sample_t sample;
+  if (!p->fresh && adc_sampler.isRunning() && adc_sampler.read(channel, &sample)) {
+    response_data["raw"] = sample.average;
+    response_data["age_us"] = sample.ageUs;
+    return RPC_OK;
+  }
+#endif
+  uint16_t raw_value = adc.readRaw(channel, p->averageCount);
   response_data["raw"] = raw_value;
 #else
   response_data["raw"] = 0;
@@ -682,15 +2301,25 @@ int RpcServer::rpc_adcReadRaw(JsonObject params) {
 }
 
 int RpcServer::rpc_adcReadVoltage(JsonObject params) {
-  if (!params.containsKey("channel")) {
+  adc_raw_params_t p;
+  if (!rpcBindParams(params, ADC_RAW_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint8_t channel = params["channel"];
-  uint8_t averageCount = params.containsKey("averageCount") ? params["averageCount"] : 1;
+  uint8_t channel = p.channel;
+  uint16_t averageCount = p.averageCount;
+  bool fresh = p.fresh;
   
 #if defined INCLUDE_ADC_3208_LIB
-  double voltage = adc.readVoltage(channel, averageCount);
+#if defined INCLUDE_ADC_SAMPLER
+  adc_sample_t sample;
+  if (!fresh && adc_sampler.isRunning() && adc_sampler.read(channel, &sample)) {
+    response_data["voltage"] = adc.rawToMicrovolt(sample.average, channel) * 1e-6f;
+    response_data["age_us"] = sample.ageUs;
+    return RPC_OK;
+  }
+#endif
+  float voltage = adc.readVoltage(channel, averageCount);
   response_data["voltage"] = voltage;
 #else
   response_data["voltage"] = 0.0;
@@ -699,12 +2328,21 @@ int RpcServer::rpc_adcReadVoltage(JsonObject params) {
   return RPC_OK;
 }
 
+typedef struct {
+  uint8_t analogButton;
+} button_params_t;
+
+static constexpr rpc_param_t BUTTON_PARAMS[] = {
+  RPC_REQUIRED(button_params_t, analogButton),
+};
+
 int RpcServer::rpc_isButtonPressed(JsonObject params) {
-  if (!params.containsKey("analogButton")) {
+  button_params_t p;
+  if (!rpcBindParams(params, BUTTON_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint8_t analogButton = params["analogButton"];
+  uint8_t analogButton = p.analogButton;
   
 #if defined INCLUDE_ADC_3208_LIB
   bool pressed = adc.isButtonPressed(analogButton);
@@ -716,6 +2354,261 @@ int RpcServer::rpc_isButtonPressed(JsonObject params) {
   return RPC_OK;
 }
 
+#if defined INCLUDE_ADC_SAMPLER
+// Background ADC sampler RPC functions
+typedef struct {
+  JsonArray channels;
+  uint32_t rate_hz;
+  uint16_t average;
+} sampler_start_params_t;
+
+static constexpr rpc_param_t SAMPLER_START_PARAMS[] = {
+  RPC_REQUIRED(sampler_start_params_t, channels),
+  RPC_OPTIONAL(sampler_start_params_t, rate_hz, SAMPLER_DEFAULT_RATE_HZ),
+  RPC_OPTIONAL(sampler_start_params_t, average, 1),
+};
+
+int RpcServer::rpc_adcSamplerStart(JsonObject params) {
+  sampler_start_params_t p;
+  if (!rpcBindParams(params, SAMPLER_START_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  bool valid = true;
+  uint8_t channel_mask = maskFromList(p.channels, N_ADC_CHANNELS, &valid);
+  if (!valid || !adc_sampler.start(channel_mask, p.rate_hz, p.average)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_adcSamplerStop(JsonObject params) {
+  adc_sampler.stop();
+  return RPC_OK;
+}
+
+int RpcServer::rpc_adcSamplerStatus(JsonObject params) {
+  uint8_t channel_mask = adc_sampler.getChannelMask();
+  response_data["running"] = adc_sampler.isRunning();
+  JsonArray channels = response_data.createNestedArray("channels");
+  for (uint8_t ch = 0; ch < N_ADC_CHANNELS; ch++) {
+    if (channel_mask & (1 << ch)) {
+      channels.add(ch);
+    }
+  }
+  response_data["rate_hz"] = adc_sampler.getScanRate();
+  response_data["average"] = adc_sampler.getAverageWindow();
+  response_data["scans"] = adc_sampler.getScans();
+  response_data["missed"] = adc_sampler.getMissedScans();
+  return RPC_OK;
+}
+
+// All cached channels in one response, as parallel arrays
+int RpcServer::rpc_adcSamplerRead(JsonObject params) {
+  JsonArray channels = response_data.createNestedArray("channels");
+  JsonArray raw = response_data.createNestedArray("raw");
+  JsonArray average = response_data.createNestedArray("average");
+  JsonArray voltage = response_data.createNestedArray("voltage");
+  JsonArray age_us = response_data.createNestedArray("age_us");
+  adc_sample_t sample;
+  for (uint8_t ch = 0; ch < N_ADC_CHANNELS; ch++) {
+    if (adc_sampler.read(ch, &sample)) {
+      channels.add(ch);
+      raw.add(sample.raw);
+      average.add(sample.average);
+      voltage.add(adc.rawToMicrovolt(sample.average, ch) * 1e-6f);
+      age_us.add(sample.ageUs);
+    }
+  }
+  response_data["running"] = adc_sampler.isRunning();
+  return RPC_OK;
+}
+
+// Filter pipeline of a sampled channel: median -> decimating average -> IIR.
+// filter_lib checks the median length and decimation.
+typedef struct {
+  uint8_t channel;
+  bool enable;
+  float alpha;
+  uint8_t median;
+  uint16_t decimation;
+} filter_set_params_t;
+
+static constexpr rpc_param_t FILTER_SET_PARAMS[] = {
+  RPC_REQUIRED_RANGE(filter_set_params_t, channel, 0, ADC_MAX_CHANNEL),
+  RPC_OPTIONAL(filter_set_params_t, enable, true),
+  RPC_OPTIONAL_RANGE(filter_set_params_t, alpha, 0.0, 1.0, 1.0),
+  RPC_OPTIONAL(filter_set_params_t, median, 1),
+  RPC_OPTIONAL(filter_set_params_t, decimation, 1),
+};
+
+int RpcServer::rpc_adcFilterSet(JsonObject params) {
+  filter_set_params_t p;
+  if (!rpcBindParams(params, FILTER_SET_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  if (!p.enable) {
+    return adc_sampler.setFilter(p.channel, nullptr) ? RPC_OK : RPC_ERROR_INVALID_PARAMS;
+  }
+  if (p.alpha <= 0.0f) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  filter_config_t config;
+  config.medianLength = p.median;
+  config.decimation = p.decimation;
+  config.alphaQ16 = max(1L, lroundf(p.alpha * FILTER_ALPHA_ONE));
+  if (!adc_sampler.setFilter(p.channel, &config)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+typedef struct {
+  uint8_t channel;
+} filter_read_params_t;
+
+static constexpr rpc_param_t FILTER_READ_PARAMS[] = {
+  RPC_REQUIRED_RANGE(filter_read_params_t, channel, 0, ADC_MAX_CHANNEL),
+};
+
+int RpcServer::rpc_adcFilterRead(JsonObject params) {
+  filter_read_params_t p;
+  if (!rpcBindParams(params, FILTER_READ_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  uint8_t channel = p.channel;
+  filter_config_t config;
+  adc_filtered_t filtered;
+  if (!adc_sampler.getFilter(channel, &config)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  if (!adc_sampler.readFiltered(channel, &filtered)) {
+    return RPC_ERROR_EXECUTION;  // no output yet, or the channel is not sampled
+  }
+  response_data["raw"] = filtered.valueQ8 / (float)(1 << FILTER_OUTPUT_SHIFT);
+  response_data["voltage"] = adc.rawQ8ToMicrovolt(filtered.valueQ8, channel) * 1e-6f;
+  response_data["age_us"] = filtered.ageUs;
+  response_data["outputs"] = filtered.outputs;
+  response_data["rate_hz"] = (float)adc_sampler.getScanRate() / config.decimation;
+  return RPC_OK;
+}
+#endif
+
+#if defined INCLUDE_ADC_CAPTURE
+// Triggered burst capture RPC functions
+typedef struct {
+  JsonArray channels;
+  uint8_t trigger;
+  uint8_t source;
+  uint16_t level;
+  uint16_t hysteresis;
+  uint16_t pre;
+  uint16_t post;
+} capture_arm_params_t;
+
+static constexpr rpc_param_t CAPTURE_ARM_PARAMS[] = {
+  RPC_REQUIRED(capture_arm_params_t, channels),
+  RPC_OPTIONAL_RANGE(capture_arm_params_t, trigger, CAPTURE_TRIGGER_NOW, CAPTURE_TRIGGER_DIO_FALLING, CAPTURE_TRIGGER_NOW),
+  RPC_OPTIONAL(capture_arm_params_t, source, 0),
+  RPC_OPTIONAL_RANGE(capture_arm_params_t, level, 0, ADC_MAX_VALUE, 0),
+  RPC_OPTIONAL_RANGE(capture_arm_params_t, hysteresis, 0, ADC_MAX_VALUE, 0),
+  RPC_REQUIRED(capture_arm_params_t, pre),
+  RPC_REQUIRED(capture_arm_params_t, post),
+};
+
+int RpcServer::rpc_captureArm(JsonObject params) {
+  capture_arm_params_t p;
+  if (!rpcBindParams(params, CAPTURE_ARM_PARAMS, &p)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+
+  bool valid = true;
+  capture_config_t config;
+  config.channelMask = maskFromList(p.channels, N_ADC_CHANNELS, &valid);
+  config.trigger = (capture_trigger_t)p.trigger;
+  config.source = p.source;
+  config.level = p.level;
+  config.hysteresis = p.hysteresis;
+  config.preScans = p.pre;
+  config.postScans = p.post;
+  if (!valid) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  if (adc_capture.getState() == CAPTURE_ARMED || adc_capture.getState() == CAPTURE_TRIGGERED) {
+    return RPC_ERROR_EXECUTION;  // stop the running capture first
+  }
+  if (!adc_capture.arm(&config)) {
+    return RPC_ERROR_INVALID_PARAMS;
+  }
+  return RPC_OK;
+}
+
+int RpcServer::rpc_captureStop(JsonObject params) {
+  adc_capture.stop();
+  return RPC_OK;
+}
+
+int RpcServer::rpc_captureTrigger(JsonObject params) {
+  adc_capture.forceTrigger();
+  return RPC_OK;
+}
+
+int RpcServer::rpc_captureStatus(JsonObject params) {
+  static const char* state_names[] = {"idle", "armed", "triggered", "done"};
+  response_data["state"] = state_names[adc_capture.getState()];
+  response_data["scans"] = adc_capture.getScans();
+  response_data["recorded"] = adc_capture.getScansRecorded();
+  response_data["max_scans"] = adc_capture.maxScans(adc_capture.getConfig()->channelMask);
+  return RPC_OK;
+}
+
+// The whole block in one response: per scan an int32 cycle count relative to
+// the trigger scan followed by the uint16 raw value of every channel, little
+// endian. Three scans at a time are a multiple of 3 bytes, so they are encoded
+// straight into the text without a packed copy of the block.
+int RpcServer::rpc_captureRead(JsonObject params) {
+  static char text[((CAPTURE_MAX_SCANS * sizeof(int32_t) + CAPTURE_MAX_SAMPLES * sizeof(uint16_t) + 2) / 3) * 4 + 1];
+  uint8_t group[3 * (sizeof(int32_t) + N_ADC_CHANNELS * sizeof(uint16_t))];
+  uint16_t raw_values[N_ADC_CHANNELS];
+  int32_t cycles = 0;
+
+  if (adc_capture.getState() != CAPTURE_DONE) {
+    return RPC_ERROR_EXECUTION;
+  }
+
+  const capture_config_t* config = adc_capture.getConfig();
+  uint8_t num_channels = adc_capture.getNumChannels();
+  uint16_t scans = adc_capture.getScans();
+  size_t scan_size = sizeof(int32_t) + num_channels * sizeof(uint16_t);
+  size_t text_length = 0;
+
+  for (uint16_t scan = 0; scan < scans; scan += 3) {
+    size_t length = 0;
+    for (uint16_t ix = scan; ix < scan + 3 && ix < scans; ix++) {
+      adc_capture.readScan(ix, &cycles, raw_values);
+      memcpy(&group[length], &cycles, sizeof(cycles));
+      memcpy(&group[length + sizeof(cycles)], raw_values, num_channels * sizeof(uint16_t));
+      length += scan_size;
+    }
+    encodeBase64(group, length, &text[text_length]);
+    text_length += ((length + 2) / 3) * 4;
+  }
+
+  JsonArray channels = response_data.createNestedArray("channels");
+  for (uint8_t ch = 0; ch < N_ADC_CHANNELS; ch++) {
+    if (config->channelMask & (1 << ch)) {
+      channels.add(ch);
+    }
+  }
+  response_data["cpu_mhz"] = ESP.getCpuFreqMHz();
+  response_data["scans"] = scans;
+  response_data["pre"] = config->preScans;
+  response_data["data"] = (const char*)text;
+  return RPC_OK;
+}
+#endif
+
 #if defined INCLUDE_DIO_LIB
 // DIO RPC functions
 int RpcServer::rpc_dioGetInput(JsonObject params) {
@@ -724,55 +2617,189 @@ int RpcServer::rpc_dioGetInput(JsonObject params) {
   return RPC_OK;
 }
 
-int RpcServer::rpc_dioIsBitSet(JsonObject params) {
-  if (!params.containsKey("bitNumber")) {
-    return RPC_ERROR_INVALID_PARAMS;
-  }
-  
-  uint8_t bitNumber = params["bitNumber"];
-  bool bitSet = digital_io.isBitSet(bitNumber);
+typedef struct {
+  uint8_t bitNumber;
+  bool force;
+} dio_bit_params_t;
+
+static constexpr rpc_param_t DIO_BIT_PARAMS[] = {
+  RPC_REQUIRED_RANGE(dio_bit_params_t, bitNumber, 0, N_OUTPUT_BITS - 1),
+  RPC_OPTIONAL(dio_bit_params_t, force, false),
+};
+
+typedef struct {
+  uint8_t value;
+  bool force;
+} dio_output_params_t;
+
+static constexpr rpc_param_t DIO_OUTPUT_PARAMS[] = {
+  RPC_REQUIRED(dio_output_params_t, value),
+  RPC_OPTIONAL(dio_output_params_t, force, false),
+};
+
+int RpcServer::rpc_dioIsBitSet(const void* args) {
+  const dio_bit_params_t* p = (const dio_bit_params_t*)args;
+  bool bitSet = digital_io.isBitSet(p->bitNumber);
   response_data["bitSet"] = bitSet;
   return RPC_OK;
 }
 
-int RpcServer::rpc_dioSetOutput(JsonObject params) {
-  if (!params.containsKey("value")) {
+int RpcServer::rpc_dioSetOutput(const void* args) {
+  const dio_output_params_t* p = (const dio_output_params_t*)args;
+  digital_io.setOutput(p->value, p->force);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_dioSetBit(const void* args) {
+  const dio_bit_params_t* p = (const dio_bit_params_t*)args;
+  digital_io.setBit(p->bitNumber, p->force);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_dioClearBit(const void* args) {
+  const dio_bit_params_t* p = (const dio_bit_params_t*)args;
+  digital_io.clearBit(p->bitNumber, p->force);
+  return RPC_OK;
+}
+
+int RpcServer::rpc_dioToggleBit(JsonObject params) {
+  dio_bit_params_t p;
+  if (!rpcBindParams(params, DIO_BIT_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
   
-  uint8_t value = params["value"];
-  digital_io.setOutput(value);
+  digital_io.toggleBit(p.bitNumber);
   return RPC_OK;
 }
 
-int RpcServer::rpc_dioSetBit(JsonObject params) {
-  if (!params.containsKey("bitNumber")) {
+#endif
+
+#if defined INCLUDE_INPUT_EVENTS
+// Input event RPC functions
+#define EVENTS_NO_DIO_MASK 0xFF
+
+typedef struct {
+  JsonArray pins;
+  uint8_t dio_mask;
+} events_params_t;
+
+static constexpr rpc_param_t EVENTS_ENABLE_PARAMS[] = {
+  RPC_OPTIONAL(events_params_t, pins, 0),
+  RPC_OPTIONAL_RANGE(events_params_t, dio_mask, 0, EVENTS_NO_DIO_MASK - 1, EVENTS_NO_DIO_MASK),
+};
+
+static constexpr rpc_param_t EVENTS_DISABLE_PARAMS[] = {
+  RPC_OPTIONAL(events_params_t, pins, 0),
+};
+
+// pins, dio_mask or both
+int RpcServer::rpc_eventsEnable(JsonObject params) {
+  events_params_t p;
+  if (!rpcBindParams(params, EVENTS_ENABLE_PARAMS, &p) ||
+      (p.pins.isNull() && p.dio_mask == EVENTS_NO_DIO_MASK)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t bitNumber = params["bitNumber"];
-  digital_io.setBit(bitNumber);
+  if (!p.pins.isNull()) {
+    for (uint8_t i = 0; i < p.pins.size(); i++) {
+      if (!input_events.enable(p.pins[i])) {
+        return RPC_ERROR_INVALID_PARAMS;
+      }
+    }
+  }
+#if defined INCLUDE_DIO_LIB
+  if (p.dio_mask != EVENTS_NO_DIO_MASK) {
+    for (uint8_t bit = 0; bit < N_INPUT_BITS; bit++) {
+      if (((p.dio_mask & (0x01 << bit)) != 0) && !input_events.enable(digital_io.getGPIONumberInput(bit))) {
+        return RPC_ERROR_INVALID_PARAMS;
+      }
+    }
+  }
+#endif
   return RPC_OK;
 }
 
-int RpcServer::rpc_dioClearBit(JsonObject params) {
-  if (!params.containsKey("bitNumber")) {
+// Without pins every pin is disabled
+int RpcServer::rpc_eventsDisable(JsonObject params) {
+  events_params_t p;
+  if (!rpcBindParams(params, EVENTS_DISABLE_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t bitNumber = params["bitNumber"];
-  digital_io.clearBit(bitNumber);
+  if (p.pins.isNull()) {
+    input_events.disableAll();
+    return RPC_OK;
+  }
+  for (uint8_t i = 0; i < p.pins.size(); i++) {
+    input_events.disable(p.pins[i]);
+  }
   return RPC_OK;
 }
 
-int RpcServer::rpc_dioToggleBit(JsonObject params) {
-  if (!params.containsKey("bitNumber")) {
+typedef struct {
+  uint16_t max;
+} events_read_params_t;
+
+static constexpr rpc_param_t EVENTS_READ_PARAMS[] = {
+  RPC_OPTIONAL(events_read_params_t, max, RPC_EVENTS_MAX_READ),
+};
+
+int RpcServer::rpc_eventsRead(JsonObject params) {
+  events_read_params_t p;
+  if (!rpcBindParams(params, EVENTS_READ_PARAMS, &p)) {
     return RPC_ERROR_INVALID_PARAMS;
   }
-  
-  uint8_t bitNumber = params["bitNumber"];
-  digital_io.toggleBit(bitNumber);
+  uint16_t max_events = p.max;
+  if (max_events > RPC_EVENTS_MAX_READ) {
+    max_events = RPC_EVENTS_MAX_READ;
+  }
+  input_event_t events[RPC_EVENTS_MAX_READ];
+  uint16_t num_events = input_events.read(events, max_events);
+  JsonArray pins = response_data.createNestedArray("pins");
+  JsonArray levels = response_data.createNestedArray("levels");
+  JsonArray timestamps = response_data.createNestedArray("t_us");
+  for (uint16_t i = 0; i < num_events; i++) {
+    pins.add(events[i].pin);
+    levels.add(events[i].level);
+    timestamps.add(events[i].timestampUs);
+  }
+  response_data["pending"] = input_events.available();
+  response_data["overflow"] = input_events.getOverflowCount();
+  return RPC_OK;
+}
+
+int RpcServer::rpc_eventsClear(JsonObject params) {
+  input_events.clear();
   return RPC_OK;
 }
+#endif
+
+// Bound methods, see execute_command() and rpc_prepare()
+#define BOUND_METHOD(name, type, fields, run) \
+  { name, fields, sizeof(fields) / sizeof(fields[0]), rpcArgsSize<type>(), &RpcServer::run }
+
+const RpcServer::bound_method_t RpcServer::bound_methods[] = {
+  BOUND_METHOD("digitalWrite", pin_write_params_t, DIGITAL_WRITE_PARAMS, rpc_digitalWrite),
+  BOUND_METHOD("digitalRead", pin_read_params_t, DIGITAL_READ_PARAMS, rpc_digitalRead),
+  BOUND_METHOD("analogRead", pin_read_params_t, ANALOG_READ_PARAMS, rpc_analogRead),
+  BOUND_METHOD("ledcWrite", ledc_write_params_t, LEDC_WRITE_PARAMS, rpc_ledcWrite),
+  BOUND_METHOD("pulse", pulse_params_t, PULSE_PARAMS, rpc_pulse),
+  BOUND_METHOD("pulseAsync", pulse_params_t, PULSE_PARAMS, rpc_pulseAsync),
+  BOUND_METHOD("isPulsing", pulse_channel_params_t, PULSE_CHANNEL_PARAMS, rpc_isPulsing),
+  BOUND_METHOD("getRemainingPulses", pulse_channel_params_t, PULSE_CHANNEL_PARAMS, rpc_getRemainingPulses),
+  BOUND_METHOD("stopPulse", pulse_channel_params_t, PULSE_CHANNEL_PARAMS, rpc_stopPulse),
+  BOUND_METHOD("generatePulsesAsync", pulse_train_params_t, PULSE_TRAIN_PARAMS, rpc_generatePulsesAsync),
+  BOUND_METHOD("adcReadRaw", adc_raw_params_t, ADC_RAW_PARAMS, rpc_adcReadRaw),
+#if defined INCLUDE_DAC_4922_LIB
+  BOUND_METHOD("dacSetVoltage", dac_voltage_params_t, DAC_VOLTAGE_PARAMS, rpc_dacSetVoltage),
+#endif
+#if defined INCLUDE_DIO_LIB
+  BOUND_METHOD("dioIsBitSet", dio_bit_params_t, DIO_BIT_PARAMS, rpc_dioIsBitSet),
+  BOUND_METHOD("dioSetOutput", dio_output_params_t, DIO_OUTPUT_PARAMS, rpc_dioSetOutput),
+  BOUND_METHOD("dioSetBit", dio_bit_params_t, DIO_BIT_PARAMS, rpc_dioSetBit),
+  BOUND_METHOD("dioClearBit", dio_bit_params_t, DIO_BIT_PARAMS, rpc_dioClearBit),
+#endif
+#if defined INCLUDE_QC_7366_LIB
+  BOUND_METHOD("qcReadCountRegister", qc_channel_params_t, QC_CHANNEL_PARAMS, rpc_qcReadCountRegister),
+#endif
+};
 
-#endif
\ No newline at end of file
+const uint8_t RpcServer::num_bound_methods = sizeof(bound_methods) / sizeof(bound_methods[0]);
@@ -0,0 +1,86 @@
+#include "rpc_stats.h"
+
+#if RPC_STATS_ENABLED
+
+RpcStats::RpcStats() {
+  reset();
+}
+
+void RpcStats::reset() {
+  memset(_methods, 0, sizeof(_methods));
+  _count = 0;
+}
+
+uint8_t RpcStats::count() {
+  return _count;
+}
+
+const rpc_method_stats_t* RpcStats::get(uint8_t index) {
+  return (index < _count) ? &_methods[index] : nullptr;
+}
+
+const rpc_method_stats_t* RpcStats::find(const char* method) {
+  for (uint8_t i = 0; i < _count; i++) {
+    if (strcmp(_methods[i].name, method) == 0) {
+      return &_methods[i];
+    }
+  }
+  return nullptr;
+}
+
+// Linear search, the table is small and the entry of a method never moves.
+rpc_method_stats_t* RpcStats::lookup(const char* method) {
+  if (method == nullptr) {
+    method = "?";
+  }
+
+  for (uint8_t i = 0; i < _count; i++) {
+    if (strncmp(_methods[i].name, method, RPC_STATS_NAME_LENGTH - 1) == 0) {
+      return &_methods[i];
+    }
+  }
+
+  if (_count < RPC_STATS_MAX_METHODS - 1) {
+    rpc_method_stats_t* entry = &_methods[_count++];
+    strncpy(entry->name, method, RPC_STATS_NAME_LENGTH - 1);
+    return entry;
+  }
+
+  rpc_method_stats_t* other = &_methods[RPC_STATS_MAX_METHODS - 1];
+  if (_count < RPC_STATS_MAX_METHODS) {
+    strcpy(other->name, "<other>");
+    _count++;
+  }
+  return other;
+}
+
+void RpcStats::addSample(rpc_method_stats_t* entry, rpc_phase_t phase, uint32_t us) {
+  uint8_t bucket = 0;
+  uint32_t magnitude = us;
+  while (magnitude != 0 && bucket < RPC_STATS_N_BUCKETS - 1) {
+    magnitude >>= 1;
+    ++bucket;
+  }
+
+  entry->totalUs[phase] += us;
+  if (us > entry->maxUs[phase]) {
+    entry->maxUs[phase] = us;
+  }
+  if (entry->histogram[phase][bucket] < UINT16_MAX) {
+    ++entry->histogram[phase][bucket];
+  }
+}
+
+void RpcStats::record(const char* method, int result, uint32_t parse_us, uint32_t execute_us, uint32_t serialize_us) {
+  rpc_method_stats_t* entry = lookup(method);
+
+  ++entry->calls;
+  if (result != RPC_OK) {
+    ++entry->errors;
+  }
+  addSample(entry, RPC_PHASE_PARSE, parse_us);
+  addSample(entry, RPC_PHASE_EXECUTE, execute_us);
+  addSample(entry, RPC_PHASE_SERIALIZE, serialize_us);
+}
+
+#endif
@@ -0,0 +1,393 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SamplerLib.cpp
+//
+// The hardware timer only wakes the scan task, the SPI driver can not be used
+// from an ISR. The task converts the whole channel set in one SPI transaction
+// and updates the cache under the spinlock, readers copy a channel out under
+// the same lock and never wait for the bus.
+//
+// The running average is an exponential one with a power of 2 window:
+// average += (raw - average) / window, kept in 24.8 fixed point so a long
+// window does not lose the fraction.
+//
+// Filtered channels run their pipeline in the scan task as well, outside the
+// critical section: the task owns the pipeline states, setFilter() only
+// publishes a configuration with a new generation under the spinlock. The
+// task picks it up with the other settings at the start of a scan and
+// restarts the pipeline, an output of an older generation is dropped.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "sampler_lib.h"
+
+adcSampler *adcSampler::instance = nullptr;
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcSampler::init(adc3208 *adc)
+
+void adcSampler::init(adc3208 *adc)
+{
+	this->adc = adc;
+	instance = this;
+
+	memset(cache, 0, sizeof(cache));
+	memset(filters, 0, sizeof(filters));
+	memset(filterStates, 0, sizeof(filterStates));
+	memset(filterGenerations, 0, sizeof(filterGenerations));
+
+	xTaskCreatePinnedToCore(scanTask, "adcSampler", RTOS_DEFAULT_STACKSIZE, this,
+							SAMPLER_TASK_PRIORITY, &taskHandle, CORE_1);
+
+	timer = timerBegin(SAMPLER_TIMER_NUMBER, SAMPLER_TIMER_DIVIDER, true);
+	timerAttachInterrupt(timer, &onTimer, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void IRAM_ATTR adcSampler::onTimer(void)
+
+void IRAM_ATTR adcSampler::onTimer(void)
+{
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(instance->taskHandle, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcSampler::scanTask(void *parameter)
+
+void adcSampler::scanTask(void *parameter)
+{
+	adcSampler *sampler = (adcSampler *)parameter;
+	uint32_t ticks = 0;
+
+	while (true)
+	{
+		ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		sampler->scan(ticks);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcSampler::scan(uint32_t ticks)
+//
+// ticks > 1: the task was held up for more than one scan period, the extra
+// timer ticks are counted as missed scans
+
+void adcSampler::scan(uint32_t ticks)
+{
+	uint16_t rawValues[N_ADC_CHANNELS];
+	uint8_t  list[N_ADC_CHANNELS];
+	bool     filterOn[N_ADC_CHANNELS];
+	uint32_t generation[N_ADC_CHANNELS];
+	filter_config_t config[N_ADC_CHANNELS];
+	bool     outputReady[N_ADC_CHANNELS];
+	int32_t  output[N_ADC_CHANNELS];
+	uint8_t  count = 0;
+	uint8_t  shift = 0;
+	uint8_t  ix = 0;
+	uint8_t  channel = 0;
+	uint32_t now = 0;
+
+	portENTER_CRITICAL(&mux);
+	count = numChannels;
+	shift = averageShift;
+	memcpy(list, channelList, sizeof(list));
+	for (ix = 0; ix < count; ix++)
+	{
+		filterOn[ix]   = filters[list[ix]].enabled;
+		generation[ix] = filters[list[ix]].generation;
+		config[ix]     = filters[list[ix]].config;
+	}
+	portEXIT_CRITICAL(&mux);
+
+	if (!running || (count == 0))
+	{
+		return;
+	}
+
+	adc->readRawMultiple(list, count, rawValues);
+	now = (uint32_t)esp_timer_get_time();
+
+	for (ix = 0; ix < count; ix++)
+	{
+		channel = list[ix];
+		outputReady[ix] = false;
+
+		if (!filterOn[ix])
+		{
+			continue;
+		}
+
+		if (filterGenerations[channel] != generation[ix])
+		{
+			filterInit(&filterStates[channel], &config[ix]);
+			filterGenerations[channel] = generation[ix];
+		}
+
+		outputReady[ix] = filterProcess(&filterStates[channel], rawValues[ix], &output[ix]);
+	}
+
+	portENTER_CRITICAL(&mux);
+	for (ix = 0; ix < count; ix++)
+	{
+		adc_cache_t *entry = &cache[list[ix]];
+		int32_t sample = (int32_t)rawValues[ix] << SAMPLER_AVERAGE_SHIFT;
+
+		if (entry->count == 0)
+		{
+			entry->average = sample;
+		}
+		else
+		{
+			entry->average += (sample - entry->average) >> shift;
+		}
+
+		entry->raw         = rawValues[ix];
+		entry->timestampUs = now;
+		entry->count++;
+
+		adc_filter_t *filter = &filters[list[ix]];
+
+		if (outputReady[ix] && (filter->generation == generation[ix]))
+		{
+			filter->output      = output[ix];
+			filter->timestampUs = now;
+			filter->outputs++;
+		}
+	}
+	scans++;
+	missedScans += (ticks > 1) ? (ticks - 1) : 0;
+	portEXIT_CRITICAL(&mux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::start(uint8_t channelMask, uint32_t scanRate, uint16_t averageWindow)
+//
+// channelMask: bit n set = scan channel n, restarts a running sampler with the
+// new settings and clears the cache
+
+bool adcSampler::start(uint8_t channelMask, uint32_t scanRate, uint16_t averageWindow)
+{
+	uint8_t channel = 0;
+	uint8_t shift = 0;
+
+	if ((channelMask == 0) || (scanRate == 0) || (scanRate > SAMPLER_MAX_RATE_HZ) ||
+		(averageWindow == 0) || (averageWindow > SAMPLER_MAX_AVERAGE) ||
+		((averageWindow & (averageWindow - 1)) != 0))
+	{
+		return false;
+	}
+
+	while ((1U << shift) < averageWindow)
+	{
+		shift++;
+	}
+
+	stop();
+
+	portENTER_CRITICAL(&mux);
+	numChannels = 0;
+	for (channel = 0; channel < N_ADC_CHANNELS; channel++)
+	{
+		if (channelMask & (1 << channel))
+		{
+			channelList[numChannels++] = channel;
+		}
+	}
+	this->channelMask = channelMask;
+	this->scanRate    = scanRate;
+	averageShift      = shift;
+	scans             = 0;
+	missedScans       = 0;
+	memset(cache, 0, sizeof(cache));
+	for (channel = 0; channel < N_ADC_CHANNELS; channel++)
+	{
+		filters[channel].generation++;
+		filters[channel].outputs = 0;
+	}
+	running = true;
+	portEXIT_CRITICAL(&mux);
+
+	timerAlarmWrite(timer, 1000000UL / scanRate, true);
+	timerAlarmEnable(timer);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void adcSampler::stop(void)
+//
+// the cache keeps the last values, their age keeps growing
+
+void adcSampler::stop(void)
+{
+	timerAlarmDisable(timer);
+	running = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::isRunning(void)
+
+bool adcSampler::isRunning(void)
+{
+	return running;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::read(uint8_t channel, adc_sample_t *sample)
+//
+// returns false when the channel is not scanned or has no value yet. After
+// stop() the last values stay readable, with their age.
+
+bool adcSampler::read(uint8_t channel, adc_sample_t *sample)
+{
+	adc_cache_t entry;
+
+	if ((channel >= N_ADC_CHANNELS) || !(channelMask & (1 << channel)))
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	entry = cache[channel];
+	portEXIT_CRITICAL(&mux);
+
+	if (entry.count == 0)
+	{
+		return false;
+	}
+
+	sample->raw     = entry.raw;
+	sample->average = (uint16_t)((entry.average + (1 << (SAMPLER_AVERAGE_SHIFT - 1))) >> SAMPLER_AVERAGE_SHIFT);
+	sample->ageUs   = (uint32_t)esp_timer_get_time() - entry.timestampUs;
+	sample->count   = entry.count;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::setFilter(uint8_t channel, const filter_config_t *config)
+//
+// config nullptr switches the filter of the channel off. The pipeline starts
+// from an empty history, the output rate is getScanRate() / decimation.
+
+bool adcSampler::setFilter(uint8_t channel, const filter_config_t *config)
+{
+	filter_state_t state;
+
+	if (channel >= N_ADC_CHANNELS)
+	{
+		return false;
+	}
+
+	// validates only, the scan task builds its own pipeline
+	if ((config != nullptr) && !filterInit(&state, config))
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	if (config != nullptr)
+	{
+		filters[channel].config = *config;
+	}
+	filters[channel].enabled = (config != nullptr);
+	filters[channel].generation++;
+	filters[channel].outputs = 0;
+	portEXIT_CRITICAL(&mux);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::getFilter(uint8_t channel, filter_config_t *config)
+//
+// returns false when the channel has no filter
+
+bool adcSampler::getFilter(uint8_t channel, filter_config_t *config)
+{
+	bool enabled = false;
+
+	if (channel >= N_ADC_CHANNELS)
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	enabled = filters[channel].enabled;
+	*config = filters[channel].config;
+	portEXIT_CRITICAL(&mux);
+
+	return enabled;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool adcSampler::readFiltered(uint8_t channel, adc_filtered_t *filtered)
+//
+// returns false when the channel has no filter or no output yet
+
+bool adcSampler::readFiltered(uint8_t channel, adc_filtered_t *filtered)
+{
+	adc_filter_t filter;
+
+	if (channel >= N_ADC_CHANNELS)
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	filter.enabled     = filters[channel].enabled;
+	filter.output      = filters[channel].output;
+	filter.timestampUs = filters[channel].timestampUs;
+	filter.outputs     = filters[channel].outputs;
+	portEXIT_CRITICAL(&mux);
+
+	if (!filter.enabled || (filter.outputs == 0))
+	{
+		return false;
+	}
+
+	filtered->valueQ8 = filter.output;
+	filtered->ageUs   = (uint32_t)esp_timer_get_time() - filter.timestampUs;
+	filtered->outputs = filter.outputs;
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getters
+
+uint8_t adcSampler::getChannelMask(void)
+{
+	return channelMask;
+}
+
+uint32_t adcSampler::getScanRate(void)
+{
+	return scanRate;
+}
+
+uint16_t adcSampler::getAverageWindow(void)
+{
+	return 1 << averageShift;
+}
+
+uint32_t adcSampler::getScans(void)
+{
+	return scans;
+}
+
+uint32_t adcSampler::getMissedScans(void)
+{
+	return missedScans;
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SamplerLib.h
+//
+// background sampler for the MCP3208 ADC: scans a set of channels at a fixed
+// rate from a hardware timer into a per-channel cache with a running average,
+// so a read returns the latest value without touching the SPI bus. A channel
+// can also feed a filter pipeline (filter_lib) at the scan rate.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SAMPLERLIB_H
+#define SAMPLERLIB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "adc_3208_lib.h"
+#include "filter_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define SAMPLER_MAX_RATE_HZ		1000		// max. scans per second of the channel set
+#define SAMPLER_DEFAULT_RATE_HZ	100
+#define SAMPLER_MAX_AVERAGE		256			// max. running average window, power of 2
+#define SAMPLER_TIMER_NUMBER	1			// hardware timer used for the scan clock
+#define SAMPLER_TIMER_DIVIDER	80			// 80 MHz APB clock / 80 = 1 us timer ticks
+
+#define SAMPLER_TASK_PRIORITY	(configMAX_PRIORITIES - 3)
+
+// running average: 24.8 fixed point raw value
+
+#define SAMPLER_AVERAGE_SHIFT	8
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint16_t raw;						// latest conversion
+	uint16_t average;					// running average, rounded to a raw value
+	uint32_t ageUs;						// time since the latest conversion
+	uint32_t count;						// conversions since start()
+} adc_sample_t;
+
+typedef struct
+{
+	uint16_t raw;
+	int32_t  average;					// 24.8 fixed point
+	uint32_t timestampUs;				// esp_timer at the conversion
+	uint32_t count;
+} adc_cache_t;
+
+typedef struct
+{
+	int32_t  valueQ8;					// filter output, 24.8 fixed point raw value
+	uint32_t ageUs;						// time since the latest output
+	uint32_t outputs;					// outputs since start() or setFilter()
+} adc_filtered_t;
+
+// filter of a channel as published under the spinlock, the pipeline state
+// itself belongs to the scan task
+
+typedef struct
+{
+	filter_config_t config;
+	bool     enabled;
+	uint32_t generation;				// counts setFilter() & start(), restarts the pipeline
+	int32_t  output;
+	uint32_t timestampUs;
+	uint32_t outputs;
+} adc_filter_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class adcSampler {
+public:
+	void init(adc3208 *adc);
+
+	bool start(uint8_t channelMask, uint32_t scanRate = SAMPLER_DEFAULT_RATE_HZ,
+			   uint16_t averageWindow = 1);
+	void stop(void);
+	bool isRunning(void);
+	bool read(uint8_t channel, adc_sample_t *sample);
+
+	bool setFilter(uint8_t channel, const filter_config_t *config);
+	bool getFilter(uint8_t channel, filter_config_t *config);
+	bool readFiltered(uint8_t channel, adc_filtered_t *filtered);
+
+	uint8_t  getChannelMask(void);
+	uint32_t getScanRate(void);
+	uint16_t getAverageWindow(void);
+	uint32_t getScans(void);
+	uint32_t getMissedScans(void);
+
+private:
+	static void IRAM_ATTR onTimer(void);
+	static void scanTask(void *parameter);
+	void scan(uint32_t ticks);
+
+	adc3208 *adc;
+	hw_timer_t *timer = nullptr;
+	TaskHandle_t taskHandle = nullptr;
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+	uint8_t  channelList[N_ADC_CHANNELS];
+	uint8_t  numChannels = 0;
+	uint8_t  channelMask = 0;
+	uint8_t  averageShift = 0;
+	uint32_t scanRate = 0;
+	uint32_t scans = 0;
+	uint32_t missedScans = 0;
+	volatile bool running = false;
+
+	adc_cache_t cache[N_ADC_CHANNELS];
+	adc_filter_t filters[N_ADC_CHANNELS];
+
+	// scan task only, run outside the spinlock
+	filter_state_t filterStates[N_ADC_CHANNELS];
+	uint32_t filterGenerations[N_ADC_CHANNELS];
+
+	static adcSampler *instance;
+};
+
+#endif	// SAMPLERLIB_H
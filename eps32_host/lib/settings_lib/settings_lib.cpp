@@ -0,0 +1,238 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SettingsLib.cpp
+//
+// The record is read once at boot, all getters work on the RAM copy. Setters
+// change the RAM copy only, commit() writes it back in one go, so a setting
+// used at boot (mode, baud rate, port) takes effect after a restart.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "settings_lib.h"
+
+RECORD_CHECK_LAYOUT(settings_record_t);
+
+///////////////////////////////////////////////////////////////////////////////
+// bool settingsStore::init(void)
+//
+// mounts LittleFS, it stays mounted for the other users of the filesystem.
+// Returns false when no valid record was found and defaults are used.
+
+bool settingsStore::init(void)
+{
+	bool loaded = load();
+
+	if (!loaded)
+	{
+		reset();
+		if (importLegacy())
+		{
+			commit();
+		}
+	}
+
+	return loaded;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool settingsStore::load(void)
+
+bool settingsStore::load(void)
+{
+	return recordLoad(SETTINGS_FILE_PATH, &record, sizeof(record), SETTINGS_MAGIC, SETTINGS_VERSION);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// String settingsStore::readLegacyFile(const char *path)
+//
+// first line of a text file, empty when the file does not exist
+
+String settingsStore::readLegacyFile(const char *path)
+{
+	String content;
+
+	if (!LittleFS.exists(path))
+	{
+		return content;
+	}
+
+	File file = LittleFS.open(path, FILE_READ);
+	if (file && !file.isDirectory())
+	{
+		content = file.readStringUntil('\n');
+		file.close();
+	}
+
+	return content;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool settingsStore::importLegacy(void)
+//
+// returns true when any of the old text files was found
+
+bool settingsStore::importLegacy(void)
+{
+	bool found = false;
+	String mode = readLegacyFile(SETTINGS_LEGACY_MODE_PATH);
+	String ssid = readLegacyFile(SETTINGS_LEGACY_SSID_PATH);
+	String password = readLegacyFile(SETTINGS_LEGACY_PASS_PATH);
+
+	if (mode.length() > 0)
+	{
+		record.commMode = (mode == "WIFI") ? COMM_WIFI : COMM_USB;
+		found = true;
+	}
+
+	if ((ssid.length() > 0) && setSsid(ssid.c_str()))
+	{
+		found = true;
+	}
+
+	if ((password.length() > 0) && setPassword(password.c_str()))
+	{
+		found = true;
+	}
+
+	return found;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool settingsStore::commit(void)
+
+bool settingsStore::commit(void)
+{
+	return recordCommit(SETTINGS_FILE_PATH, SETTINGS_TEMP_PATH, &record, sizeof(record), SETTINGS_MAGIC, SETTINGS_VERSION);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void settingsStore::reset(void)
+//
+// build defaults, the stored record is kept until commit()
+
+void settingsStore::reset(void)
+{
+	memset(&record, 0, sizeof(record));
+
+	record.commMode = COMM_USB;
+	record.baudRate = CONFIG_BAUD_RATE;
+	record.tcpPort  = CONFIG_WIFI_PORT;
+#if !defined WIFI_CONFIGURE_SERVER
+	// with the configure server an empty SSID starts the access point
+	strlcpy(record.ssid, CONFIG_WIFI_SSID, sizeof(record.ssid));
+	strlcpy(record.password, CONFIG_WIFI_PASSWORD, sizeof(record.password));
+#endif
+	strlcpy(record.hostname, SETTINGS_DEFAULT_HOSTNAME, sizeof(record.hostname));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// getters
+
+uint8_t settingsStore::getCommMode(void)
+{
+	return record.commMode;
+}
+
+uint32_t settingsStore::getBaudRate(void)
+{
+	return record.baudRate;
+}
+
+uint16_t settingsStore::getTcpPort(void)
+{
+	return record.tcpPort;
+}
+
+const char *settingsStore::getSsid(void)
+{
+	return record.ssid;
+}
+
+const char *settingsStore::getPassword(void)
+{
+	return record.password;
+}
+
+const char *settingsStore::getHostname(void)
+{
+	return record.hostname;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// setters, return false on an invalid value and leave the setting as is
+
+bool settingsStore::setCommMode(uint8_t commMode)
+{
+	if ((commMode != COMM_USB) && (commMode != COMM_WIFI))
+	{
+		return false;
+	}
+
+	record.commMode = commMode;
+	return true;
+}
+
+bool settingsStore::setBaudRate(uint32_t baudRate)
+{
+	if ((baudRate < RPC_BAUD_RATE_MIN) || (baudRate > RPC_BAUD_RATE_MAX))
+	{
+		return false;
+	}
+
+	record.baudRate = baudRate;
+	return true;
+}
+
+bool settingsStore::setTcpPort(uint16_t tcpPort)
+{
+	if (tcpPort == 0)
+	{
+		return false;
+	}
+
+	record.tcpPort = tcpPort;
+	return true;
+}
+
+bool settingsStore::setSsid(const char *ssid)
+{
+	if ((ssid == nullptr) || (strlen(ssid) >= sizeof(record.ssid)))
+	{
+		return false;
+	}
+
+	strlcpy(record.ssid, ssid, sizeof(record.ssid));
+	return true;
+}
+
+bool settingsStore::setPassword(const char *password)
+{
+	if ((password == nullptr) || (strlen(password) >= sizeof(record.password)))
+	{
+		return false;
+	}
+
+	strlcpy(record.password, password, sizeof(record.password));
+	return true;
+}
+
+bool settingsStore::setHostname(const char *hostname)
+{
+	if ((hostname == nullptr) || (hostname[0] == '\0') || (strlen(hostname) >= sizeof(record.hostname)))
+	{
+		return false;
+	}
+
+	strlcpy(record.hostname, hostname, sizeof(record.hostname));
+	return true;
+}
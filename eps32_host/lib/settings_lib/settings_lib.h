@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SettingsLib.h
+//
+// device configuration (communication mode, WiFi credentials, baud rate,
+// TCP port) as a single versioned, CRC checked record in LittleFS, loaded
+// once at boot and read from RAM afterwards
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SETTINGSLIB_H
+#define SETTINGSLIB_H
+
+#include <Arduino.h>
+#include "rpc_config.h"
+#include "record_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define SETTINGS_FILE_PATH		"/settings.bin"
+#define SETTINGS_TEMP_PATH		"/settings.tmp"
+
+#define SETTINGS_MAGIC			0x47464E43		// "CNFG"
+#define SETTINGS_VERSION		1
+
+#define SETTINGS_SSID_LENGTH		33			// including the terminating 0
+#define SETTINGS_PASSWORD_LENGTH	65
+#define SETTINGS_HOSTNAME_LENGTH	32
+
+#define SETTINGS_DEFAULT_HOSTNAME	"ESP32_RPC_Server"
+
+// text files of earlier firmware, imported once when no record exists
+
+#define SETTINGS_LEGACY_MODE_PATH	"/comm_mode.txt"
+#define SETTINGS_LEGACY_SSID_PATH	"/ssid.txt"
+#define SETTINGS_LEGACY_PASS_PATH	"/pass.txt"
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	record_header_t header;
+	uint8_t  commMode;							// COMM_USB or COMM_WIFI
+	uint8_t  reserved;
+	uint16_t tcpPort;
+	uint32_t baudRate;
+	char     ssid[SETTINGS_SSID_LENGTH];
+	char     password[SETTINGS_PASSWORD_LENGTH];
+	char     hostname[SETTINGS_HOSTNAME_LENGTH];
+	uint32_t crc;								// CRC32 of all fields above, see record_lib
+} settings_record_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class settingsStore {
+public:
+	bool init(void);
+
+	uint8_t getCommMode(void);
+	uint32_t getBaudRate(void);
+	uint16_t getTcpPort(void);
+	const char *getSsid(void);
+	const char *getPassword(void);
+	const char *getHostname(void);
+
+	bool setCommMode(uint8_t commMode);
+	bool setBaudRate(uint32_t baudRate);
+	bool setTcpPort(uint16_t tcpPort);
+	bool setSsid(const char *ssid);
+	bool setPassword(const char *password);
+	bool setHostname(const char *hostname);
+
+	void reset(void);
+	bool commit(void);
+
+private:
+	bool load(void);
+	bool importLegacy(void);
+	String readLegacyFile(const char *path);
+
+	settings_record_t record;
+};
+
+#endif	// SETTINGSLIB_H
@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// ShadowLib.cpp
+//
+// The pin mode is kept in software, pinMode() rewrites the IO MUX and the
+// GPIO matrix and is the expensive part of a digitalWrite over RPC. Anything
+// else that reconfigures a pin (analogWrite, a pulse channel) has to
+// invalidate it. The level needs no software copy: the GPIO output latch is
+// the shadow and is read back, so it can not go stale.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "shadow_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::init(void)
+
+void outputShadow::init(void)
+{
+	invalidate();
+
+	memset(&gpioStats, 0, sizeof(gpioStats));
+	memset(&ledcStats, 0, sizeof(ledcStats));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::invalidate(void)
+//
+// the next write of every pin & channel goes to the hardware
+
+void outputShadow::invalidate(void)
+{
+	memset(gpioMode, SHADOW_MODE_UNKNOWN, sizeof(gpioMode));
+	memset(ledcValid, 0, sizeof(ledcValid));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::invalidatePin(uint8_t pin)
+
+void outputShadow::invalidatePin(uint8_t pin)
+{
+	if (pin < SHADOW_N_GPIO)
+	{
+		gpioMode[pin] = SHADOW_MODE_UNKNOWN;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::invalidateLedc(uint8_t channel)
+
+void outputShadow::invalidateLedc(uint8_t channel)
+{
+	if (channel < SHADOW_N_LEDC)
+	{
+		ledcValid[channel] = false;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::setMode(uint8_t pin, uint8_t mode, bool force)
+
+void outputShadow::setMode(uint8_t pin, uint8_t mode, bool force)
+{
+	if (!force && (pin < SHADOW_N_GPIO) && (gpioMode[pin] == mode))
+	{
+		gpioStats.hits++;
+		return;
+	}
+
+	pinMode(pin, mode);
+	gpioStats.misses++;
+
+	if (pin < SHADOW_N_GPIO)
+	{
+		gpioMode[pin] = mode;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::writeLevel(uint8_t pin, uint8_t level, bool force)
+
+void outputShadow::writeLevel(uint8_t pin, uint8_t level, bool force)
+{
+	uint32_t latch = 0;
+
+	if (!force && (pin < SHADOW_N_GPIO))
+	{
+		latch = (pin < 32) ? GPIO.out : GPIO.out1.val;
+
+		if (((latch & (1UL << (pin & 0x1F))) != 0) == (level != LOW))
+		{
+			gpioStats.hits++;
+			return;
+		}
+	}
+
+	digitalWrite(pin, level);
+	gpioStats.misses++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::writeDuty(uint8_t channel, uint32_t duty, bool force)
+
+void outputShadow::writeDuty(uint8_t channel, uint32_t duty, bool force)
+{
+	if (!force && (channel < SHADOW_N_LEDC) && ledcValid[channel] && (ledcDuty[channel] == duty))
+	{
+		ledcStats.hits++;
+		return;
+	}
+
+	ledcWrite(channel, duty);
+	ledcStats.misses++;
+
+	if (channel < SHADOW_N_LEDC)
+	{
+		ledcDuty[channel]  = duty;
+		ledcValid[channel] = true;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void outputShadow::getStats(shadow_stats_t *gpioStats, shadow_stats_t *ledcStats, bool reset)
+
+void outputShadow::getStats(shadow_stats_t *gpioStats, shadow_stats_t *ledcStats, bool reset)
+{
+	*gpioStats = this->gpioStats;
+	*ledcStats = this->ledcStats;
+
+	if (reset)
+	{
+		memset(&this->gpioStats, 0, sizeof(this->gpioStats));
+		memset(&this->ledcStats, 0, sizeof(this->ledcStats));
+	}
+}
@@ -0,0 +1,62 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// ShadowLib.h
+//
+// write cache for outputs the host tends to set again and again: a write
+// that would not change the hardware is counted as a hit and skipped. The
+// DAC and DIO drivers keep their own shadow (dac_4922_lib, dio_lib) and use
+// the counters defined here, outputShadow covers the GPIO pin modes & levels
+// and the LEDC duty cycles written over RPC.
+//
+// Every cached write takes a force flag that writes through and refreshes the
+// shadow, e.g. after the hardware was reset behind the cache's back.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SHADOWLIB_H
+#define SHADOWLIB_H
+
+#include <Arduino.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define SHADOW_N_GPIO			40			// GPIO0..39
+#define SHADOW_N_LEDC			16			// LEDC channels
+#define SHADOW_MODE_UNKNOWN		0xFF		// not a pinMode() mode
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint32_t hits;						// writes skipped, hardware already there
+	uint32_t misses;					// writes done
+} shadow_stats_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class outputShadow {
+public:
+	void init(void);
+	void invalidate(void);
+	void invalidatePin(uint8_t pin);
+	void invalidateLedc(uint8_t channel);
+
+	void setMode(uint8_t pin, uint8_t mode, bool force = false);
+	void writeLevel(uint8_t pin, uint8_t level, bool force = false);
+	void writeDuty(uint8_t channel, uint32_t duty, bool force = false);
+
+	void getStats(shadow_stats_t *gpioStats, shadow_stats_t *ledcStats, bool reset);
+
+private:
+	uint8_t  gpioMode[SHADOW_N_GPIO];
+	uint32_t ledcDuty[SHADOW_N_LEDC];
+	bool     ledcValid[SHADOW_N_LEDC];
+
+	shadow_stats_t gpioStats;
+	shadow_stats_t ledcStats;
+};
+
+#endif	// SHADOWLIB_H
@@ -11,12 +11,13 @@
 // system #includes
 
 #include <Arduino.h>
-#include <spi.h>
+#include <SPI.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // application #includes
 
 #include "spi_lib.h"
+#include "trace_lib.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -135,6 +136,11 @@ void spi::selectDevice(uint8_t spiDeviceNumber)
 			}
 			digitalWrite(gpioPinNumber, bitValue);
 		}
+
+		if (spiDeviceNumber != SPI_DEVICE_UNUSED)
+		{
+			TRACE_EVENT(TRACE_SPI_BEGIN, spiDeviceNumber);
+		}
 	}
 }
 
@@ -144,4 +150,5 @@ void spi::selectDevice(uint8_t spiDeviceNumber)
 void spi::deselectDevice(void)
 {
 	selectDevice(SPI_DEVICE_UNUSED);
+	TRACE_EVENT(TRACE_SPI_END, 0);
 }
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// TraceLib.cpp
+//
+// A record costs a spinlock and four stores, so events can be emitted from
+// tasks and ISRs on both cores. The ring overwrites the oldest records, a
+// dump always holds the most recent TRACE_BUFFER_SIZE events.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "trace_lib.h"
+
+#if defined INCLUDE_TRACE
+
+///////////////////////////////////////////////////////////////////////////////
+// trace ring, head counts all records written since the last clear
+
+static trace_record_t    traceBuffer[TRACE_BUFFER_SIZE];
+static volatile uint32_t traceHead = 0;
+static volatile bool     traceRunning = false;
+static portMUX_TYPE      traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+///////////////////////////////////////////////////////////////////////////////
+// void IRAM_ATTR traceEvent(uint8_t event, uint16_t arg)
+
+void IRAM_ATTR traceEvent(uint8_t event, uint16_t arg)
+{
+	trace_record_t *record = nullptr;
+
+	if (!traceRunning)
+	{
+		return;
+	}
+
+	portENTER_CRITICAL_SAFE(&traceMux);
+	record = &traceBuffer[traceHead & TRACE_BUFFER_MASK];
+	record->cycles = xthal_get_ccount();
+	record->event  = event;
+	record->core   = (uint8_t)xPortGetCoreID();
+	record->arg    = arg;
+	traceHead = traceHead + 1;
+	portEXIT_CRITICAL_SAFE(&traceMux);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint16_t traceHash(const char *text)
+//
+// FNV-1a folded to 16 bits, the host hashes the known method names the same
+// way to label the RPC events
+
+uint16_t traceHash(const char *text)
+{
+	uint32_t hash = 2166136261UL;
+
+	while ((text != nullptr) && (*text != '\0'))
+	{
+		hash ^= (uint8_t)*text++;
+		hash *= 16777619UL;
+	}
+
+	return (uint16_t)((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void traceStart(bool clear)
+
+void traceStart(bool clear)
+{
+	if (clear)
+	{
+		portENTER_CRITICAL(&traceMux);
+		traceHead = 0;
+		portEXIT_CRITICAL(&traceMux);
+	}
+
+	traceRunning = true;
+	traceEvent(TRACE_MARK, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void traceStop(void)
+
+void traceStop(void)
+{
+	traceRunning = false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool traceIsRunning(void)
+
+bool traceIsRunning(void)
+{
+	return traceRunning;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t traceTotal(void)
+//
+// records written since the last clear, including the overwritten ones
+
+uint32_t traceTotal(void)
+{
+	return traceHead;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t traceAvailable(void)
+
+uint32_t traceAvailable(void)
+{
+	uint32_t head = traceHead;
+
+	return (head < TRACE_BUFFER_SIZE) ? head : TRACE_BUFFER_SIZE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// uint32_t traceRead(uint32_t first, trace_record_t records[], uint32_t maxRecords)
+//
+// first = 0 is the oldest record still in the ring, returns the number of
+// records copied. Stop the trace first for a consistent dump.
+
+uint32_t traceRead(uint32_t first, trace_record_t records[], uint32_t maxRecords)
+{
+	uint32_t count = 0;
+	uint32_t head = traceHead;
+	uint32_t available = (head < TRACE_BUFFER_SIZE) ? head : TRACE_BUFFER_SIZE;
+	uint32_t oldest = head - available;
+
+	if (first >= available)
+	{
+		return 0;
+	}
+
+	portENTER_CRITICAL(&traceMux);
+	while ((first + count < available) && (count < maxRecords))
+	{
+		records[count] = traceBuffer[(oldest + first + count) & TRACE_BUFFER_MASK];
+		count++;
+	}
+	portEXIT_CRITICAL(&traceMux);
+
+	return count;
+}
+
+#endif
@@ -0,0 +1,76 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// TraceLib.h
+//
+// low overhead event tracer: compact records with a CPU cycle count timestamp
+// in a fixed RAM ring, dumped over RPC and converted to a Chrome / Perfetto
+// trace on the host (python_client/library/trace_converter.py)
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TRACELIB_H
+#define TRACELIB_H
+
+#include <Arduino.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define TRACE_BUFFER_SIZE	1024	// records, power of 2 (8 kB)
+#define TRACE_BUFFER_MASK	(TRACE_BUFFER_SIZE - 1)
+
+// event id's, the meaning of arg is given per event. Keep in sync with
+// TRACE_EVENTS in trace_converter.py
+
+#define TRACE_MARK			0		// arg: user value, written by traceStart()
+#define TRACE_RPC_BEGIN		1		// arg: traceHash() of the method name
+#define TRACE_RPC_END		2		// arg: RPC result code
+#define TRACE_PULSE_EDGE	3		// arg: pin | (level << 8)
+#define TRACE_PULSE_HALT	4		// arg: pin
+#define TRACE_SPI_BEGIN		5		// arg: selected SPI device
+#define TRACE_SPI_END		6		// arg: 0
+#define TRACE_WIFI_CONNECT	7		// arg: 0
+#define TRACE_WIFI_RX		8		// arg: request length
+#define TRACE_WIFI_TX		9		// arg: response length
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint32_t cycles;				// CCOUNT of the emitting core, wraps every 2^32 cycles
+	uint8_t  event;					// TRACE_xxx
+	uint8_t  core;					// emitting core
+	uint16_t arg;
+} trace_record_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+#if defined INCLUDE_TRACE
+
+void IRAM_ATTR traceEvent(uint8_t event, uint16_t arg);
+uint16_t traceHash(const char *text);
+
+void traceStart(bool clear);
+void traceStop(void);
+bool traceIsRunning(void);
+
+uint32_t traceTotal(void);
+uint32_t traceAvailable(void);
+uint32_t traceRead(uint32_t first, trace_record_t records[], uint32_t maxRecords);
+
+#define TRACE_EVENT(event, arg)	traceEvent((event), (uint16_t)(arg))
+
+#else
+
+#define TRACE_EVENT(event, arg)
+
+#endif
+
+#endif	// TRACELIB_H
@@ -1,4 +1,7 @@
 #include "usb_wifi_switch.h"
+#include "settings_lib.h"
+
+extern settingsStore settings;
 
 
 #if defined (INCLUDE_OLED_DISPLAY)
@@ -23,33 +26,32 @@ extern oledDisplay  oled_Display;
 #endif
 
 
+// The mode is part of the settings record, loaded once at boot
 bool check_wifi_mode(){
-    bool result = false;
-    result = LittleFS.begin(true);
+    bool result = (settings.getCommMode() == COMM_WIFI);
 
-    if (!result) {
-        DEBUG_PRINT("No file system found assuming USB mode\n");
-        return false;
-    }
- 
-    String mode = readFile(LittleFS, "/comm_mode.txt");
-    if(mode == "WIFI"){
+    if(result){
         DEBUG_PRINT("WiFi mode detected\n");
-        result = true;
     }
     else{
         DEBUG_PRINT("USB mode detected\n");
-        result = false;
     }
-    LittleFS.end();
     return result;
-
 }
 
 
 void toggle_usb_wifi_mode(){
     bool result = false;
-    result = LittleFS.begin(true);
+
+    if(settings.getCommMode() == COMM_WIFI){
+        DEBUG_PRINT("Switching to USB mode\n");
+        settings.setCommMode(COMM_USB);
+    }
+    else{
+        DEBUG_PRINT("Switching to WiFi mode\n");
+        settings.setCommMode(COMM_WIFI);
+    }
+    result = settings.commit();
 
     if (!result) {
         DEBUG_PRINT("No file system install with platformIO\n");
@@ -59,33 +61,17 @@ void toggle_usb_wifi_mode(){
         oled_Display.writeLine(1, "found",  ALIGN_CENTER);
         oled_Display.writeLine(2, "Install",  		ALIGN_CENTER);
         oled_Display.writeLine(3, "Through PlatformIO",  		ALIGN_CENTER);
+        oled_Display.flush();
         delay(2000);
 #endif
     }
-    String mode = readFile(LittleFS, "/comm_mode.txt");
-    if(mode == "WIFI"){
-        DEBUG_PRINT("Switching to USB mode\n");
-        writeFile(LittleFS, "/comm_mode.txt", "USB");
 #if defined (INCLUDE_OLED_DISPLAY)
-        oled_Display.clear();
-        oled_Display.writeLine(0, "Communication", ALIGN_CENTER);
-        oled_Display.writeLine(1, "mode",  ALIGN_CENTER);
-        oled_Display.writeLine(2, "changed to",  ALIGN_CENTER);
-        oled_Display.writeLine(3, "USB",  		ALIGN_CENTER);
-        delay(2000);
-#endif    
-    }
-    else{
-        DEBUG_PRINT("Switching to WiFi mode\n");
-        writeFile(LittleFS, "/comm_mode.txt", "WIFI");
-#if defined (INCLUDE_OLED_DISPLAY)
-        oled_Display.clear();
-        oled_Display.writeLine(0, "Communication", ALIGN_CENTER);
-        oled_Display.writeLine(1, "mode",  ALIGN_CENTER);
-        oled_Display.writeLine(2, "changed to",  ALIGN_CENTER);
-        oled_Display.writeLine(3, "WIFI",  		ALIGN_CENTER);
-        delay(2000);
-#endif    
-    }
-    LittleFS.end(); 
+    oled_Display.clear();
+    oled_Display.writeLine(0, "Communication", ALIGN_CENTER);
+    oled_Display.writeLine(1, "mode",  ALIGN_CENTER);
+    oled_Display.writeLine(2, "changed to",  ALIGN_CENTER);
+    oled_Display.writeLine(3, (settings.getCommMode() == COMM_WIFI) ? "WIFI" : "USB",  		ALIGN_CENTER);
+    oled_Display.flush();
+    delay(2000);
+#endif
 }
\ No newline at end of file
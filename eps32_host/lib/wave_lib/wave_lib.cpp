@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// WaveLib.cpp
+//
+// The hardware timer only wakes the sample task, the SPI driver can not be
+// used from an ISR. The task collects the next precomputed DAC code of every
+// running channel, advances its phase accumulator and writes all codes in one
+// SPI transaction, with LDAC* wired the outputs change at the same instant.
+//
+// A new waveform is built in the inactive half of the channel's table and is
+// swapped in by the sample task between two samples, so a running output can
+// be retuned without a glitch or a phase jump.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// application specific includes
+
+#include "wave_lib.h"
+
+dacWaveform *dacWaveform::instance = nullptr;
+
+///////////////////////////////////////////////////////////////////////////////
+// void dacWaveform::init(dac4922 *dac)
+
+void dacWaveform::init(dac4922 *dac)
+{
+	this->dac = dac;
+	instance = this;
+
+	memset(channels, 0, sizeof(channels));
+	memset(userTable, 0, sizeof(userTable));
+
+	xTaskCreatePinnedToCore(sampleTask, "dacWaveform", RTOS_DEFAULT_STACKSIZE, this,
+							WAVE_TASK_PRIORITY, &taskHandle, CORE_1);
+
+	timer = timerBegin(WAVE_TIMER_NUMBER, WAVE_TIMER_DIVIDER, true);
+	timerAttachInterrupt(timer, &onTimer, true);
+	timerAlarmWrite(timer, 1000000UL / WAVE_TIMER_HZ, true);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void IRAM_ATTR dacWaveform::onTimer(void)
+
+void IRAM_ATTR dacWaveform::onTimer(void)
+{
+	BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+	vTaskNotifyGiveFromISR(instance->taskHandle, &higherPriorityTaskWoken);
+	portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dacWaveform::sampleTask(void *parameter)
+
+void dacWaveform::sampleTask(void *parameter)
+{
+	dacWaveform *waveform = (dacWaveform *)parameter;
+
+	while (true)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		waveform->outputSamples();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dacWaveform::outputSamples(void)
+
+void dacWaveform::outputSamples(void)
+{
+	uint8_t  channel = 0;
+	uint8_t  channelMask = 0;
+	uint16_t dacValues[N_DAC_CHANNELS];
+
+	for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+	{
+		wave_channel_t *wave = &channels[channel];
+
+		portENTER_CRITICAL(&mux);
+
+		if (wave->pending)
+		{
+			// same position within the period in the new table
+			wave->phase          = (uint32_t)(((uint64_t)wave->phase * wave->pendingLength) / wave->length);
+			wave->activeTable   ^= 1;
+			wave->length         = wave->pendingLength;
+			wave->phaseIncrement = wave->pendingIncrement;
+			wave->pending        = false;
+		}
+
+		if (wave->running)
+		{
+			dacValues[channel] = wave->table[wave->activeTable][wave->phase >> WAVE_PHASE_SHIFT];
+			channelMask |= (1 << channel);
+
+			wave->phase += wave->phaseIncrement;
+			while (wave->phase >= ((uint32_t)wave->length << WAVE_PHASE_SHIFT))
+			{
+				wave->phase -= ((uint32_t)wave->length << WAVE_PHASE_SHIFT);
+			}
+		}
+
+		portEXIT_CRITICAL(&mux);
+	}
+
+	if (channelMask != 0)
+	{
+		dac->writeChannels(dacValues, channelMask);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// void dacWaveform::updateTimer(void)
+//
+// the sample clock only runs while at least one channel is playing
+
+void dacWaveform::updateTimer(void)
+{
+	uint8_t channel = 0;
+	bool anyRunning = false;
+
+	for (channel = 0; channel < N_DAC_CHANNELS; channel++)
+	{
+		anyRunning = anyRunning || channels[channel].running;
+	}
+
+	if (anyRunning)
+	{
+		timerAlarmEnable(timer);
+	}
+	else
+	{
+		timerAlarmDisable(timer);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool dacWaveform::uploadTable(uint8_t channel, uint16_t startIndex,
+//								 const float points[], uint16_t numPoints)
+//
+// points are normalised to -1.0 .. +1.0, scaled by amplitude & offset in
+// configure(). Large tables are uploaded in several chunks.
+
+bool dacWaveform::uploadTable(uint8_t channel, uint16_t startIndex, const float points[], uint16_t numPoints)
+{
+	uint16_t ix = 0;
+	float point = 0.0;
+
+	if ((channel >= N_DAC_CHANNELS) || (startIndex + numPoints > WAVE_TABLE_SIZE))
+	{
+		return false;
+	}
+
+	for (ix = 0; ix < numPoints; ix++)
+	{
+		point = constrain(points[ix], -1.0f, 1.0f);
+		userTable[channel][startIndex + ix] = (int16_t)lroundf(point * INT16_MAX);
+	}
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool dacWaveform::configure(uint8_t channel, wave_shape_t shape, float amplitude,
+//							   float offset, uint32_t sampleRate, uint16_t length)
+//
+// Vout = offset + amplitude * shape, shape running from -1.0 .. +1.0
+// sampleRate is in table points per second, frequency = sampleRate / length
+
+bool dacWaveform::configure(uint8_t channel, wave_shape_t shape, float amplitude, float offset,
+							uint32_t sampleRate, uint16_t length)
+{
+	uint16_t ix = 0;
+	uint8_t  target = 0;
+	uint32_t phaseIncrement = 0;
+	float    point = 0.0;
+
+	if ((channel >= N_DAC_CHANNELS) || (shape > WAVE_SHAPE_TABLE) ||
+		(sampleRate == 0) || (sampleRate > WAVE_TIMER_HZ) ||
+		(length < 2) || (length > WAVE_TABLE_SIZE))
+	{
+		return false;
+	}
+
+	wave_channel_t *wave = &channels[channel];
+
+	// claim the inactive half, the sample task does not read it
+	portENTER_CRITICAL(&mux);
+	wave->pending = false;
+	target = wave->activeTable ^ 1;
+	portEXIT_CRITICAL(&mux);
+
+	for (ix = 0; ix < length; ix++)
+	{
+		switch (shape)
+		{
+			case WAVE_SHAPE_SINE:
+			point = sinf((2.0f * (float)M_PI * ix) / length);
+			break;
+
+			case WAVE_SHAPE_TRIANGLE:
+			point = (ix < length / 2) ? (-1.0f + (4.0f * ix) / length) : (3.0f - (4.0f * ix) / length);
+			break;
+
+			case WAVE_SHAPE_RAMP:
+			point = -1.0f + (2.0f * ix) / length;
+			break;
+
+			case WAVE_SHAPE_TABLE:
+			point = (float)userTable[channel][ix] / INT16_MAX;
+			break;
+		}
+
+		wave->table[target][ix] = dac->voltageToValue(channel, offset + amplitude * point);
+	}
+
+	phaseIncrement = (uint32_t)(((uint64_t)sampleRate << WAVE_PHASE_SHIFT) / WAVE_TIMER_HZ);
+
+	portENTER_CRITICAL(&mux);
+	if (wave->running)
+	{
+		wave->pendingLength    = length;
+		wave->pendingIncrement = phaseIncrement;
+		wave->pending          = true;
+	}
+	else
+	{
+		wave->activeTable    = target;
+		wave->length         = length;
+		wave->phaseIncrement = phaseIncrement;
+		wave->phase          = 0;
+	}
+	portEXIT_CRITICAL(&mux);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool dacWaveform::start(uint8_t channel)
+
+bool dacWaveform::start(uint8_t channel)
+{
+	if ((channel >= N_DAC_CHANNELS) || (channels[channel].length == 0))
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	channels[channel].phase   = 0;
+	channels[channel].running = true;
+	portEXIT_CRITICAL(&mux);
+
+	updateTimer();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool dacWaveform::stop(uint8_t channel)
+//
+// the output keeps the last written value
+
+bool dacWaveform::stop(uint8_t channel)
+{
+	if (channel >= N_DAC_CHANNELS)
+	{
+		return false;
+	}
+
+	portENTER_CRITICAL(&mux);
+	channels[channel].running = false;
+	portEXIT_CRITICAL(&mux);
+
+	updateTimer();
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// bool dacWaveform::isRunning(uint8_t channel)
+
+bool dacWaveform::isRunning(uint8_t channel)
+{
+	return (channel < N_DAC_CHANNELS) && channels[channel].running;
+}
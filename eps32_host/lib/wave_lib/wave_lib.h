@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// WaveLib.h
+//
+// waveform generator for the MCP4922 DAC outputs: sine, triangle, ramp or an
+// uploaded table per channel, played from a hardware timer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef WAVELIB_H
+#define WAVELIB_H
+
+#include <Arduino.h>
+#include "../config.h"
+#include "dac_4922_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define WAVE_TABLE_SIZE		256			// max. points per waveform table
+#define WAVE_TIMER_HZ		5000		// output update rate, max. sample rate per channel
+#define WAVE_TIMER_NUMBER	0			// hardware timer used for the sample clock
+#define WAVE_TIMER_DIVIDER	80			// 80 MHz APB clock / 80 = 1 us timer ticks
+
+#define WAVE_TASK_PRIORITY	(configMAX_PRIORITIES - 2)
+
+// phase accumulator: 16.16 fixed point index into the table
+
+#define WAVE_PHASE_SHIFT	16
+
+///////////////////////////////////////////////////////////////////////////////
+// enum's
+
+typedef enum
+{
+	WAVE_SHAPE_SINE,
+	WAVE_SHAPE_TRIANGLE,
+	WAVE_SHAPE_RAMP,
+	WAVE_SHAPE_TABLE,		// uploaded with uploadTable()
+} wave_shape_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// structs
+
+typedef struct
+{
+	uint16_t table[2][WAVE_TABLE_SIZE];	// precomputed DAC codes, double buffered
+	uint8_t  activeTable;				// table the sample task plays from
+	uint16_t length;					// points in the active table
+	uint32_t phase;						// 16.16 index in the active table
+	uint32_t phaseIncrement;			// 16.16 points per timer tick
+	bool     running;
+
+	bool     pending;					// new table/increment waiting for the next sample
+	uint16_t pendingLength;
+	uint32_t pendingIncrement;
+} wave_channel_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// function prototypes
+
+class dacWaveform {
+public:
+	void init(dac4922 *dac);
+
+	bool uploadTable(uint8_t channel, uint16_t startIndex, const float points[], uint16_t numPoints);
+	bool configure(uint8_t channel, wave_shape_t shape, float amplitude, float offset,
+				   uint32_t sampleRate, uint16_t length = WAVE_TABLE_SIZE);
+	bool start(uint8_t channel);
+	bool stop(uint8_t channel);
+	bool isRunning(uint8_t channel);
+
+private:
+	static void IRAM_ATTR onTimer(void);
+	static void sampleTask(void *parameter);
+	void outputSamples(void);
+	void updateTimer(void);
+
+	dac4922 *dac;
+	hw_timer_t *timer = nullptr;
+	TaskHandle_t taskHandle = nullptr;
+	portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+	wave_channel_t channels[N_DAC_CHANNELS];
+	int16_t  userTable[N_DAC_CHANNELS][WAVE_TABLE_SIZE];	// uploaded points, Q15 (-1.0 .. +1.0)
+
+	static dacWaveform *instance;
+};
+
+#endif	// WAVELIB_H
@@ -18,38 +18,187 @@ spi spi_bus;
 dac4922 dac;
 #endif
 
+#if defined INCLUDE_DAC_WAVE_LIB
+#include "wave_lib.h"
+dacWaveform dac_waveform;
+#endif
+
 #if defined INCLUDE_ADC_3208_LIB
 #include "adc_3208_lib.h"
 adc3208 adc;
 #endif
 
+#if defined INCLUDE_ADC_SAMPLER
+#include "sampler_lib.h"
+adcSampler adc_sampler;
+#endif
+
 #if defined INCLUDE_DIO_LIB
 #include "dio_lib.h"
 dio digital_io;
 #endif
 
+#if defined INCLUDE_ADC_CAPTURE
+#include "capture_lib.h"
+adcCapture adc_capture;
+#endif
+
 #if defined INCLUDE_QC_7366_LIB
 #include "qc_7366_lib.h"
 qc7366 qc;
 #endif
 
+#if defined INCLUDE_INPUT_EVENTS
+#include "event_lib.h"
+inputEvents input_events;
+#endif
+
+#if defined INCLUDE_CALIBRATION_STORE
+#include "calib_lib.h"
+calibrationStore calibration;
+#endif
+
+#include "boot_lib.h"
+bootProfile boot_profile;
+
+#include "settings_lib.h"
+settingsStore settings;
+
 RpcServer rpc_server;
 
 #if defined INCLUDE_OLED_DISPLAY
 oledDisplay  oled_Display;
 #endif
 
+// loop() iterations, shown as loop frequency on the OLED dashboard
+static volatile uint32_t loop_count = 0;
+
+#if defined INCLUDE_QC_7366_LIB
+static uint32_t last_qc_poll_ms = 0;
+#endif
+
+#if defined INCLUDE_OLED_DISPLAY
+// Runs in the dashboard task on core 0: reads only counters the loop task
+// publishes, nothing that touches the WiFi client or the handler state
+void dashboard_source(oled_dashboard_t *values) {
+  rpc_metrics_t metrics;
+
+  rpc_server.getMetrics(&metrics, true);
+  values->rpcCalls = metrics.calls;
+  values->rpcHandlerUs = metrics.handlerUs;
+  values->rpcHandlerMaxUs = metrics.handlerMaxUs;
+  values->loopCount = loop_count;
+  values->freeHeap = ESP.getFreeHeap();
+  values->activePulses = rpc_server.getActivePulseChannels();
+  values->clients = rpc_server.getClientCount();
+}
+#endif
+
 
 //#define WIFI_CONFIGURE_BUTTON_PIN 5  // GPIO pin for forcing WiFi configuration mode
 #define COMM_MODE_BUTTON_PIN 4     // GPIO pin for toggling communication mode
 
+#define WIFI_CONNECT_TIMEOUT_MS 10000
+#define WIFI_CONNECT_POLL_MS 50
+
 bool wifi_mode = false;
+bool force_network_configure = false;
+
+// WiFi association runs in its own task, so setup() does not wait for the
+// access point and the peripherals are initialised in the meantime
+void wifi_connect_task(void *parameter) {
+  uint8_t stage = boot_profile.begin("wifi");
+
+#if RPC_SERIAL_LOGS
+  Serial.println("Connecting to WiFi...");
+#endif
+#if defined INCLUDE_OLED_DISPLAY
+  oled_Display.clear();
+  oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
+  oled_Display.writeLine(1, "Connecting to ",  ALIGN_CENTER);
+  oled_Display.writeLine(2, "WiFi...",  		ALIGN_CENTER);
+  oled_Display.flush();
+#endif
+  WiFi.setHostname(settings.getHostname());
+#if defined WIFI_CONFIGURE_SERVER
+  NETWORK_CONFIG network_config;
 
+  if (!configureNetwork(force_network_configure, &network_config)) {
+  #if RPC_SERIAL_LOGS
+    Serial.println("Failed to configure network");
+  #endif
+#if defined INCLUDE_OLED_DISPLAY
+    oled_Display.clear();
+    oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
+    oled_Display.writeLine(1, "Failed to",  ALIGN_CENTER);
+    oled_Display.writeLine(2, "configure network",  	ALIGN_CENTER);
+    oled_Display.writeLine(3, "Restarting...",  	ALIGN_CENTER);
+    oled_Display.flush();
+#endif
+    delay(3000);
+    ESP.restart();
+  }
+  // configureNetwork() has already connected the station
+  if (WiFi.status() != WL_CONNECTED) {
+    WiFi.begin(network_config.ssid.c_str(), network_config.password.c_str());
+  }
+#else
+  WiFi.begin(settings.getSsid(), settings.getPassword());
+#endif
+
+  uint32_t start_ms = millis();
+  while (WiFi.status() != WL_CONNECTED && millis() - start_ms < WIFI_CONNECT_TIMEOUT_MS) {
+    delay(WIFI_CONNECT_POLL_MS);
+  }
+
+  if (WiFi.status() == WL_CONNECTED) {
+  #if RPC_SERIAL_LOGS
+    Serial.println("\nWiFi connected!");
+    Serial.print("IP address: ");
+    Serial.println(WiFi.localIP());
+    Serial.printf("Listening on port %d\n", settings.getTcpPort());
+  #endif
+#if defined INCLUDE_OLED_DISPLAY
+    char text_buffer[32];
+    oled_Display.clear();
+    oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
+    oled_Display.writeLine(1, "Server Ready",  ALIGN_CENTER);
+    oled_Display.writeLine(2, "WiFi Connection",  		ALIGN_CENTER);
+    snprintf(text_buffer, sizeof(text_buffer), "IP: %s", WiFi.localIP().toString().c_str());
+    oled_Display.writeLine(3, text_buffer,  ALIGN_CENTER);
+    oled_Display.flush();
+#endif
+  } else {
+  #if RPC_SERIAL_LOGS
+    Serial.println("\nWiFi connection failed!");
+  #endif
+#if defined INCLUDE_OLED_DISPLAY
+    oled_Display.clear();
+    oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
+    oled_Display.writeLine(1, "WiFi",  ALIGN_CENTER);
+    oled_Display.writeLine(2, "connection failed",  	ALIGN_CENTER);
+    oled_Display.writeLine(3, "Restarting...",  	ALIGN_CENTER);
+    oled_Display.flush();
+#endif
+    delay(3000);
+    ESP.restart();
+  }
+#if RPC_SERIAL_LOGS
+  Serial.println("RPC Server ready. Waiting for commands...");
+#endif
+
+  boot_profile.end(stage);
+  vTaskDelete(NULL);
+}
+
+// Staged boot, every stage is timed in boot_profile (bootProfile RPC)
 void setup() {
+  uint8_t stage;
+
   Serial.begin(115200);
-  delay(1000);
 
 #if defined INCLUDE_OLED_DISPLAY
+  stage = boot_profile.begin("oled");
   bool oledOK  = oled_Display.init();
   if(!oledOK) {
 #if RPC_SERIAL_LOGS
@@ -61,9 +210,33 @@ void setup() {
 	oled_Display.writeLine(1, "Server",  ALIGN_CENTER);
 	oled_Display.writeLine(2, "V0.6",  		ALIGN_CENTER);
 	oled_Display.writeLine(3, "Server Starting...",  		ALIGN_CENTER);
-  delay(2000);
+  oled_Display.flush();
+  boot_profile.end(stage);
 #endif  
 
+#if RPC_SERIAL_LOGS
+  Serial.println("\n\nESP32 RPC Server Starting...");
+#endif
+
+  // LittleFS is mounted here once and stays mounted, the settings are read
+  // once into RAM
+  stage = boot_profile.begin("filesystem");
+  settings.init();
+  wifi_mode = check_wifi_mode();
+  //pinMode(WIFI_CONFIGURE_BUTTON_PIN, INPUT_PULLUP);
+  pinMode(COMM_MODE_BUTTON_PIN, INPUT_PULLUP);
+
+  // Check if communication mode toggle button is pressed
+  if (digitalRead(COMM_MODE_BUTTON_PIN) == LOW) {
+#if RPC_SERIAL_LOGS
+    Serial.println("Communication mode toggle button pressed. Toggling mode.");
+#endif
+    toggle_usb_wifi_mode();
+    wifi_mode = check_wifi_mode();
+  }
+  boot_profile.end(stage);
+
+  stage = boot_profile.begin("spi");
 #if defined INCLUDE_DAC_4922_LIB || defined INCLUDE_ADC_3208_LIB
   spi_bus.init();
 #endif
@@ -75,140 +248,86 @@ void setup() {
 #if defined INCLUDE_ADC_3208_LIB
   adc.init(&spi_bus);
 #endif
+  boot_profile.end(stage);
+
+  // Start WiFi as early as possible, it needs the ADC for the configure button
+  if (wifi_mode) {
+#if defined INCLUDE_ADC_3208_LIB
+    force_network_configure = adc.isButtonPressed(1);  // Check if button 1 is pressed to force network configuration mode
+#endif
+    xTaskCreatePinnedToCore(wifi_connect_task, "wifiConnect", 2 * RTOS_DEFAULT_STACKSIZE, NULL,
+                            1, NULL, CORE_0);
+  }
+
+#if defined INCLUDE_CALIBRATION_STORE
+  stage = boot_profile.begin("calibration");
+#if defined INCLUDE_ADC_3208_LIB
+  calibration.attach(&adc);
+#endif
+#if defined INCLUDE_DAC_4922_LIB
+  calibration.attach(&dac);
+#endif
+  calibration.init();
+  boot_profile.end(stage);
+#endif
+
+  stage = boot_profile.begin("peripherals");
+#if defined INCLUDE_DAC_WAVE_LIB
+  dac_waveform.init(&dac);
+#endif
+
+#if defined INCLUDE_ADC_SAMPLER
+  adc_sampler.init(&adc);
+#endif
 
 #if defined INCLUDE_DIO_LIB
   digital_io.init();
 #endif
 
-#if defined INCLUDE_QC_7366_LIB
-  qc.init(&spi_bus);
+#if defined INCLUDE_ADC_CAPTURE
+#if defined INCLUDE_DIO_LIB
+  adc_capture.init(&adc, &digital_io);
+#else
+  adc_capture.init(&adc);
+#endif
 #endif
 
-#if RPC_SERIAL_LOGS
-  Serial.println("\n\nESP32 RPC Server Starting...");
+#if defined INCLUDE_INPUT_EVENTS
+  input_events.init();
 #endif
-  wifi_mode = check_wifi_mode();
-  //pinMode(WIFI_CONFIGURE_BUTTON_PIN, INPUT_PULLUP);
-  pinMode(COMM_MODE_BUTTON_PIN, INPUT_PULLUP);
 
-  // Check if communication mode toggle button is pressed
-  if (digitalRead(COMM_MODE_BUTTON_PIN) == LOW) {
-#if RPC_SERIAL_LOGS
-    Serial.println("Communication mode toggle button pressed. Toggling mode.");
+#if defined INCLUDE_QC_7366_LIB
+  qc.init(&spi_bus);
 #endif
-    toggle_usb_wifi_mode();
-    wifi_mode = check_wifi_mode();
-  }
+  boot_profile.end(stage);
 
-  // Initialize RPC server
+  // Initialize RPC server, the TCP server is started by handle_wifi() once
+  // the WiFi task has connected
+  stage = boot_profile.begin("rpc");
   rpc_server.begin();
-  
-  // Initialize WiFi if enabled
-  if (wifi_mode) {
-#if RPC_SERIAL_LOGS
-    Serial.println("Connecting to WiFi...");
-#endif
+  boot_profile.end(stage);
+
 #if defined INCLUDE_OLED_DISPLAY
+  if (!wifi_mode) {
     oled_Display.clear();
     oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
-    oled_Display.writeLine(1, "Connecting to ",  ALIGN_CENTER);
-    oled_Display.writeLine(2, "WiFi...",  		ALIGN_CENTER);
-#endif
-    WiFi.setHostname("ESP32_RPC_Server");
-#if defined WIFI_CONFIGURE_SERVER
-    NETWORK_CONFIG network_config;
+    oled_Display.writeLine(1, "Server Ready",  ALIGN_CENTER);
+    oled_Display.writeLine(3, "USB Connection",  		ALIGN_CENTER);
+    oled_Display.flush();
+  }
 
-#if defined INCLUDE_DAC_4922_LIB
-    bool force_network_configure = adc.isButtonPressed(1);  // Check if button 1 is pressed to force network configuration mode
-#else
-    bool force_network_configure = false;  // No ADC button available, do not force
+  oled_Display.setDashboardSource(dashboard_source);
+#if defined OLED_DASHBOARD_AT_BOOT
+  oled_Display.startDashboard(OLED_DASHBOARD_PERIOD_MS);
 #endif
-
-    if (!configureNetwork(force_network_configure, &network_config)) {
-    #if RPC_SERIAL_LOGS
-      Serial.println("Failed to configure network");
-    #endif
-#if defined INCLUDE_OLED_DISPLAY
-      oled_Display.clear();
-      oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
-      oled_Display.writeLine(1, "Failed to",  ALIGN_CENTER);
-      oled_Display.writeLine(2, "configure network",  	ALIGN_CENTER);
-      oled_Display.writeLine(3, "Restarting...",  	ALIGN_CENTER);
-#endif
-      delay(3000);
-      ESP.restart();
-    }
-    WiFi.begin(network_config.ssid.c_str(), network_config.password.c_str());
-#else
-    
-      WiFi.begin(CONFIG_WIFI_SSID, CONFIG_WIFI_PASSWORD);
-#endif
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-      delay(500);
-    #if RPC_SERIAL_LOGS
-      Serial.print(".");
-    #endif
-      attempts++;
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-    #if RPC_SERIAL_LOGS
-      Serial.println("\nWiFi connected!");
-      Serial.print("IP address: ");
-      Serial.println(WiFi.localIP());
-      Serial.printf("Listening on port %d\n", CONFIG_WIFI_PORT);
-    #endif
-#if defined INCLUDE_OLED_DISPLAY
-      char text_buffer[32];
-      oled_Display.clear();
-      oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
-      oled_Display.writeLine(1, "WiFi connected",  ALIGN_CENTER);
-      snprintf(text_buffer, sizeof(text_buffer), "IP: %s", WiFi.localIP().toString().c_str());
-      oled_Display.writeLine(2, text_buffer,  ALIGN_CENTER);
-      snprintf(text_buffer, sizeof(text_buffer), "Port: %d", CONFIG_WIFI_PORT);
-      oled_Display.writeLine(3, text_buffer,  ALIGN_CENTER);
-      delay(3000);
-#endif
-
-    } else {
-    #if RPC_SERIAL_LOGS
-      Serial.println("\nWiFi connection failed!");
-    #endif
-#if defined INCLUDE_OLED_DISPLAY
-      oled_Display.clear();
-      oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
-      oled_Display.writeLine(1, "WiFi",  ALIGN_CENTER);
-      oled_Display.writeLine(2, "connection failed",  	ALIGN_CENTER);
-      oled_Display.writeLine(3, "Restarting...",  	ALIGN_CENTER);
-#endif
-      delay(3000);
-      ESP.restart();
-    }
-  #if RPC_SERIAL_LOGS
-    Serial.println("RPC Server ready. Waiting for commands...");
-  #endif
-    
-  }
-#if defined INCLUDE_OLED_DISPLAY
-  oled_Display.clear();
-	oled_Display.writeLine(0, "ESP32 RPC", ALIGN_CENTER);
-	oled_Display.writeLine(1, "Server Ready",  ALIGN_CENTER);
-  if (wifi_mode) {
-    oled_Display.writeLine(2, "WiFi Connection",  		ALIGN_CENTER);
-    char text_buffer[32];
-    snprintf(text_buffer, sizeof(text_buffer), "IP: %s", WiFi.localIP().toString().c_str());
-    oled_Display.writeLine(3, text_buffer,  ALIGN_CENTER);
-  }
-  else
-    oled_Display.writeLine(3, "USB Connection",  		ALIGN_CENTER);
 #endif
-  Serial.flush();
+  boot_profile.ready();
 }
 
 void loop() {
 
+  loop_count = loop_count + 1;
+
   if (!wifi_mode) {
     rpc_server.handle_serial();
   } else {
@@ -218,6 +337,22 @@ void loop() {
   
   // Handle pulse ticks for async pulse generation
   rpc_server.handlePulseTicks();
+  rpc_server.handleJobs();
+
+#if defined INCLUDE_QC_7366_LIB
+  // keep the 64 bit encoder positions while no client reads the counters
+  if (millis() - last_qc_poll_ms >= QC_POSITION_POLL_MS) {
+    last_qc_poll_ms = millis();
+    qc.pollPositions();
+  }
+#endif
+
+#if defined INCLUDE_OLED_DISPLAY
+  // Send pending display changes, rate limited
+  oled_Display.update();
+#endif
   
-  delay(10);
+  // pulse edges and job deadlines are placed by the ticks above, tick every
+  // ms while a channel is pulsing or a job runs
+  delay((rpc_server.getActivePulseChannels() > 0 || rpc_server.hasRunningJobs()) ? 1 : 10);
 }
\ No newline at end of file
@@ -0,0 +1,380 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Arduino.h (native test stub)
+//
+// just enough of the ESP32 Arduino core and FreeRTOS to run the libraries in
+// lib/ on the host:
+//
+//   - a simulated clock, advanced by the test, delay() and vTaskDelay()
+//   - GPIO levels with edge interrupts, inputs are driven by simSetInput()
+//   - GPIO register proxies that count every register access
+//   - critical sections and semaphores that do nothing
+//   - tasks that run synchronously when notified
+//
+// Header only, the simulation state lives in function local statics so every
+// translation unit shares it.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::min;
+using std::max;
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define HIGH				1
+#define LOW					0
+
+#define INPUT				0x01
+#define OUTPUT				0x03
+#define INPUT_PULLUP		0x05
+#define INPUT_PULLDOWN		0x09
+
+#define RISING				0x01
+#define FALLING				0x02
+#define CHANGE				0x03
+
+#define IRAM_ATTR
+
+#define constrain(amt, low, high)	((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define lowByte(w)			((uint8_t)((w) & 0xff))
+#define highByte(w)			((uint8_t)((w) >> 8))
+
+#define SIM_N_GPIO			40
+
+typedef enum
+{
+	GPIO_NUM_0 = 0, GPIO_NUM_1, GPIO_NUM_2, GPIO_NUM_3, GPIO_NUM_4, GPIO_NUM_5,
+	GPIO_NUM_12 = 12, GPIO_NUM_13, GPIO_NUM_14, GPIO_NUM_15, GPIO_NUM_16, GPIO_NUM_17,
+	GPIO_NUM_18, GPIO_NUM_19, GPIO_NUM_21 = 21, GPIO_NUM_22, GPIO_NUM_23,
+	GPIO_NUM_25 = 25, GPIO_NUM_26, GPIO_NUM_27,
+	GPIO_NUM_32 = 32, GPIO_NUM_33, GPIO_NUM_34, GPIO_NUM_35, GPIO_NUM_36, GPIO_NUM_39 = 39,
+} gpio_num_t;
+
+///////////////////////////////////////////////////////////////////////////////
+// simulation state
+
+typedef struct
+{
+	uint64_t nowUs;
+
+	uint32_t port[2];							// pin levels, GPIO0..31 & GPIO32..39
+	uint8_t  mode[SIM_N_GPIO];
+	void   (*isr[SIM_N_GPIO])(void *);
+	void    *isrArg[SIM_N_GPIO];
+	int      isrMode[SIM_N_GPIO];
+
+	uint32_t registerReads;						// GPIO.in/out reads
+	uint32_t registerWrites;					// GPIO.out_w1ts/w1tc writes
+	uint32_t pinReads;							// digitalRead() calls
+	uint32_t pinWrites;							// digitalWrite() calls
+
+	void    *currentTask;
+} sim_state_t;
+
+inline sim_state_t &sim(void)
+{
+	static sim_state_t state;
+	return state;
+}
+
+inline void simReset(void)
+{
+	memset(&sim(), 0, sizeof(sim_state_t));
+}
+
+inline void simAdvanceUs(uint64_t us)
+{
+	sim().nowUs += us;
+}
+
+inline uint8_t simGetLevel(uint8_t pin)
+{
+	return ((sim().port[pin >> 5] >> (pin & 0x1F)) & 1) ? HIGH : LOW;
+}
+
+// drives a pin and runs its interrupt handler when the edge matches
+
+inline void simSetInput(uint8_t pin, uint8_t level)
+{
+	uint8_t previous = simGetLevel(pin);
+	int     mode = sim().isrMode[pin];
+
+	if (level)
+	{
+		sim().port[pin >> 5] |= (1UL << (pin & 0x1F));
+	}
+	else
+	{
+		sim().port[pin >> 5] &= ~(1UL << (pin & 0x1F));
+	}
+
+	if ((sim().isr[pin] != nullptr) && (level != previous) &&
+		((mode == CHANGE) || ((mode == RISING) && level) || ((mode == FALLING) && !level)))
+	{
+		sim().isr[pin](sim().isrArg[pin]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GPIO registers, only the fields the libraries use
+
+struct sim_gpio_read_t
+{
+	uint8_t port;
+
+	operator uint32_t() const
+	{
+		sim().registerReads++;
+		return sim().port[port];
+	}
+};
+
+struct sim_gpio_set_t
+{
+	uint8_t port;
+
+	sim_gpio_set_t &operator=(uint32_t mask)
+	{
+		sim().registerWrites++;
+		sim().port[port] |= mask;
+		return *this;
+	}
+};
+
+struct sim_gpio_clear_t
+{
+	uint8_t port;
+
+	sim_gpio_clear_t &operator=(uint32_t mask)
+	{
+		sim().registerWrites++;
+		sim().port[port] &= ~mask;
+		return *this;
+	}
+};
+
+struct sim_gpio_dev_t
+{
+	sim_gpio_read_t  in;
+	sim_gpio_read_t  out;
+	sim_gpio_set_t   out_w1ts;
+	sim_gpio_clear_t out_w1tc;
+	struct { sim_gpio_read_t  val; } in1;
+	struct { sim_gpio_read_t  val; } out1;
+	struct { sim_gpio_set_t   val; } out1_w1ts;
+	struct { sim_gpio_clear_t val; } out1_w1tc;
+};
+
+static sim_gpio_dev_t GPIO = { {0}, {0}, {0}, {0}, {{1}}, {{1}}, {{1}}, {{1}} };
+
+///////////////////////////////////////////////////////////////////////////////
+// time
+
+inline unsigned long millis(void)
+{
+	return (unsigned long)(sim().nowUs / 1000);
+}
+
+inline unsigned long micros(void)
+{
+	return (unsigned long)(uint32_t)sim().nowUs;
+}
+
+inline int64_t esp_timer_get_time(void)
+{
+	return (int64_t)sim().nowUs;
+}
+
+inline uint32_t xthal_get_ccount(void)
+{
+	return (uint32_t)(sim().nowUs * 240);		// 240 MHz
+}
+
+inline void delay(uint32_t ms)
+{
+	simAdvanceUs((uint64_t)ms * 1000);
+}
+
+inline void delayMicroseconds(uint32_t us)
+{
+	simAdvanceUs(us);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// GPIO
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+	sim().mode[pin] = mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level)
+{
+	sim().pinWrites++;
+	simSetInput(pin, level ? HIGH : LOW);
+}
+
+inline int digitalRead(uint8_t pin)
+{
+	sim().pinReads++;
+	return simGetLevel(pin);
+}
+
+inline void attachInterruptArg(uint8_t pin, void (*handler)(void *), void *arg, int mode)
+{
+	sim().isr[pin]     = handler;
+	sim().isrArg[pin]  = arg;
+	sim().isrMode[pin] = mode;
+}
+
+inline void detachInterrupt(uint8_t pin)
+{
+	sim().isr[pin]     = nullptr;
+	sim().isrArg[pin]  = nullptr;
+	sim().isrMode[pin] = 0;
+}
+
+inline void ledcWrite(uint8_t channel, uint32_t duty)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FreeRTOS
+
+typedef int      BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE				1
+#define pdFALSE				0
+#define pdPASS				1
+#define portMAX_DELAY		0xFFFFFFFF
+#define pdMS_TO_TICKS(ms)	(ms)
+
+typedef struct { int owner; } portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED	{ 0 }
+
+#define portENTER_CRITICAL(mux)			((void)(mux))
+#define portEXIT_CRITICAL(mux)			((void)(mux))
+#define portENTER_CRITICAL_ISR(mux)		((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux)		((void)(mux))
+
+// a task runs inside xTaskNotifyGive() until it waits for the next notify
+
+struct sim_task_t
+{
+	void   (*code)(void *);
+	void    *parameter;
+	uint32_t notifyCount;
+	bool     running;
+};
+
+typedef sim_task_t *TaskHandle_t;
+
+struct sim_task_blocked_t {};
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*code)(void *), const char *name, uint32_t stackSize,
+										  void *parameter, int priority, TaskHandle_t *handle, int core)
+{
+	sim_task_t *task = new sim_task_t();
+
+	task->code      = code;
+	task->parameter = parameter;
+	if (handle != nullptr)
+	{
+		*handle = task;
+	}
+
+	return pdPASS;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task)
+{
+	void *caller = sim().currentTask;
+
+	task->notifyCount++;
+	if (task->running)
+	{
+		return;
+	}
+
+	task->running = true;
+	sim().currentTask = task;
+	try
+	{
+		task->code(task->parameter);
+	}
+	catch (sim_task_blocked_t &)
+	{
+	}
+	sim().currentTask = caller;
+	task->running = false;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+	sim_task_t *task = (sim_task_t *)sim().currentTask;
+	uint32_t count = 0;
+
+	if ((task == nullptr) || (task->notifyCount == 0))
+	{
+		throw sim_task_blocked_t();
+	}
+
+	count = task->notifyCount;
+	task->notifyCount = clearOnExit ? 0 : count - 1;
+
+	return count;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+	simAdvanceUs((uint64_t)ticks * 1000);
+}
+
+inline void vTaskDelayUntil(TickType_t *previousWake, TickType_t ticks)
+{
+	*previousWake += ticks;
+	vTaskDelay(ticks);
+}
+
+inline TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)millis();
+}
+
+typedef void *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	static int mutex;
+	return &mutex;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait)
+{
+	return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	return pdTRUE;
+}
+
+#endif	// NATIVE_ARDUINO_H
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SPI.h (native test stub)
+//
+// records the words written per transaction, reads are answered by a
+// device model the test installs with simSpi().onTransfer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define VSPI				3
+#define MSBFIRST			1
+#define SPI_MODE0			0
+
+#define SIM_SPI_MAX_WORDS	64
+
+///////////////////////////////////////////////////////////////////////////////
+// simulation state
+
+typedef struct
+{
+	uint32_t transactions;						// beginTransaction() calls
+	bool     inTransaction;
+	uint32_t bytes;								// bytes on the bus
+	uint16_t words[SIM_SPI_MAX_WORDS];			// write16() words, in order
+	uint8_t  numWords;
+	uint8_t  (*onTransfer)(uint8_t data);		// device model, nullptr answers 0
+} sim_spi_t;
+
+inline sim_spi_t &simSpi(void)
+{
+	static sim_spi_t state;
+	return state;
+}
+
+inline void simSpiReset(void)
+{
+	memset(&simSpi(), 0, sizeof(sim_spi_t));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// classes
+
+class SPISettings {
+public:
+	SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+		: _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+
+	uint32_t _clock;
+	uint8_t  _bitOrder;
+	uint8_t  _dataMode;
+};
+
+class SPIClass {
+public:
+	SPIClass(uint8_t bus = VSPI) {}
+
+	void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) {}
+	void setHwCs(bool use) {}
+
+	void beginTransaction(SPISettings settings)
+	{
+		simSpi().transactions++;
+		simSpi().inTransaction = true;
+	}
+
+	void endTransaction(void)
+	{
+		simSpi().inTransaction = false;
+	}
+
+	uint8_t transfer(uint8_t data)
+	{
+		simSpi().bytes++;
+		return (simSpi().onTransfer != nullptr) ? simSpi().onTransfer(data) : 0;
+	}
+
+	uint16_t transfer16(uint16_t data)
+	{
+		uint16_t msb = transfer(highByte(data));
+		return (msb << 8) | transfer(lowByte(data));
+	}
+
+	void write(uint8_t data)
+	{
+		transfer(data);
+	}
+
+	void write16(uint16_t data)
+	{
+		if (simSpi().numWords < SIM_SPI_MAX_WORDS)
+		{
+			simSpi().words[simSpi().numWords++] = data;
+		}
+		transfer16(data);
+	}
+};
+
+#endif	// NATIVE_SPI_H
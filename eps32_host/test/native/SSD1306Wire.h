@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// SSD1306Wire.h (native test stub)
+//
+// the frame buffer of the ThingPulse driver with a stand-in renderer: text
+// is 6 columns per character with a pixel pattern that depends on the
+// character, so a changed text changes exactly the columns it covers. No
+// I2C traffic, the tests look at what oled_lib sends itself.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NATIVE_SSD1306WIRE_H
+#define NATIVE_SSD1306WIRE_H
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define SIM_OLED_WIDTH		128
+#define SIM_OLED_HEIGHT		64
+#define SIM_OLED_CHAR_WIDTH	6
+
+#define BLACK				0
+#define WHITE				1
+
+typedef enum
+{
+	TEXT_ALIGN_LEFT = 0,
+	TEXT_ALIGN_CENTER,
+	TEXT_ALIGN_RIGHT,
+	TEXT_ALIGN_CENTER_BOTH,
+} OLEDDISPLAY_TEXT_ALIGNMENT;
+
+// a font is its height only
+static const uint8_t ArialMT_Plain_10[] = { 10 };
+static const uint8_t ArialMT_Plain_16[] = { 16 };
+
+///////////////////////////////////////////////////////////////////////////////
+// classes
+
+class SSD1306Wire {
+public:
+	SSD1306Wire(uint8_t address, int sda, int scl)
+		: buffer(frame), color(WHITE), alignment(TEXT_ALIGN_LEFT), fontHeight(10) {}
+
+	bool init(void)
+	{
+		clear();
+		return true;
+	}
+
+	void setFont(const uint8_t *font) { fontHeight = font[0]; }
+	void setContrast(uint8_t contrast) {}
+	void setBrightness(uint8_t brightness) {}
+	void flipScreenVertically(void) {}
+	void setTextAlignment(OLEDDISPLAY_TEXT_ALIGNMENT textAlignment) { alignment = textAlignment; }
+	void setColor(uint8_t newColor) { color = newColor; }
+
+	void clear(void)
+	{
+		memset(frame, 0, sizeof(frame));
+	}
+
+	void setPixel(int16_t x, int16_t y, bool on)
+	{
+		if ((x < 0) || (x >= SIM_OLED_WIDTH) || (y < 0) || (y >= SIM_OLED_HEIGHT))
+		{
+			return;
+		}
+		if (on)
+		{
+			frame[(y / 8) * SIM_OLED_WIDTH + x] |= (1 << (y & 7));
+		}
+		else
+		{
+			frame[(y / 8) * SIM_OLED_WIDTH + x] &= ~(1 << (y & 7));
+		}
+	}
+
+	void fillRect(int16_t x, int16_t y, int16_t width, int16_t height)
+	{
+		for (int16_t column = x; column < x + width; column++)
+		{
+			for (int16_t row = y; row < y + height; row++)
+			{
+				setPixel(column, row, color == WHITE);
+			}
+		}
+	}
+
+	void drawString(int16_t x, int16_t y, const char *text)
+	{
+		int16_t width = (int16_t)strlen(text) * SIM_OLED_CHAR_WIDTH;
+
+		if (alignment == TEXT_ALIGN_RIGHT)
+		{
+			x -= width;
+		}
+		else if (alignment != TEXT_ALIGN_LEFT)
+		{
+			x -= width / 2;
+		}
+
+		for (int16_t column = 0; column < width; column++)
+		{
+			uint8_t glyph = (uint8_t)text[column / SIM_OLED_CHAR_WIDTH];
+			uint8_t slice = column % SIM_OLED_CHAR_WIDTH;
+
+			for (int16_t row = 0; row < fontHeight; row++)
+			{
+				// last column is the gap between characters
+				if ((slice != SIM_OLED_CHAR_WIDTH - 1) && (((glyph * 7 + slice * 3 + row) % 4) == 0))
+				{
+					setPixel(x + column, y + row, color == WHITE);
+				}
+			}
+		}
+	}
+
+	uint8_t *buffer;
+
+private:
+	uint8_t frame[SIM_OLED_WIDTH * SIM_OLED_HEIGHT / 8];
+	uint8_t color;
+	OLEDDISPLAY_TEXT_ALIGNMENT alignment;
+	uint8_t fontHeight;
+};
+
+#endif	// NATIVE_SSD1306WIRE_H
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Wire.h (native test stub)
+//
+// counts transactions & bytes on the I2C bus, every finished transaction is
+// handed to a device model the test installs with simWire().onTransmission
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+#include "Arduino.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define SIM_WIRE_MAX_BYTES	256			// largest transaction, longer ones are cut
+
+///////////////////////////////////////////////////////////////////////////////
+// simulation state
+
+typedef struct
+{
+	uint32_t transactions;						// endTransmission() calls
+	uint32_t bytes;								// payload bytes, address excluded
+	uint8_t  address;
+	uint8_t  data[SIM_WIRE_MAX_BYTES];			// transaction in progress
+	uint16_t length;
+	void   (*onTransmission)(uint8_t address, const uint8_t *data, uint16_t length);
+} sim_wire_t;
+
+inline sim_wire_t &simWire(void)
+{
+	static sim_wire_t state;
+	return state;
+}
+
+inline void simWireReset(void)
+{
+	memset(&simWire(), 0, sizeof(sim_wire_t));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// classes
+
+class TwoWire {
+public:
+	bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0) { return true; }
+	void setClock(uint32_t frequency) {}
+
+	void beginTransmission(uint8_t address)
+	{
+		simWire().address = address;
+		simWire().length  = 0;
+	}
+
+	size_t write(uint8_t data)
+	{
+		simWire().bytes++;
+		if (simWire().length < SIM_WIRE_MAX_BYTES)
+		{
+			simWire().data[simWire().length++] = data;
+		}
+		return 1;
+	}
+
+	uint8_t endTransmission(bool stop = true)
+	{
+		simWire().transactions++;
+		if (simWire().onTransmission != nullptr)
+		{
+			simWire().onTransmission(simWire().address, simWire().data, simWire().length);
+		}
+		return 0;
+	}
+};
+
+static TwoWire Wire;
+
+#endif	// NATIVE_WIRE_H
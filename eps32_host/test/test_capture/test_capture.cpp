@@ -0,0 +1,353 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_capture.cpp
+//
+// the capture scan loop, trigger and ring of adcCapture against a simulated
+// signal: an MCP3208 model on the SPI stub answers every 3 byte conversion
+// with the value of a signal function, per channel and scan, and takes one
+// microsecond per byte so the scan timestamps advance
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "capture_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define BYTES_PER_CONVERSION	3
+#define CYCLES_PER_BYTE			240			// 1 us at 240 MHz
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static spi        spiBus;
+static adc3208    adc;
+static dio        io;
+static adcCapture capture;
+
+// MCP3208 model
+
+typedef uint16_t (*signal_t)(uint8_t channel, uint32_t scan);
+
+static signal_t adcSignal;
+static uint8_t  channelsPerScan;
+static uint32_t conversions;
+static uint8_t  byteIndex;
+static uint8_t  command;
+static uint16_t conversionValue;
+static void   (*onScan)(uint32_t scan);		// runs before the first conversion of a scan
+
+static uint8_t adcModel(uint8_t data)
+{
+	uint8_t  channel = 0;
+	uint32_t scan = conversions / channelsPerScan;
+	uint8_t  answer = 0;
+
+	simAdvanceUs(1);
+
+	switch (byteIndex)
+	{
+		case 0:
+		if ((onScan != nullptr) && ((conversions % channelsPerScan) == 0))
+		{
+			onScan(scan);
+		}
+		command = data;
+		break;
+
+		case 1:
+		channel = ((command & 0x01) << 2) | (data >> 6);
+		conversionValue = adcSignal(channel, scan) & ADC_MAX_VALUE;
+		answer = highByte(conversionValue) & 0x0F;
+		break;
+
+		case 2:
+		answer = lowByte(conversionValue);
+		conversions++;
+		break;
+	}
+
+	byteIndex = (byteIndex + 1) % BYTES_PER_CONVERSION;
+
+	return answer;
+}
+
+void setUp(void)
+{
+	simReset();
+	spiBus.init();
+	adc.init(&spiBus);
+	io.init();
+	capture.stop();
+	capture.init(&adc, &io);
+
+	simSpiReset();
+	simSpi().onTransfer = adcModel;
+	conversions = 0;
+	byteIndex   = 0;
+	onScan      = nullptr;
+}
+
+void tearDown(void)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// signals
+
+// channel * 1000 + scan, tells every sample apart
+static uint16_t scanNumberSignal(uint8_t channel, uint32_t scan)
+{
+	return channel * 1000 + scan;
+}
+
+static const uint16_t risingTrace[] =
+{
+	// above the level, not primed   within the hysteresis     primed   trigger   post
+	3000,                           1950, 2050, 1950,         1800,    1950, 2000, 2100, 2200, 2300,
+};
+
+static uint16_t risingSignal(uint8_t channel, uint32_t scan)
+{
+	if (channel == 1)
+	{
+		return risingTrace[min(scan, (uint32_t)(sizeof(risingTrace) / sizeof(risingTrace[0]) - 1))];
+	}
+
+	return scan;
+}
+
+static const uint16_t fallingTrace[] =
+{
+	// crossing inside the pre-trigger fill   re-primed   trigger   post
+	2000, 900, 800, 700,                     1200,       950,      900, 850, 800,
+};
+
+static uint16_t fallingSignal(uint8_t channel, uint32_t scan)
+{
+	return fallingTrace[min(scan, (uint32_t)(sizeof(fallingTrace) / sizeof(fallingTrace[0]) - 1))];
+}
+
+// noise around the level, never as far as the hysteresis on either side
+static uint16_t noiseSignal(uint8_t channel, uint32_t scan)
+{
+	if (channel == 3)
+	{
+		return (scan & 1) ? 1040 : 990;
+	}
+
+	return scan;
+}
+
+static void forceAtScan20(uint32_t scan)
+{
+	if (scan == 20)
+	{
+		capture.forceTrigger();
+	}
+}
+
+static void dioHighAtScan10(uint32_t scan)
+{
+	simSetInput(GPIO_NUM_36, (scan >= 10) ? HIGH : LOW);		// input bit 0
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers
+
+static capture_config_t makeConfig(uint8_t channelMask, capture_trigger_t trigger, uint8_t source,
+								   uint16_t level, uint16_t hysteresis, uint16_t preScans, uint16_t postScans)
+{
+	capture_config_t config;
+
+	config.channelMask = channelMask;
+	config.trigger     = trigger;
+	config.source      = source;
+	config.level       = level;
+	config.hysteresis  = hysteresis;
+	config.preScans    = preScans;
+	config.postScans   = postScans;
+
+	return config;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_trigger_now_fills_the_ring_in_order(void)
+{
+	capture_config_t config = makeConfig(0x05, CAPTURE_TRIGGER_NOW, 0, 0, 0, 4, 3);
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = scanNumberSignal;
+	channelsPerScan = 2;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+
+	TEST_ASSERT_EQUAL(CAPTURE_DONE, capture.getState());
+	TEST_ASSERT_EQUAL(2, capture.getNumChannels());
+	TEST_ASSERT_EQUAL(8, capture.getScans());
+	TEST_ASSERT_EQUAL(8, capture.getScansRecorded());
+	TEST_ASSERT_EQUAL(8 * 2, conversions);
+
+	for (uint16_t scan = 0; scan < 8; scan++)
+	{
+		TEST_ASSERT_TRUE(capture.readScan(scan, &cycles, rawValues));
+		TEST_ASSERT_EQUAL(scan, rawValues[0]);
+		TEST_ASSERT_EQUAL(2000 + scan, rawValues[1]);
+		TEST_ASSERT_EQUAL(((int32_t)scan - 4) * 2 * BYTES_PER_CONVERSION * CYCLES_PER_BYTE, cycles);
+	}
+}
+
+void test_rising_trigger_needs_the_hysteresis(void)
+{
+	capture_config_t config = makeConfig(0x03, CAPTURE_TRIGGER_RISING, 1, 2000, 100, 3, 2);
+	const uint16_t expected[] = { 1950, 1800, 1950, 2000, 2100, 2200 };
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = risingSignal;
+	channelsPerScan = 2;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+	TEST_ASSERT_EQUAL(CAPTURE_DONE, capture.getState());
+
+	// 2050 at scan 2 does not trigger, 1950 is within the hysteresis
+	for (uint16_t scan = 0; scan < 6; scan++)
+	{
+		TEST_ASSERT_TRUE(capture.readScan(scan, &cycles, rawValues));
+		TEST_ASSERT_EQUAL(scan + 3, rawValues[0]);
+		TEST_ASSERT_EQUAL(expected[scan], rawValues[1]);
+	}
+}
+
+void test_trigger_waits_for_the_pre_trigger_block(void)
+{
+	capture_config_t config = makeConfig(0x01, CAPTURE_TRIGGER_FALLING, 0, 1000, 50, 4, 3);
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = fallingSignal;
+	channelsPerScan = 1;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+	TEST_ASSERT_EQUAL(CAPTURE_DONE, capture.getState());
+
+	// 9 scans into a ring of 8: the first one is overwritten
+	TEST_ASSERT_EQUAL(9, conversions);
+	TEST_ASSERT_EQUAL(8, capture.getScansRecorded());
+
+	for (uint16_t scan = 0; scan < 8; scan++)
+	{
+		TEST_ASSERT_TRUE(capture.readScan(scan, &cycles, rawValues));
+		TEST_ASSERT_EQUAL(fallingTrace[scan + 1], rawValues[0]);
+	}
+
+	TEST_ASSERT_TRUE(capture.readScan(4, &cycles, rawValues));
+	TEST_ASSERT_EQUAL(950, rawValues[0]);
+	TEST_ASSERT_EQUAL(0, cycles);
+}
+
+void test_noise_within_hysteresis_needs_a_forced_trigger(void)
+{
+	capture_config_t config = makeConfig(0x09, CAPTURE_TRIGGER_FALLING, 3, 1000, 50, 2, 1);
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = noiseSignal;
+	channelsPerScan = 2;
+	onScan = forceAtScan20;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+	TEST_ASSERT_EQUAL(CAPTURE_DONE, capture.getState());
+
+	TEST_ASSERT_TRUE(capture.readScan(2, &cycles, rawValues));
+	TEST_ASSERT_EQUAL(20, rawValues[0]);
+	TEST_ASSERT_EQUAL(990, rawValues[1]);
+	TEST_ASSERT_EQUAL(0, cycles);
+}
+
+void test_dio_rising_trigger(void)
+{
+	capture_config_t config = makeConfig(0x01, CAPTURE_TRIGGER_DIO_RISING, 0, 0, 0, 5, 5);
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = scanNumberSignal;
+	channelsPerScan = 1;
+	onScan = dioHighAtScan10;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+	TEST_ASSERT_EQUAL(CAPTURE_DONE, capture.getState());
+
+	TEST_ASSERT_TRUE(capture.readScan(5, &cycles, rawValues));
+	TEST_ASSERT_EQUAL(10, rawValues[0]);
+	TEST_ASSERT_TRUE(capture.readScan(0, &cycles, rawValues));
+	TEST_ASSERT_EQUAL(5, rawValues[0]);
+	TEST_ASSERT_EQUAL(-5 * BYTES_PER_CONVERSION * CYCLES_PER_BYTE, cycles);
+}
+
+void test_arm_rejects_invalid_configs(void)
+{
+	capture_config_t config;
+
+	config = makeConfig(0x00, CAPTURE_TRIGGER_NOW, 0, 0, 0, 1, 1);
+	TEST_ASSERT_FALSE(capture.arm(&config));
+
+	config = makeConfig(0x01, CAPTURE_TRIGGER_RISING, 2, 100, 0, 1, 1);		// source not captured
+	TEST_ASSERT_FALSE(capture.arm(&config));
+
+	config = makeConfig(0x01, CAPTURE_TRIGGER_DIO_RISING, N_INPUT_BITS, 0, 0, 1, 1);
+	TEST_ASSERT_FALSE(capture.arm(&config));
+
+	config = makeConfig(0xFF, CAPTURE_TRIGGER_NOW, 0, 0, 0, CAPTURE_MAX_SAMPLES / 8, 0);
+	TEST_ASSERT_FALSE(capture.arm(&config));
+
+	TEST_ASSERT_EQUAL(CAPTURE_IDLE, capture.getState());
+	TEST_ASSERT_EQUAL(0, conversions);
+}
+
+void test_read_scan_bounds_and_stop(void)
+{
+	capture_config_t config = makeConfig(0x01, CAPTURE_TRIGGER_NOW, 0, 0, 0, 2, 2);
+	uint16_t rawValues[N_ADC_CHANNELS];
+	int32_t  cycles = 0;
+
+	adcSignal = scanNumberSignal;
+	channelsPerScan = 1;
+
+	TEST_ASSERT_TRUE(capture.arm(&config));
+	TEST_ASSERT_TRUE(capture.readScan(4, &cycles, rawValues));
+	TEST_ASSERT_FALSE(capture.readScan(5, &cycles, rawValues));
+
+	capture.stop();
+	TEST_ASSERT_EQUAL(CAPTURE_IDLE, capture.getState());
+	TEST_ASSERT_FALSE(capture.readScan(0, &cycles, rawValues));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_trigger_now_fills_the_ring_in_order);
+	RUN_TEST(test_rising_trigger_needs_the_hysteresis);
+	RUN_TEST(test_trigger_waits_for_the_pre_trigger_block);
+	RUN_TEST(test_noise_within_hysteresis_needs_a_forced_trigger);
+	RUN_TEST(test_dio_rising_trigger);
+	RUN_TEST(test_arm_rejects_invalid_configs);
+	RUN_TEST(test_read_scan_bounds_and_stop);
+
+	return UNITY_END();
+}
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_conv.cpp
+//
+// fixed point conversions of conv_lib against the fmap()/integer paths they
+// replaced and a double reference, ideal and calibrated
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <Arduino.h>
+#include <unity.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "config.h"
+#include "conv_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define DAC_MIN_MV			((int32_t)(DAC_MIN_VOLTAGE * VOLT_TO_MV))
+#define DAC_MAX_MV			((int32_t)(DAC_MAX_VOLTAGE * VOLT_TO_MV))
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static conv_raw_to_uv_t adcConv;
+static conv_uv_to_raw_t dacConv;
+
+void setUp(void)
+{
+	convInitRawToUv(&adcConv, ADC03_MIN_VOLTAGE, ADC03_RESOLUTION);
+	convInitUvToRaw(&dacConv, DAC_MIN_VOLTAGE, DAC_RESOLUTION, DAC_MAX_VALUE);
+}
+
+void tearDown(void)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reference conversions
+
+// the integer dac4922::voltageToValue() before conv_lib, truncates
+
+static uint16_t oldDacValue(int32_t milliVolt)
+{
+	int32_t dacValue = 0;
+
+	milliVolt = constrain(milliVolt, DAC_MIN_MV, DAC_MAX_MV);
+	dacValue  = ((milliVolt - DAC_MIN_MV) * (DAC_MAX_VALUE + 1)) / (int32_t)(DAC_SPAN * VOLT_TO_MV);
+
+	return (uint16_t)constrain(dacValue, DAC_MIN_VALUE, DAC_MAX_VALUE);
+}
+
+static uint16_t exactDacValue(int32_t milliVolt)
+{
+	double value = floor((milliVolt - DAC_MIN_MV) / (DAC_RESOLUTION * VOLT_TO_MV) + 0.5);
+
+	return (uint16_t)constrain(value, (double)DAC_MIN_VALUE, (double)DAC_MAX_VALUE);
+}
+
+// fmap(adcRaw, ADC_MIN_VALUE, ADC_MAX_VALUE, ADC03_MIN_VOLTAGE, ADC03_MAX_VOLTAGE) in double
+
+static double fmapAdcUv(uint16_t raw)
+{
+	return (ADC03_MIN_VOLTAGE + (double)raw * (ADC03_MAX_VOLTAGE - ADC03_MIN_VOLTAGE) / ADC_MAX_VALUE) * 1e6;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+// every millivolt of the range: at most 1 LSB from the old truncating path,
+// always the nearest code
+
+void test_dac_rounds_to_nearest(void)
+{
+	uint32_t differ = 0;
+
+	for (int32_t milliVolt = DAC_MIN_MV; milliVolt <= DAC_MAX_MV; milliVolt++)
+	{
+		uint16_t value = convUvToRaw(&dacConv, milliVolt * 1000);
+		uint16_t old   = oldDacValue(milliVolt);
+
+		TEST_ASSERT_EQUAL_UINT16(exactDacValue(milliVolt), value);
+		TEST_ASSERT_TRUE((value == old) || (value == old + 1));
+		differ += (value != old);
+	}
+
+	printf("test_conv: %u of %d millivolt steps are 1 LSB above the truncating path\n",
+		   (unsigned)differ, DAC_MAX_MV - DAC_MIN_MV + 1);
+}
+
+void test_dac_clamps_to_range(void)
+{
+	TEST_ASSERT_EQUAL_UINT16(DAC_MIN_VALUE, convUvToRaw(&dacConv, -12000000));
+	TEST_ASSERT_EQUAL_UINT16(DAC_MAX_VALUE, convUvToRaw(&dacConv, 12000000));
+	TEST_ASSERT_EQUAL_UINT16(DAC_MIN_VALUE, convUvToRaw(&dacConv, convVoltToUv(DAC_MIN_VOLTAGE)));
+	TEST_ASSERT_EQUAL_UINT16(DAC_MAX_VALUE, convUvToRaw(&dacConv, convVoltToUv(DAC_MAX_VOLTAGE)));
+}
+
+// code -> voltage -> code is exact for every code
+
+void test_round_trip_is_exact(void)
+{
+	conv_raw_to_uv_t dacToUv;
+
+	convInitRawToUv(&dacToUv, DAC_MIN_VOLTAGE, DAC_RESOLUTION);
+
+	for (uint16_t code = DAC_MIN_VALUE; code <= DAC_MAX_VALUE; code++)
+	{
+		TEST_ASSERT_EQUAL_UINT16(code, convUvToRaw(&dacConv, convRawToUv(&dacToUv, code)));
+	}
+}
+
+void test_adc_matches_fmap(void)
+{
+	for (uint16_t raw = ADC_MIN_VALUE; raw <= ADC_MAX_VALUE; raw++)
+	{
+		TEST_ASSERT_TRUE(fabs(fmapAdcUv(raw) - convRawToUv(&adcConv, raw)) <= 0.5);
+	}
+}
+
+void test_adc_q8_keeps_fraction(void)
+{
+	int32_t lower = convRawToUv(&adcConv, 1000);
+	int32_t upper = convRawToUv(&adcConv, 1001);
+
+	TEST_ASSERT_EQUAL_INT32(lower, convRawQ8ToUv(&adcConv, 1000 << CONV_FRACTION_SHIFT));
+	TEST_ASSERT_INT32_WITHIN(1, (lower + upper) / 2, convRawQ8ToUv(&adcConv, (1000 << CONV_FRACTION_SHIFT) + 128));
+}
+
+// corrections of opposite sign at the ends of the PWL limits, the
+// product of the differences needs far more than 32 bits
+
+void test_pwl_full_span_interpolates(void)
+{
+	conv_calibration_t calibration;
+	conv_raw_to_uv_t conv;
+
+	convDefaultCalibration(&calibration);
+	calibration.pwl.numPoints       = 2;
+	calibration.pwl.pointUv[0]      = -CONV_PWL_MAX_UV;
+	calibration.pwl.pointUv[1]      = CONV_PWL_MAX_UV;
+	calibration.pwl.correctionUv[0] = -CONV_PWL_MAX_UV;
+	calibration.pwl.correctionUv[1] = CONV_PWL_MAX_UV;
+	convInitRawToUv(&conv, ADC03_MIN_VOLTAGE, ADC03_RESOLUTION, &calibration);
+
+	TEST_ASSERT_EQUAL(2, conv.pwl.numPoints);
+	TEST_ASSERT_EQUAL_INT32(-CONV_PWL_MAX_UV, convPwlCorrection(&conv.pwl, -CONV_PWL_MAX_UV));
+	TEST_ASSERT_EQUAL_INT32(0, convPwlCorrection(&conv.pwl, 0));
+	TEST_ASSERT_EQUAL_INT32(CONV_PWL_MAX_UV / 2, convPwlCorrection(&conv.pwl, CONV_PWL_MAX_UV / 2));
+	TEST_ASSERT_EQUAL_INT32(CONV_PWL_MAX_UV, convPwlCorrection(&conv.pwl, INT32_MAX));
+}
+
+// a correction beyond the limits is dropped, an offset beyond them ignored
+
+void test_out_of_limit_calibration_is_ignored(void)
+{
+	conv_calibration_t calibration;
+	conv_raw_to_uv_t conv;
+
+	convDefaultCalibration(&calibration);
+	calibration.offset              = 2000.0f;
+	calibration.pwl.numPoints       = 2;
+	calibration.pwl.pointUv[0]      = 0;
+	calibration.pwl.pointUv[1]      = CONV_PWL_MAX_UV + 1;
+	convInitRawToUv(&conv, ADC03_MIN_VOLTAGE, ADC03_RESOLUTION, &calibration);
+
+	TEST_ASSERT_EQUAL(0, conv.pwl.numPoints);
+	TEST_ASSERT_EQUAL_INT32(adcConv.offsetUv, conv.offsetUv);
+}
+
+// gain & offset calibrations over the limits: the fixed point paths against
+// the same conversion in double, for every code of both ADC ranges and every
+// millivolt of the DAC range
+
+void test_calibrated_matches_double(void)
+{
+	const float gains[]   = { CONV_MIN_GAIN, 0.9876f, 1.0f, 1.0123f, CONV_MAX_GAIN };
+	const float offsets[] = { -0.25f, 0.0f, 0.0421f };
+	conv_calibration_t calibration;
+	conv_raw_to_uv_t adc03;
+	conv_raw_to_uv_t adc47;
+	conv_uv_to_raw_t dac;
+
+	convDefaultCalibration(&calibration);
+
+	for (float gain : gains)
+	{
+		for (float offset : offsets)
+		{
+			calibration.gain   = gain;
+			calibration.offset = offset;
+			convInitRawToUv(&adc03, ADC03_MIN_VOLTAGE, ADC03_RESOLUTION, &calibration);
+			convInitRawToUv(&adc47, ADC47_MIN_VOLTAGE, ADC47_RESOLUTION, &calibration);
+			convInitUvToRaw(&dac, DAC_MIN_VOLTAGE, DAC_RESOLUTION, DAC_MAX_VALUE, &calibration);
+
+			for (uint16_t raw = ADC_MIN_VALUE; raw <= ADC_MAX_VALUE; raw++)
+			{
+				double uv03 = ((double)gain * (ADC03_MIN_VOLTAGE + raw * ADC03_RESOLUTION) + offset) * 1e6;
+				double uv47 = ((double)gain * (ADC47_MIN_VOLTAGE + raw * ADC47_RESOLUTION) + offset) * 1e6;
+
+				TEST_ASSERT_TRUE(fabs(uv03 - convRawToUv(&adc03, raw)) <= 1.0);
+				TEST_ASSERT_TRUE(fabs(uv47 - convRawToUv(&adc47, raw)) <= 1.0);
+			}
+
+			// the code whose calibrated output is nearest, a tie may round
+			// either way
+			for (int32_t milliVolt = DAC_MIN_MV; milliVolt <= DAC_MAX_MV; milliVolt++)
+			{
+				double code = ((milliVolt / VOLT_TO_MV - offset) / gain - DAC_MIN_VOLTAGE) / DAC_RESOLUTION;
+				double clamped = constrain(code, (double)DAC_MIN_VALUE, (double)DAC_MAX_VALUE);
+
+				TEST_ASSERT_TRUE(fabs(clamped - convUvToRaw(&dac, milliVolt * 1000)) <= 0.5 + 1e-3);
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_dac_rounds_to_nearest);
+	RUN_TEST(test_dac_clamps_to_range);
+	RUN_TEST(test_round_trip_is_exact);
+	RUN_TEST(test_adc_matches_fmap);
+	RUN_TEST(test_adc_q8_keeps_fraction);
+	RUN_TEST(test_pwl_full_span_interpolates);
+	RUN_TEST(test_out_of_limit_calibration_is_ignored);
+	RUN_TEST(test_calibrated_matches_double);
+
+	return UNITY_END();
+}
@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_dac_4922.cpp
+//
+// MCP4922 command words and the batched writes of dac4922, checked against
+// the words the SPI stub records
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "dac_4922_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+// buffered Vref, gain 1, output on
+#define DAC_COMMAND_A		0x7000
+#define DAC_COMMAND_B		0xF000
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static spi     spiBus;
+static dac4922 dac;
+
+void setUp(void)
+{
+	simReset();
+	spiBus.init();
+	dac.init(&spiBus);
+	simSpiReset();
+}
+
+void tearDown(void)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_command_selects_chip_half(void)
+{
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_A | 0x000, dac4922::buildCommand(0, 0x000));
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0xFFF, dac4922::buildCommand(1, 0xFFF));
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_A | 0x800, dac4922::buildCommand(2, 0x800));
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0x123, dac4922::buildCommand(3, 0x123));
+}
+
+void test_command_masks_value_to_12_bits(void)
+{
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_A | 0xABC, dac4922::buildCommand(0, 0x1ABC));
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0xFFF, dac4922::buildCommand(1, 0xFFFF));
+}
+
+void test_write_all_is_one_transaction(void)
+{
+	const uint16_t values[N_DAC_CHANNELS] = { 0x001, 0x202, 0x403, 0xFFF };
+	const uint16_t words[N_DAC_CHANNELS] =
+	{
+		DAC_COMMAND_A | 0x001, DAC_COMMAND_B | 0x202, DAC_COMMAND_A | 0x403, DAC_COMMAND_B | 0xFFF,
+	};
+
+	dac.writeAll(values);
+
+	TEST_ASSERT_EQUAL(1, simSpi().transactions);
+	TEST_ASSERT_EQUAL(N_DAC_CHANNELS, simSpi().numWords);
+	TEST_ASSERT_EQUAL_UINT16_ARRAY(words, simSpi().words, N_DAC_CHANNELS);
+	TEST_ASSERT_FALSE(simSpi().inTransaction);
+}
+
+void test_write_is_one_transaction_per_channel(void)
+{
+	dac.write(2, 0x555);
+	dac.write(3, 0x0AA);
+
+	TEST_ASSERT_EQUAL(2, simSpi().transactions);
+	TEST_ASSERT_EQUAL(2, simSpi().numWords);
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_A | 0x555, simSpi().words[0]);
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0x0AA, simSpi().words[1]);
+}
+
+void test_update_all_writes_changed_channels_only(void)
+{
+	const uint16_t values[N_DAC_CHANNELS]  = { 0x100, 0x200, 0x300, 0x400 };
+	const uint16_t changed[N_DAC_CHANNELS] = { 0x100, 0x222, 0x300, 0x444 };
+	shadow_stats_t stats;
+
+	dac.writeAll(values);
+	dac.getShadowStats(&stats, true);
+	simSpiReset();
+
+	dac.updateAll(changed);
+
+	TEST_ASSERT_EQUAL(1, simSpi().transactions);
+	TEST_ASSERT_EQUAL(2, simSpi().numWords);
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0x222, simSpi().words[0]);
+	TEST_ASSERT_EQUAL_HEX16(DAC_COMMAND_B | 0x444, simSpi().words[1]);
+
+	dac.getShadowStats(&stats, false);
+	TEST_ASSERT_EQUAL(2, stats.hits);
+	TEST_ASSERT_EQUAL(2, stats.misses);
+}
+
+void test_update_all_unchanged_skips_the_bus(void)
+{
+	const uint16_t values[N_DAC_CHANNELS] = { 0x100, 0x200, 0x300, 0x400 };
+
+	dac.writeAll(values);
+	simSpiReset();
+
+	dac.updateAll(values);
+	TEST_ASSERT_EQUAL(0, simSpi().transactions);
+
+	dac.updateAll(values, true);
+	TEST_ASSERT_EQUAL(1, simSpi().transactions);
+	TEST_ASSERT_EQUAL(N_DAC_CHANNELS, simSpi().numWords);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_command_selects_chip_half);
+	RUN_TEST(test_command_masks_value_to_12_bits);
+	RUN_TEST(test_write_all_is_one_transaction);
+	RUN_TEST(test_write_is_one_transaction_per_channel);
+	RUN_TEST(test_update_all_writes_changed_channels_only);
+	RUN_TEST(test_update_all_unchanged_skips_the_bus);
+
+	return UNITY_END();
+}
@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_dio.cpp
+//
+// the port register paths of dio against the per pin digitalRead() &
+// digitalWrite() loop they replaced, on the simulated GPIO of the Arduino
+// stub: same levels, and the register accesses each call costs
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+#include <chrono>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "dio_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define ALL_OUTPUTS			((1 << N_OUTPUT_BITS) - 1)
+#define BENCH_ROUNDS		100000
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static dio io;
+
+static const uint8_t inputPins[N_INPUT_BITS]   = { 36, 39, 34, 35, 32, 33 };
+static const uint8_t outputPins[N_OUTPUT_BITS] = { 25, 26, 27, 14, 12, 13 };
+
+void setUp(void)
+{
+	simReset();
+	io.init();
+}
+
+void tearDown(void)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reference, one digitalRead()/digitalWrite() per bit
+
+static uint8_t referenceGetInput(void)
+{
+	uint8_t value = 0;
+
+	for (uint8_t bitNr = 0; bitNr < N_INPUT_BITS; bitNr++)
+	{
+		if (digitalRead(inputPins[bitNr]) == HIGH)
+		{
+			value |= (0x01 << bitNr);
+		}
+	}
+
+	return value;
+}
+
+static void referenceSetOutput(uint8_t value)
+{
+	for (uint8_t bitNr = 0; bitNr < N_OUTPUT_BITS; bitNr++)
+	{
+		digitalWrite(outputPins[bitNr], (value & (0x01 << bitNr)) ? HIGH : LOW);
+	}
+}
+
+static void driveInputs(uint8_t value)
+{
+	for (uint8_t bitNr = 0; bitNr < N_INPUT_BITS; bitNr++)
+	{
+		simSetInput(inputPins[bitNr], (value & (0x01 << bitNr)) ? HIGH : LOW);
+	}
+}
+
+static uint8_t outputLevels(void)
+{
+	uint8_t value = 0;
+
+	for (uint8_t bitNr = 0; bitNr < N_OUTPUT_BITS; bitNr++)
+	{
+		value |= simGetLevel(outputPins[bitNr]) << bitNr;
+	}
+
+	return value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+// all inputs are on GPIO32..39, one read of GPIO.in1 per call
+
+void test_get_input_matches_per_pin_read(void)
+{
+	for (uint8_t value = 0; value < (1 << N_INPUT_BITS); value++)
+	{
+		driveInputs(value);
+		sim().registerReads = 0;
+
+		TEST_ASSERT_EQUAL_HEX8(referenceGetInput(), io.getInput());
+		TEST_ASSERT_EQUAL_UINT32(1, sim().registerReads);
+	}
+}
+
+void test_is_bit_set(void)
+{
+	driveInputs(0x24);
+
+	TEST_ASSERT_TRUE(io.isBitSet(2));
+	TEST_ASSERT_TRUE(io.isBitSet(5));
+	TEST_ASSERT_FALSE(io.isBitSet(0));
+	TEST_ASSERT_FALSE(io.isBitSet(N_INPUT_BITS));
+}
+
+// every transition of the 6 bit output, at most one set & one clear write
+
+void test_set_output_matches_per_pin_write(void)
+{
+	for (uint8_t from = 0; from <= ALL_OUTPUTS; from++)
+	{
+		for (uint8_t to = 0; to <= ALL_OUTPUTS; to++)
+		{
+			io.setOutput(from);
+			sim().registerWrites = 0;
+
+			io.setOutput(to);
+
+			TEST_ASSERT_EQUAL_HEX8(to, outputLevels());
+			TEST_ASSERT_TRUE(sim().registerWrites <= 2);
+			TEST_ASSERT_EQUAL_UINT32((from == to) ? 0 : 1, (sim().registerWrites != 0));
+		}
+	}
+}
+
+void test_unchanged_output_is_a_shadow_hit(void)
+{
+	shadow_stats_t stats;
+
+	io.setOutput(0x15);
+	io.getShadowStats(&stats, true);
+	sim().registerWrites = 0;
+
+	io.setOutput(0x15);
+	io.setBit(0);
+	io.clearBit(1);
+
+	io.getShadowStats(&stats, false);
+	TEST_ASSERT_EQUAL_UINT32(0, sim().registerWrites);
+	TEST_ASSERT_EQUAL_UINT32(3, stats.hits);
+	TEST_ASSERT_EQUAL_UINT32(0, stats.misses);
+
+	io.setOutput(0x15, true);
+	TEST_ASSERT_EQUAL_UINT32(2, sim().registerWrites);
+}
+
+// toggle reads the latch, an output changed behind the shadow is resynced
+// by invalidateShadow()
+
+void test_toggle_and_invalidate(void)
+{
+	io.setOutput(0x00);
+
+	io.toggleBit(3);
+	TEST_ASSERT_EQUAL_HEX8(0x08, outputLevels());
+	io.toggleBit(3);
+	TEST_ASSERT_EQUAL_HEX8(0x00, outputLevels());
+
+	digitalWrite(outputPins[4], HIGH);
+	io.invalidateShadow();
+	sim().registerWrites = 0;
+
+	io.setBit(4);
+	TEST_ASSERT_EQUAL_UINT32(0, sim().registerWrites);
+}
+
+// register & pin accesses per call, plus host time
+
+void test_benchmark(void)
+{
+	volatile uint8_t sink = 0;
+	uint32_t registerAccesses = 0;
+	uint32_t pinAccesses = 0;
+
+	sim().registerReads  = 0;
+	sim().registerWrites = 0;
+	sim().pinReads       = 0;
+	sim().pinWrites      = 0;
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		sink += io.getInput();
+		io.setOutput(round & ALL_OUTPUTS);
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	registerAccesses = sim().registerReads + sim().registerWrites;
+
+	for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		sink += referenceGetInput();
+		referenceSetOutput(round & ALL_OUTPUTS);
+	}
+	auto t2 = std::chrono::steady_clock::now();
+	pinAccesses = sim().pinReads + sim().pinWrites;
+
+	printf("test_dio: %.2f register accesses %.1f ns per read+write, %.2f pin accesses %.1f ns per pin loop\n",
+		   (double)registerAccesses / BENCH_ROUNDS,
+		   std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_ROUNDS,
+		   (double)pinAccesses / BENCH_ROUNDS,
+		   std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_ROUNDS);
+
+	TEST_ASSERT_TRUE(registerAccesses < pinAccesses);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_get_input_matches_per_pin_read);
+	RUN_TEST(test_is_bit_set);
+	RUN_TEST(test_set_output_matches_per_pin_write);
+	RUN_TEST(test_unchanged_output_is_a_shadow_hit);
+	RUN_TEST(test_toggle_and_invalidate);
+	RUN_TEST(test_benchmark);
+
+	return UNITY_END();
+}
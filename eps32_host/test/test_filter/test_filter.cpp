@@ -0,0 +1,235 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_filter.cpp
+//
+// the fixed point filter pipeline against a double reference: median,
+// decimating moving average and IIR step responses over the whole alpha
+// range, the IIR must settle on the input
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+#include <math.h>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "filter_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define OUTPUT_ONE			(1 << FILTER_OUTPUT_SHIFT)		// 1 raw LSB in 24.8
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static filter_state_t filter;
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void initFilter(uint8_t medianLength, uint16_t decimation, uint32_t alphaQ16)
+{
+	filter_config_t config;
+
+	config.medianLength = medianLength;
+	config.decimation   = decimation;
+	config.alphaQ16     = alphaQ16;
+
+	TEST_ASSERT_TRUE(filterInit(&filter, &config));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// reference
+
+// output of the fixed point filter, -1 when the sample gave none
+
+static int32_t feed(uint16_t raw)
+{
+	int32_t output = 0;
+
+	return filterProcess(&filter, raw, &output) ? output : -1;
+}
+
+// IIR step response: the fixed point output may be off by the 24.8 rounding
+// and the rounding of every step, never by more than 1 output LSB, and ends
+// on the input
+
+static void checkStep(uint32_t alphaQ16, uint16_t from, uint16_t to, uint32_t steps)
+{
+	double alpha = (double)alphaQ16 / FILTER_ALPHA_ONE;
+	double reference = from;
+	int32_t output = 0;
+
+	initFilter(1, 1, alphaQ16);
+	feed(from);
+
+	for (uint32_t step = 0; step < steps; step++)
+	{
+		reference += alpha * (to - reference);
+		output = feed(to);
+
+		if (fabs(output - reference * OUTPUT_ONE) > 1.0)
+		{
+			char message[80];
+			snprintf(message, sizeof(message), "alpha %u step %u: %d vs %.3f",
+					 (unsigned)alphaQ16, (unsigned)step, (int)output, reference * OUTPUT_ONE);
+			TEST_FAIL_MESSAGE(message);
+		}
+	}
+
+	TEST_ASSERT_EQUAL_INT32((int32_t)to * OUTPUT_ONE, output);
+}
+
+// steps until alpha settles within half an output LSB of a full scale step
+
+static uint32_t settleSteps(uint32_t alphaQ16)
+{
+	double alpha = (double)alphaQ16 / FILTER_ALPHA_ONE;
+
+	return (uint32_t)(log(4096.0 * OUTPUT_ONE * 2) / -log1p(-alpha)) + 10;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_config_limits(void)
+{
+	filter_config_t config;
+
+	filterDefaultConfig(&config);
+	TEST_ASSERT_TRUE(filterInit(&filter, &config));
+
+	config.medianLength = 4;
+	TEST_ASSERT_FALSE(filterInit(&filter, &config));
+	config.medianLength = FILTER_MAX_MEDIAN + 2;
+	TEST_ASSERT_FALSE(filterInit(&filter, &config));
+
+	filterDefaultConfig(&config);
+	config.alphaQ16 = 0;
+	TEST_ASSERT_FALSE(filterInit(&filter, &config));
+	config.alphaQ16 = FILTER_ALPHA_ONE + 1;
+	TEST_ASSERT_FALSE(filterInit(&filter, &config));
+
+	filterDefaultConfig(&config);
+	config.decimation = FILTER_MAX_DECIMATION + 1;
+	TEST_ASSERT_FALSE(filterInit(&filter, &config));
+}
+
+void test_pass_through(void)
+{
+	initFilter(1, 1, FILTER_ALPHA_ONE);
+
+	for (uint16_t raw = 0; raw < 4096; raw += 17)
+	{
+		TEST_ASSERT_EQUAL_INT32(raw * OUTPUT_ONE, feed(raw));
+	}
+}
+
+void test_median_removes_spikes(void)
+{
+	const uint16_t input[] = { 100, 100, 4000, 100, 101, 0, 102, 103, 4095, 104 };
+	uint16_t history[5];
+
+	initFilter(5, 1, FILTER_ALPHA_ONE);
+
+	for (uint8_t ix = 0; ix < sizeof(input) / sizeof(input[0]); ix++)
+	{
+		uint8_t fill = std::min<uint8_t>(ix + 1, 5);
+
+		for (uint8_t jx = 0; jx < fill; jx++)
+		{
+			history[jx] = input[ix + 1 - fill + jx];
+		}
+		std::sort(history, history + fill);
+
+		TEST_ASSERT_EQUAL_INT32(history[fill / 2] * OUTPUT_ONE, feed(input[ix]));
+	}
+}
+
+// one output per decimation samples, their mean rounded to 24.8
+
+void test_decimation_average(void)
+{
+	uint32_t sum = 0;
+	uint16_t raw = 0;
+
+	initFilter(1, 7, FILTER_ALPHA_ONE);
+
+	for (uint16_t sample = 1; sample <= 70; sample++)
+	{
+		raw = (uint16_t)((sample * 389) % 4096);
+		sum += raw;
+
+		int32_t output = feed(raw);
+
+		if ((sample % 7) != 0)
+		{
+			TEST_ASSERT_EQUAL_INT32(-1, output);
+			continue;
+		}
+
+		TEST_ASSERT_EQUAL_INT32((int32_t)floor(sum * (double)OUTPUT_ONE / 7 + 0.5), output);
+		sum = 0;
+	}
+}
+
+// the smallest alpha used to settle at 872 for a 0 -> 1000 step
+
+void test_iir_small_alpha_settles(void)
+{
+	checkStep(1, 0, 1000, settleSteps(1));
+}
+
+void test_iir_step_responses(void)
+{
+	const uint32_t alphas[] = { 65, 655, 6554, 32768, FILTER_ALPHA_ONE - 1, FILTER_ALPHA_ONE };
+
+	for (uint8_t ix = 0; ix < sizeof(alphas) / sizeof(alphas[0]); ix++)
+	{
+		checkStep(alphas[ix], 0, 1000, settleSteps(alphas[ix]));
+		checkStep(alphas[ix], 4095, 0, settleSteps(alphas[ix]));
+		checkStep(alphas[ix], 1234, 1235, settleSteps(alphas[ix]));
+	}
+}
+
+void test_reset_keeps_config(void)
+{
+	initFilter(3, 2, 32768);
+	feed(1000);
+	feed(1000);
+
+	filterReset(&filter);
+
+	TEST_ASSERT_EQUAL_INT32(-1, feed(10));
+	TEST_ASSERT_EQUAL_INT32(10 * OUTPUT_ONE, feed(10));
+	TEST_ASSERT_EQUAL_UINT32(32768, filter.config.alphaQ16);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_config_limits);
+	RUN_TEST(test_pass_through);
+	RUN_TEST(test_median_removes_spikes);
+	RUN_TEST(test_decimation_average);
+	RUN_TEST(test_iir_small_alpha_settles);
+	RUN_TEST(test_iir_step_responses);
+	RUN_TEST(test_reset_keeps_config);
+
+	return UNITY_END();
+}
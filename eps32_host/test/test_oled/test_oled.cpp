@@ -0,0 +1,293 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_oled.cpp
+//
+// the partial flush of oledDisplay on a mocked I2C bus: a SSD1306 model
+// decodes the transactions into its own display RAM, the tests count the
+// bytes and transactions every flush costs and check that the panel ends up
+// showing the frame buffer
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+#include <Wire.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "oled_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define OLED_ADDRESS		0x3C
+
+#define CONTROL_COMMAND		0x80
+#define CONTROL_DATA		0x40
+#define COMMAND_COLUMNADDR	0x21
+#define COMMAND_PAGEADDR	0x22
+
+#define WINDOW_COMMANDS		6			// column & page address, 2 bytes each
+#define WINDOW_BYTES		(WINDOW_COMMANDS * 2)
+
+///////////////////////////////////////////////////////////////////////////////
+// SSD1306 model, horizontal addressing within the column & page window
+
+typedef struct
+{
+	uint8_t ram[OLED_FRAME_SIZE];
+	uint8_t command;					// command waiting for arguments
+	uint8_t arguments;
+	uint8_t firstColumn, lastColumn, firstPage, lastPage;
+	uint8_t column, page;
+
+	// columns & pages written since the last reset
+	int16_t minColumn, maxColumn, minPage, maxPage;
+} ssd1306_model_t;
+
+static ssd1306_model_t panel;
+
+static void panelResetTouched(void)
+{
+	panel.minColumn = OLED_XSIZE;
+	panel.maxColumn = -1;
+	panel.minPage   = OLED_NPAGES;
+	panel.maxPage   = -1;
+}
+
+static void panelCommand(uint8_t byte)
+{
+	if (panel.arguments == 0)
+	{
+		panel.command   = byte;
+		panel.arguments = ((byte == COMMAND_COLUMNADDR) || (byte == COMMAND_PAGEADDR)) ? 2 : 0;
+		return;
+	}
+
+	if (panel.command == COMMAND_COLUMNADDR)
+	{
+		if (panel.arguments == 2)
+		{
+			panel.firstColumn = panel.column = byte;
+		}
+		else
+		{
+			panel.lastColumn = byte;
+		}
+	}
+	else
+	{
+		if (panel.arguments == 2)
+		{
+			panel.firstPage = panel.page = byte;
+		}
+		else
+		{
+			panel.lastPage = byte;
+		}
+	}
+	panel.arguments--;
+}
+
+static void panelData(uint8_t byte)
+{
+	panel.ram[panel.page * OLED_XSIZE + panel.column] = byte;
+
+	panel.minColumn = min<int16_t>(panel.minColumn, panel.column);
+	panel.maxColumn = max<int16_t>(panel.maxColumn, panel.column);
+	panel.minPage   = min<int16_t>(panel.minPage, panel.page);
+	panel.maxPage   = max<int16_t>(panel.maxPage, panel.page);
+
+	if (panel.column++ == panel.lastColumn)
+	{
+		panel.column = panel.firstColumn;
+		panel.page = (panel.page == panel.lastPage) ? panel.firstPage : panel.page + 1;
+	}
+}
+
+static void onTransmission(uint8_t address, const uint8_t *data, uint16_t length)
+{
+	TEST_ASSERT_EQUAL_HEX8(OLED_ADDRESS, address);
+	TEST_ASSERT_TRUE(length >= 2);
+
+	if (data[0] == CONTROL_COMMAND)
+	{
+		TEST_ASSERT_EQUAL(2, length);
+		panelCommand(data[1]);
+		return;
+	}
+
+	TEST_ASSERT_EQUAL_HEX8(CONTROL_DATA, data[0]);
+	TEST_ASSERT_TRUE(length <= OLED_I2C_CHUNK + 1);
+	for (uint16_t ix = 1; ix < length; ix++)
+	{
+		panelData(data[ix]);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+class oledTestDisplay : public oledDisplay {
+public:
+	uint8_t *frame(void) { return display->buffer; }
+	void render(const oled_dashboard_t *values) { renderDashboard(values); flushFrame(); }
+};
+
+static oledTestDisplay oled;
+
+void setUp(void)
+{
+	simReset();
+	oled.init();
+
+	memset(&panel, 0, sizeof(panel));
+	panelResetTouched();
+	simWireReset();
+	simWire().onTransmission = onTransmission;
+}
+
+void tearDown(void)
+{
+}
+
+static void resetCounters(void)
+{
+	panelResetTouched();
+	simWire().transactions = 0;
+	simWire().bytes = 0;
+}
+
+static void assertPanelShowsFrame(void)
+{
+	TEST_ASSERT_EQUAL_HEX8_ARRAY(oled.frame(), panel.ram, OLED_FRAME_SIZE);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_unchanged_frame_sends_nothing(void)
+{
+	oled.flush();
+
+	TEST_ASSERT_EQUAL_UINT32(0, simWire().transactions);
+	TEST_ASSERT_EQUAL_UINT32(0, oled.getBytesSent());
+}
+
+void test_single_byte_change(void)
+{
+	oled.frame()[3 * OLED_XSIZE + 40] = 0x55;
+	oled.flush();
+
+	// window + control byte + the data byte
+	TEST_ASSERT_EQUAL_UINT32(WINDOW_BYTES + 2, simWire().bytes);
+	TEST_ASSERT_EQUAL_UINT32(WINDOW_COMMANDS + 1, simWire().transactions);
+	TEST_ASSERT_EQUAL_UINT32(simWire().bytes, oled.getBytesSent());
+	TEST_ASSERT_EQUAL(40, panel.minColumn);
+	TEST_ASSERT_EQUAL(40, panel.maxColumn);
+	TEST_ASSERT_EQUAL(3, panel.minPage);
+	assertPanelShowsFrame();
+}
+
+// only the span between the first and the last changed column goes out
+
+void test_changed_span_of_a_page(void)
+{
+	oled.frame()[5 * OLED_XSIZE + 10]  = 0x01;
+	oled.frame()[5 * OLED_XSIZE + 100] = 0x80;
+	oled.flush();
+
+	// 91 columns in 6 chunks of at most 16
+	TEST_ASSERT_EQUAL_UINT32(WINDOW_BYTES + 91 + 6, simWire().bytes);
+	TEST_ASSERT_EQUAL_UINT32(WINDOW_COMMANDS + 6, simWire().transactions);
+	TEST_ASSERT_EQUAL(10, panel.minColumn);
+	TEST_ASSERT_EQUAL(100, panel.maxColumn);
+	assertPanelShowsFrame();
+}
+
+void test_full_frame(void)
+{
+	for (uint16_t ix = 0; ix < OLED_FRAME_SIZE; ix++)
+	{
+		oled.frame()[ix] = (uint8_t)(ix * 13 + 1);
+	}
+	oled.flush();
+
+	TEST_ASSERT_EQUAL_UINT32(OLED_NPAGES * (WINDOW_BYTES + OLED_XSIZE + OLED_XSIZE / OLED_I2C_CHUNK),
+							 simWire().bytes);
+	assertPanelShowsFrame();
+
+	resetCounters();
+	oled.flush();
+	TEST_ASSERT_EQUAL_UINT32(0, simWire().bytes);
+}
+
+// update() coalesces the lines written within the flush interval
+
+void test_update_coalesces_writes(void)
+{
+	oled.writeLine(0, "one", ALIGN_LEFT);
+	oled.writeLine(1, "two", ALIGN_RIGHT);
+	oled.update();
+	TEST_ASSERT_EQUAL_UINT32(0, simWire().transactions);
+
+	simAdvanceUs(OLED_FLUSH_INTERVAL_MS * 1000);
+	oled.update();
+	TEST_ASSERT_TRUE(simWire().transactions > 0);
+	assertPanelShowsFrame();
+
+	resetCounters();
+	simAdvanceUs(OLED_FLUSH_INTERVAL_MS * 1000);
+	oled.update();
+	TEST_ASSERT_EQUAL_UINT32(0, simWire().transactions);
+}
+
+// a dashboard refresh only sends the value that changed
+
+void test_dashboard_sends_changed_values_only(void)
+{
+	oled_dashboard_t values;
+
+	memset(&values, 0, sizeof(values));
+	values.freeHeap = 123456;
+	values.clients  = 1;
+
+	oled.render(&values);
+	assertPanelShowsFrame();
+
+	resetCounters();
+	simAdvanceUs(OLED_DASHBOARD_PERIOD_MS * 1000);
+	oled.render(&values);
+	TEST_ASSERT_EQUAL_UINT32(0, simWire().bytes);
+
+	values.clients = 2;
+	simAdvanceUs(OLED_DASHBOARD_PERIOD_MS * 1000);
+	oled.render(&values);
+
+	TEST_ASSERT_TRUE(simWire().bytes > 0);
+	// the client count is the right half of the last row
+	TEST_ASSERT_TRUE(simWire().bytes < WINDOW_BYTES * 2 + 2 * (OLED_XSIZE / 2) + 16);
+	TEST_ASSERT_TRUE(panel.minColumn >= OLED_XSIZE / 2);
+	TEST_ASSERT_TRUE(panel.minPage >= (3 * OLED_DASHBOARD_ROW_HEIGHT) / 8);
+	assertPanelShowsFrame();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_unchanged_frame_sends_nothing);
+	RUN_TEST(test_single_byte_change);
+	RUN_TEST(test_changed_span_of_a_page);
+	RUN_TEST(test_full_frame);
+	RUN_TEST(test_update_coalesces_writes);
+	RUN_TEST(test_dashboard_sends_changed_values_only);
+
+	return UNITY_END();
+}
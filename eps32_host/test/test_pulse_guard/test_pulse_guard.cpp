@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_pulse_guard.cpp
+//
+// endstop guards on the simulated GPIO: edges injected with simSetInput()
+// run the guard ISR, the tests check the halt, the cut pulse count, the
+// start refusal on an already active pin and the interrupt ownership shared
+// with the input event log
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "pulse_lib.h"
+#include "pulse_guard.h"
+#include "event_lib.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define N_CHANNELS			2
+#define OUTPUT_PIN_0		25
+#define OUTPUT_PIN_1		26
+#define GUARD_PIN			34			// GPIO32..39 port
+#define GUARD_PIN_LOW		4			// GPIO0..31 port, active low
+
+#define PULSE_MS			10
+#define PAUSE_MS			10
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static PulseLib    channels[N_CHANNELS];
+static PulseGuard  guard;
+static inputEvents events;
+
+void setUp(void)
+{
+	simReset();
+
+	channels[0] = PulseLib();
+	channels[1] = PulseLib();
+	channels[0].begin(OUTPUT_PIN_0);
+	channels[1].begin(OUTPUT_PIN_1);
+
+	guard = PulseGuard();
+	guard.begin(channels, N_CHANNELS);
+	events.init();
+
+	simSetInput(GUARD_PIN_LOW, HIGH);
+}
+
+void tearDown(void)
+{
+	guard.unbind(GUARD_PIN);
+	guard.unbind(GUARD_PIN_LOW);
+	events.disableAll();
+}
+
+// ticks the channels for ms milliseconds in 1 ms steps
+
+static void runMs(uint32_t ms)
+{
+	for (uint32_t step = 0; step < ms; step++)
+	{
+		simAdvanceUs(1000);
+		channels[0].tick();
+		channels[1].tick();
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_edge_halts_bound_channel(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+	TEST_ASSERT_TRUE(channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 5));
+	TEST_ASSERT_TRUE(channels[1].generetePulsesAsync(PULSE_MS, PAUSE_MS, 5));
+
+	// second pulse is high
+	runMs(PAUSE_MS + PULSE_MS + PAUSE_MS + 1);
+	TEST_ASSERT_EQUAL(HIGH, simGetLevel(OUTPUT_PIN_0));
+	TEST_ASSERT_EQUAL(3, channels[0].getRemainingPulses());
+
+	simSetInput(GUARD_PIN, HIGH);
+
+	TEST_ASSERT_FALSE(channels[0].isPulsing());
+	TEST_ASSERT_EQUAL(LOW, simGetLevel(OUTPUT_PIN_0));
+	TEST_ASSERT_EQUAL(GUARD_PIN, channels[0].getHaltReason());
+	TEST_ASSERT_EQUAL(4, channels[0].getCutPulses());
+
+	// not bound, keeps running
+	TEST_ASSERT_TRUE(channels[1].isPulsing());
+	TEST_ASSERT_EQUAL(PULSE_HALT_NONE, channels[1].getHaltReason());
+}
+
+void test_pin_guards_several_channels(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN_LOW, 0, LOW));
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN_LOW, 1, LOW));
+	TEST_ASSERT_FALSE(guard.bind(GUARD_PIN_LOW, 1, HIGH));
+
+	channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3);
+	channels[1].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3);
+	runMs(PAUSE_MS + PULSE_MS + 1);
+
+	simSetInput(GUARD_PIN_LOW, LOW);
+
+	TEST_ASSERT_FALSE(channels[0].isPulsing());
+	TEST_ASSERT_FALSE(channels[1].isPulsing());
+	TEST_ASSERT_EQUAL(GUARD_PIN_LOW, channels[0].getHaltReason());
+	TEST_ASSERT_EQUAL(GUARD_PIN_LOW, channels[1].getHaltReason());
+	TEST_ASSERT_EQUAL(2, channels[0].getCutPulses());
+}
+
+// the inactive edge of a bouncing input does not halt
+
+void test_inactive_edge_is_ignored(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+	channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3);
+
+	simSetInput(GUARD_PIN, LOW);
+	runMs(1);
+
+	TEST_ASSERT_TRUE(channels[0].isPulsing());
+	TEST_ASSERT_EQUAL(PULSE_HALT_NONE, channels[0].getHaltReason());
+	TEST_ASSERT_FALSE(guard.isTripped(GUARD_PIN));
+}
+
+// no edge will come for a pin that is already active: the train does not
+// start and the halt is latched with every pulse cut
+
+void test_start_refused_on_active_pin(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+	simSetInput(GUARD_PIN, HIGH);
+	TEST_ASSERT_TRUE(guard.isTripped(GUARD_PIN));
+
+	TEST_ASSERT_FALSE(channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 7));
+	TEST_ASSERT_FALSE(channels[0].isPulsing());
+	TEST_ASSERT_EQUAL(LOW, simGetLevel(OUTPUT_PIN_0));
+	TEST_ASSERT_EQUAL(GUARD_PIN, channels[0].getHaltReason());
+	TEST_ASSERT_EQUAL(7, channels[0].getCutPulses());
+
+	channels[0].clearHalt();
+	TEST_ASSERT_FALSE(channels[0].pulseAsync(PULSE_MS));
+	TEST_ASSERT_EQUAL(LOW, simGetLevel(OUTPUT_PIN_0));
+	TEST_ASSERT_EQUAL(1, channels[0].getCutPulses());
+
+	channels[0].clearHalt();
+	channels[0].pulse(PULSE_MS);
+	TEST_ASSERT_EQUAL(GUARD_PIN, channels[0].getHaltReason());
+
+	// other channel is not guarded by the pin
+	TEST_ASSERT_TRUE(channels[1].generetePulsesAsync(PULSE_MS, PAUSE_MS, 7));
+}
+
+void test_bind_on_active_pin_halts_at_once(void)
+{
+	channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3);
+	runMs(PAUSE_MS + 1);
+	simSetInput(GUARD_PIN, HIGH);
+
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+
+	TEST_ASSERT_FALSE(channels[0].isPulsing());
+	TEST_ASSERT_EQUAL(GUARD_PIN, channels[0].getHaltReason());
+	TEST_ASSERT_EQUAL(3, channels[0].getCutPulses());
+}
+
+void test_unbind_releases_channel(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+	TEST_ASSERT_TRUE(guard.unbind(GUARD_PIN));
+	TEST_ASSERT_FALSE(guard.unbind(GUARD_PIN));
+
+	simSetInput(GUARD_PIN, HIGH);
+	TEST_ASSERT_TRUE(channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3));
+	simSetInput(GUARD_PIN, LOW);
+	simSetInput(GUARD_PIN, HIGH);
+	TEST_ASSERT_TRUE(channels[0].isPulsing());
+}
+
+// one interrupt handler per GPIO, the guard and the event log refuse each
+// other's pins
+
+void test_guard_and_events_do_not_share_pins(void)
+{
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN, 0, HIGH));
+	TEST_ASSERT_FALSE(events.enable(GUARD_PIN));
+	TEST_ASSERT_EQUAL(GPIO_IRQ_PULSE_GUARD, gpioIrqOwner(GUARD_PIN));
+
+	TEST_ASSERT_TRUE(events.enable(GUARD_PIN_LOW));
+	TEST_ASSERT_FALSE(guard.bind(GUARD_PIN_LOW, 0, LOW));
+
+	// the guard handler is still the one attached
+	channels[0].generetePulsesAsync(PULSE_MS, PAUSE_MS, 3);
+	simSetInput(GUARD_PIN, HIGH);
+	TEST_ASSERT_FALSE(channels[0].isPulsing());
+	TEST_ASSERT_EQUAL(0, events.available());
+
+	TEST_ASSERT_TRUE(guard.unbind(GUARD_PIN));
+	TEST_ASSERT_TRUE(events.enable(GUARD_PIN));
+	TEST_ASSERT_TRUE(events.disable(GUARD_PIN_LOW));
+	TEST_ASSERT_TRUE(guard.bind(GUARD_PIN_LOW, 0, LOW));
+}
+
+void test_bind_rejects_bad_arguments(void)
+{
+	TEST_ASSERT_FALSE(guard.bind(GUARD_PIN, N_CHANNELS, HIGH));
+	TEST_ASSERT_FALSE(guard.bind(GUARD_PIN, 0, 2));
+	TEST_ASSERT_FALSE(guard.bind(40, 0, HIGH));
+	TEST_ASSERT_EQUAL(GPIO_IRQ_FREE, gpioIrqOwner(GUARD_PIN));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_edge_halts_bound_channel);
+	RUN_TEST(test_pin_guards_several_channels);
+	RUN_TEST(test_inactive_edge_is_ignored);
+	RUN_TEST(test_start_refused_on_active_pin);
+	RUN_TEST(test_bind_on_active_pin_halts_at_once);
+	RUN_TEST(test_unbind_releases_channel);
+	RUN_TEST(test_guard_and_events_do_not_share_pins);
+	RUN_TEST(test_bind_rejects_bad_arguments);
+
+	return UNITY_END();
+}
@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// test_rpc_params.cpp
+//
+// typed parameter binding of the RPC server: defaults, range & type checks,
+// keep flags and the positional binding of prepared calls, and the cost of a
+// captureArm sized bind against the containsKey() pattern it replaced
+//
+// RpcServer itself needs WiFi, so rpc_params.cpp is compiled in directly
+//
+///////////////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////////////
+// system #includes
+
+#include <unity.h>
+#include <chrono>
+#include <ArduinoJson.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// application #includes
+
+#include "rpc_params.h"
+#include "../../lib/rpc_server/src/rpc_params.cpp"
+
+///////////////////////////////////////////////////////////////////////////////
+// #define's
+
+#define MAX_CHANNEL			7
+#define MAX_LEVEL			4095
+#define BENCH_ROUNDS		100000
+
+///////////////////////////////////////////////////////////////////////////////
+// parameter tables
+
+typedef struct
+{
+	uint8_t  channel;
+	uint16_t count;
+	int16_t  offset;
+	float    alpha;
+	bool     reset;
+	const char *name;
+} sample_params_t;
+
+static constexpr rpc_param_t SAMPLE_PARAMS[] =
+{
+	RPC_REQUIRED_RANGE(sample_params_t, channel, 0, MAX_CHANNEL),
+	RPC_OPTIONAL_RANGE(sample_params_t, count, 1, 1000, 10),
+	RPC_OPTIONAL(sample_params_t, offset, -5),
+	RPC_OPTIONAL_RANGE(sample_params_t, alpha, 0.0, 1.0, 0.5),
+	RPC_OPTIONAL(sample_params_t, reset, true),
+	RPC_OPTIONAL(sample_params_t, name, 0),
+};
+
+typedef struct
+{
+	rpc_flag_t enable;
+	uint8_t    mode;
+} keep_params_t;
+
+#define MODE_KEEP			0xFF
+
+static constexpr rpc_param_t KEEP_PARAMS[] =
+{
+	RPC_OPTIONAL(keep_params_t, enable, RPC_FLAG_KEEP),
+	RPC_OPTIONAL_RANGE(keep_params_t, mode, 0, 3, MODE_KEEP),
+};
+
+// the parameters of captureArm
+typedef struct
+{
+	JsonArray channels;
+	uint8_t   trigger;
+	uint8_t   source;
+	uint16_t  level;
+	uint16_t  hysteresis;
+	uint16_t  pre;
+	uint16_t  post;
+} capture_params_t;
+
+static constexpr rpc_param_t CAPTURE_PARAMS[] =
+{
+	RPC_REQUIRED(capture_params_t, channels),
+	RPC_OPTIONAL_RANGE(capture_params_t, trigger, 0, 4, 0),
+	RPC_OPTIONAL(capture_params_t, source, 0),
+	RPC_OPTIONAL_RANGE(capture_params_t, level, 0, MAX_LEVEL, 0),
+	RPC_OPTIONAL_RANGE(capture_params_t, hysteresis, 0, MAX_LEVEL, 0),
+	RPC_REQUIRED(capture_params_t, pre),
+	RPC_REQUIRED(capture_params_t, post),
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// globals
+
+static DynamicJsonDocument doc(1024);
+
+// the params object of a request
+static JsonObject request(const char *json)
+{
+	TEST_ASSERT_TRUE(deserializeJson(doc, json) == DeserializationError::Ok);
+	return doc.as<JsonObject>();
+}
+
+// captureArm before the binding: a containsKey() per optional field and a
+// second lookup for its value, without type or range checks
+static bool referenceCaptureBind(JsonObject params, capture_params_t *p)
+{
+	if (!params.containsKey("channels") || !params.containsKey("pre") || !params.containsKey("post"))
+	{
+		return false;
+	}
+	p->channels   = params["channels"].as<JsonArray>();
+	p->trigger    = params.containsKey("trigger") ? params["trigger"].as<uint8_t>() : 0;
+	p->source     = params.containsKey("source") ? params["source"].as<uint8_t>() : 0;
+	p->level      = params.containsKey("level") ? params["level"].as<uint16_t>() : 0;
+	p->hysteresis = params.containsKey("hysteresis") ? params["hysteresis"].as<uint16_t>() : 0;
+	p->pre        = params["pre"].as<uint16_t>();
+	p->post       = params["post"].as<uint16_t>();
+	return true;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// tests
+
+void test_missing_optional_fields_get_defaults(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{\"channel\": 3}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_EQUAL(3, p.channel);
+	TEST_ASSERT_EQUAL(10, p.count);
+	TEST_ASSERT_EQUAL(-5, p.offset);
+	TEST_ASSERT_TRUE(fabs(p.alpha - 0.5) <= 1e-6);
+	TEST_ASSERT_TRUE(p.reset);
+	TEST_ASSERT_NULL(p.name);
+}
+
+void test_request_values_are_stored(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{\"name\": \"x\", \"reset\": false, \"alpha\": 0.25, "
+										   "\"offset\": -300, \"count\": 1000, \"channel\": 7}"),
+								   SAMPLE_PARAMS, &p));
+	TEST_ASSERT_EQUAL(7, p.channel);
+	TEST_ASSERT_EQUAL(1000, p.count);
+	TEST_ASSERT_EQUAL(-300, p.offset);
+	TEST_ASSERT_TRUE(fabs(p.alpha - 0.25) <= 1e-6);
+	TEST_ASSERT_FALSE(p.reset);
+	TEST_ASSERT_EQUAL_STRING("x", p.name);
+}
+
+void test_missing_required_field_fails(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_FALSE(rpcBindParams(request("{}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"count\": 5}"), SAMPLE_PARAMS, &p));
+}
+
+void test_out_of_range_fails(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 8}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 0, \"count\": 0}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 0, \"alpha\": 1.5}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 0, \"offset\": 40000}"), SAMPLE_PARAMS, &p));
+}
+
+// a negative number must not wrap into an unsigned field
+void test_negative_into_unsigned_fails(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": -1}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 1, \"count\": -1}"), SAMPLE_PARAMS, &p));
+}
+
+void test_wrong_type_fails(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": \"1\"}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 1.5}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 1, \"name\": 5}"), SAMPLE_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"channel\": 1, \"reset\": 2}"), SAMPLE_PARAMS, &p));
+}
+
+void test_unknown_keys_are_ignored(void)
+{
+	sample_params_t p;
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{\"verbose\": true, \"channel\": 2, \"other\": [1, 2]}"),
+								   SAMPLE_PARAMS, &p));
+	TEST_ASSERT_EQUAL(2, p.channel);
+}
+
+// a flag left out keeps the setting, a default outside the range does the
+// same for a number
+void test_keep_defaults(void)
+{
+	keep_params_t p;
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{}"), KEEP_PARAMS, &p));
+	TEST_ASSERT_EQUAL(RPC_FLAG_KEEP, p.enable);
+	TEST_ASSERT_EQUAL(MODE_KEEP, p.mode);
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{\"enable\": true, \"mode\": 3}"), KEEP_PARAMS, &p));
+	TEST_ASSERT_EQUAL(RPC_FLAG_TRUE, p.enable);
+	TEST_ASSERT_EQUAL(3, p.mode);
+
+	TEST_ASSERT_TRUE(rpcBindParams(request("{\"enable\": 0}"), KEEP_PARAMS, &p));
+	TEST_ASSERT_EQUAL(RPC_FLAG_FALSE, p.enable);
+
+	// the sentinel itself is not a valid request value
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"mode\": 255}"), KEEP_PARAMS, &p));
+	TEST_ASSERT_FALSE(rpcBindParams(request("{\"enable\": 2}"), KEEP_PARAMS, &p));
+}
+
+void test_positional_values(void)
+{
+	const uint8_t layout[] = { 1, 0 };			// count, channel
+	const uint8_t missingChannel[] = { 1 };
+	const uint8_t twice[] = { 0, 0 };
+	sample_params_t p;
+
+	TEST_ASSERT_TRUE(rpcCheckLayout(SAMPLE_PARAMS, 6, layout, 2));
+	TEST_ASSERT_FALSE(rpcCheckLayout(SAMPLE_PARAMS, 6, missingChannel, 1));
+	TEST_ASSERT_FALSE(rpcCheckLayout(SAMPLE_PARAMS, 6, twice, 2));
+	TEST_ASSERT_EQUAL(3, rpcFindField(SAMPLE_PARAMS, 6, "alpha"));
+	TEST_ASSERT_EQUAL(-1, rpcFindField(SAMPLE_PARAMS, 6, "beta"));
+
+	TEST_ASSERT_TRUE(deserializeJson(doc, "[20, 4]") == DeserializationError::Ok);
+	TEST_ASSERT_TRUE(rpcBindValues(doc.as<JsonArray>(), SAMPLE_PARAMS, 6, layout, 2, &p));
+	TEST_ASSERT_EQUAL(4, p.channel);
+	TEST_ASSERT_EQUAL(20, p.count);
+	TEST_ASSERT_EQUAL(-5, p.offset);
+
+	// too few, too many or out of range values
+	TEST_ASSERT_TRUE(deserializeJson(doc, "[20]") == DeserializationError::Ok);
+	TEST_ASSERT_FALSE(rpcBindValues(doc.as<JsonArray>(), SAMPLE_PARAMS, 6, layout, 2, &p));
+	TEST_ASSERT_TRUE(deserializeJson(doc, "[20, 4, 1]") == DeserializationError::Ok);
+	TEST_ASSERT_FALSE(rpcBindValues(doc.as<JsonArray>(), SAMPLE_PARAMS, 6, layout, 2, &p));
+	TEST_ASSERT_TRUE(deserializeJson(doc, "[20, 9]") == DeserializationError::Ok);
+	TEST_ASSERT_FALSE(rpcBindValues(doc.as<JsonArray>(), SAMPLE_PARAMS, 6, layout, 2, &p));
+}
+
+// a full captureArm request, bound both ways: same values, and the time per
+// bind printed for comparison
+void test_bench_capture_arm_bind(void)
+{
+	JsonObject params = request("{\"channels\": [0, 1, 2, 3], \"trigger\": 1, \"source\": 2, "
+								"\"level\": 2048, \"hysteresis\": 16, \"pre\": 100, \"post\": 400}");
+	capture_params_t bound;
+	capture_params_t reference;
+	uint32_t sink = 0;
+
+	TEST_ASSERT_TRUE(rpcBindParams(params, CAPTURE_PARAMS, &bound));
+	TEST_ASSERT_TRUE(referenceCaptureBind(params, &reference));
+	TEST_ASSERT_EQUAL(reference.channels.size(), bound.channels.size());
+	TEST_ASSERT_EQUAL(reference.trigger, bound.trigger);
+	TEST_ASSERT_EQUAL(reference.source, bound.source);
+	TEST_ASSERT_EQUAL(reference.level, bound.level);
+	TEST_ASSERT_EQUAL(reference.hysteresis, bound.hysteresis);
+	TEST_ASSERT_EQUAL(reference.pre, bound.pre);
+	TEST_ASSERT_EQUAL(reference.post, bound.post);
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		sink += rpcBindParams(params, CAPTURE_PARAMS, &bound) ? bound.post : 0;
+	}
+	auto t1 = std::chrono::steady_clock::now();
+	for (uint32_t round = 0; round < BENCH_ROUNDS; round++)
+	{
+		sink += referenceCaptureBind(params, &reference) ? reference.post : 0;
+	}
+	auto t2 = std::chrono::steady_clock::now();
+
+	printf("test_rpc_params: %.1f ns per bind, %.1f ns per containsKey lookup\n",
+		   std::chrono::duration<double, std::nano>(t1 - t0).count() / BENCH_ROUNDS,
+		   std::chrono::duration<double, std::nano>(t2 - t1).count() / BENCH_ROUNDS);
+
+	TEST_ASSERT_EQUAL(2 * 400 * BENCH_ROUNDS, sink);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// int main(void)
+
+int main(void)
+{
+	UNITY_BEGIN();
+
+	RUN_TEST(test_missing_optional_fields_get_defaults);
+	RUN_TEST(test_request_values_are_stored);
+	RUN_TEST(test_missing_required_field_fails);
+	RUN_TEST(test_out_of_range_fails);
+	RUN_TEST(test_negative_into_unsigned_fails);
+	RUN_TEST(test_wrong_type_fails);
+	RUN_TEST(test_unknown_keys_are_ignored);
+	RUN_TEST(test_keep_defaults);
+	RUN_TEST(test_positional_values);
+	RUN_TEST(test_bench_capture_arm_bind);
+
+	return UNITY_END();
+}
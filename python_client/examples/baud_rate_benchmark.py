@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+ESP32 RPC Baud Rate Benchmark
+
+Switches the USB serial link to each baud rate with setBaudRate and measures
+round trips and response throughput at that rate. Ends at the start rate.
+"""
+
+import sys
+import os
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..')))
+
+import json
+import time
+import argparse
+import logging
+from library.rpc_client import RPCClient
+from library.config import COMM_USB, RPC_OK, setup_logging
+
+# Setup logger
+logger = logging.getLogger(__name__)
+
+DEFAULT_RATES = [115200, 230400, 460800, 921600, 1500000, 2000000]
+
+
+def benchmark(client, requests):
+    """Time small and large requests at the current rate"""
+    start = time.perf_counter()
+    for _ in range(requests):
+        client.getMillis()
+    small_s = time.perf_counter() - start
+
+    response_bytes = 0
+    start = time.perf_counter()
+    for _ in range(requests):
+        result, msg, data = client.call_raw("bootProfile", {})
+        if result == RPC_OK:
+            response_bytes += len(json.dumps(data))
+    large_s = time.perf_counter() - start
+
+    return small_s / requests * 1000.0, response_bytes / large_s / 1024.0
+
+
+def main():
+    # Parse command line arguments
+    parser = argparse.ArgumentParser(description='ESP32 RPC Baud Rate Benchmark')
+    parser.add_argument('-d', '--debug', type=int, choices=[0, 1, 2, 3, 4], default=0,
+                        help='Debug level: 0=None, 1=Error, 2=Warning, 3=Info, 4=Verbose (default: 0)')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0',
+                        help='Serial port (default: /dev/ttyUSB0)')
+    parser.add_argument('-n', '--requests', type=int, default=50,
+                        help='Requests per measurement (default: 50)')
+    parser.add_argument('-r', '--rates', type=int, nargs='+', default=DEFAULT_RATES,
+                        help='Baud rates to test')
+    args = parser.parse_args()
+
+    setup_logging(debug_level=args.debug)
+
+    client = RPCClient(comm_mode=COMM_USB, port=args.port)
+    success, msg = client.connect()
+    if not success:
+        print(f"Connection failed: {msg}")
+        return
+
+    start_rate = client.transport.baudrate
+    print(f"{'baud':>10} {'round trip ms':>14} {'KB/s':>8}")
+    try:
+        for rate in args.rates:
+            result, msg = client.setBaudRate(rate)
+            if result != RPC_OK:
+                print(f"{rate:>10} {'failed: ' + msg:>24}")
+                continue
+            round_trip_ms, kbytes_s = benchmark(client, args.requests)
+            print(f"{rate:>10} {round_trip_ms:>14.2f} {kbytes_s:>8.1f}")
+    finally:
+        client.setBaudRate(start_rate)
+        client.disconnect()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+"""
+ESP32 RPC Transient Capture
+
+Arms a triggered burst capture on ADC channels, waits for the trigger and
+writes the block to a CSV file: time relative to the trigger in microseconds
+and the raw value of every channel.
+"""
+
+import sys
+import os
+sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '..')))
+
+import csv
+import time
+import argparse
+import logging
+from library.rpc_client import RPCClient
+from library.config import (COMM_USB, COMM_WIFI, RPC_OK, CAPTURE_TRIGGER_NOW, CAPTURE_TRIGGER_RISING,
+                            CAPTURE_TRIGGER_FALLING, CAPTURE_TRIGGER_DIO_RISING,
+                            CAPTURE_TRIGGER_DIO_FALLING, setup_logging)
+
+# Setup logger
+logger = logging.getLogger(__name__)
+
+TRIGGERS = {
+    'now': CAPTURE_TRIGGER_NOW,
+    'rising': CAPTURE_TRIGGER_RISING,
+    'falling': CAPTURE_TRIGGER_FALLING,
+    'dio-rising': CAPTURE_TRIGGER_DIO_RISING,
+    'dio-falling': CAPTURE_TRIGGER_DIO_FALLING,
+}
+
+
+def main():
+    # Parse command line arguments
+    parser = argparse.ArgumentParser(description='ESP32 RPC Transient Capture')
+    parser.add_argument('-d', '--debug', type=int, choices=[0, 1, 2, 3, 4], default=0,
+                        help='Debug level: 0=None, 1=Error, 2=Warning, 3=Info, 4=Verbose (default: 0)')
+    parser.add_argument('-p', '--port', default='/dev/ttyUSB0',
+                        help='Serial port (default: /dev/ttyUSB0)')
+    parser.add_argument('--host', help='Connect over WiFi to this host instead of USB')
+    parser.add_argument('-c', '--channels', type=int, nargs='+', default=[0],
+                        help='ADC channels to capture (default: 0)')
+    parser.add_argument('-t', '--trigger', choices=TRIGGERS.keys(), default='rising',
+                        help='Trigger (default: rising)')
+    parser.add_argument('-s', '--source', type=int, default=0,
+                        help='Trigger ADC channel or DIO input bit (default: 0)')
+    parser.add_argument('-l', '--level', type=int, default=2048,
+                        help='Raw trigger level (default: 2048)')
+    parser.add_argument('--hysteresis', type=int, default=20,
+                        help='Raw trigger hysteresis (default: 20)')
+    parser.add_argument('--pre', type=int, default=200,
+                        help='Scans before the trigger (default: 200)')
+    parser.add_argument('--post', type=int, default=799,
+                        help='Scans after the trigger (default: 799)')
+    parser.add_argument('--timeout', type=float, default=10.0,
+                        help='Seconds to wait for the trigger (default: 10)')
+    parser.add_argument('-o', '--output', default='capture.csv',
+                        help='CSV output file (default: capture.csv)')
+    args = parser.parse_args()
+
+    setup_logging(debug_level=args.debug)
+
+    if args.host:
+        client = RPCClient(comm_mode=COMM_WIFI, host=args.host)
+    else:
+        client = RPCClient(comm_mode=COMM_USB, port=args.port)
+    success, msg = client.connect()
+    if not success:
+        print(f"Connection failed: {msg}")
+        return
+
+    try:
+        result, msg = client.captureArm(args.channels, args.pre, args.post, TRIGGERS[args.trigger],
+                                        args.source, args.level, args.hysteresis)
+        if result != RPC_OK:
+            print(f"captureArm failed: {msg}")
+            return
+
+        deadline = time.time() + args.timeout
+        state = None
+        while time.time() < deadline:
+            result, msg, status = client.captureStatus()
+            state = status.get('state') if status else None
+            if state == 'done':
+                break
+            time.sleep(0.1)
+
+        if state != 'done':
+            print("No trigger, capture stopped")
+            client.captureStop()
+            return
+
+        result, msg, capture = client.captureRead()
+        if result != RPC_OK:
+            print(f"captureRead failed: {msg}")
+            return
+
+        with open(args.output, 'w', newline='') as csv_file:
+            writer = csv.writer(csv_file)
+            writer.writerow(['time_us'] + [f"ch{channel}" for channel in capture['channels']])
+            for ix, time_us in enumerate(capture['time_us']):
+                writer.writerow([f"{time_us:.3f}"] + [capture['raw'][channel][ix] for channel in capture['channels']])
+
+        span_us = capture['time_us'][-1] - capture['time_us'][0]
+        scans = len(capture['time_us'])
+        print(f"{scans} scans over {span_us:.0f} us ({scans / span_us * 1e6:.0f} scans/s) written to {args.output}")
+    finally:
+        client.disconnect()
+
+
+if __name__ == "__main__":
+    main()
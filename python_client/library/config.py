@@ -13,6 +13,19 @@ RPC_ERROR_TIMEOUT = 3
 RPC_ERROR_EXECUTION = 4
 RPC_ERROR_NOT_SUPPORTED = 5
 
+# DAC waveform shapes (waveSetup)
+WAVE_SHAPE_SINE = 0
+WAVE_SHAPE_TRIANGLE = 1
+WAVE_SHAPE_RAMP = 2
+WAVE_SHAPE_TABLE = 3
+
+# ADC capture triggers (captureArm)
+CAPTURE_TRIGGER_NOW = 0
+CAPTURE_TRIGGER_RISING = 1
+CAPTURE_TRIGGER_FALLING = 2
+CAPTURE_TRIGGER_DIO_RISING = 3
+CAPTURE_TRIGGER_DIO_FALLING = 4
+
 # Communication Mode
 COMM_USB = 0
 COMM_WIFI = 1
@@ -4,11 +4,15 @@ ESP32 RPC Client Library
 Provides easy-to-use interface for calling RPC functions on ESP32
 """
 
+import base64
 import json
 import logging
-from typing import Optional, Dict, Any, Tuple
+import struct
+import time
+from typing import Optional, Dict, Any, Tuple, List
 from .transport import Transport, TransportFactory
-from .config import CONFIG, RPC_OK, COMM_USB, RPC_ERROR_TIMEOUT, get_result_message
+from .config import (CONFIG, RPC_OK, COMM_USB, RPC_ERROR_INVALID_COMMAND, RPC_ERROR_TIMEOUT,
+                     RPC_ERROR_EXECUTION, RPC_ERROR_NOT_SUPPORTED, CAPTURE_TRIGGER_NOW, get_result_message)
 
 # Setup logger
 logger = logging.getLogger(__name__)
@@ -29,6 +33,9 @@ class RPCClient:
         self.transport = TransportFactory.create(comm_mode, **kwargs)
         self._connected = False
         self._request_id = 0
+        self._prepared_methods = set()   # methods sent as invoke frames
+        self._prepared = {}              # (method, parameter names) -> handle
+        self._events = []                # event lines received between responses
         logger.debug(f"RPCClient initialized with transport: {type(self.transport).__name__}")
         
     def connect(self) -> Tuple[bool, str]:
@@ -41,6 +48,7 @@ class RPCClient:
         logger.info("Attempting to connect to ESP32...")
         if self.transport.connect():
             self._connected = True
+            self._prepared.clear()
             logger.info("Successfully connected to ESP32")
             return True, "Connected successfully"
         else:
@@ -71,13 +79,55 @@ class RPCClient:
             logger.warning("Command attempted while not connected")
             return RPC_ERROR_TIMEOUT, "Not connected to device", {}
         
+        if method in self._prepared_methods and params:
+            return self._send_prepared(method, params)
+
         # Build request
         request = {
             "method": method,
             "params": params or {}
         }
-        
-        request_str = json.dumps(request)
+        return self._exchange(method, request)
+
+    def _send_prepared(self, method: str, params: Dict[str, Any]) -> Tuple[int, str, Dict[str, Any]]:
+        """
+        Send a call as an invoke frame of a prepared handle. The method is
+        prepared on first use for its parameter names, a handle the device
+        no longer knows (after a reset) is prepared again once.
+
+        Returns:
+            (result_code, message, data) tuple
+        """
+        names = tuple(params.keys())
+        for _ in range(2):
+            handle = self._prepared.get((method, names))
+            if handle is None:
+                result, msg, handle = self.prepare(method, list(names))
+                if result == RPC_ERROR_NOT_SUPPORTED:
+                    logger.info(f"{method} can not be prepared, sending it by name")
+                    self._prepared_methods.discard(method)
+                    return self._send_command(method, params)
+                if result != RPC_OK:
+                    return result, msg, {}
+
+            result, msg, data = self.invoke(handle, list(params.values()), method)
+            if result != RPC_ERROR_INVALID_COMMAND:
+                break
+            self._prepared.pop((method, names), None)
+        return result, msg, data
+
+    def _exchange(self, method: str, request: Dict[str, Any]) -> Tuple[int, str, Dict[str, Any]]:
+        """
+        Send a request frame and wait for its response
+
+        Returns:
+            (result_code, message, data) tuple
+        """
+        if not self.is_connected():
+            logger.warning("Command attempted while not connected")
+            return RPC_ERROR_TIMEOUT, "Not connected to device", {}
+
+        request_str = json.dumps(request, separators=(',', ':'))
         logger.debug(f"Request JSON: {request_str}")
         
         # Send request
@@ -87,13 +137,16 @@ class RPCClient:
         
         logger.debug(f"Command sent successfully: {method}")
         
-        # Receive response
-        response_str = self.transport.recv(CONFIG['timeout'])
-        if response_str is None:
-            logger.error(f"No response received for command: {method}")
-            return RPC_ERROR_TIMEOUT, "No response from device", {}
-        
-        logger.debug(f"Response received: {response_str}")
+        # Receive response, event lines in front of it are queued
+        while True:
+            response_str = self.transport.recv(CONFIG['timeout'])
+            if response_str is None:
+                logger.error(f"No response received for command: {method}")
+                return RPC_ERROR_TIMEOUT, "No response from device", {}
+
+            logger.debug(f"Response received: {response_str}")
+            if not self._queue_event(response_str):
+                break
         
         try:
             response = json.loads(response_str)
@@ -111,25 +164,54 @@ class RPCClient:
             logger.error(f"Invalid JSON response: {response_str}, error: {e}")
             return RPC_ERROR_TIMEOUT, "Invalid response format", {}
     
+    def _queue_event(self, line: str) -> bool:
+        """
+        Queue an unsolicited event line ({"event": ..., "data": {...}})
+
+        Returns:
+            True if the line was an event
+        """
+        try:
+            message = json.loads(line)
+        except json.JSONDecodeError:
+            return False
+        if not isinstance(message, dict) or 'event' not in message:
+            return False
+        logger.debug(f"Event received: {message}")
+        self._events.append(message)
+        return True
+
     # GPIO Functions
-    def pinMode(self, pin: int, mode: int) -> Tuple[int, str]:
+    def pinMode(self, pin: int, mode: int, force: bool = False) -> Tuple[int, str]:
         """
         Set pin mode (INPUT=0, OUTPUT=1, INPUT_PULLUP=2)
         
+        Args:
+            force: Reconfigure even if the pin already has this mode
+
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("pinMode", {"pin": pin, "mode": mode})
+        params = {"pin": pin, "mode": mode}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("pinMode", params)
         return result, msg
     
-    def digitalWrite(self, pin: int, value: int) -> Tuple[int, str]:
+    def digitalWrite(self, pin: int, value: int, force: bool = False) -> Tuple[int, str]:
         """
         Write digital value to pin (0 or 1)
         
+        Args:
+            force: Write even if the output already has this value
+
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("digitalWrite", {"pin": pin, "value": value})
+        params = {"pin": pin, "value": value}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("digitalWrite", params)
         return result, msg
     
     def digitalRead(self, pin: int) -> Tuple[int, str, Optional[int]]:
@@ -208,6 +290,299 @@ class RPCClient:
         value = data.get('chip_id') if (result == RPC_OK and data) else None
         return result, msg, value
     
+    def setBaudRate(self, baudrate: int) -> Tuple[int, str]:
+        """
+        Switch the USB serial link of both ends to another baud rate.
+        The new rate is confirmed with a ping, when that fails both ends
+        fall back to the previous rate. Not stored, use configSet(baud_rate=...)
+        at the new rate and configCommit() to keep the rate after a restart
+        
+        Args:
+            baudrate: New baud rate, e.g. 921600 or 2000000
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        previous = getattr(self.transport, 'baudrate', None)
+        if previous is None:
+            return RPC_ERROR_NOT_SUPPORTED, "Baud rate applies to the USB transport only"
+        
+        result, msg, data = self._send_command("setBaudRate", {"baud": baudrate})
+        if result != RPC_OK:
+            return result, msg
+        
+        # The device answers at the old rate and switches after the response
+        self.transport.set_baudrate(baudrate)
+        result, msg, _ = self._send_command("millis", {})
+        if result == RPC_OK:
+            logger.info(f"Baud rate switched to {baudrate}")
+            return RPC_OK, "OK"
+        
+        # Wait for the device to fall back, then confirm the old rate
+        logger.warning(f"No response at {baudrate} baud, falling back to {previous}")
+        self.transport.set_baudrate(previous)
+        time.sleep(data.get("confirm_ms", 2000) / 1000.0 + 0.1)
+        self.transport.set_baudrate(previous)
+        self._send_command("millis", {})
+        return RPC_ERROR_EXECUTION, f"Baud rate {baudrate} failed, back at {previous}"
+    
+    def prepare(self, method: str, param_names: List[str]) -> Tuple[int, str, Optional[int]]:
+        """
+        Register a method with the order of its parameters on the device
+        
+        Args:
+            method: Method name, only methods with a typed parameter table
+                    can be prepared (RPC_ERROR_NOT_SUPPORTED otherwise)
+            param_names: Parameter names in the order invoke() passes the values,
+                         omitted optional parameters keep their default
+        
+        Returns:
+            (result_code, message, handle) tuple
+        """
+        result, msg, data = self._send_command("prepare", {"method": method, "params": param_names})
+        handle = data.get('handle') if (result == RPC_OK and data) else None
+        if handle is not None:
+            self._prepared[(method, tuple(param_names))] = handle
+        return result, msg, handle
+
+    def invoke(self, handle: int, values: List[Any], method: str = "invoke") -> Tuple[int, str, Dict[str, Any]]:
+        """
+        Call a prepared method: the frame carries only the handle and the
+        parameter values in the prepared order
+        
+        Args:
+            method: Name used in the log messages
+        
+        Returns:
+            (result_code, message, data) tuple
+        """
+        return self._exchange(method, {"h": handle, "v": values})
+
+    def release(self, handle: Optional[int] = None) -> Tuple[int, str]:
+        """
+        Free a prepared handle on the device
+        
+        Args:
+            handle: Handle to free, None frees every handle
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {}
+        if handle is not None:
+            params["handle"] = handle
+        result, msg, _ = self._send_command("release", params)
+        if result == RPC_OK:
+            for key in [key for key, value in self._prepared.items() if handle is None or value == handle]:
+                del self._prepared[key]
+        return result, msg
+
+    def usePrepared(self, methods: List[str], enable: bool = True) -> None:
+        """
+        Send calls of these methods as invoke frames instead of named
+        requests. Every parameter combination is prepared on its first call,
+        methods the device can not prepare fall back to named requests.
+        
+        Args:
+            methods: Method names, e.g. ["digitalWrite", "adcReadRaw"]
+            enable: False sends the methods by name again
+        """
+        if enable:
+            self._prepared_methods.update(methods)
+        else:
+            self._prepared_methods.difference_update(methods)
+
+    def bootProfile(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the duration of every boot stage of the ESP32
+        
+        Returns:
+            (result_code, message, profile) tuple, profile holds 'stages'
+            (name, start_ms, ms, done), 'ready_ms' and 'first_command_ms'
+        """
+        result, msg, data = self._send_command("bootProfile", {})
+        profile = data if (result == RPC_OK and data) else None
+        return result, msg, profile
+    
+    def configGet(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the settings record of the ESP32
+        
+        Returns:
+            (result_code, message, settings) tuple with 'comm_mode', 'baud_rate',
+            'tcp_port', 'ssid', 'password_set' and 'hostname'
+        """
+        result, msg, data = self._send_command("configGet", {})
+        settings = data if (result == RPC_OK and data) else None
+        return result, msg, settings
+    
+    def configSet(self, **fields: Any) -> Tuple[int, str]:
+        """
+        Change settings in RAM, configCommit() stores them. Settings used at
+        boot (comm_mode, baud_rate, tcp_port, ssid, password, hostname) take
+        effect after a restart
+        
+        Args:
+            fields: Any of comm_mode (COMM_USB/COMM_WIFI), baud_rate, tcp_port,
+                    ssid, password and hostname. baud_rate is only accepted
+                    for the default rate or the rate a setBaudRate() switched
+                    the link to, so a stored rate is known to work
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("configSet", fields)
+        return result, msg
+    
+    def configCommit(self) -> Tuple[int, str]:
+        """
+        Store the settings record in flash, as a single atomic write
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("configCommit", {})
+        return result, msg
+    
+    def configReset(self) -> Tuple[int, str]:
+        """
+        Restore the default settings in RAM, configCommit() stores them
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("configReset", {})
+        return result, msg
+    
+    def stats(self, method: str = None, start: int = 0) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get per method RPC instrumentation (firmware built with RPC_STATS_ENABLED)
+        
+        Args:
+            method: Method name for its full 'parse', 'execute' and 'serialize'
+                    statistics with log2 histograms in microseconds
+            start: First table entry of the summary page when no method is given
+        
+        Returns:
+            (result_code, message, stats) tuple, the summary page holds
+            'methods', 'total' and 'next' (-1 on the last page)
+        """
+        params = {"method": method} if method is not None else {"start": start}
+        result, msg, data = self._send_command("stats", params)
+        stats = data if (result == RPC_OK and data) else None
+        return result, msg, stats
+    
+    def statsAll(self) -> Tuple[int, str, Optional[List[Dict[str, Any]]]]:
+        """
+        Get the summary of all instrumented methods, page by page
+        
+        Returns:
+            (result_code, message, methods) tuple
+        """
+        methods = []
+        start = 0
+        while start >= 0:
+            result, msg, page = self.stats(start=start)
+            if result != RPC_OK or page is None:
+                return result, msg, None
+            methods.extend(page.get("methods", []))
+            start = page.get("next", -1)
+        return RPC_OK, "OK", methods
+    
+    def statsReset(self) -> Tuple[int, str]:
+        """
+        Clear the RPC instrumentation
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("statsReset", {})
+        return result, msg
+    
+    def traceStart(self, clear: bool = True) -> Tuple[int, str]:
+        """
+        Start the event tracer (firmware built with INCLUDE_TRACE)
+        
+        Args:
+            clear: Drop the records of a previous trace
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("traceStart", {"clear": clear})
+        return result, msg
+    
+    def traceStop(self) -> Tuple[int, str]:
+        """
+        Stop the event tracer, the records are kept for traceDump
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("traceStop", {})
+        return result, msg
+    
+    def traceDump(self) -> Tuple[int, str, Optional[bytes], Optional[int]]:
+        """
+        Read the trace ring chunk by chunk, this stops the tracer.
+        Convert the blob with trace_converter.write_chrome_trace()
+        
+        Returns:
+            (result_code, message, blob, cpu_mhz) tuple
+        """
+        blob = b""
+        cpu_mhz = None
+        start = 0
+        while start >= 0:
+            result, msg, data = self._send_command("traceDump", {"start": start})
+            if result != RPC_OK or not data:
+                return result, msg, None, None
+            blob += base64.b64decode(data.get("data", ""))
+            cpu_mhz = data.get("cpu_mhz")
+            start = data.get("next", -1)
+        return RPC_OK, "OK", blob, cpu_mhz
+    
+    # Input snapshot Functions
+    def snapshotConfig(self, adc: List[int] = None, qc: List[int] = None,
+                       dio: bool = None, voltage: bool = None) -> Tuple[int, str]:
+        """
+        Select the inputs captured by snapshot(), arguments left at None keep
+        their current setting. At boot all ADC channels, both encoders and
+        the DIO port are captured, ADC values raw.
+
+        Args:
+            adc: ADC channels to read (empty list = none)
+            qc: Encoder channels to latch & read (empty list = none)
+            dio: Read the DIO input port
+            voltage: ADC values in volts instead of raw
+
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {}
+        if adc is not None:
+            params["adc"] = adc
+        if qc is not None:
+            params["qc"] = qc
+        if dio is not None:
+            params["dio"] = dio
+        if voltage is not None:
+            params["voltage"] = voltage
+        result, msg, _ = self._send_command("snapshotConfig", params)
+        return result, msg
+
+    def snapshot(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Capture the configured inputs back to back on the device
+
+        Returns:
+            (result_code, message, snapshot) tuple, snapshot has t_us (micros
+            at the encoder latch), span_us (time until the last input was
+            read), adc and qc (values in ascending channel order) and dio
+        """
+        result, msg, data = self._send_command("snapshot", {})
+        return result, msg, data if result == RPC_OK else None
+    
     # PWM Functions
     def ledcSetup(self, channel: int, freq: int, bits: int) -> Tuple[int, str]:
         """
@@ -228,21 +603,52 @@ class RPCClient:
         })
         return result, msg
     
-    def ledcWrite(self, channel: int, duty: int) -> Tuple[int, str]:
+    def ledcWrite(self, channel: int, duty: int, force: bool = False) -> Tuple[int, str]:
         """
         Write PWM duty cycle
         
         Args:
             channel: PWM channel (0-15)
             duty: Duty cycle (0 - 2^bits - 1)
+            force: Write even if the output already has this value
         
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("ledcWrite", {
+        params = {
             "channel": channel,
             "duty": duty
-        })
+        }
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("ledcWrite", params)
+        return result, msg
+
+    def shadowStats(self, reset: bool = False) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the output write cache counters, a hit is a write that was
+        skipped because the output already had the value
+
+        Args:
+            reset: Clear the counters after reading
+
+        Returns:
+            (result_code, message, stats) tuple, stats holds 'gpio', 'ledc',
+            'dac' and 'dio' (when built in), each with 'hits' and 'misses'
+        """
+        result, msg, data = self._send_command("shadowStats", {"reset": reset})
+        stats = data if (result == RPC_OK and data) else None
+        return result, msg, stats
+
+    def shadowInvalidate(self) -> Tuple[int, str]:
+        """
+        Forget the cached output state, the next write of every output goes
+        to the hardware (e.g. after a peripheral lost power)
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("shadowInvalidate", {})
         return result, msg
     
     # Pulse Library Functions
@@ -265,7 +671,8 @@ class RPCClient:
     
     def pulse(self, channel: int, duration_ms: int) -> Tuple[int, str]:
         """
-        Generate a single pulse (blocking)
+        Generate a single pulse (blocking). The pulse runs as a job on the
+        device, which keeps ticking the other channels until it answers.
         
         Args:
             channel: Pulse channel (0-3)
@@ -345,7 +752,8 @@ class RPCClient:
     
     def generatePulses(self, channel: int, pulse_width_ms: int, pause_width_ms: int, pulse_count: int) -> Tuple[int, str]:
         """
-        Generate multiple pulses (blocking)
+        Generate multiple pulses (blocking). The train runs as a job on the
+        device, which keeps ticking the other channels until it answers.
         
         Args:
             channel: Pulse channel (0-3)
@@ -386,6 +794,193 @@ class RPCClient:
         })
         return result, msg
     
+    def pulseStats(self, channel: int, reset: bool = True) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get pulse edge timing statistics for a channel
+        Lateness is the measured edge time minus the requested pulse/pause width
+        
+        Args:
+            channel: Pulse channel (0-3)
+            reset: Clear the statistics after reading (default True)
+        
+        Returns:
+            (result_code, message, stats) tuple, stats holds 'edges',
+            'min_us', 'max_us', 'mean_us' and a log2 'histogram' in microseconds
+        """
+        result, msg, data = self._send_command("pulseStats", {
+            "channel": channel,
+            "reset": reset
+        })
+        stats = data if (result == RPC_OK and data) else None
+        return result, msg, stats
+    
+    # Job Functions
+    def jobDelay(self, ms: int, notify: bool = False) -> Tuple[int, str, Optional[int]]:
+        """
+        Start a delay job, it finishes after ms milliseconds
+        
+        Args:
+            notify: Send a job event when the job finishes, see jobEvents()
+        
+        Returns:
+            (result_code, message, job_id) tuple
+        """
+        params = {"ms": ms}
+        if notify:
+            params["notify"] = True
+        result, msg, data = self._send_command("jobDelay", params)
+        job_id = data.get('job') if (result == RPC_OK and data) else None
+        return result, msg, job_id
+
+    def jobPulses(self, channel: int, pulse_width_ms: int, pause_width_ms: int = 0,
+                  pulse_count: int = 1, notify: bool = False) -> Tuple[int, str, Optional[int]]:
+        """
+        Start a pulse train job on a channel set up with pulseBegin. Fails
+        with RPC_ERROR_EXECUTION while the channel is pulsing.
+        
+        Args:
+            channel: Pulse channel (0-3)
+            notify: Send a job event when the job finishes, see jobEvents()
+        
+        Returns:
+            (result_code, message, job_id) tuple
+        """
+        params = {
+            "channel": channel,
+            "pulse_width_ms": pulse_width_ms,
+            "pause_width_ms": pause_width_ms,
+            "pulse_count": pulse_count
+        }
+        if notify:
+            params["notify"] = True
+        result, msg, data = self._send_command("jobPulses", params)
+        job_id = data.get('job') if (result == RPC_OK and data) else None
+        return result, msg, job_id
+
+    def jobStatus(self, job_id: int) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the state and progress of a job
+        
+        Returns:
+            (result_code, message, status) tuple, status holds 'job', 'type'
+            ('delay' or 'pulses'), 'state' ('running', 'done', 'halted' or
+            'cancelled'), 'done' and 'total' (ms or pulses), 'elapsed_ms'
+            and for a pulse job 'channel'
+        """
+        result, msg, data = self._send_command("jobStatus", {"job": job_id})
+        status = data if (result == RPC_OK and data) else None
+        return result, msg, status
+
+    def jobList(self) -> Tuple[int, str, Optional[List[Dict[str, Any]]]]:
+        """
+        Get the status of every job in the job table, finished jobs stay
+        listed until their slot is reused
+        
+        Returns:
+            (result_code, message, jobs) tuple, see jobStatus for the fields
+        """
+        result, msg, data = self._send_command("jobList", {})
+        jobs = data.get('jobs') if (result == RPC_OK and data) else None
+        return result, msg, jobs
+
+    def jobCancel(self, job_id: int) -> Tuple[int, str]:
+        """
+        Cancel a running job, a pulse train stops with the output low
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("jobCancel", {"job": job_id})
+        return result, msg
+
+    def jobEvents(self, wait: float = 0.0) -> List[Dict[str, Any]]:
+        """
+        Take the job events received so far
+        
+        Args:
+            wait: Seconds to wait for an event when none is queued
+        
+        Returns:
+            List of event data dicts, see jobStatus for the fields
+        """
+        deadline = time.time() + wait
+        while not self._events and self.is_connected() and time.time() < deadline:
+            line = self.transport.recv(deadline - time.time())
+            if line is not None and not self._queue_event(line):
+                logger.warning(f"Unexpected line while waiting for events: {line}")
+
+        events = [message.get('data', {}) for message in self._events if message.get('event') == 'job']
+        self._events = [message for message in self._events if message.get('event') != 'job']
+        return events
+
+    def waitJob(self, job_id: int, timeout: float = 10.0,
+                interval: float = 0.05) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Poll a job until it is no longer running
+        
+        Returns:
+            (result_code, message, status) tuple, RPC_ERROR_TIMEOUT with the
+            last status when the job still runs after timeout seconds
+        """
+        deadline = time.time() + timeout
+        while True:
+            result, msg, status = self.jobStatus(job_id)
+            if result != RPC_OK or status.get('state') != 'running':
+                return result, msg, status
+            if time.time() >= deadline:
+                return RPC_ERROR_TIMEOUT, "Job still running", status
+            time.sleep(interval)
+
+    def guardBind(self, pin: int, channel: int, active_level: int = 1) -> Tuple[int, str]:
+        """
+        Bind an endstop/limit input to a pulse channel
+        When the pin reaches its active level the channel is halted on the device
+        
+        Args:
+            pin: Input GPIO number
+            channel: Pulse channel (0-3), a pin may be bound to several channels
+            active_level: Level that trips the guard (1 = HIGH, 0 = LOW)
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("guardBind", {
+            "pin": pin,
+            "channel": channel,
+            "active_level": active_level
+        })
+        return result, msg
+    
+    def guardUnbind(self, pin: int) -> Tuple[int, str]:
+        """
+        Remove the guard from an input pin
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("guardUnbind", {"pin": pin})
+        return result, msg
+    
+    def guardStatus(self, channel: int, clear: bool = False) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the latched guard halt of a pulse channel
+        
+        Args:
+            channel: Pulse channel (0-3)
+            clear: Clear the latched halt after reading
+        
+        Returns:
+            (result_code, message, status) tuple, status holds 'halted',
+            'pin' (guard pin that tripped, -1 if none) and 'cut_pulses',
+            plus 'compare' (counter channel) when an encoder compare halted it
+        """
+        result, msg, data = self._send_command("guardStatus", {
+            "channel": channel,
+            "clear": clear
+        })
+        status = data if (result == RPC_OK and data) else None
+        return result, msg, status
+    
     def pulseTick(self, channel: int) -> Tuple[int, str]:
         """
         Update pulse state for async pulse generation
@@ -401,42 +996,252 @@ class RPCClient:
         return result, msg
 
     # ADC Functions
-    def adcReadRaw(self, channel: int, averageCount: int = 1) -> Tuple[int, str, Optional[int]]:
+    def adcReadRaw(self, channel: int, averageCount: int = 1,
+                   fresh: bool = False) -> Tuple[int, str, Optional[int]]:
         """
         Read raw ADC value
 
+        While the background sampler scans the channel the running average
+        from its cache is returned, unless fresh is set.
+
         Args:
             channel: ADC channel number
-            averageCount: Number of samples to average (default 1)
+            averageCount: Number of samples to average (default 1, max 65535)
+            fresh: Always convert on the bus, bypassing the sampler cache
 
         Returns:
             (result_code, message, raw_value) tuple
         """
         result, msg, data = self._send_command("adcReadRaw", {
             "channel": channel,
-            "averageCount": averageCount
+            "averageCount": averageCount,
+            "fresh": fresh
         })
         value = data.get('raw') if (result == RPC_OK and data) else None
         return result, msg, value
 
-    def adcReadVoltage(self, channel: int, averageCount: int = 1) -> Tuple[int, str, Optional[float]]:
+    def adcReadVoltage(self, channel: int, averageCount: int = 1,
+                       fresh: bool = False) -> Tuple[int, str, Optional[float]]:
         """
         Read ADC voltage
 
+        While the background sampler scans the channel the running average
+        from its cache is returned, unless fresh is set.
+
         Args:
             channel: ADC channel number
-            averageCount: Number of samples to average (default 1)
+            averageCount: Number of samples to average (default 1, max 65535)
+            fresh: Always convert on the bus, bypassing the sampler cache
 
         Returns:
             (result_code, message, voltage) tuple
         """
         result, msg, data = self._send_command("adcReadVoltage", {
             "channel": channel,
-            "averageCount": averageCount
+            "averageCount": averageCount,
+            "fresh": fresh
         })
         value = data.get('voltage') if (result == RPC_OK and data) else None
         return result, msg, value
 
+    def adcSamplerStart(self, channels: List[int], rate_hz: int = 100,
+                        average: int = 1) -> Tuple[int, str]:
+        """
+        Start scanning ADC channels in the background
+
+        Args:
+            channels: ADC channel numbers to scan
+            rate_hz: Scans of the channel set per second (1-1000)
+            average: Running average window, power of 2 (1-256)
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("adcSamplerStart", {
+            "channels": channels,
+            "rate_hz": rate_hz,
+            "average": average
+        })
+        return result, msg
+
+    def adcSamplerStop(self) -> Tuple[int, str]:
+        """
+        Stop the background sampler, the cache keeps the last values
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("adcSamplerStop", {})
+        return result, msg
+
+    def adcSamplerStatus(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the background sampler settings and scan counters
+
+        Returns:
+            (result_code, message, status) tuple, status has running,
+            channels, rate_hz, average, scans and missed
+        """
+        result, msg, data = self._send_command("adcSamplerStatus", {})
+        return result, msg, data if result == RPC_OK else None
+
+    def adcSamplerRead(self) -> Tuple[int, str, Optional[Dict[int, Dict[str, Any]]]]:
+        """
+        Read all cached channels of the background sampler
+
+        Returns:
+            (result_code, message, samples) tuple, samples maps a channel to
+            its raw, average, voltage and age_us
+        """
+        result, msg, data = self._send_command("adcSamplerRead", {})
+        if result != RPC_OK or not data:
+            return result, msg, None
+        samples = {}
+        for ix, channel in enumerate(data.get('channels', [])):
+            samples[channel] = {
+                'raw': data['raw'][ix],
+                'average': data['average'][ix],
+                'voltage': data['voltage'][ix],
+                'age_us': data['age_us'][ix]
+            }
+        return result, msg, samples
+
+    def adcFilterSet(self, channel: int, median: int = 1, decimation: int = 1,
+                     alpha: float = 1.0, enable: bool = True) -> Tuple[int, str]:
+        """
+        Configure the filter pipeline of a sampled ADC channel
+
+        The pipeline runs on every background sampler scan:
+        median of N -> moving average over decimation samples -> first
+        order IIR y += alpha * (x - y). A decimation of rate_hz / 50 nulls
+        50 Hz mains hum.
+
+        Args:
+            channel: ADC channel number
+            median: Median window for spike rejection, odd (1 = off, max 9)
+            decimation: Samples per output (1-1000)
+            alpha: IIR coefficient (0 < alpha <= 1, 1 = off)
+            enable: False switches the filter of the channel off
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("adcFilterSet", {
+            "channel": channel,
+            "median": median,
+            "decimation": decimation,
+            "alpha": alpha,
+            "enable": enable
+        })
+        return result, msg
+
+    def adcFilterRead(self, channel: int) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Read the latest filter output of an ADC channel
+
+        Args:
+            channel: ADC channel number
+
+        Returns:
+            (result_code, message, output) tuple, output has raw (with
+            fraction), voltage, age_us, outputs and rate_hz
+        """
+        result, msg, data = self._send_command("adcFilterRead", {"channel": channel})
+        return result, msg, data if result == RPC_OK else None
+
+    def captureArm(self, channels: List[int], pre: int, post: int,
+                   trigger: int = CAPTURE_TRIGGER_NOW, source: int = 0,
+                   level: int = 0, hysteresis: int = 0) -> Tuple[int, str]:
+        """
+        Arm a triggered burst capture on ADC channels
+
+        The channels are scanned back to back at the full SPI rate. The
+        trigger is accepted once the pre-trigger scans are recorded.
+
+        Args:
+            channels: ADC channel numbers to capture
+            pre: Scans kept before the trigger scan
+            post: Scans recorded after the trigger scan
+            trigger: CAPTURE_TRIGGER_NOW, _RISING, _FALLING, _DIO_RISING or _DIO_FALLING
+            source: ADC channel (level triggers, must be captured) or DIO input bit
+            level: Raw trigger level (0-4095)
+            hysteresis: Raw distance the signal must first be on the other side
+
+        Returns:
+            (result_code, message) tuple, pre + 1 + post is limited to
+            min(1024, 4096 / len(channels)) scans
+        """
+        result, msg, _ = self._send_command("captureArm", {
+            "channels": channels,
+            "pre": pre,
+            "post": post,
+            "trigger": trigger,
+            "source": source,
+            "level": level,
+            "hysteresis": hysteresis
+        })
+        return result, msg
+
+    def captureStop(self) -> Tuple[int, str]:
+        """
+        Abort a running capture
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("captureStop", {})
+        return result, msg
+
+    def captureTrigger(self) -> Tuple[int, str]:
+        """
+        Force the trigger of an armed capture
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("captureTrigger", {})
+        return result, msg
+
+    def captureStatus(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the capture state
+
+        Returns:
+            (result_code, message, status) tuple, status has state ("idle",
+            "armed", "triggered" or "done"), scans, recorded and max_scans
+        """
+        result, msg, data = self._send_command("captureStatus", {})
+        return result, msg, data if result == RPC_OK else None
+
+    def captureRead(self) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Read a finished capture in one transfer
+
+        Returns:
+            (result_code, message, capture) tuple, capture has channels,
+            pre (index of the trigger scan), time_us (per scan, relative to
+            the trigger scan) and raw (per channel a list of raw values)
+        """
+        result, msg, data = self._send_command("captureRead", {})
+        if result != RPC_OK or not data:
+            return result, msg, None
+        channels = data.get("channels", [])
+        blob = base64.b64decode(data.get("data", ""))
+        cpu_mhz = data.get("cpu_mhz", 240)
+        scan_format = "<i" + "H" * len(channels)
+        time_us = []
+        raw = {channel: [] for channel in channels}
+        for values in struct.iter_unpack(scan_format, blob):
+            time_us.append(values[0] / cpu_mhz)
+            for ix, channel in enumerate(channels):
+                raw[channel].append(values[1 + ix])
+        return result, msg, {
+            "channels": channels,
+            "pre": data.get("pre"),
+            "time_us": time_us,
+            "raw": raw
+        }
+
     def isButtonPressed(self, analogButton: int) -> Tuple[int, str, Optional[bool]]:
         """
         Check if an analog button is pressed
@@ -477,43 +1282,55 @@ class RPCClient:
         bit_set = data.get('bitSet') if (result == RPC_OK and data) else None
         return result, msg, bit_set
 
-    def dioSetOutput(self, value: int) -> Tuple[int, str]:
+    def dioSetOutput(self, value: int, force: bool = False) -> Tuple[int, str]:
         """
         Write DIO output register
 
         Args:
             value: Output register value
+            force: Write even if the output already has this value
 
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("dioSetOutput", {"value": value})
+        params = {"value": value}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dioSetOutput", params)
         return result, msg
 
-    def dioSetBit(self, bitNumber: int) -> Tuple[int, str]:
+    def dioSetBit(self, bitNumber: int, force: bool = False) -> Tuple[int, str]:
         """
         Set a DIO bit
 
         Args:
             bitNumber: Bit index to set
+            force: Write even if the output already has this value
 
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("dioSetBit", {"bitNumber": bitNumber})
+        params = {"bitNumber": bitNumber}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dioSetBit", params)
         return result, msg
 
-    def dioClearBit(self, bitNumber: int) -> Tuple[int, str]:
+    def dioClearBit(self, bitNumber: int, force: bool = False) -> Tuple[int, str]:
         """
         Clear a DIO bit
 
         Args:
             bitNumber: Bit index to clear
+            force: Write even if the output already has this value
 
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("dioClearBit", {"bitNumber": bitNumber})
+        params = {"bitNumber": bitNumber}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dioClearBit", params)
         return result, msg
 
     def dioToggleBit(self, bitNumber: int) -> Tuple[int, str]:
@@ -529,6 +1346,67 @@ class RPCClient:
         result, msg, _ = self._send_command("dioToggleBit", {"bitNumber": bitNumber})
         return result, msg
 
+    # Input Event Functions
+    def eventsEnable(self, pins: List[int] = None, dio_mask: int = None) -> Tuple[int, str]:
+        """
+        Capture level changes of GPIO pins and/or DIO inputs in the event log
+
+        Args:
+            pins: GPIO numbers to watch (e.g. endstops)
+            dio_mask: DIO input bits to watch
+
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {}
+        if pins is not None:
+            params["pins"] = list(pins)
+        if dio_mask is not None:
+            params["dio_mask"] = dio_mask
+        result, msg, _ = self._send_command("eventsEnable", params)
+        return result, msg
+
+    def eventsDisable(self, pins: List[int] = None) -> Tuple[int, str]:
+        """
+        Stop watching GPIO pins, all pins when none are given
+
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {"pins": list(pins)} if pins is not None else {}
+        result, msg, _ = self._send_command("eventsDisable", params)
+        return result, msg
+
+    def eventsRead(self, max_events: int = 16) -> Tuple[int, str, Optional[List[Tuple[int, int, int]]], Optional[Dict[str, Any]]]:
+        """
+        Read captured input events, oldest first
+        Call again while 'pending' is non zero
+
+        Args:
+            max_events: Maximum events per request (max 16)
+
+        Returns:
+            (result_code, message, events, info) tuple, events is a list of
+            (pin, level, timestamp_us) and info holds 'pending' and 'overflow'
+            (events dropped since eventsClear)
+        """
+        result, msg, data = self._send_command("eventsRead", {"max": max_events})
+        if result != RPC_OK or not data:
+            return result, msg, None, None
+        events = list(zip(data.get("pins", []), data.get("levels", []), data.get("t_us", [])))
+        info = {"pending": data.get("pending", 0), "overflow": data.get("overflow", 0)}
+        return result, msg, events, info
+
+    def eventsClear(self) -> Tuple[int, str]:
+        """
+        Discard all captured events and reset the overflow counter
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("eventsClear", {})
+        return result, msg
+
     # QC Counter Functions
     def qcEnableCounter(self, channel: int) -> Tuple[int, str]:
         """
@@ -583,6 +1461,96 @@ class RPCClient:
         count = data.get('count') if (result == RPC_OK and data) else None
         return result, msg, count
 
+    def qcReadPosition(self, channel: int) -> Tuple[int, str, Optional[int]]:
+        """
+        Read the QC counter extended to 64 bit by the firmware
+
+        Args:
+            channel: Counter channel number
+
+        Returns:
+            (result_code, message, position) tuple
+        """
+        result, msg, data = self._send_command("qcReadCountRegister", {"channel": channel})
+        position = data.get('position') if (result == RPC_OK and data) else None
+        return result, msg, position
+
+    def qcSetCounterWidth(self, channel: int, num_bytes: int) -> Tuple[int, str]:
+        """
+        Set the QC counter width, only this many bytes are read per count
+
+        Args:
+            channel: Counter channel number
+            num_bytes: Counter width in bytes (1-4)
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("qcSetCounterWidth", {"channel": channel, "bytes": num_bytes})
+        return result, msg
+
+    def qcCompareArm(self, channel: int, target: int, pulse_channels: Optional[List[int]] = None,
+                     dio_bit: Optional[int] = None, dio_level: bool = True,
+                     adc_channels: Optional[List[int]] = None, capture: bool = False,
+                     poll_hz: Optional[int] = None) -> Tuple[int, str]:
+        """
+        Arm a one-shot position compare, the actions run on the device when
+        the counter reaches target
+
+        Args:
+            channel: Counter channel number
+            target: Counter value at the configured counter width
+            pulse_channels: Pulse channels to halt
+            dio_bit: DIO output bit to drive, None for no DIO action
+            dio_level: Level the DIO bit is driven to
+            adc_channels: ADC channels converted at the hit
+            capture: Force the trigger of an armed ADC capture
+            poll_hz: Counter status polls per second (firmware default if None)
+
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {"channel": channel, "target": target, "dio_level": dio_level, "capture": capture}
+        if pulse_channels:
+            params["pulse"] = pulse_channels
+        if dio_bit is not None:
+            params["dio_bit"] = dio_bit
+        if adc_channels:
+            params["adc"] = adc_channels
+        if poll_hz is not None:
+            params["poll_hz"] = poll_hz
+        result, msg, _ = self._send_command("qcCompareArm", params)
+        return result, msg
+
+    def qcCompareDisarm(self, channel: int) -> Tuple[int, str]:
+        """
+        Disarm a position compare, a result that fired stays readable
+
+        Args:
+            channel: Counter channel number
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("qcCompareDisarm", {"channel": channel})
+        return result, msg
+
+    def qcCompareStatus(self, channel: int) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the state of a position compare
+
+        Args:
+            channel: Counter channel number
+
+        Returns:
+            (result_code, message, status) tuple, status holds 'armed', 'fired'
+            and 'target'; once fired also 'count' (counter at detection),
+            't_us', 'latency_us' and 'adc' (raw values of the ADC channels)
+        """
+        result, msg, data = self._send_command("qcCompareStatus", {"channel": channel})
+        status = data if (result == RPC_OK and data) else None
+        return result, msg, status
+
     # OLED Functions
     def oledClear(self) -> Tuple[int, str]:
         """
@@ -612,33 +1580,233 @@ class RPCClient:
             "align": align
         })
         return result, msg
+
+    def oledFlush(self) -> Tuple[int, str, Optional[int]]:
+        """
+        Send pending OLED changes now instead of at the next deferred flush
+        Only the changed parts of the display are transferred
+
+        Returns:
+            (result_code, message, bytes_sent) tuple, bytes_sent is the total
+            number of I2C bytes sent to the display since boot
+        """
+        result, msg, data = self._send_command("oledFlush", {})
+        bytes_sent = data.get("bytes_sent") if (result == RPC_OK and data) else None
+        return result, msg, bytes_sent
+
+    def oledDashboard(self, enable: bool = True, period_ms: int = 500) -> Tuple[int, str]:
+        """
+        Show or stop the on-device performance dashboard on the OLED
+        (RPC calls/s, handler latency, free heap, loop frequency, active
+        pulse channels and connected clients)
+
+        Args:
+            enable: True to show the dashboard, False to stop it
+            period_ms: Refresh period in milliseconds (min. 50)
+
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("oledDashboard", {
+            "enable": enable,
+            "period_ms": period_ms
+        })
+        return result, msg
     
     # DAC Functions
-    def dacSetVoltage(self, channel: int, voltage: float) -> Tuple[int, str]:
+    def dacSetVoltage(self, channel: int, voltage: float, force: bool = False) -> Tuple[int, str]:
         """
         Set output voltage on DAC channel
         
         Args:
             channel: DAC channel (0 for A, 1 for B)
             voltage: Output voltage (0.0 to reference voltage)
+            force: Write even if the output already has this value
         
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("dacSetVoltage", {"channel": channel, "voltage": voltage})
+        params = {"channel": channel, "voltage": voltage}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dacSetVoltage", params)
         return result, msg
     
-    def dacSetVoltageAll(self, voltage: float) -> Tuple[int, str]:
+    def dacSetVoltageAll(self, voltage: float, force: bool = False) -> Tuple[int, str]:
         """
         Set output voltage on all DAC channels
         
         Args:
             voltage: Output voltage (0.0 to reference voltage)
+            force: Write even if the output already has this value
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {"voltage": voltage}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dacSetVoltageAll", params)
+        return result, msg
+    
+    def dacSetVoltages(self, voltages: List[float], force: bool = False) -> Tuple[int, str]:
+        """
+        Set output voltages on all four DAC channels in one update
+        
+        Args:
+            voltages: Output voltage per channel (4 values, -10.0 to +10.0)
+            force: Write even if the output already has this value
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {"voltages": list(voltages)}
+        if force:
+            params["force"] = True
+        result, msg, _ = self._send_command("dacSetVoltages", params)
+        return result, msg
+    
+    # DAC Waveform Functions
+    def waveUpload(self, channel: int, points: List[float], chunk_size: int = 64) -> Tuple[int, str]:
+        """
+        Upload a waveform table for a DAC channel (used with WAVE_SHAPE_TABLE)
+        The table is sent in chunks so each request fits the firmware buffer
+        
+        Args:
+            channel: DAC channel (0-3)
+            points: Table points normalised to -1.0 .. +1.0 (max 256 points)
+            chunk_size: Points per request
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg = RPC_OK, "OK"
+        for start in range(0, len(points), chunk_size):
+            result, msg, _ = self._send_command("waveUpload", {
+                "channel": channel,
+                "start": start,
+                "points": list(points[start:start + chunk_size])
+            })
+            if result != RPC_OK:
+                break
+        return result, msg
+    
+    def waveSetup(self, channel: int, shape: int, amplitude: float, sample_rate: int,
+                  offset: float = 0.0, length: int = None) -> Tuple[int, str]:
+        """
+        Configure the waveform of a DAC channel, Vout = offset + amplitude * shape
+        A running channel switches to the new waveform without a glitch
+        
+        Args:
+            channel: DAC channel (0-3)
+            shape: WAVE_SHAPE_SINE, WAVE_SHAPE_TRIANGLE, WAVE_SHAPE_RAMP or WAVE_SHAPE_TABLE
+            amplitude: Peak amplitude in volts
+            sample_rate: Table points per second (frequency = sample_rate / length)
+            offset: Offset voltage
+            length: Table length in points (default 256, or the uploaded table length)
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {
+            "channel": channel,
+            "shape": shape,
+            "amplitude": amplitude,
+            "offset": offset,
+            "sample_rate": sample_rate
+        }
+        if length is not None:
+            params["length"] = length
+        result, msg, _ = self._send_command("waveSetup", params)
+        return result, msg
+    
+    def waveStart(self, channel: int) -> Tuple[int, str]:
+        """
+        Start playing the configured waveform on a DAC channel
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("waveStart", {"channel": channel})
+        return result, msg
+    
+    def waveStop(self, channel: int) -> Tuple[int, str]:
+        """
+        Stop the waveform on a DAC channel, the output keeps its last value
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("waveStop", {"channel": channel})
+        return result, msg
+    
+    # Calibration Functions
+    def calGet(self, device: str, channel: int) -> Tuple[int, str, Optional[Dict[str, Any]]]:
+        """
+        Get the calibration of an ADC or DAC channel
+        
+        Args:
+            device: "adc" or "dac"
+            channel: Channel number
+        
+        Returns:
+            (result_code, message, calibration) tuple, calibration holds 'gain',
+            'offset' and 'points' as [voltage, correction] pairs in volts
+        """
+        result, msg, data = self._send_command("calGet", {
+            "type": device,
+            "channel": channel
+        })
+        calibration = data if (result == RPC_OK and data) else None
+        return result, msg, calibration
+    
+    def calSet(self, device: str, channel: int, gain: float = 1.0, offset: float = 0.0,
+               points: List[List[float]] = None) -> Tuple[int, str]:
+        """
+        Set the calibration of an ADC or DAC channel, active immediately
+        Vcorrected = gain * Videal + offset + piecewise linear correction
+        Use calCommit() to keep the calibration after a reset
+        
+        Args:
+            device: "adc" or "dac"
+            channel: Channel number
+            gain: Gain correction (0.5 - 2.0)
+            offset: Offset correction in volts
+            points: Optional [voltage, correction] pairs in volts, ascending voltage (max 8)
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        params = {
+            "type": device,
+            "channel": channel,
+            "gain": gain,
+            "offset": offset
+        }
+        if points is not None:
+            params["points"] = [list(point) for point in points]
+        result, msg, _ = self._send_command("calSet", params)
+        return result, msg
+    
+    def calCommit(self) -> Tuple[int, str]:
+        """
+        Store the current calibration of all channels in flash
+        
+        Returns:
+            (result_code, message) tuple
+        """
+        result, msg, _ = self._send_command("calCommit", {})
+        return result, msg
+    
+    def calReset(self) -> Tuple[int, str]:
+        """
+        Restore the ideal conversion on all channels, the stored calibration
+        is kept until calCommit()
         
         Returns:
             (result_code, message) tuple
         """
-        result, msg, _ = self._send_command("dacSetVoltageAll", {"voltage": voltage})
+        result, msg, _ = self._send_command("calReset", {})
         return result, msg
     
     # Utility
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+ESP32 Trace Converter
+
+Converts a trace dumped with RPCClient.traceDump() to the Chrome trace event
+JSON format, open it in chrome://tracing or https://ui.perfetto.dev
+
+Usage:
+    python -m library.trace_converter trace.bin trace.json --mhz 240
+"""
+
+import argparse
+import json
+import struct
+from typing import Dict, Any, Iterable, List, Optional, Tuple
+
+# Record layout of trace_record_t in trace_lib.h: cycles, event, core, arg
+RECORD_FORMAT = "<IBBH"
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+
+# Event id's, keep in sync with trace_lib.h
+TRACE_MARK = 0
+TRACE_RPC_BEGIN = 1
+TRACE_RPC_END = 2
+TRACE_PULSE_EDGE = 3
+TRACE_PULSE_HALT = 4
+TRACE_SPI_BEGIN = 5
+TRACE_SPI_END = 6
+TRACE_WIFI_CONNECT = 7
+TRACE_WIFI_RX = 8
+TRACE_WIFI_TX = 9
+
+SPI_DEVICE_NAMES = ["DAC01", "DAC23", "QC0", "QC1", "ADC", "EXT5", "EXT6"]
+
+# Firmware methods whose client method has another name
+FIRMWARE_METHOD_NAMES = ["millis", "freeMem", "chipID"]
+
+
+def trace_hash(text: str) -> int:
+    """FNV-1a folded to 16 bits, same as traceHash() in the firmware"""
+    value = 2166136261
+    for byte in text.encode():
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return (value >> 16) ^ (value & 0xFFFF)
+
+
+def default_method_names() -> List[str]:
+    """RPC method names known to the client library"""
+    from .rpc_client import RPCClient
+    names = [name for name in dir(RPCClient) if not name.startswith("_")]
+    return names + FIRMWARE_METHOD_NAMES
+
+
+def decode_trace(blob: bytes) -> List[Tuple[int, int, int, int]]:
+    """
+    Split a trace blob into records
+
+    Returns:
+        List of (cycles, event, core, arg) tuples, oldest first
+    """
+    usable = len(blob) - (len(blob) % RECORD_SIZE)
+    return [struct.unpack_from(RECORD_FORMAT, blob, offset)
+            for offset in range(0, usable, RECORD_SIZE)]
+
+
+def to_chrome_trace(blob: bytes, cpu_mhz: int,
+                    method_names: Optional[Iterable[str]] = None) -> Dict[str, Any]:
+    """
+    Convert a trace blob to Chrome trace events
+
+    Every core is a thread of its own. The cycle counters of both cores are
+    not synchronised, so each core starts at time 0 at its first record.
+
+    Args:
+        blob: Records as returned by RPCClient.traceDump()
+        cpu_mhz: CPU clock, converts cycles to microseconds
+        method_names: RPC method names to label the RPC events with
+
+    Returns:
+        Chrome trace as a dict, ready for json.dump()
+    """
+    if method_names is None:
+        method_names = default_method_names()
+    methods = {trace_hash(name): name for name in method_names}
+
+    events = []
+    last_cycles = {}
+    elapsed_cycles = {}
+
+    for cycles, event, core, arg in decode_trace(blob):
+        # the 32 bit cycle counter wraps, records of a core are in order
+        if core not in last_cycles:
+            last_cycles[core] = cycles
+            elapsed_cycles[core] = 0
+            events.append({"ph": "M", "name": "thread_name", "pid": 0, "tid": core,
+                           "args": {"name": f"core {core}"}})
+        elapsed_cycles[core] += (cycles - last_cycles[core]) & 0xFFFFFFFF
+        last_cycles[core] = cycles
+
+        base = {"pid": 0, "tid": core, "ts": elapsed_cycles[core] / cpu_mhz}
+
+        if event == TRACE_MARK:
+            events.append({**base, "ph": "i", "s": "g", "name": "trace start"})
+        elif event == TRACE_RPC_BEGIN:
+            name = methods.get(arg, f"rpc 0x{arg:04x}")
+            events.append({**base, "ph": "B", "name": name, "cat": "rpc"})
+        elif event == TRACE_RPC_END:
+            events.append({**base, "ph": "E", "cat": "rpc", "args": {"result": arg}})
+        elif event == TRACE_PULSE_EDGE:
+            events.append({**base, "ph": "C", "name": f"pin {arg & 0xFF}",
+                           "args": {"level": arg >> 8}})
+        elif event == TRACE_PULSE_HALT:
+            events.append({**base, "ph": "i", "s": "g", "name": f"halt pin {arg}",
+                           "cat": "pulse"})
+        elif event == TRACE_SPI_BEGIN:
+            name = SPI_DEVICE_NAMES[arg] if arg < len(SPI_DEVICE_NAMES) else str(arg)
+            events.append({**base, "ph": "B", "name": f"spi {name}", "cat": "spi"})
+        elif event == TRACE_SPI_END:
+            events.append({**base, "ph": "E", "cat": "spi"})
+        elif event == TRACE_WIFI_CONNECT:
+            events.append({**base, "ph": "i", "s": "t", "name": "client connect",
+                           "cat": "wifi"})
+        elif event in (TRACE_WIFI_RX, TRACE_WIFI_TX):
+            name = "rx" if event == TRACE_WIFI_RX else "tx"
+            events.append({**base, "ph": "i", "s": "t", "name": name, "cat": "wifi",
+                           "args": {"bytes": arg}})
+        else:
+            events.append({**base, "ph": "i", "s": "t", "name": f"event {event}",
+                           "args": {"arg": arg}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ns"}
+
+
+def write_chrome_trace(path: str, blob: bytes, cpu_mhz: int,
+                       method_names: Optional[Iterable[str]] = None) -> int:
+    """
+    Write a trace blob as a Chrome trace JSON file
+
+    Returns:
+        Number of records converted
+    """
+    trace = to_chrome_trace(blob, cpu_mhz, method_names)
+    with open(path, "w") as file:
+        json.dump(trace, file)
+    return len(blob) // RECORD_SIZE
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert an ESP32 trace dump to Chrome trace JSON")
+    parser.add_argument("input", help="binary trace as returned by traceDump()")
+    parser.add_argument("output", help="Chrome trace JSON file")
+    parser.add_argument("--mhz", type=int, default=240, help="CPU clock in MHz")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as file:
+        blob = file.read()
+    count = write_chrome_trace(args.output, blob, args.mhz)
+    print(f"{count} records written to {args.output}")
+
+
+if __name__ == "__main__":
+    main()
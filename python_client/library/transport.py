@@ -39,6 +39,10 @@ class Transport(ABC):
     def is_connected(self) -> bool:
         """Check if connected"""
         pass
+    
+    def set_baudrate(self, baudrate: int) -> bool:
+        """Change the link speed, only supported by the serial transport"""
+        return False
 
 
 class SerialTransport(Transport):
@@ -137,6 +141,24 @@ class SerialTransport(Transport):
     def is_connected(self) -> bool:
         """Check if serial port is connected"""
         return self._connected and self.serial and self.serial.is_open
+    
+    def set_baudrate(self, baudrate: int) -> bool:
+        """Switch the open port to another baud rate, drops pending input"""
+        if not self._connected or not self.serial:
+            logger.warning("Baud rate change attempted while not connected")
+            return False
+        
+        try:
+            self.serial.baudrate = baudrate
+            self.serial.reset_input_buffer()
+            self.baudrate = baudrate
+            logger.info(f"Serial baud rate set to {baudrate}")
+            return True
+        except Exception as e:
+            logger.error(f"Baud rate change failed: {e}")
+            if CONFIG['debug']:
+                print(f"[ERROR] Baud rate change failed: {e}")
+            return False
 
 
 class WiFiTransport(Transport):